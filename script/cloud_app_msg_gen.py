@@ -0,0 +1,526 @@
+#!/usr/bin/env python3
+"""Generate the CloudApp telemetry encoders and their host decoders from src/cloud_app/cloud_app_msg.json.
+
+Each message of the schema gets a struct holding its values and two encoders specialised for its layout: a JSON
+writer and a CBOR writer. Keys, braces and CBOR map headers are known at generation time, so the encoders copy
+them as literals and only format the values at run time. The host decoders check the same literals and read the
+values back into the same structs.
+
+The JSON of a message with a json_format is that printf format, %f being the values in field order, so payloads
+keep the layout the application published before the encoders were generated. Messages without one are written
+compact.
+
+Usage, from the repository root after editing the schema:
+    python3 script/cloud_app_msg_gen.py
+
+Outputs:
+    src/cloud_app/cloud_app_msg.h, src/cloud_app/cloud_app_msg.c     firmware encoders
+    script/host/cloud_app_msg_decode.h, script/host/cloud_app_msg_decode.c     host decoders
+"""
+
+import json
+import os
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+SCHEMA = os.path.join(ROOT, 'src', 'cloud_app', 'cloud_app_msg.json')
+FIRMWARE_DIR = os.path.join(ROOT, 'src', 'cloud_app')
+HOST_DIR = os.path.join(ROOT, 'script', 'host')
+
+# Largest text CloudApp_TelemetryWriteFixed writes for a value, checked again by the generated firmware source
+FIXED_SIZE_MAX = 23
+# Largest CBOR item CloudApp_TelemetryWriteValue writes for a value, checked again by the generated firmware source
+VALUE_SIZE_MAX = 8
+
+C_TYPES = {'float': 'float_t', 'double': 'double', 'uint16': 'uint16_t'}
+HOST_CASTS = {'float': '(float_t){v}', 'double': '{v}', 'uint16': '(uint16_t)lround({v})'}
+PRECISION_MIN = -6
+
+BANNER_LINE = '*' * 119
+
+C_ESCAPES = {'\r': '\\r', '\n': '\\n', '\t': '\\t'}
+
+
+class Field:
+    def __init__(self, schema, access):
+        self.key = schema['key']
+        self.member = schema['member']
+        self.type = schema['type']
+        self.precision = int(schema['precision'])
+        self.access = access + self.member
+        if self.type not in C_TYPES:
+            raise ValueError('field %s: unknown type %s' % (self.key, self.type))
+        if not PRECISION_MIN <= self.precision <= 0:
+            raise ValueError('field %s: precision out of %d..0' % (self.key, PRECISION_MIN))
+
+
+class Group:
+    def __init__(self, schema, access):
+        self.key = schema['key']
+        self.fields = [Field(f, access) for f in schema.get('fields', [])]
+        self.groups = [Group(g, access) for g in schema.get('groups', [])]
+        if self.fields and self.groups:
+            raise ValueError('group %s: holds fields or groups, not both' % self.key)
+
+    def children(self):
+        return self.fields if self.fields else self.groups
+
+
+class Message:
+    def __init__(self, schema, messages):
+        self.name = schema['name']
+        self.topic = schema['topic']
+        self.includes = [messages[name] for name in schema.get('include', [])]
+        if self.includes:
+            self.groups = []
+            for included in self.includes:
+                self.groups += [Group(g, 'msg->%s.' % member_name(included)) for g in included.schema['groups']]
+        else:
+            self.groups = [Group(g, 'msg->') for g in schema['groups']]
+        self.schema = schema
+
+    @property
+    def type_name(self):
+        return 'CloudAppMsg%s_t' % self.name
+
+    @property
+    def macro(self):
+        return 'CLOUD_APP_MSG_%s' % self.name.upper()
+
+    def fields(self):
+        out = []
+
+        def walk(group):
+            out.extend(group.fields)
+            for child in group.groups:
+                walk(child)
+        for group in self.groups:
+            walk(group)
+        return out
+
+
+def member_name(message):
+    return message.name[0].lower() + message.name[1:]
+
+
+# ------------------------------------------------------------------------------------------------------------------
+# Layouts: a message is a list of literal byte strings and values
+# ------------------------------------------------------------------------------------------------------------------
+
+def append_literal(tokens, data):
+    if tokens and isinstance(tokens[-1], bytes):
+        tokens[-1] += data
+    else:
+        tokens.append(data)
+
+
+def json_tree(groups):
+    """Keys and nesting of the groups, as json.loads returns them with object_pairs_hook=list."""
+    return [(group.key, json_tree(group.groups) if group.groups else [(field.key, '0') for field in group.fields])
+            for group in groups]
+
+
+def json_format_layout(message):
+    """Layout of the printf format of the message, kept byte for byte so that the payload does not change."""
+    text = ''.join(message.schema['json_format'])
+    literals = text.split('%f')
+    fields = message.fields()
+    if len(literals) != len(fields) + 1:
+        raise ValueError('message %s: json_format holds %d values, the groups %d'
+                         % (message.name, len(literals) - 1, len(fields)))
+    if json.loads(text.replace('%f', '0'), object_pairs_hook=list) != json_tree(message.groups):
+        raise ValueError('message %s: json_format keys differ from the groups' % message.name)
+
+    tokens = [literals[0].encode()]
+    for field, literal in zip(fields, literals[1:]):
+        tokens += [field, literal.encode()]
+    return tokens
+
+
+def json_layout(message):
+    if 'json_format' in message.schema:
+        return json_format_layout(message)
+
+    tokens = []
+
+    def walk(group):
+        append_literal(tokens, json.dumps(group.key).encode() + b':{')
+        for index, child in enumerate(group.children()):
+            if index:
+                append_literal(tokens, b',')
+            if isinstance(child, Field):
+                append_literal(tokens, json.dumps(child.key).encode() + b':"')
+                tokens.append(child)
+                append_literal(tokens, b'"')
+            else:
+                walk(child)
+        append_literal(tokens, b'}')
+
+    append_literal(tokens, b'{')
+    for index, group in enumerate(message.groups):
+        if index:
+            append_literal(tokens, b',')
+        walk(group)
+    append_literal(tokens, b'}')
+    return tokens
+
+
+def cbor_head(major, value):
+    if value < 24:
+        return bytes([(major << 5) | value])
+    if value < 0x100:
+        return bytes([(major << 5) | 24, value])
+    return bytes([(major << 5) | 25]) + value.to_bytes(2, 'big')
+
+
+def cbor_text(text):
+    data = text.encode()
+    return cbor_head(3, len(data)) + data
+
+
+def cbor_layout(message):
+    tokens = []
+
+    def walk(group):
+        append_literal(tokens, cbor_text(group.key) + cbor_head(5, len(group.children())))
+        for child in group.children():
+            if isinstance(child, Field):
+                append_literal(tokens, cbor_text(child.key))
+                tokens.append(child)
+            else:
+                walk(child)
+
+    append_literal(tokens, cbor_head(5, len(message.groups)))
+    for group in message.groups:
+        walk(group)
+    return tokens
+
+
+def layout_size(tokens, value_size):
+    literal = sum(len(t) for t in tokens if isinstance(t, bytes))
+    values = sum(1 for t in tokens if isinstance(t, Field))
+    return literal + values * value_size
+
+
+def c_literal(data):
+    """C string literal of data. Octal escapes never swallow the characters that follow them."""
+    out = []
+    for byte in data:
+        char = chr(byte)
+        if char in '"\\?':
+            out.append('\\' + char)
+        elif char in C_ESCAPES:
+            out.append(C_ESCAPES[char])
+        elif not 0x20 <= byte < 0x7f:
+            out.append('\\%03o' % byte)
+        else:
+            out.append(char)
+    return '"' + ''.join(out) + '"'
+
+
+# ------------------------------------------------------------------------------------------------------------------
+# Firmware encoders
+# ------------------------------------------------------------------------------------------------------------------
+
+def banner(file_name, description):
+    return ('/' + BANNER_LINE + '\n'
+            ' * File Name    : %s\n'
+            ' * Description  : %s\n'
+            ' *                Generated by script/cloud_app_msg_gen.py from src/cloud_app/cloud_app_msg.json, do not edit\n'
+            ' ' + BANNER_LINE[1:] + '/\n') % (file_name, description)
+
+
+def firmware_header(messages):
+    out = [banner('cloud_app_msg.h', 'CloudApp telemetry messages and their specialised encoders'),
+           '#ifndef CLOUD_APP_MSG_H\n#define CLOUD_APP_MSG_H\n\n'
+           '#include <stdint.h>\n#include <stddef.h>\n#include <math.h>\n\n']
+
+    for message in messages:
+        out.append('/** @brief Values of the %s message */\ntypedef struct\n{\n' % message.topic)
+        if message.includes:
+            for included in message.includes:
+                out.append('    %s %s;\n' % (included.type_name, member_name(included)))
+        else:
+            for field in message.fields():
+                out.append('    %s %s;\n' % (C_TYPES[field.type], field.member))
+        out.append('}%s;\n\n' % message.type_name)
+
+    width = max(len(message.macro) for message in messages) + len('_JSON_SIZE_MAX') + 1
+    for message in messages:
+        out.append('#define %s"%s"\n' % ((message.macro + '_TOPIC').ljust(width), message.topic))
+        out.append('#define %s(%du)\n' % ((message.macro + '_JSON_SIZE_MAX').ljust(width),
+                                         layout_size(json_layout(message), FIXED_SIZE_MAX)))
+        out.append('#define %s(%du)\n' % ((message.macro + '_CBOR_SIZE_MAX').ljust(width),
+                                         layout_size(cbor_layout(message), VALUE_SIZE_MAX)))
+    out.append('\n')
+
+    for message in messages:
+        out.append('/**\n'
+                   ' * @brief Write the JSON payload of msg, values as %%f text.\n'
+                   ' * @return Payload length, 0 if size is under %s_JSON_SIZE_MAX.\n'
+                   ' */\n'
+                   'size_t CloudAppMsg_Encode%sJson(const %s *msg, char *buffer, size_t size);\n\n'
+                   % (message.macro, message.name, message.type_name))
+        out.append('/**\n'
+                   ' * @brief Write the CBOR payload of msg, values at the precision the schema declares.\n'
+                   ' * @return Payload length, 0 if size is under %s_CBOR_SIZE_MAX.\n'
+                   ' */\n'
+                   'size_t CloudAppMsg_Encode%sCbor(const %s *msg, uint8_t *buffer, size_t size);\n\n'
+                   % (message.macro, message.name, message.type_name))
+
+    out.append('#endif //CLOUD_APP_MSG_H\n')
+    return ''.join(out)
+
+
+def firmware_encoder(message, kind):
+    if kind == 'Json':
+        tokens, buffer_type = json_layout(message), 'char'
+    else:
+        tokens, buffer_type = cbor_layout(message), 'uint8_t'
+
+    out = ['size_t CloudAppMsg_Encode%s%s(const %s *msg, %s *buffer, size_t size)\n{\n'
+           '    %s *out = buffer;\n'
+           '    size_t length = 0u;\n\n'
+           '    if(size >= %s_%s_SIZE_MAX)\n    {\n'
+           % (message.name, kind, message.type_name, buffer_type, buffer_type, message.macro, kind.upper())]
+    for token in tokens:
+        if isinstance(token, bytes):
+            out.append('        CLOUD_APP_MSG_PUT(out, %s);\n' % c_literal(token))
+        elif kind == 'Json':
+            out.append('        out = CloudApp_TelemetryWriteFixed(out, (double)%s);\n' % token.access)
+        else:
+            out.append('        out = CloudApp_TelemetryWriteValue(out, (float_t)%s, %d);\n'
+                       % (token.access, token.precision))
+    out.append('        length = (size_t)(out - buffer);\n    }\n\n    return length;\n}\n\n')
+    return ''.join(out)
+
+
+def firmware_source(messages):
+    out = [banner('cloud_app_msg.c', 'Specialised encoders of the CloudApp telemetry messages'),
+           '\n#include <string.h>\n#include <cloud_app_msg.h>\n#include <cloud_app_telemetry.h>\n\n'
+           '#if (CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX != %du) || (CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX != %du)\n'
+           '#error "Value sizes changed in cloud_app_telemetry.h, update script/cloud_app_msg_gen.py and regenerate"\n'
+           '#endif\n\n'
+           '/** @brief Copy a string literal without its terminating NUL, then move out past it */\n'
+           '#define CLOUD_APP_MSG_PUT(out, literal)     do { memcpy((out), (literal), sizeof(literal) - 1u); \\\n'
+           '                                                 (out) += sizeof(literal) - 1u; } while(0)\n\n'
+           % (FIXED_SIZE_MAX, VALUE_SIZE_MAX)]
+    for message in messages:
+        out.append(firmware_encoder(message, 'Json'))
+        out.append(firmware_encoder(message, 'Cbor'))
+    return ''.join(out).rstrip('\n') + '\n'
+
+
+# ------------------------------------------------------------------------------------------------------------------
+# Host decoders
+# ------------------------------------------------------------------------------------------------------------------
+
+HOST_HELPERS = r'''
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+/** @brief Check that the payload at *in starts with literal, then move *in past it */
+static bool CloudAppMsg_Expect(const uint8_t **in, const uint8_t *end, const char *literal, size_t length)
+{
+    bool ok = ((size_t)(end - *in) >= length) && (memcmp(*in, literal, length) == 0);
+
+    if(ok)
+    {
+        *in += length;
+    }
+    return ok;
+}
+
+/** @brief Read the text of a JSON string value up to its closing quote, left for the next literal */
+static bool CloudAppMsg_ReadJson(const uint8_t **in, const uint8_t *end, double *value)
+{
+    char text[32];
+    char *textEnd;
+    size_t length = 0u;
+
+    while(((*in + length) < end) && ((*in)[length] != '"') && (length < (sizeof(text) - 1u)))
+    {
+        text[length] = (char)(*in)[length];
+        length++;
+    }
+    text[length] = '\0';
+    *value = strtod(text, &textEnd);
+    *in += length;
+    return (length > 0u) && (textEnd == &text[length]);
+}
+
+/** @brief Read an unsigned CBOR argument of the additional information info */
+static bool CloudAppMsg_ReadCborArgument(const uint8_t **in, const uint8_t *end, uint8_t info, uint64_t *argument)
+{
+    size_t size = (info < 24u) ? 0u : ((info <= 27u) ? ((size_t)1u << (info - 24u)) : 9u);
+    bool ok = (size <= 8u) && ((size_t)(end - *in) >= size);
+
+    *argument = (info < 24u) ? info : 0u;
+    for(size_t byte = 0u; ok && (byte < size); byte++)
+    {
+        *argument = (*argument << 8) | (*in)[byte];
+    }
+    if(ok)
+    {
+        *in += size;
+    }
+    return ok;
+}
+
+/** @brief Read an integer, a half, single or double float, or a decimal fraction (tag 4) */
+static bool CloudAppMsg_ReadCbor(const uint8_t **in, const uint8_t *end, double *value)
+{
+    uint64_t argument = 0u;
+    uint8_t initial = 0u;
+    bool ok = (*in < end);
+    double exponent = 0.0;
+    double mantissa = 0.0;
+
+    if(ok)
+    {
+        initial = *(*in)++;
+        ok = CloudAppMsg_ReadCborArgument(in, end, initial & 0x1fu, &argument);
+    }
+
+    if(!ok)
+    {
+        /* Truncated payload */
+    }
+    else if((initial >> 5) == 0u)
+    {
+        *value = (double)argument;
+    }
+    else if((initial >> 5) == 1u)
+    {
+        *value = -1.0 - (double)argument;
+    }
+    else if(initial == 0xf9u)
+    {
+        int halfExponent = (int)((argument >> 10) & 0x1fu);
+        double halfMantissa = (double)(argument & 0x3ffu);
+
+        if(halfExponent == 0)
+        {
+            *value = ldexp(halfMantissa, -24);
+        }
+        else if(halfExponent == 31)
+        {
+            *value = (halfMantissa == 0.0) ? INFINITY : NAN;
+        }
+        else
+        {
+            *value = ldexp(halfMantissa + 1024.0, halfExponent - 25);
+        }
+        *value = ((argument & 0x8000u) != 0u) ? -*value : *value;
+    }
+    else if(initial == 0xfau)
+    {
+        uint32_t bits = (uint32_t)argument;
+        float single;
+
+        memcpy(&single, &bits, sizeof(single));
+        *value = single;
+    }
+    else if(initial == 0xfbu)
+    {
+        memcpy(value, &argument, sizeof(*value));
+    }
+    else if(initial == 0xc4u)
+    {
+        ok = CloudAppMsg_Expect(in, end, "\202", 1u)
+             && CloudAppMsg_ReadCbor(in, end, &exponent)
+             && CloudAppMsg_ReadCbor(in, end, &mantissa);
+        /* Dividing by an exact power of ten gives the nearest double of the decimal value */
+        *value = (exponent < 0.0) ? (mantissa / pow(10.0, -exponent)) : (mantissa * pow(10.0, exponent));
+    }
+    else
+    {
+        ok = false;
+    }
+
+    return ok;
+}
+'''
+
+
+def host_header(messages):
+    out = [banner('cloud_app_msg_decode.h', 'Host decoders of the CloudApp telemetry messages'),
+           '#ifndef CLOUD_APP_MSG_DECODE_H\n#define CLOUD_APP_MSG_DECODE_H\n\n'
+           '/* Build on the host with the firmware header in the include path, e.g.\n'
+           ' * cc -I src/cloud_app -c script/host/cloud_app_msg_decode.c */\n\n'
+           '#include <stdbool.h>\n#include <cloud_app_msg.h>\n\n']
+    for message in messages:
+        out.append('/** @brief Decode a payload written by CloudAppMsg_Encode%sJson, false if it is not one */\n'
+                   'bool CloudAppMsg_Decode%sJson(const char *payload, size_t length, %s *msg);\n\n'
+                   % (message.name, message.name, message.type_name))
+        out.append('/** @brief Decode a payload written by CloudAppMsg_Encode%sCbor, false if it is not one */\n'
+                   'bool CloudAppMsg_Decode%sCbor(const uint8_t *payload, size_t length, %s *msg);\n\n'
+                   % (message.name, message.name, message.type_name))
+    out.append('#endif //CLOUD_APP_MSG_DECODE_H\n')
+    return ''.join(out)
+
+
+def host_decoder(message, kind):
+    tokens = json_layout(message) if kind == 'Json' else cbor_layout(message)
+    payload_type = 'char' if kind == 'Json' else 'uint8_t'
+    fields = message.fields()
+
+    out = ['bool CloudAppMsg_Decode%s%s(const %s *payload, size_t length, %s *msg)\n{\n'
+           '    const uint8_t *in = (const uint8_t *)payload;\n'
+           '    const uint8_t *end = in + length;\n'
+           '    double values[%du];\n'
+           '    bool ok = true;\n\n'
+           % (message.name, kind, payload_type, message.type_name, len(fields))]
+    index = 0
+    for token in tokens:
+        if isinstance(token, bytes):
+            line = '    ok = ok && CloudAppMsg_Expect(&in, end, %s, %du);\n' % (c_literal(token), len(token))
+            if len(line) > 121:
+                line = ('    ok = ok && CloudAppMsg_Expect(&in, end,\n'
+                        '                                  %s,\n'
+                        '                                  %du);\n' % (c_literal(token), len(token)))
+            out.append(line)
+        else:
+            out.append('    ok = ok && CloudAppMsg_Read%s(&in, end, &values[%d]);\n' % (kind, index))
+            index += 1
+    out.append('\n    if(ok && (in == end))\n    {\n')
+    for index, field in enumerate(fields):
+        out.append('        %s = %s;\n' % (field.access, HOST_CASTS[field.type].format(v='values[%d]' % index)))
+    out.append('    }\n\n    return ok && (in == end);\n}\n\n')
+    return ''.join(out)
+
+
+def host_source(messages):
+    out = [banner('cloud_app_msg_decode.c', 'Host decoders of the CloudApp telemetry messages'),
+           '\n#include <string.h>\n#include <stdlib.h>\n#include <math.h>\n#include "cloud_app_msg_decode.h"\n',
+           HOST_HELPERS,
+           '\n/' + '*' * 118 + '\n                                    GLOBAL FUNCTIONS\n' + '*' * 118 + '/\n']
+    for message in messages:
+        out.append(host_decoder(message, 'Json'))
+        out.append(host_decoder(message, 'Cbor'))
+    return ''.join(out).rstrip('\n') + '\n'
+
+
+def write(path, text):
+    with open(path, 'w', newline='\n') as output:
+        output.write(text)
+
+
+def main():
+    schema_path = sys.argv[1] if len(sys.argv) > 1 else SCHEMA
+    with open(schema_path) as schema_file:
+        schema = json.load(schema_file)
+
+    messages = {}
+    for message_schema in schema['messages']:
+        messages[message_schema['name']] = Message(message_schema, messages)
+    ordered = list(messages.values())
+
+    write(os.path.join(FIRMWARE_DIR, 'cloud_app_msg.h'), firmware_header(ordered))
+    write(os.path.join(FIRMWARE_DIR, 'cloud_app_msg.c'), firmware_source(ordered))
+    write(os.path.join(HOST_DIR, 'cloud_app_msg_decode.h'), host_header(ordered))
+    write(os.path.join(HOST_DIR, 'cloud_app_msg_decode.c'), host_source(ordered))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Turn the binary console logs of a CONSOLE_LOG_BINARY build back into text.
+
+APP_*_PRINT sends a frame per log instead of text: sync byte 0xC5, frame length, 32-bit ID of the log site and the
+raw arguments (see CONSOLE_LOG_FRAME in src/console/console_log.h). The ID is the offset of the format in the
+.console_log_fmt section of the ELF file, which is not loaded on the target. Arguments are sized from the format:
+32 bits for integers, chars and pointers, 64 bits for long long, floating point values are floats. %s arguments
+are read from the loaded sections of the ELF file when they point to flash, strings in RAM are shown by address.
+Console text, which is ASCII, is passed through as it comes.
+
+Usage:
+    python3 script/console_log_decode.py firmware.elf [--port /dev/ttyACM0] [--baud 115200]
+    python3 script/console_log_decode.py firmware.elf --tcp localhost:19021      J-Link RTT telnet server
+    python3 script/console_log_decode.py firmware.elf < capture.bin
+"""
+
+import argparse
+import re
+import socket
+import struct
+import sys
+
+FRAME_SYNC = 0xC5
+FRAME_HEADER_SIZE = 6
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXcsfFeEgGaAp%])')
+
+
+class Elf:
+    """Sections of a 32-bit little-endian ELF file, enough to read the format table and strings in flash."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as elf:
+            self.data = elf.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError('%s: not a 32-bit little-endian ELF file' % path)
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x2E)
+        headers = [struct.unpack_from('<IIIIIIIIII', self.data, shoff + index * shentsize) for index in range(shnum)]
+        names = headers[shstrndx][4]
+        self.sections = {}
+        self.loaded = []
+        for name, kind, flags, address, offset, size, _, _, _, _ in headers:
+            section = (address, offset, size)
+            self.sections[self.string(names + name)] = section
+            if (flags & SHF_ALLOC) and kind != SHT_NOBITS and size != 0:
+                self.loaded.append(section)
+
+    def string(self, offset):
+        return self.data[offset:self.data.index(b'\0', offset)].decode('latin-1')
+
+    def format(self, site):
+        address, offset, size = self.sections['.console_log_fmt']
+        if not address <= site < address + size:
+            return None
+        return self.string(offset + site - address)
+
+    def flash_string(self, pointer):
+        for address, offset, size in self.loaded:
+            if address <= pointer < address + size:
+                return self.string(offset + pointer - address)
+        return None
+
+
+def arguments(fmt):
+    """Size and kind of each argument the format takes, as (size, kind) with kind in 'i', 'l', 'f', 's'."""
+    taken = []
+    for flags, width, precision, length, conversion in CONVERSION.findall(fmt):
+        if conversion == '%':
+            continue
+        if width == '*':
+            taken.append((4, 'i'))
+        if precision == '*':
+            taken.append((4, 'i'))
+        if conversion == 's':
+            taken.append((4, 's'))
+        elif conversion in 'fFeEgGaA':
+            taken.append((4, 'f'))
+        elif length in ('ll', 'j'):
+            taken.append((8, 'l'))
+        else:
+            taken.append((4, 'i'))
+    return taken
+
+
+def render(elf, fmt, payload):
+    """Format the payload of a frame as printf would have on the target, None if it does not match the format."""
+    values = []
+    position = 0
+    for size, kind in arguments(fmt):
+        if position + size > len(payload):
+            return None
+        raw = payload[position:position + size]
+        position += size
+        if kind == 'f':
+            values.append(struct.unpack('<f', raw)[0])
+        elif kind == 'l':
+            values.append(struct.unpack('<q', raw)[0])
+        elif kind == 's':
+            pointer, = struct.unpack('<I', raw)
+            text = elf.flash_string(pointer)
+            values.append(text if text is not None else '<0x%08x>' % pointer)
+        else:
+            values.append(struct.unpack('<i', raw)[0])
+    if position != len(payload):
+        return None
+
+    def substitute(match):
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if width == '*':
+            width = str(values.pop(0))
+        if precision == '*':
+            precision = str(values.pop(0))
+        value = values.pop(0)
+        if conversion in 'ouxX' and value < 0:
+            value += 1 << (64 if length in ('ll', 'j') else 32)
+        if conversion == 'c':
+            value = chr(value & 0xFF)
+        elif conversion == 'p':
+            conversion, value = 'x', value & 0xFFFFFFFF
+        spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '') + conversion
+        return spec % value
+
+    return CONVERSION.sub(substitute, fmt)
+
+
+def decode(elf, read, write):
+    """Pass console text through and replace each frame read by its text, until read returns nothing."""
+    pending = b''
+    while True:
+        chunk = read()
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            sync = pending.find(bytes([FRAME_SYNC]))
+            if sync != 0:
+                text = pending if sync < 0 else pending[:sync]
+                write(text.decode('latin-1'))
+                pending = pending[len(text):]
+                continue
+            if len(pending) < FRAME_HEADER_SIZE or len(pending) < pending[1]:
+                break
+            length = pending[1]
+            site, = struct.unpack_from('<I', pending, 2)
+            fmt = elf.format(site) if length >= FRAME_HEADER_SIZE else None
+            text = render(elf, fmt, pending[FRAME_HEADER_SIZE:length]) if fmt is not None else None
+            if text is None:
+                # Not a frame of this firmware, resynchronise on the next sync byte
+                write('<?%02x>' % FRAME_SYNC)
+                pending = pending[1:]
+            else:
+                write(text)
+                pending = pending[length:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('elf', help='ELF file of the running firmware')
+    parser.add_argument('--port', help='serial port of the console UART, standard input if not given')
+    parser.add_argument('--baud', type=int, default=115200, help='baud rate of the console UART')
+    parser.add_argument('--tcp', help='host:port of an RTT telnet server')
+    options = parser.parse_args()
+
+    elf = Elf(options.elf)
+    if '.console_log_fmt' not in elf.sections:
+        sys.exit('%s: no .console_log_fmt section, build with CONSOLE_LOG_BINARY' % options.elf)
+
+    if options.tcp:
+        host, port = options.tcp.rsplit(':', 1)
+        connection = socket.create_connection((host, int(port)))
+        read = lambda: connection.recv(4096)
+    elif options.port:
+        import termios
+        import tty
+        port = open(options.port, 'rb', buffering=0)
+        tty.setraw(port.fileno())
+        attributes = termios.tcgetattr(port.fileno())
+        attributes[4] = attributes[5] = getattr(termios, 'B%d' % options.baud)
+        termios.tcsetattr(port.fileno(), termios.TCSANOW, attributes)
+        read = lambda: port.read(4096)
+    else:
+        read = lambda: sys.stdin.buffer.read1(4096)
+
+    def write(text):
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    try:
+        decode(elf, read, write)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
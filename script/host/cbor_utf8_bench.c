@@ -0,0 +1,341 @@
+/***********************************************************************************************************************
+ * File Name    : cbor_utf8_bench.c
+ * Description  : Host test and benchmark of the UTF-8 validation of tinycbor text strings, on fleet provisioning
+ *                responses as cloud_prov_serializer.c validates them
+ **********************************************************************************************************************/
+
+/* Build and run on the host from the repository root, e.g.
+ * cc -O2 -I src/cloud_prov/tinycbor/src script/host/cbor_utf8_bench.c \
+ *    src/cloud_prov/tinycbor/src/cborparser.c src/cloud_prov/tinycbor/src/cborvalidation.c \
+ *    src/cloud_prov/tinycbor/src/cborencoder.c src/cloud_prov/tinycbor/src/cborerrorstrings.c -lm -o cbor_utf8_bench
+ * ./cbor_utf8_bench
+ * Exits with 1 if validate_utf8_string of cborvalidation.c and the scalar get_utf8 loop it replaced disagree. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cbor.h"
+#include "utf8_p.h"
+
+/**********************************************************************************************************************
+                                    MACRO DEFINITIONS
+**********************************************************************************************************************/
+#define CBOR_UTF8_BENCH_RANDOM_STRINGS      (200000u)
+#define CBOR_UTF8_BENCH_RANDOM_MAX_LENGTH   (64u)
+#define CBOR_UTF8_BENCH_ITERATIONS          (20000u)
+#define CBOR_UTF8_BENCH_PAYLOAD_SIZE        (4096u)
+#define CBOR_UTF8_BENCH_ALIGNMENTS          (8u)
+
+/**********************************************************************************************************************
+                                    TYPE DEFINITIONS
+**********************************************************************************************************************/
+typedef struct
+{
+    const char *text;
+    size_t length;
+    bool valid;
+}CborUtf8Vector_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t payload[CBOR_UTF8_BENCH_PAYLOAD_SIZE];
+    size_t length;
+}CborUtf8Payload_t;
+
+/**********************************************************************************************************************
+                                    LOCAL VARIABLES
+**********************************************************************************************************************/
+
+/** @brief UTF-8 cases of the tinycbor validation tests (tests/parser/tst_parser.cpp, validation_data) */
+#define CBOR_UTF8_VECTOR(text, valid)   { text, sizeof(text) - 1u, valid }
+static const CborUtf8Vector_t CborUtf8Vectors[] =
+        {
+            CBOR_UTF8_VECTOR("", true),
+            CBOR_UTF8_VECTOR("a", true),
+            CBOR_UTF8_VECTOR("\x7f", true),
+            CBOR_UTF8_VECTOR("\xc2\x80", true),
+            CBOR_UTF8_VECTOR("\xdf\xbf", true),
+            CBOR_UTF8_VECTOR("\xe0\xa0\x80", true),
+            CBOR_UTF8_VECTOR("\xef\xbf\xbf", true),
+            CBOR_UTF8_VECTOR("\xf0\x90\x80\x80", true),
+            CBOR_UTF8_VECTOR("\xf4\x8f\xbf\xbf", true),
+            CBOR_UTF8_VECTOR("\x80", false),
+            CBOR_UTF8_VECTOR("\xbf", false),
+            CBOR_UTF8_VECTOR("\xc0\x80", false),
+            CBOR_UTF8_VECTOR("\xc1\xbf", false),
+            CBOR_UTF8_VECTOR("\xc2", false),
+            CBOR_UTF8_VECTOR("\xc2\x7f", false),
+            CBOR_UTF8_VECTOR("\xe0\x80\x80", false),
+            CBOR_UTF8_VECTOR("\xe0\x9f\xbf", false),
+            CBOR_UTF8_VECTOR("\xe0\xa0", false),
+            CBOR_UTF8_VECTOR("\xed\xa0\x80", false),
+            CBOR_UTF8_VECTOR("\xed\xbf\xbf", false),
+            CBOR_UTF8_VECTOR("\xf0\x80\x80\x80", false),
+            CBOR_UTF8_VECTOR("\xf0\x8f\xbf\xbf", false),
+            CBOR_UTF8_VECTOR("\xf0\x90\x80", false),
+            CBOR_UTF8_VECTOR("\xf4\x90\x80\x80", false),
+            CBOR_UTF8_VECTOR("\xf5\x80\x80\x80", false),
+            CBOR_UTF8_VECTOR("\xff", false),
+        };
+
+static CborUtf8Payload_t CborUtf8Payloads[2] =
+        {
+            { .name = "CreateCertificateFromCsr" },
+            { .name = "CreateKeysAndCertificate" },
+        };
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+
+/** @brief validate_utf8_string before the word-at-a-time ASCII fast path, the reference of the tests */
+static bool CborUtf8_ScalarValid(const uint8_t *buffer, size_t length)
+{
+    const uint8_t * const end = buffer + length;
+
+    while (buffer < end)
+    {
+        if (get_utf8(&buffer, end) == ~0U)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Validate text as the single text string of a CBOR item, through cbor_value_validate */
+static bool CborUtf8_CborValid(const uint8_t *text, size_t length)
+{
+    static uint8_t item[CBOR_UTF8_BENCH_PAYLOAD_SIZE];
+    CborEncoder encoder;
+    CborParser parser;
+    CborValue value;
+
+    cbor_encoder_init(&encoder, item, sizeof(item), 0);
+    if ((cbor_encode_text_string(&encoder, (const char *)text, length) != CborNoError) ||
+        (cbor_parser_init(item, cbor_encoder_get_buffer_size(&encoder, item), 0, &parser, &value) != CborNoError))
+    {
+        fprintf(stderr, "Could not encode a %zu byte text string\n", length);
+        exit(1);
+    }
+    return (cbor_value_validate(&value, CborValidateUtf8) == CborNoError);
+}
+
+/** @brief Base64 text of length chars, in lines of 64 chars as AWS IoT sends them when lineFeeds is set */
+static void CborUtf8_Base64(char *text, size_t length, bool lineFeeds)
+{
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (size_t position = 0u; position < length; position++)
+    {
+        text[position] = (lineFeeds && ((position % 65u) == 64u)) ? '\n' : base64[rand() % 64];
+    }
+}
+
+/** @brief PEM block of about length bytes */
+static size_t CborUtf8_Pem(char *pem, const char *label, size_t length)
+{
+    size_t position = (size_t)sprintf(pem, "-----BEGIN %s-----\n", label);
+    size_t bodyLength = length - (2u * position);
+
+    CborUtf8_Base64(&pem[position], bodyLength, true);
+    position += bodyLength;
+    position += (size_t)sprintf(&pem[position], "\n-----END %s-----", label);
+    return position;
+}
+
+/** @brief Response map of the fleet provisioning API, text values sized as AWS IoT sends them */
+static void CborUtf8_BuildPayload(CborUtf8Payload_t *payload, bool withPrivateKey)
+{
+    static char text[CBOR_UTF8_BENCH_PAYLOAD_SIZE];
+    CborEncoder encoder;
+    CborEncoder map;
+    size_t length;
+
+    cbor_encoder_init(&encoder, payload->payload, sizeof(payload->payload), 0);
+    (void)cbor_encoder_create_map(&encoder, &map, withPrivateKey ? 4u : 3u);
+    (void)cbor_encode_text_stringz(&map, "certificateId");
+    (void)cbor_encode_text_stringz(&map, "8f1b4f2a9c3d7e6b5a4c3b2a1f0e9d8c7b6a5f4e3d2c1b0a9f8e7d6c5b4a3f2e");
+    (void)cbor_encode_text_stringz(&map, "certificatePem");
+    length = CborUtf8_Pem(text, "CERTIFICATE", 1224u);
+    (void)cbor_encode_text_string(&map, text, length);
+    if (withPrivateKey)
+    {
+        (void)cbor_encode_text_stringz(&map, "privateKey");
+        length = CborUtf8_Pem(text, "RSA PRIVATE KEY", 1675u);
+        (void)cbor_encode_text_string(&map, text, length);
+    }
+    (void)cbor_encode_text_stringz(&map, "certificateOwnershipToken");
+    CborUtf8_Base64(text, 584u, false);
+    (void)cbor_encode_text_string(&map, text, 584u);
+    (void)cbor_encoder_close_container(&encoder, &map);
+    payload->length = cbor_encoder_get_buffer_size(&encoder, payload->payload);
+}
+
+static double CborUtf8_Seconds(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+/** @brief Mean time of cbor_value_validate on payload, in microseconds */
+static double CborUtf8_BenchValidate(const CborUtf8Payload_t *payload, uint32_t flags)
+{
+    CborParser parser;
+    CborValue value;
+    double start;
+    uint32_t errors = 0u;
+
+    start = CborUtf8_Seconds();
+    for (uint32_t iteration = 0u; iteration < CBOR_UTF8_BENCH_ITERATIONS; iteration++)
+    {
+        (void)cbor_parser_init(payload->payload, payload->length, 0, &parser, &value);
+        errors += (cbor_value_validate(&value, flags) != CborNoError);
+    }
+    if (errors != 0u)
+    {
+        fprintf(stderr, "%s payload does not validate\n", payload->name);
+        exit(1);
+    }
+    return ((CborUtf8_Seconds() - start) * 1e6) / CBOR_UTF8_BENCH_ITERATIONS;
+}
+
+/** @brief Mean time of the scalar loop over the text strings of payload, in microseconds */
+static double CborUtf8_BenchScalar(const CborUtf8Payload_t *payload)
+{
+    CborParser parser;
+    CborValue map;
+    CborValue item;
+    const char *text;
+    size_t length;
+    double start;
+    uint32_t errors = 0u;
+
+    start = CborUtf8_Seconds();
+    for (uint32_t iteration = 0u; iteration < CBOR_UTF8_BENCH_ITERATIONS; iteration++)
+    {
+        (void)cbor_parser_init(payload->payload, payload->length, 0, &parser, &map);
+        (void)cbor_value_enter_container(&map, &item);
+        while (!cbor_value_at_end(&item))
+        {
+            CborValue string = item;
+            (void)cbor_value_begin_string_iteration(&string);
+            (void)cbor_value_get_text_string_chunk(&string, &text, &length, &string);
+            errors += (CborUtf8_ScalarValid((const uint8_t *)text, length) != true);
+            (void)cbor_value_advance(&item);
+        }
+    }
+    if (errors != 0u)
+    {
+        fprintf(stderr, "%s payload does not validate\n", payload->name);
+        exit(1);
+    }
+    return ((CborUtf8_Seconds() - start) * 1e6) / CBOR_UTF8_BENCH_ITERATIONS;
+}
+
+/** @brief Check every vector at every alignment, behind and in front of ASCII, against its expected result */
+static uint32_t CborUtf8_TestVectors(void)
+{
+    uint8_t text[64];
+    uint32_t failures = 0u;
+
+    for (size_t vector = 0u; vector < (sizeof(CborUtf8Vectors) / sizeof(CborUtf8Vectors[0])); vector++)
+    {
+        for (size_t prefix = 0u; prefix < CBOR_UTF8_BENCH_ALIGNMENTS; prefix++)
+        {
+            for (size_t suffix = 0u; suffix < CBOR_UTF8_BENCH_ALIGNMENTS; suffix++)
+            {
+                size_t length = prefix + CborUtf8Vectors[vector].length + suffix;
+
+                memset(text, 'A', length);
+                memcpy(&text[prefix], CborUtf8Vectors[vector].text, CborUtf8Vectors[vector].length);
+                if ((CborUtf8_CborValid(text, length) != CborUtf8Vectors[vector].valid) ||
+                    (CborUtf8_ScalarValid(text, length) != CborUtf8Vectors[vector].valid))
+                {
+                    fprintf(stderr, "Vector %zu with %zu ASCII bytes before and %zu after: expected %s\n",
+                            vector, prefix, suffix, CborUtf8Vectors[vector].valid ? "valid" : "invalid");
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+/** @brief Compare cbor_value_validate with the scalar loop on random strings, mostly ASCII with UTF-8 and noise */
+static uint32_t CborUtf8_TestRandom(void)
+{
+    static const char * const sequences[] = { "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\xa0\x80",
+                                              "\xc0\xaf", "\x80", "\xf4\x90\x80\x80", "\xe2\x82" };
+    uint8_t text[CBOR_UTF8_BENCH_RANDOM_MAX_LENGTH + 4u];
+    uint32_t failures = 0u;
+    uint32_t invalid = 0u;
+
+    for (uint32_t string = 0u; string < CBOR_UTF8_BENCH_RANDOM_STRINGS; string++)
+    {
+        size_t length = (size_t)rand() % CBOR_UTF8_BENCH_RANDOM_MAX_LENGTH;
+        size_t position = 0u;
+
+        while (position < length)
+        {
+            int kind = rand() % 32;
+            if (kind < 29)
+            {
+                text[position++] = (uint8_t)(0x20 + (rand() % 0x5f));
+            }
+            else if (kind < 31)
+            {
+                const char *sequence = sequences[rand() % (sizeof(sequences) / sizeof(sequences[0]))];
+                memcpy(&text[position], sequence, strlen(sequence));
+                position += strlen(sequence);
+            }
+            else
+            {
+                text[position++] = (uint8_t)rand();
+            }
+        }
+
+        if (CborUtf8_CborValid(text, position) != CborUtf8_ScalarValid(text, position))
+        {
+            failures++;
+        }
+        invalid += (CborUtf8_ScalarValid(text, position) != true);
+    }
+    printf("%u random strings, %u of them invalid, %u mismatches\n", CBOR_UTF8_BENCH_RANDOM_STRINGS, invalid,
+           failures);
+    return failures;
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+
+int main(void)
+{
+    uint32_t failures;
+
+    srand(42u);
+    failures = CborUtf8_TestVectors();
+    printf("%zu UTF-8 vectors at %u x %u alignments, %u failures\n",
+           sizeof(CborUtf8Vectors) / sizeof(CborUtf8Vectors[0]), CBOR_UTF8_BENCH_ALIGNMENTS,
+           CBOR_UTF8_BENCH_ALIGNMENTS, failures);
+    failures += CborUtf8_TestRandom();
+
+    CborUtf8_BuildPayload(&CborUtf8Payloads[0], false);
+    CborUtf8_BuildPayload(&CborUtf8Payloads[1], true);
+    printf("\n%-26s %8s %14s %14s %14s\n", "response", "bytes", "walk (us)", "UTF-8 (us)", "scalar (us)");
+    for (size_t payload = 0u; payload < (sizeof(CborUtf8Payloads) / sizeof(CborUtf8Payloads[0])); payload++)
+    {
+        double walk = CborUtf8_BenchValidate(&CborUtf8Payloads[payload], CborValidateBasic);
+        double utf8 = CborUtf8_BenchValidate(&CborUtf8Payloads[payload], CborValidateUtf8);
+
+        printf("%-26s %8zu %14.3f %14.3f %14.3f\n", CborUtf8Payloads[payload].name, CborUtf8Payloads[payload].length,
+               walk, utf8, CborUtf8_BenchScalar(&CborUtf8Payloads[payload]));
+    }
+
+    return (failures == 0u) ? 0 : 1;
+}
@@ -0,0 +1,613 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_msg_decode.c
+ * Description  : Host decoders of the CloudApp telemetry messages
+ *                Generated by script/cloud_app_msg_gen.py from src/cloud_app/cloud_app_msg.json, do not edit
+ **********************************************************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "cloud_app_msg_decode.h"
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+/** @brief Check that the payload at *in starts with literal, then move *in past it */
+static bool CloudAppMsg_Expect(const uint8_t **in, const uint8_t *end, const char *literal, size_t length)
+{
+    bool ok = ((size_t)(end - *in) >= length) && (memcmp(*in, literal, length) == 0);
+
+    if(ok)
+    {
+        *in += length;
+    }
+    return ok;
+}
+
+/** @brief Read the text of a JSON string value up to its closing quote, left for the next literal */
+static bool CloudAppMsg_ReadJson(const uint8_t **in, const uint8_t *end, double *value)
+{
+    char text[32];
+    char *textEnd;
+    size_t length = 0u;
+
+    while(((*in + length) < end) && ((*in)[length] != '"') && (length < (sizeof(text) - 1u)))
+    {
+        text[length] = (char)(*in)[length];
+        length++;
+    }
+    text[length] = '\0';
+    *value = strtod(text, &textEnd);
+    *in += length;
+    return (length > 0u) && (textEnd == &text[length]);
+}
+
+/** @brief Read an unsigned CBOR argument of the additional information info */
+static bool CloudAppMsg_ReadCborArgument(const uint8_t **in, const uint8_t *end, uint8_t info, uint64_t *argument)
+{
+    size_t size = (info < 24u) ? 0u : ((info <= 27u) ? ((size_t)1u << (info - 24u)) : 9u);
+    bool ok = (size <= 8u) && ((size_t)(end - *in) >= size);
+
+    *argument = (info < 24u) ? info : 0u;
+    for(size_t byte = 0u; ok && (byte < size); byte++)
+    {
+        *argument = (*argument << 8) | (*in)[byte];
+    }
+    if(ok)
+    {
+        *in += size;
+    }
+    return ok;
+}
+
+/** @brief Read an integer, a half, single or double float, or a decimal fraction (tag 4) */
+static bool CloudAppMsg_ReadCbor(const uint8_t **in, const uint8_t *end, double *value)
+{
+    uint64_t argument = 0u;
+    uint8_t initial = 0u;
+    bool ok = (*in < end);
+    double exponent = 0.0;
+    double mantissa = 0.0;
+
+    if(ok)
+    {
+        initial = *(*in)++;
+        ok = CloudAppMsg_ReadCborArgument(in, end, initial & 0x1fu, &argument);
+    }
+
+    if(!ok)
+    {
+        /* Truncated payload */
+    }
+    else if((initial >> 5) == 0u)
+    {
+        *value = (double)argument;
+    }
+    else if((initial >> 5) == 1u)
+    {
+        *value = -1.0 - (double)argument;
+    }
+    else if(initial == 0xf9u)
+    {
+        int halfExponent = (int)((argument >> 10) & 0x1fu);
+        double halfMantissa = (double)(argument & 0x3ffu);
+
+        if(halfExponent == 0)
+        {
+            *value = ldexp(halfMantissa, -24);
+        }
+        else if(halfExponent == 31)
+        {
+            *value = (halfMantissa == 0.0) ? INFINITY : NAN;
+        }
+        else
+        {
+            *value = ldexp(halfMantissa + 1024.0, halfExponent - 25);
+        }
+        *value = ((argument & 0x8000u) != 0u) ? -*value : *value;
+    }
+    else if(initial == 0xfau)
+    {
+        uint32_t bits = (uint32_t)argument;
+        float single;
+
+        memcpy(&single, &bits, sizeof(single));
+        *value = single;
+    }
+    else if(initial == 0xfbu)
+    {
+        memcpy(value, &argument, sizeof(*value));
+    }
+    else if(initial == 0xc4u)
+    {
+        ok = CloudAppMsg_Expect(in, end, "\202", 1u)
+             && CloudAppMsg_ReadCbor(in, end, &exponent)
+             && CloudAppMsg_ReadCbor(in, end, &mantissa);
+        /* Dividing by an exact power of ten gives the nearest double of the decimal value */
+        *value = (exponent < 0.0) ? (mantissa / pow(10.0, -exponent)) : (mantissa * pow(10.0, exponent));
+    }
+    else
+    {
+        ok = false;
+    }
+
+    return ok;
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+bool CloudAppMsg_DecodeIaqJson(const char *payload, size_t length, CloudAppMsgIaq_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[3u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"IAQ\" : {\r\n      \"TVOC (mg/m^3)\" :\"", 38u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Etoh (ppm)\" :\"", 25u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"eco2 (ppm)\" :\"", 25u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n     }\r\n}\r\n", 14u);
+
+    if(ok && (in == end))
+    {
+        msg->tvoc = (float_t)values[0];
+        msg->etoh = (float_t)values[1];
+        msg->eco2 = (float_t)values[2];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeIaqCbor(const uint8_t *payload, size_t length, CloudAppMsgIaq_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[3u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241cIAQ\243mTVOC (mg/m^3)", 20u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "jEtoh (ppm)", 11u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "jeco2 (ppm)", 11u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[2]);
+
+    if(ok && (in == end))
+    {
+        msg->tvoc = (float_t)values[0];
+        msg->etoh = (float_t)values[1];
+        msg->eco2 = (float_t)values[2];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeOaqJson(const char *payload, size_t length, CloudAppMsgOaq_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[1u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"OAQ\" : {\r\n      \"air quality (Index)\" :\"", 44u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n\r\n         }\r\n}\r\n", 20u);
+
+    if(ok && (in == end))
+    {
+        msg->airQuality = (float_t)values[0];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeOaqCbor(const uint8_t *payload, size_t length, CloudAppMsgOaq_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[1u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241cOAQ\241sair quality (Index)", 26u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+
+    if(ok && (in == end))
+    {
+        msg->airQuality = (float_t)values[0];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeHs3001Json(const char *payload, size_t length, CloudAppMsgHs3001_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[2u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"HS3001\" : {\r\n      \"Humidity ()\" :\"", 39u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Temperature (F)\" :\"", 30u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n\r\n         }\r\n}\r\n", 20u);
+
+    if(ok && (in == end))
+    {
+        msg->humidity = (float_t)values[0];
+        msg->temperature = (float_t)values[1];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeHs3001Cbor(const uint8_t *payload, size_t length, CloudAppMsgHs3001_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[2u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241fHS3001\242kHumidity ()", 21u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "oTemperature (F)", 16u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+
+    if(ok && (in == end))
+    {
+        msg->humidity = (float_t)values[0];
+        msg->temperature = (float_t)values[1];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeIcmJson(const char *payload, size_t length, CloudAppMsgIcm_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[9u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"ICM\" : {\r\n   \"acc\" : {\r\n      \"x \" :\"", 41u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n   \r\n      },\r\n   \"mag\" : {\r\n      \"x \" :\"", 45u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[3]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[4]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[5]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n   \r\n      },\r\n   \"gyr\" : {\r\n      \"x \" :\"", 45u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[6]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[7]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[8]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n   \r\n      }\r\n\r\n      }\r\n}\r\n", 31u);
+
+    if(ok && (in == end))
+    {
+        msg->accX = values[0];
+        msg->accY = values[1];
+        msg->accZ = values[2];
+        msg->magX = values[3];
+        msg->magY = values[4];
+        msg->magZ = values[5];
+        msg->gyrX = values[6];
+        msg->gyrY = values[7];
+        msg->gyrZ = values[8];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeIcmCbor(const uint8_t *payload, size_t length, CloudAppMsgIcm_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[9u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241cICM\243cacc\243bx ", 14u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cmag\243bx ", 8u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[3]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[4]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[5]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cgyr\243bx ", 8u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[6]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[7]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[8]);
+
+    if(ok && (in == end))
+    {
+        msg->accX = values[0];
+        msg->accY = values[1];
+        msg->accZ = values[2];
+        msg->magX = values[3];
+        msg->magY = values[4];
+        msg->magZ = values[5];
+        msg->gyrX = values[6];
+        msg->gyrY = values[7];
+        msg->gyrZ = values[8];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeIcpJson(const char *payload, size_t length, CloudAppMsgIcp_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[2u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"ICP\" : {\r\n      \"Temperature (F)\" :\"", 40u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Pressure (Pa)\" :\"", 28u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n\r\n         }\r\n}\r\n", 20u);
+
+    if(ok && (in == end))
+    {
+        msg->temperature = (float_t)values[0];
+        msg->pressure = (float_t)values[1];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeIcpCbor(const uint8_t *payload, size_t length, CloudAppMsgIcp_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[2u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241cICP\242oTemperature (F)", 22u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "mPressure (Pa)", 14u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+
+    if(ok && (in == end))
+    {
+        msg->temperature = (float_t)values[0];
+        msg->pressure = (float_t)values[1];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeOb1203Json(const char *payload, size_t length, CloudAppMsgOb1203_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[4u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"OB1203\" : {\r\n      \"spo2 ()\" :\"", 35u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Heart Rate ()\" :\"", 28u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Breath rate ()\" :\"", 29u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"P2P ()\" :\"", 21u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[3]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n\r\n         }\r\n}\r\n", 20u);
+
+    if(ok && (in == end))
+    {
+        msg->spo2 = (uint16_t)lround(values[0]);
+        msg->heartRate = (uint16_t)lround(values[1]);
+        msg->respirationRate = (uint16_t)lround(values[2]);
+        msg->perfusionIndex = (float_t)values[3];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeOb1203Cbor(const uint8_t *payload, size_t length, CloudAppMsgOb1203_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[4u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\241fOB1203\244gspo2 ()", 17u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "mHeart Rate ()", 14u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "nBreath rate ()", 15u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "fP2P ()", 7u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[3]);
+
+    if(ok && (in == end))
+    {
+        msg->spo2 = (uint16_t)lround(values[0]);
+        msg->heartRate = (uint16_t)lround(values[1]);
+        msg->respirationRate = (uint16_t)lround(values[2]);
+        msg->perfusionIndex = (float_t)values[3];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeBulkJson(const char *payload, size_t length, CloudAppMsgBulk_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[21u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "{\r\n\"IAQ\" : {\r\n      \"TVOC (mg/m^3)\" :\"", 38u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Etoh (ppm)\" :\"", 25u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"eco2 (ppm)\" :\"", 25u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end,
+                                  "\"\r\n          },\r\n\"OAQ\" : {\r\n      \"air quality (Index)\" :\"",
+                                  58u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[3]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n          },\r\n\"HS3001\" : {\r\n      \"Humidity ()\" :\"", 53u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[4]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Temperature (F)\" :\"", 30u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[5]);
+    ok = ok && CloudAppMsg_Expect(&in, end,
+                                  "\"\r\n             },\r\n\"ICM\" : {\r\n   \"acc\" : {\r\n      \"x \" :\"",
+                                  58u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[6]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[7]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[8]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n             },\r\n   \"mag\" : {\r\n      \"x \" :\"", 47u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[9]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[10]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[11]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n             },\r\n   \"gyr\" : {\r\n      \"x \" :\"", 47u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[12]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"y \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[13]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"z \" :\"", 17u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[14]);
+    ok = ok && CloudAppMsg_Expect(&in, end,
+                                  "\"\r\n             }\r\n         },\r\n\"ICP\" : {\r\n      \"Temperature (F)\" :\"",
+                                  69u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[15]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Pressure (Pa)\" :\"", 28u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[16]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n            },\r\n\"OB1203\" : {\r\n      \"spo2 ()\" :\"", 51u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[17]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Heart Rate ()\" :\"", 28u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[18]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"Breath rate ()\" :\"", 29u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[19]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\",\r\n      \"P2P ()\" :\"", 21u);
+    ok = ok && CloudAppMsg_ReadJson(&in, end, &values[20]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "\"\r\n              }\r\n}\r\n", 23u);
+
+    if(ok && (in == end))
+    {
+        msg->iaq.tvoc = (float_t)values[0];
+        msg->iaq.etoh = (float_t)values[1];
+        msg->iaq.eco2 = (float_t)values[2];
+        msg->oaq.airQuality = (float_t)values[3];
+        msg->hs3001.humidity = (float_t)values[4];
+        msg->hs3001.temperature = (float_t)values[5];
+        msg->icm.accX = values[6];
+        msg->icm.accY = values[7];
+        msg->icm.accZ = values[8];
+        msg->icm.magX = values[9];
+        msg->icm.magY = values[10];
+        msg->icm.magZ = values[11];
+        msg->icm.gyrX = values[12];
+        msg->icm.gyrY = values[13];
+        msg->icm.gyrZ = values[14];
+        msg->icp.temperature = (float_t)values[15];
+        msg->icp.pressure = (float_t)values[16];
+        msg->ob1203.spo2 = (uint16_t)lround(values[17]);
+        msg->ob1203.heartRate = (uint16_t)lround(values[18]);
+        msg->ob1203.respirationRate = (uint16_t)lround(values[19]);
+        msg->ob1203.perfusionIndex = (float_t)values[20];
+    }
+
+    return ok && (in == end);
+}
+
+bool CloudAppMsg_DecodeBulkCbor(const uint8_t *payload, size_t length, CloudAppMsgBulk_t *msg)
+{
+    const uint8_t *in = (const uint8_t *)payload;
+    const uint8_t *end = in + length;
+    double values[21u];
+    bool ok = true;
+
+    ok = ok && CloudAppMsg_Expect(&in, end, "\246cIAQ\243mTVOC (mg/m^3)", 20u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[0]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "jEtoh (ppm)", 11u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[1]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "jeco2 (ppm)", 11u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[2]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cOAQ\241sair quality (Index)", 25u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[3]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "fHS3001\242kHumidity ()", 20u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[4]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "oTemperature (F)", 16u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[5]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cICM\243cacc\243bx ", 13u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[6]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[7]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[8]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cmag\243bx ", 8u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[9]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[10]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[11]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cgyr\243bx ", 8u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[12]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "by ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[13]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "bz ", 3u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[14]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "cICP\242oTemperature (F)", 21u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[15]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "mPressure (Pa)", 14u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[16]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "fOB1203\244gspo2 ()", 16u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[17]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "mHeart Rate ()", 14u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[18]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "nBreath rate ()", 15u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[19]);
+    ok = ok && CloudAppMsg_Expect(&in, end, "fP2P ()", 7u);
+    ok = ok && CloudAppMsg_ReadCbor(&in, end, &values[20]);
+
+    if(ok && (in == end))
+    {
+        msg->iaq.tvoc = (float_t)values[0];
+        msg->iaq.etoh = (float_t)values[1];
+        msg->iaq.eco2 = (float_t)values[2];
+        msg->oaq.airQuality = (float_t)values[3];
+        msg->hs3001.humidity = (float_t)values[4];
+        msg->hs3001.temperature = (float_t)values[5];
+        msg->icm.accX = values[6];
+        msg->icm.accY = values[7];
+        msg->icm.accZ = values[8];
+        msg->icm.magX = values[9];
+        msg->icm.magY = values[10];
+        msg->icm.magZ = values[11];
+        msg->icm.gyrX = values[12];
+        msg->icm.gyrY = values[13];
+        msg->icm.gyrZ = values[14];
+        msg->icp.temperature = (float_t)values[15];
+        msg->icp.pressure = (float_t)values[16];
+        msg->ob1203.spo2 = (uint16_t)lround(values[17]);
+        msg->ob1203.heartRate = (uint16_t)lround(values[18]);
+        msg->ob1203.respirationRate = (uint16_t)lround(values[19]);
+        msg->ob1203.perfusionIndex = (float_t)values[20];
+    }
+
+    return ok && (in == end);
+}
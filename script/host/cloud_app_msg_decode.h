@@ -0,0 +1,57 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_msg_decode.h
+ * Description  : Host decoders of the CloudApp telemetry messages
+ *                Generated by script/cloud_app_msg_gen.py from src/cloud_app/cloud_app_msg.json, do not edit
+ **********************************************************************************************************************/
+#ifndef CLOUD_APP_MSG_DECODE_H
+#define CLOUD_APP_MSG_DECODE_H
+
+/* Build on the host with the firmware header in the include path, e.g.
+ * cc -I src/cloud_app -c script/host/cloud_app_msg_decode.c */
+
+#include <stdbool.h>
+#include <cloud_app_msg.h>
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIaqJson, false if it is not one */
+bool CloudAppMsg_DecodeIaqJson(const char *payload, size_t length, CloudAppMsgIaq_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIaqCbor, false if it is not one */
+bool CloudAppMsg_DecodeIaqCbor(const uint8_t *payload, size_t length, CloudAppMsgIaq_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeOaqJson, false if it is not one */
+bool CloudAppMsg_DecodeOaqJson(const char *payload, size_t length, CloudAppMsgOaq_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeOaqCbor, false if it is not one */
+bool CloudAppMsg_DecodeOaqCbor(const uint8_t *payload, size_t length, CloudAppMsgOaq_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeHs3001Json, false if it is not one */
+bool CloudAppMsg_DecodeHs3001Json(const char *payload, size_t length, CloudAppMsgHs3001_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeHs3001Cbor, false if it is not one */
+bool CloudAppMsg_DecodeHs3001Cbor(const uint8_t *payload, size_t length, CloudAppMsgHs3001_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIcmJson, false if it is not one */
+bool CloudAppMsg_DecodeIcmJson(const char *payload, size_t length, CloudAppMsgIcm_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIcmCbor, false if it is not one */
+bool CloudAppMsg_DecodeIcmCbor(const uint8_t *payload, size_t length, CloudAppMsgIcm_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIcpJson, false if it is not one */
+bool CloudAppMsg_DecodeIcpJson(const char *payload, size_t length, CloudAppMsgIcp_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeIcpCbor, false if it is not one */
+bool CloudAppMsg_DecodeIcpCbor(const uint8_t *payload, size_t length, CloudAppMsgIcp_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeOb1203Json, false if it is not one */
+bool CloudAppMsg_DecodeOb1203Json(const char *payload, size_t length, CloudAppMsgOb1203_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeOb1203Cbor, false if it is not one */
+bool CloudAppMsg_DecodeOb1203Cbor(const uint8_t *payload, size_t length, CloudAppMsgOb1203_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeBulkJson, false if it is not one */
+bool CloudAppMsg_DecodeBulkJson(const char *payload, size_t length, CloudAppMsgBulk_t *msg);
+
+/** @brief Decode a payload written by CloudAppMsg_EncodeBulkCbor, false if it is not one */
+bool CloudAppMsg_DecodeBulkCbor(const uint8_t *payload, size_t length, CloudAppMsgBulk_t *msg);
+
+#endif //CLOUD_APP_MSG_DECODE_H
@@ -0,0 +1,864 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_fleet_sim.c
+ * Description  : Host fleet simulator, N virtual devices provision and push telemetry at once against a local broker,
+ *                through the CloudProv serializer, the Fleet Provisioning topic matcher, the connect backoff and the
+ *                CloudApp message encoders of the firmware
+ **********************************************************************************************************************/
+
+/* Partial host build: FreeRTOS, FreeRTOS+TCP, mbedTLS, corePKCS11 and coreMQTT are not part of this tree, so the
+ * devices are POSIX threads, the transport is a plain loopback socket without TLS and the broker in this file frames
+ * publishes as [topic length (2), 0 (2), payload length (4), topic, payload], big endian. The CSR is a fixed PEM of
+ * the size mbedTLS writes for the P-256 device key. Build and run on the host from the repository root, e.g.
+ * cc -O2 -pthread -include assert.h -DconfigASSERT=assert -I script/host/include -I src/cloud_prov \
+ *    -I src/cloud_prov/tinycbor/src -I src/cloud_prov/fleet_provisioning/source/include \
+ *    -I src/cloud_prov/backoffAlgorithm -I src/cloud_app script/host/cloud_fleet_sim.c \
+ *    src/cloud_prov/cloud_prov_serializer.c src/cloud_prov/fleet_provisioning/source/fleet_provisioning.c \
+ *    src/cloud_prov/backoffAlgorithm/backoff_algorithm.c src/cloud_app/cloud_app_msg.c \
+ *    src/cloud_app/cloud_app_telemetry.c src/cloud_prov/tinycbor/src/cborparser.c \
+ *    src/cloud_prov/tinycbor/src/cborvalidation.c src/cloud_prov/tinycbor/src/cborencoder.c \
+ *    src/cloud_prov/tinycbor/src/cborencoder_float.c src/cloud_prov/tinycbor/src/cborerrorstrings.c -lm \
+ *    -o cloud_fleet_sim
+ * ./cloud_fleet_sim [devices] [messages per device] [push period ms]
+ * Prints the connect, provisioning and telemetry round trip latencies of each device, their distribution over the
+ * fleet and the resident memory added per device. Exits with 1 if a device failed. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "cloud_prov_config.h"
+#include "cloud_prov_serializer.h"
+#include "fleet_provisioning.h"
+#include "backoff_algorithm.h"
+#include "cloud_app_msg.h"
+
+/**********************************************************************************************************************
+                                    MACRO DEFINITIONS
+**********************************************************************************************************************/
+#define CLOUD_FLEET_SIM_DEVICES_DEFAULT     (100u)
+#define CLOUD_FLEET_SIM_DEVICES_MAX         (1000u)
+#define CLOUD_FLEET_SIM_MESSAGES_DEFAULT    (20u)
+#define CLOUD_FLEET_SIM_MESSAGES_MAX        (10000u)
+#define CLOUD_FLEET_SIM_STACK_SIZE          (64u * 1024u)
+#define CLOUD_FLEET_SIM_FRAME_HEADER_SIZE   (8u)
+#define CLOUD_FLEET_SIM_TOPIC_SIZE_MAX      (128u)
+#define CLOUD_FLEET_SIM_STAGING_SIZE        (160u)
+#define CLOUD_FLEET_SIM_THING_NAME_SIZE     (128u)
+#define CLOUD_FLEET_SIM_SERIAL_SIZE         (36u)
+#define CLOUD_FLEET_SIM_BROKER_BUFFER_SIZE  (CLOUD_FLEET_SIM_FRAME_HEADER_SIZE + CLOUD_FLEET_SIM_TOPIC_SIZE_MAX + \
+                                             CLOUD_PROV_MQTT_BUFFER_SIZE)
+#define CLOUD_FLEET_SIM_ACK_TOPIC           "$sim/puback"
+#define CLOUD_FLEET_SIM_CONNECT_ATTEMPTS    (8u)
+#define CLOUD_FLEET_SIM_BACKOFF_BASE_MS     (10u)
+#define CLOUD_FLEET_SIM_BACKOFF_MAX_MS      (1000u)
+#define CLOUD_FLEET_SIM_CERT_LINES          (20u)
+#define CLOUD_FLEET_SIM_PEM_LINE_LENGTH     (64u)
+#define CLOUD_FLEET_SIM_TOKEN_LENGTH        (456u)
+#define CLOUD_FLEET_SIM_STRLEN(literal)     (sizeof(literal) - 1u)
+
+/**********************************************************************************************************************
+                                    TYPE DEFINITIONS
+**********************************************************************************************************************/
+/** @brief State of one virtual device, the receive buffer has the size of the firmware MQTT buffer */
+typedef struct
+{
+    uint32_t index;
+    int socket;
+    unsigned int seed;
+    char topic[CLOUD_FLEET_SIM_TOPIC_SIZE_MAX];
+    uint16_t topicLength;
+    uint8_t buffer[CLOUD_PROV_MQTT_BUFFER_SIZE];
+    size_t payloadLength;
+    uint8_t staging[CLOUD_FLEET_SIM_STAGING_SIZE];
+    size_t stagingUsed;
+    bool sendFailed;
+    char serial[CLOUD_FLEET_SIM_SERIAL_SIZE + 1u];
+    char thingName[CLOUD_FLEET_SIM_THING_NAME_SIZE];
+    uint32_t connectAttempts;
+    uint64_t connectNs;
+    uint64_t provisionNs;
+    uint64_t *roundTripNs;
+    uint32_t messagesDone;
+    bool ok;
+}CloudFleetSimDevice_t;
+
+/** @brief Broker side of one device connection */
+typedef struct
+{
+    int socket;
+    uint32_t index;
+    uint8_t buffer[CLOUD_FLEET_SIM_BROKER_BUFFER_SIZE];
+    size_t used;
+}CloudFleetSimConnection_t;
+
+/**********************************************************************************************************************
+                                    LOCAL VARIABLES
+**********************************************************************************************************************/
+static uint32_t CloudFleetSimDevices = CLOUD_FLEET_SIM_DEVICES_DEFAULT;
+static uint32_t CloudFleetSimMessages = CLOUD_FLEET_SIM_MESSAGES_DEFAULT;
+static uint32_t CloudFleetSimPeriodMs = 0u;
+static uint16_t CloudFleetSimPort;
+static int CloudFleetSimListenSocket = -1;
+static atomic_bool CloudFleetSimStop = false;
+static pthread_barrier_t CloudFleetSimProvisioned;
+static pthread_barrier_t CloudFleetSimMeasured;
+static pthread_mutex_t CloudFleetSimLogMutex = PTHREAD_MUTEX_INITIALIZER;
+static char CloudFleetSimCertificate[CLOUD_FLEET_SIM_CERT_LINES * (CLOUD_FLEET_SIM_PEM_LINE_LENGTH + 1u) + 64u];
+static char CloudFleetSimToken[CLOUD_FLEET_SIM_TOKEN_LENGTH + 1u];
+
+/** @brief PEM CSR of the size mbedtls_x509write_csr_pem writes for a P-256 key and the demo subject name */
+static const char CloudFleetSimCsr[] =
+        "-----BEGIN CERTIFICATE REQUEST-----\n"
+        "MIIBBzCBrgIBADAhMR8wHQYDVQQDDBZDTj1GUERlbW9JRDEyOjAwOjAwMFkwEwYH\n"
+        "KoZIzj0CAQYIKoZIzj0DAQcDQgAE8t9Hw6h9pFhBLtqR+m/Ehk1xW3Fq6l0fRj8w\n"
+        "t0xJjxvS2o2y3kJx7V7oUj2oC5ZlCq3nJ2YOqz7sVnBqg7oZ6KAtMCsGCSqGSIb3\n"
+        "DQEJDjEeMBwwGgYDVR0RBBMwEYIPY2xvdWQta2l0LmxvY2FsMAoGCCqGSM49BAMC\n"
+        "A0gAMEUCIQDkV2q6fJ3sYh1rLq0xGx2Xk8cN7w3oC6pYJ3mR4m1nNwIgI8k2eR0b\n"
+        "Vf1W7uE9m3cK2yT5qJ8oN0dH6sG4rL1aPz0=\n"
+        "-----END CERTIFICATE REQUEST-----\n";
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+/** @brief SdkLog of cloud_prov_config.h, so the serializer errors, one line at a time */
+void vLoggingPrintf(const char *pcFormatString, ...)
+{
+    va_list args;
+
+    pthread_mutex_lock(&CloudFleetSimLogMutex);
+    va_start(args, pcFormatString);
+    vfprintf(stderr, pcFormatString, args);
+    va_end(args);
+    pthread_mutex_unlock(&CloudFleetSimLogMutex);
+}
+
+static uint64_t CloudFleetSim_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000u) + (uint64_t)now.tv_nsec;
+}
+
+static void CloudFleetSim_SleepMs(uint32_t delayMs)
+{
+    struct timespec delay = { (time_t)(delayMs / 1000u), (long)(delayMs % 1000u) * 1000000L };
+
+    while((nanosleep(&delay, &delay) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+static long CloudFleetSim_ResidentKb(void)
+{
+    char line[128];
+    long residentKb = -1;
+    FILE *status = fopen("/proc/self/status", "r");
+
+    while((status != NULL) && (residentKb < 0) && (fgets(line, sizeof(line), status) != NULL))
+    {
+        if(strncmp(line, "VmRSS:", 6u) == 0)
+        {
+            residentKb = strtol(&line[6], NULL, 10);
+        }
+    }
+    if(status != NULL)
+    {
+        fclose(status);
+    }
+    return residentKb;
+}
+
+static bool CloudFleetSim_WriteAll(int socket, const void *data, size_t length)
+{
+    const uint8_t *position = data;
+    ssize_t written;
+
+    while(length > 0u)
+    {
+        written = send(socket, position, length, MSG_NOSIGNAL);
+        if(written <= 0)
+        {
+            if((written < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            return false;
+        }
+        position += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool CloudFleetSim_ReadAll(int socket, void *data, size_t length)
+{
+    uint8_t *position = data;
+    ssize_t received;
+
+    while(length > 0u)
+    {
+        received = recv(socket, position, length, 0);
+        if(received <= 0)
+        {
+            if((received < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            return false;
+        }
+        position += received;
+        length -= (size_t)received;
+    }
+    return true;
+}
+
+static void CloudFleetSim_FrameHeader(uint8_t *header, size_t topicLength, size_t payloadLength)
+{
+    header[0] = (uint8_t)(topicLength >> 8u);
+    header[1] = (uint8_t)topicLength;
+    header[2] = 0u;
+    header[3] = 0u;
+    header[4] = (uint8_t)(payloadLength >> 24u);
+    header[5] = (uint8_t)(payloadLength >> 16u);
+    header[6] = (uint8_t)(payloadLength >> 8u);
+    header[7] = (uint8_t)payloadLength;
+}
+
+static bool CloudFleetSim_SendFrame(int socket, const char *topic, size_t topicLength, const void *payload,
+                                    size_t payloadLength)
+{
+    uint8_t header[CLOUD_FLEET_SIM_FRAME_HEADER_SIZE];
+
+    CloudFleetSim_FrameHeader(header, topicLength, payloadLength);
+    return CloudFleetSim_WriteAll(socket, header, sizeof(header)) &&
+           CloudFleetSim_WriteAll(socket, topic, topicLength) &&
+           CloudFleetSim_WriteAll(socket, payload, payloadLength);
+}
+
+/*************************************** Device ***********************************************************************/
+
+static bool CloudFleetSim_DeviceReceive(CloudFleetSimDevice_t *device)
+{
+    uint8_t header[CLOUD_FLEET_SIM_FRAME_HEADER_SIZE];
+    bool ok = CloudFleetSim_ReadAll(device->socket, header, sizeof(header));
+
+    if(ok)
+    {
+        device->topicLength = (uint16_t)(((uint16_t)header[0] << 8u) | header[1]);
+        device->payloadLength = ((size_t)header[4] << 24u) | ((size_t)header[5] << 16u) |
+                                ((size_t)header[6] << 8u) | header[7];
+        ok = (device->topicLength <= sizeof(device->topic)) && (device->payloadLength <= sizeof(device->buffer));
+    }
+    if(ok)
+    {
+        ok = CloudFleetSim_ReadAll(device->socket, device->topic, device->topicLength) &&
+             CloudFleetSim_ReadAll(device->socket, device->buffer, device->payloadLength);
+    }
+    return ok;
+}
+
+/** @brief tinycbor writer of the streaming pass, as CloudProv_StreamWrite without the MQTT header */
+static CborError CloudFleetSim_StreamWrite(void *token, const void *data, size_t length, CborEncoderAppendType type)
+{
+    CloudFleetSimDevice_t *device = token;
+
+    (void)type;
+    if((device->stagingUsed + length) > sizeof(device->staging))
+    {
+        device->sendFailed |= !CloudFleetSim_WriteAll(device->socket, device->staging, device->stagingUsed);
+        device->stagingUsed = 0u;
+    }
+    if(length > sizeof(device->staging))
+    {
+        device->sendFailed |= !CloudFleetSim_WriteAll(device->socket, data, length);
+    }
+    else
+    {
+        memcpy(&device->staging[device->stagingUsed], data, length);
+        device->stagingUsed += length;
+    }
+    return CborNoError;
+}
+
+/** @brief Same two passes as CloudProv_PublishStream, the request is measured then encoded to the socket */
+static bool CloudFleetSim_PublishStream(CloudFleetSimDevice_t *device, const char *topic, uint16_t topicLength,
+                                        CloudProvCborEncode_t encode, const void *request)
+{
+    CborEncoder encoder;
+    CborError cborStatus;
+    size_t payloadLength = 0u;
+    bool ok;
+
+    cbor_encoder_init(&encoder, NULL, 0u, 0);
+    cborStatus = encode(&encoder, request);
+    ok = (cborStatus == CborNoError) || (cborStatus == CborErrorOutOfMemory);
+    if(ok)
+    {
+        payloadLength = cbor_encoder_get_extra_bytes_needed(&encoder);
+        CloudFleetSim_FrameHeader(device->staging, topicLength, payloadLength);
+        memcpy(&device->staging[CLOUD_FLEET_SIM_FRAME_HEADER_SIZE], topic, topicLength);
+        device->stagingUsed = CLOUD_FLEET_SIM_FRAME_HEADER_SIZE + topicLength;
+        device->sendFailed = false;
+
+        cbor_encoder_init_writer(&encoder, CloudFleetSim_StreamWrite, device);
+        cborStatus = encode(&encoder, request);
+        device->sendFailed |= !CloudFleetSim_WriteAll(device->socket, device->staging, device->stagingUsed);
+        ok = (cborStatus == CborNoError) && !device->sendFailed;
+    }
+    return ok;
+}
+
+static bool CloudFleetSim_DeviceConnect(CloudFleetSimDevice_t *device)
+{
+    BackoffAlgorithmContext_t backoff;
+    BackoffAlgorithmStatus_t backoffStatus = BackoffAlgorithmSuccess;
+    struct sockaddr_in broker = { .sin_family = AF_INET, .sin_port = htons(CloudFleetSimPort),
+                                  .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    uint16_t delayMs = 0u;
+    int noDelay = 1;
+    bool connected = false;
+
+    BackoffAlgorithm_InitializeParams(&backoff, CLOUD_FLEET_SIM_BACKOFF_BASE_MS, CLOUD_FLEET_SIM_BACKOFF_MAX_MS,
+                                      CLOUD_FLEET_SIM_CONNECT_ATTEMPTS);
+    while(!connected && (backoffStatus == BackoffAlgorithmSuccess))
+    {
+        device->connectAttempts++;
+        device->socket = socket(AF_INET, SOCK_STREAM, 0);
+        connected = (device->socket >= 0) &&
+                    (connect(device->socket, (struct sockaddr *)&broker, sizeof(broker)) == 0);
+        if(!connected)
+        {
+            if(device->socket >= 0)
+            {
+                close(device->socket);
+                device->socket = -1;
+            }
+            backoffStatus = BackoffAlgorithm_GetNextBackoff(&backoff, (uint32_t)rand_r(&device->seed), &delayMs);
+            if(backoffStatus == BackoffAlgorithmSuccess)
+            {
+                CloudFleetSim_SleepMs(delayMs);
+            }
+        }
+    }
+    if(connected)
+    {
+        (void)setsockopt(device->socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+    return connected;
+}
+
+/** @brief CreateCertificateFromCsr then RegisterThing, as CloudProv_ProvisionDevice in CSR mode */
+static bool CloudFleetSim_DeviceProvision(CloudFleetSimDevice_t *device)
+{
+    CloudProvCsrRequest_t csrRequest = { (const uint8_t *)CloudFleetSimCsr, CLOUD_FLEET_SIM_STRLEN(CloudFleetSimCsr) };
+    CloudProvRegisterThingRequest_t registerRequest = { { NULL, 0u }, device->serial, CLOUD_FLEET_SIM_SERIAL_SIZE };
+    CloudProvCborView_t certificate;
+    CloudProvCborView_t certificateId;
+    FleetProvisioningTopic_t api = FleetProvisioningInvalidTopic;
+    size_t thingNameLength = sizeof(device->thingName);
+    bool ok;
+
+    ok = CloudFleetSim_PublishStream(device, FP_CBOR_CREATE_CERT_PUBLISH_TOPIC, FP_CBOR_CREATE_CERT_PUBLISH_LENGTH,
+                                     CloudProv_EncodeCsrRequest, &csrRequest) &&
+         CloudFleetSim_DeviceReceive(device) &&
+         (FleetProvisioning_MatchTopic(device->topic, device->topicLength, &api) == FleetProvisioningSuccess) &&
+         (api == FleetProvCborCreateCertFromCsrAccepted) &&
+         CloudProv_DeserializeCsrResponse(device->buffer, device->payloadLength, &certificate, &certificateId,
+                                          &registerRequest.xOwnershipToken);
+
+    /* The ownership token points into the receive buffer, it is streamed before the buffer is reused */
+    ok = ok && CloudFleetSim_PublishStream(device, FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME),
+                                           FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH),
+                                           CloudProv_EncodeRegisterThingRequest, &registerRequest) &&
+         CloudFleetSim_DeviceReceive(device) &&
+         (FleetProvisioning_MatchTopic(device->topic, device->topicLength, &api) == FleetProvisioningSuccess) &&
+         (api == FleetProvCborRegisterThingAccepted) &&
+         (CloudProv_DeserializeThingName(device->buffer, device->payloadLength, device->thingName,
+                                         &thingNameLength) == CborNoError);
+    if(ok)
+    {
+        device->thingName[(thingNameLength < sizeof(device->thingName)) ? thingNameLength : 0u] = '\0';
+    }
+    return ok;
+}
+
+/** @brief Bulk telemetry every period, each publish waits for the broker acknowledgement as a QoS 1 PUBACK */
+static bool CloudFleetSim_DeviceTelemetry(CloudFleetSimDevice_t *device)
+{
+    CloudAppMsgBulk_t msg;
+    size_t payloadLength;
+    uint64_t start;
+    bool ok = true;
+
+    for(uint32_t message = 0u; ok && (message < CloudFleetSimMessages); message++)
+    {
+        msg.iaq.tvoc = (float_t)(rand_r(&device->seed) % 1000) / 10.0f;
+        msg.iaq.etoh = (float_t)(rand_r(&device->seed) % 1000) / 100.0f;
+        msg.iaq.eco2 = 400.0f + (float_t)(rand_r(&device->seed) % 1000);
+        msg.oaq.airQuality = (float_t)(rand_r(&device->seed) % 500) / 10.0f;
+        msg.hs3001.humidity = (float_t)(rand_r(&device->seed) % 1000) / 10.0f;
+        msg.hs3001.temperature = 15.0f + ((float_t)(rand_r(&device->seed) % 200) / 10.0f);
+        msg.icm.accX = (double)(rand_r(&device->seed) % 2000) / 1000.0 - 1.0;
+        msg.icm.accY = (double)(rand_r(&device->seed) % 2000) / 1000.0 - 1.0;
+        msg.icm.accZ = (double)(rand_r(&device->seed) % 2000) / 1000.0;
+        msg.icm.magX = (double)(rand_r(&device->seed) % 1000) / 10.0 - 50.0;
+        msg.icm.magY = (double)(rand_r(&device->seed) % 1000) / 10.0 - 50.0;
+        msg.icm.magZ = (double)(rand_r(&device->seed) % 1000) / 10.0 - 50.0;
+        msg.icm.gyrX = (double)(rand_r(&device->seed) % 500) / 100.0;
+        msg.icm.gyrY = (double)(rand_r(&device->seed) % 500) / 100.0;
+        msg.icm.gyrZ = (double)(rand_r(&device->seed) % 500) / 100.0;
+        msg.icp.temperature = 15.0f + ((float_t)(rand_r(&device->seed) % 200) / 10.0f);
+        msg.icp.pressure = 950.0f + ((float_t)(rand_r(&device->seed) % 1000) / 10.0f);
+        msg.ob1203.spo2 = (uint16_t)(90u + ((unsigned int)rand_r(&device->seed) % 10u));
+        msg.ob1203.heartRate = (uint16_t)(50u + ((unsigned int)rand_r(&device->seed) % 70u));
+        msg.ob1203.respirationRate = (uint16_t)(10u + ((unsigned int)rand_r(&device->seed) % 10u));
+        msg.ob1203.perfusionIndex = (float_t)(rand_r(&device->seed) % 200) / 10.0f;
+
+        start = CloudFleetSim_Now();
+        payloadLength = CloudAppMsg_EncodeBulkCbor(&msg, device->buffer, sizeof(device->buffer));
+        ok = (payloadLength > 0u) &&
+             CloudFleetSim_SendFrame(device->socket, CLOUD_APP_MSG_BULK_TOPIC,
+                                     CLOUD_FLEET_SIM_STRLEN(CLOUD_APP_MSG_BULK_TOPIC), device->buffer,
+                                     payloadLength) &&
+             CloudFleetSim_DeviceReceive(device) &&
+             (device->topicLength == CLOUD_FLEET_SIM_STRLEN(CLOUD_FLEET_SIM_ACK_TOPIC)) &&
+             (memcmp(device->topic, CLOUD_FLEET_SIM_ACK_TOPIC, device->topicLength) == 0);
+        if(ok)
+        {
+            device->roundTripNs[message] = CloudFleetSim_Now() - start;
+            device->messagesDone++;
+            if(CloudFleetSimPeriodMs > 0u)
+            {
+                CloudFleetSim_SleepMs(CloudFleetSimPeriodMs);
+            }
+        }
+    }
+    return ok;
+}
+
+static void *CloudFleetSim_DeviceTask(void *parameter)
+{
+    CloudFleetSimDevice_t *device = parameter;
+    uint64_t start = CloudFleetSim_Now();
+    bool ok = CloudFleetSim_DeviceConnect(device);
+
+    device->connectNs = CloudFleetSim_Now() - start;
+    if(ok)
+    {
+        start = CloudFleetSim_Now();
+        ok = CloudFleetSim_DeviceProvision(device);
+        device->provisionNs = CloudFleetSim_Now() - start;
+    }
+
+    /* Every device holds its connection and buffers while the process memory is measured */
+    (void)pthread_barrier_wait(&CloudFleetSimProvisioned);
+    (void)pthread_barrier_wait(&CloudFleetSimMeasured);
+
+    ok = ok && CloudFleetSim_DeviceTelemetry(device);
+    if(device->socket >= 0)
+    {
+        close(device->socket);
+    }
+    device->ok = ok;
+    return NULL;
+}
+
+/*************************************** Broker ***********************************************************************/
+
+static void CloudFleetSim_BrokerInit(void)
+{
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char *position = CloudFleetSimCertificate;
+    unsigned int seed = 1u;
+
+    /* Certificate and token of the sizes AWS IoT returns, an RSA 2048 signed certificate and a JWE token */
+    position += sprintf(position, "-----BEGIN CERTIFICATE-----\n");
+    for(uint32_t line = 0u; line < CLOUD_FLEET_SIM_CERT_LINES; line++)
+    {
+        for(uint32_t column = 0u; column < CLOUD_FLEET_SIM_PEM_LINE_LENGTH; column++)
+        {
+            *position++ = base64[(unsigned int)rand_r(&seed) % 64u];
+        }
+        *position++ = '\n';
+    }
+    sprintf(position, "-----END CERTIFICATE-----\n");
+    for(uint32_t index = 0u; index < CLOUD_FLEET_SIM_TOKEN_LENGTH; index++)
+    {
+        CloudFleetSimToken[index] = base64[(unsigned int)rand_r(&seed) % 64u];
+    }
+}
+
+static bool CloudFleetSim_BrokerCsr(CloudFleetSimConnection_t *connection, const uint8_t *payload, size_t length,
+                                    uint8_t *response, size_t *responseLength)
+{
+    CborParser parser;
+    CborValue map;
+    CborValue csr;
+    CborEncoder encoder;
+    CborEncoder mapEncoder;
+    char certificateId[65];
+    CborError cborStatus = cbor_parser_init(payload, length, 0, &parser, &map);
+
+    /* The CSR is not signed, the certificate only has the size of a real one */
+    cborStatus = (cborStatus != CborNoError) ? cborStatus : cbor_value_map_find_value(&map, "certificateSigningRequest",
+                                                                                      &csr);
+    if((cborStatus != CborNoError) || !cbor_value_is_text_string(&csr))
+    {
+        return false;
+    }
+    snprintf(certificateId, sizeof(certificateId), "%064x", connection->index);
+    cbor_encoder_init(&encoder, response, *responseLength, 0);
+    cborStatus = cbor_encoder_create_map(&encoder, &mapEncoder, 3);
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, "certificateId");
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, certificateId);
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, "certificatePem");
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, CloudFleetSimCertificate);
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, "certificateOwnershipToken");
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, CloudFleetSimToken);
+    cborStatus |= cbor_encoder_close_container(&encoder, &mapEncoder);
+    *responseLength = cbor_encoder_get_buffer_size(&encoder, response);
+    return cborStatus == CborNoError;
+}
+
+static bool CloudFleetSim_BrokerRegister(const uint8_t *payload, size_t length, uint8_t *response,
+                                         size_t *responseLength)
+{
+    CborParser parser;
+    CborValue map;
+    CborValue token;
+    CborValue parameters;
+    CborValue serial;
+    CborEncoder encoder;
+    CborEncoder mapEncoder;
+    CborEncoder configurationEncoder;
+    char thingName[CLOUD_FLEET_SIM_THING_NAME_SIZE] = "sim-";
+    size_t serialLength = sizeof(thingName) - CLOUD_FLEET_SIM_STRLEN("sim-");
+    CborError cborStatus = cbor_parser_init(payload, length, 0, &parser, &map);
+
+    cborStatus = (cborStatus != CborNoError) ? cborStatus : cbor_value_map_find_value(&map,
+                                                                                      "certificateOwnershipToken",
+                                                                                      &token);
+    cborStatus = (cborStatus != CborNoError) ? cborStatus : cbor_value_map_find_value(&map, "parameters",
+                                                                                      &parameters);
+    cborStatus = (cborStatus != CborNoError) ? cborStatus : cbor_value_map_find_value(&parameters, "SerialNumber",
+                                                                                      &serial);
+    if((cborStatus != CborNoError) || !cbor_value_is_text_string(&token) || !cbor_value_is_text_string(&serial) ||
+       (cbor_value_copy_text_string(&serial, &thingName[CLOUD_FLEET_SIM_STRLEN("sim-")], &serialLength, NULL) !=
+        CborNoError))
+    {
+        return false;
+    }
+    cbor_encoder_init(&encoder, response, *responseLength, 0);
+    cborStatus = cbor_encoder_create_map(&encoder, &mapEncoder, 2);
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, "deviceConfiguration");
+    cborStatus |= cbor_encoder_create_map(&mapEncoder, &configurationEncoder, 0);
+    cborStatus |= cbor_encoder_close_container(&mapEncoder, &configurationEncoder);
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, "thingName");
+    cborStatus |= cbor_encode_text_stringz(&mapEncoder, thingName);
+    cborStatus |= cbor_encoder_close_container(&encoder, &mapEncoder);
+    *responseLength = cbor_encoder_get_buffer_size(&encoder, response);
+    return cborStatus == CborNoError;
+}
+
+/** @brief Answer one publish as AWS IoT would, false closes the connection */
+static bool CloudFleetSim_BrokerPublish(CloudFleetSimConnection_t *connection, const char *topic, size_t topicLength,
+                                        const uint8_t *payload, size_t payloadLength)
+{
+    static uint8_t response[CLOUD_PROV_MQTT_BUFFER_SIZE];
+    size_t responseLength = sizeof(response);
+    CborParser parser;
+    CborValue value;
+    bool ok = false;
+
+    if((topicLength == FP_CBOR_CREATE_CERT_PUBLISH_LENGTH) &&
+       (memcmp(topic, FP_CBOR_CREATE_CERT_PUBLISH_TOPIC, topicLength) == 0))
+    {
+        ok = CloudFleetSim_BrokerCsr(connection, payload, payloadLength, response, &responseLength) &&
+             CloudFleetSim_SendFrame(connection->socket, FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC,
+                                     FP_CBOR_CREATE_CERT_ACCEPTED_LENGTH, response, responseLength);
+    }
+    else if((topicLength == FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH)) &&
+            (memcmp(topic, FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME), topicLength) == 0))
+    {
+        ok = CloudFleetSim_BrokerRegister(payload, payloadLength, response, &responseLength) &&
+             CloudFleetSim_SendFrame(connection->socket, FP_CBOR_REGISTER_ACCEPTED_TOPIC(CLOUD_PROV_TEMPLATE_NAME),
+                                     FP_CBOR_REGISTER_ACCEPTED_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH), response,
+                                     responseLength);
+    }
+    else if((topicLength == CLOUD_FLEET_SIM_STRLEN(CLOUD_APP_MSG_BULK_TOPIC)) &&
+            (memcmp(topic, CLOUD_APP_MSG_BULK_TOPIC, topicLength) == 0))
+    {
+        ok = (cbor_parser_init(payload, payloadLength, 0, &parser, &value) == CborNoError) &&
+             (cbor_value_validate_basic(&value) == CborNoError) &&
+             CloudFleetSim_SendFrame(connection->socket, CLOUD_FLEET_SIM_ACK_TOPIC,
+                                     CLOUD_FLEET_SIM_STRLEN(CLOUD_FLEET_SIM_ACK_TOPIC), NULL, 0u);
+    }
+    if(!ok)
+    {
+        fprintf(stderr, "Broker: device %u publish to %.*s refused\n", connection->index, (int)topicLength, topic);
+    }
+    return ok;
+}
+
+/** @brief Handle the complete frames received on connection, false closes it */
+static bool CloudFleetSim_BrokerReceive(CloudFleetSimConnection_t *connection)
+{
+    ssize_t received = recv(connection->socket, &connection->buffer[connection->used],
+                            sizeof(connection->buffer) - connection->used, 0);
+    size_t topicLength;
+    size_t payloadLength;
+    size_t frameLength;
+    bool ok = received > 0;
+
+    connection->used += (received > 0) ? (size_t)received : 0u;
+    while(ok && (connection->used >= CLOUD_FLEET_SIM_FRAME_HEADER_SIZE))
+    {
+        topicLength = ((size_t)connection->buffer[0] << 8u) | connection->buffer[1];
+        payloadLength = ((size_t)connection->buffer[4] << 24u) | ((size_t)connection->buffer[5] << 16u) |
+                        ((size_t)connection->buffer[6] << 8u) | connection->buffer[7];
+        frameLength = CLOUD_FLEET_SIM_FRAME_HEADER_SIZE + topicLength + payloadLength;
+        ok = frameLength <= sizeof(connection->buffer);
+        if(!ok || (connection->used < frameLength))
+        {
+            break;
+        }
+        ok = CloudFleetSim_BrokerPublish(connection,
+                                         (const char *)&connection->buffer[CLOUD_FLEET_SIM_FRAME_HEADER_SIZE],
+                                         topicLength,
+                                         &connection->buffer[CLOUD_FLEET_SIM_FRAME_HEADER_SIZE + topicLength],
+                                         payloadLength);
+        memmove(connection->buffer, &connection->buffer[frameLength], connection->used - frameLength);
+        connection->used -= frameLength;
+    }
+    return ok;
+}
+
+/** @brief Single threaded broker, polls the listening socket and every device connection */
+static void *CloudFleetSim_BrokerTask(void *parameter)
+{
+    CloudFleetSimConnection_t *connections = calloc(CloudFleetSimDevices, sizeof(CloudFleetSimConnection_t));
+    struct pollfd *polled = calloc(CloudFleetSimDevices + 1u, sizeof(struct pollfd));
+    uint32_t connectionCount = 0u;
+    uint32_t accepted = 0u;
+    int noDelay = 1;
+
+    (void)parameter;
+    if((connections == NULL) || (polled == NULL))
+    {
+        fprintf(stderr, "Broker: out of memory\n");
+        exit(1);
+    }
+    while(!CloudFleetSimStop)
+    {
+        polled[0].fd = CloudFleetSimListenSocket;
+        polled[0].events = POLLIN;
+        for(uint32_t index = 0u; index < connectionCount; index++)
+        {
+            polled[index + 1u].fd = connections[index].socket;
+            polled[index + 1u].events = POLLIN;
+        }
+        if(poll(polled, connectionCount + 1u, 100) <= 0)
+        {
+            continue;
+        }
+        for(uint32_t index = connectionCount; index > 0u; index--)
+        {
+            if((polled[index].revents != 0) && !CloudFleetSim_BrokerReceive(&connections[index - 1u]))
+            {
+                close(connections[index - 1u].socket);
+                connections[index - 1u] = connections[--connectionCount];
+            }
+        }
+        if(((polled[0].revents & POLLIN) != 0) && (connectionCount < CloudFleetSimDevices))
+        {
+            connections[connectionCount].socket = accept(CloudFleetSimListenSocket, NULL, NULL);
+            if(connections[connectionCount].socket >= 0)
+            {
+                (void)setsockopt(connections[connectionCount].socket, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+                                 sizeof(noDelay));
+                connections[connectionCount].index = accepted++;
+                connections[connectionCount].used = 0u;
+                connectionCount++;
+            }
+        }
+    }
+    for(uint32_t index = 0u; index < connectionCount; index++)
+    {
+        close(connections[index].socket);
+    }
+    free(polled);
+    free(connections);
+    return NULL;
+}
+
+/*************************************** Report ***********************************************************************/
+
+static int CloudFleetSim_Compare(const void *left, const void *right)
+{
+    uint64_t a = *(const uint64_t *)left;
+    uint64_t b = *(const uint64_t *)right;
+
+    return (a > b) - (a < b);
+}
+
+/** @brief Percentile of sorted samples in microseconds, nearest rank */
+static double CloudFleetSim_PercentileUs(const uint64_t *sorted, size_t count, uint32_t percentile)
+{
+    size_t rank = ((count * percentile) + 99u) / 100u;
+
+    return (count == 0u) ? 0.0 : ((double)sorted[(rank > 0u) ? (rank - 1u) : 0u] / 1000.0);
+}
+
+static void CloudFleetSim_PrintDistribution(const char *name, uint64_t *samples, size_t count)
+{
+    qsort(samples, count, sizeof(uint64_t), CloudFleetSim_Compare);
+    printf("%-22s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, count,
+           CloudFleetSim_PercentileUs(samples, count, 0u), CloudFleetSim_PercentileUs(samples, count, 50u),
+           CloudFleetSim_PercentileUs(samples, count, 90u), CloudFleetSim_PercentileUs(samples, count, 99u),
+           CloudFleetSim_PercentileUs(samples, count, 100u));
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+int main(int argc, char *argv[])
+{
+    CloudFleetSimDevice_t *devices;
+    pthread_t *threads;
+    pthread_t broker;
+    pthread_attr_t attributes;
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addressLength = sizeof(address);
+    uint64_t *connectNs;
+    uint64_t *provisionNs;
+    uint64_t *roundTripNs;
+    uint64_t *deviceRoundTripNs;
+    size_t roundTrips = 0u;
+    uint32_t failed = 0u;
+    uint32_t retried = 0u;
+    long residentBeforeKb;
+    long residentFleetKb;
+    int reuse = 1;
+
+    CloudFleetSimDevices = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : CLOUD_FLEET_SIM_DEVICES_DEFAULT;
+    CloudFleetSimMessages = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : CLOUD_FLEET_SIM_MESSAGES_DEFAULT;
+    CloudFleetSimPeriodMs = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : 0u;
+    if((CloudFleetSimDevices == 0u) || (CloudFleetSimDevices > CLOUD_FLEET_SIM_DEVICES_MAX) ||
+       (CloudFleetSimMessages == 0u) || (CloudFleetSimMessages > CLOUD_FLEET_SIM_MESSAGES_MAX))
+    {
+        fprintf(stderr, "usage: %s [devices 1..%u] [messages 1..%u] [push period ms]\n", argv[0],
+                CLOUD_FLEET_SIM_DEVICES_MAX, CLOUD_FLEET_SIM_MESSAGES_MAX);
+        return 2;
+    }
+
+    CloudFleetSim_BrokerInit();
+    CloudFleetSimListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    (void)setsockopt(CloudFleetSimListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if((CloudFleetSimListenSocket < 0) ||
+       (bind(CloudFleetSimListenSocket, (struct sockaddr *)&address, sizeof(address)) != 0) ||
+       (listen(CloudFleetSimListenSocket, SOMAXCONN) != 0) ||
+       (getsockname(CloudFleetSimListenSocket, (struct sockaddr *)&address, &addressLength) != 0))
+    {
+        perror("broker socket");
+        return 1;
+    }
+    CloudFleetSimPort = ntohs(address.sin_port);
+
+    devices = calloc(CloudFleetSimDevices, sizeof(CloudFleetSimDevice_t));
+    threads = calloc(CloudFleetSimDevices, sizeof(pthread_t));
+    connectNs = calloc(CloudFleetSimDevices, sizeof(uint64_t));
+    provisionNs = calloc(CloudFleetSimDevices, sizeof(uint64_t));
+    roundTripNs = calloc((size_t)CloudFleetSimDevices * CloudFleetSimMessages, sizeof(uint64_t));
+    deviceRoundTripNs = calloc(CloudFleetSimMessages, sizeof(uint64_t));
+    if((devices == NULL) || (threads == NULL) || (connectNs == NULL) || (provisionNs == NULL) ||
+       (roundTripNs == NULL) || (deviceRoundTripNs == NULL))
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    pthread_barrier_init(&CloudFleetSimProvisioned, NULL, CloudFleetSimDevices + 1u);
+    pthread_barrier_init(&CloudFleetSimMeasured, NULL, CloudFleetSimDevices + 1u);
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, CLOUD_FLEET_SIM_STACK_SIZE);
+    pthread_create(&broker, NULL, CloudFleetSim_BrokerTask, NULL);
+    residentBeforeKb = CloudFleetSim_ResidentKb();
+
+    /* Connect storm: every device starts at once */
+    for(uint32_t index = 0u; index < CloudFleetSimDevices; index++)
+    {
+        devices[index].index = index;
+        devices[index].socket = -1;
+        devices[index].seed = index + 1u;
+        devices[index].roundTripNs = &roundTripNs[(size_t)index * CloudFleetSimMessages];
+        snprintf(devices[index].serial, sizeof(devices[index].serial), "%08x-%08x-%08x-%08x", 0x52413600u, index,
+                 0x5349u, ~index);
+        if(pthread_create(&threads[index], &attributes, CloudFleetSim_DeviceTask, &devices[index]) != 0)
+        {
+            fprintf(stderr, "cannot start device %u\n", index);
+            return 1;
+        }
+    }
+    (void)pthread_barrier_wait(&CloudFleetSimProvisioned);
+    residentFleetKb = CloudFleetSim_ResidentKb();
+    (void)pthread_barrier_wait(&CloudFleetSimMeasured);
+    for(uint32_t index = 0u; index < CloudFleetSimDevices; index++)
+    {
+        pthread_join(threads[index], NULL);
+    }
+    CloudFleetSimStop = true;
+    pthread_join(broker, NULL);
+    close(CloudFleetSimListenSocket);
+
+    printf("%u devices, %u bulk CBOR messages each, push period %u ms\n\n", CloudFleetSimDevices,
+           CloudFleetSimMessages, CloudFleetSimPeriodMs);
+    printf("device attempts connect_us provision_us  rtt_p50_us  rtt_p99_us  rtt_max_us thing\n");
+    for(uint32_t index = 0u; index < CloudFleetSimDevices; index++)
+    {
+        CloudFleetSimDevice_t *device = &devices[index];
+
+        memcpy(deviceRoundTripNs, device->roundTripNs, device->messagesDone * sizeof(uint64_t));
+        qsort(deviceRoundTripNs, device->messagesDone, sizeof(uint64_t), CloudFleetSim_Compare);
+        printf("%6u %8u %10.1f %12.1f %11.1f %11.1f %11.1f %s%s\n", index, device->connectAttempts,
+               (double)device->connectNs / 1000.0, (double)device->provisionNs / 1000.0,
+               CloudFleetSim_PercentileUs(deviceRoundTripNs, device->messagesDone, 50u),
+               CloudFleetSim_PercentileUs(deviceRoundTripNs, device->messagesDone, 99u),
+               CloudFleetSim_PercentileUs(deviceRoundTripNs, device->messagesDone, 100u), device->thingName,
+               device->ok ? "" : " FAILED");
+        connectNs[index] = device->connectNs;
+        provisionNs[index] = device->provisionNs;
+        memmove(&roundTripNs[roundTrips], device->roundTripNs, device->messagesDone * sizeof(uint64_t));
+        roundTrips += device->messagesDone;
+        failed += device->ok ? 0u : 1u;
+        retried += (device->connectAttempts > 1u) ? 1u : 0u;
+    }
+
+    printf("\n%-22s %8s %10s %10s %10s %10s %10s\n", "fleet (us)", "samples", "min", "p50", "p90", "p99", "max");
+    CloudFleetSim_PrintDistribution("connect", connectNs, CloudFleetSimDevices);
+    CloudFleetSim_PrintDistribution("provision", provisionNs, CloudFleetSimDevices);
+    CloudFleetSim_PrintDistribution("telemetry round trip", roundTripNs, roundTrips);
+    printf("\n%u devices retried the connection, %u failed\n", retried, failed);
+    printf("resident memory %ld kB before the fleet, %ld kB with every device provisioned, %.1f kB per device\n",
+           residentBeforeKb, residentFleetKb,
+           (double)(residentFleetKb - residentBeforeKb) / (double)CloudFleetSimDevices);
+    printf("per device: %zu B device state, %zu B broker connection, %u kB thread stack reserved\n",
+           sizeof(CloudFleetSimDevice_t), sizeof(CloudFleetSimConnection_t), CLOUD_FLEET_SIM_STACK_SIZE / 1024u);
+
+    free(deviceRoundTripNs);
+    free(roundTripNs);
+    free(provisionNs);
+    free(connectNs);
+    free(threads);
+    free(devices);
+    return (failed == 0u) ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+/***********************************************************************************************************************
+ * File Name    : FreeRTOS.h
+ * Description  : Host build of the FreeRTOS definitions mbedtls_rng_pkcs11.c uses, single threaded
+ **********************************************************************************************************************/
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFu)
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif //FREERTOS_H
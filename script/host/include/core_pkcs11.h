@@ -0,0 +1,36 @@
+/***********************************************************************************************************************
+ * File Name    : core_pkcs11.h
+ * Description  : Host build of the corePKCS11 API subset the RNG pool uses. The host program implements the
+ *                functions, see script/host/rng_pool_bench.c
+ **********************************************************************************************************************/
+#ifndef CORE_PKCS11_H
+#define CORE_PKCS11_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned long CK_ULONG;
+typedef CK_ULONG CK_RV;
+typedef CK_ULONG CK_SESSION_HANDLE;
+typedef CK_ULONG CK_OBJECT_HANDLE;
+typedef unsigned char CK_BYTE;
+typedef CK_BYTE *CK_BYTE_PTR;
+
+#define CK_INVALID_HANDLE       (0ul)
+#define CKR_OK                  (0x00ul)
+#define CKR_FUNCTION_FAILED     (0x06ul)
+
+typedef struct
+{
+    CK_RV (*C_GenerateRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pRandomData, CK_ULONG ulRandomLen);
+}CK_FUNCTION_LIST;
+
+typedef CK_FUNCTION_LIST *CK_FUNCTION_LIST_PTR;
+typedef CK_FUNCTION_LIST_PTR *CK_FUNCTION_LIST_PTR_PTR;
+
+CK_RV C_GetFunctionList(CK_FUNCTION_LIST_PTR_PTR ppFunctionList);
+CK_RV C_CloseSession(CK_SESSION_HANDLE hSession);
+CK_RV xInitializePkcs11Session(CK_SESSION_HANDLE *pxSession);
+
+#endif //CORE_PKCS11_H
@@ -0,0 +1,8 @@
+/***********************************************************************************************************************
+ * File Name    : core_pkcs11_config.h
+ * Description  : Host build of the corePKCS11 configuration, nothing the host programs depend on
+ **********************************************************************************************************************/
+#ifndef CORE_PKCS11_CONFIG_H
+#define CORE_PKCS11_CONFIG_H
+
+#endif //CORE_PKCS11_CONFIG_H
@@ -0,0 +1,14 @@
+/***********************************************************************************************************************
+ * File Name    : logging_levels.h
+ * Description  : Host build of the FreeRTOS demo log levels that cloud_prov_config.h includes
+ **********************************************************************************************************************/
+#ifndef LOGGING_LEVELS_H
+#define LOGGING_LEVELS_H
+
+#define LOG_NONE     (0)
+#define LOG_ERROR    (1)
+#define LOG_WARN     (2)
+#define LOG_INFO     (3)
+#define LOG_DEBUG    (4)
+
+#endif //LOGGING_LEVELS_H
@@ -0,0 +1,47 @@
+/***********************************************************************************************************************
+ * File Name    : logging_stack.h
+ * Description  : Host build of the FreeRTOS demo logging macros, message is a parenthesised printf argument list
+ *                handed to SdkLog, so vLoggingPrintf of the host program
+ **********************************************************************************************************************/
+#ifndef LOGGING_STACK_H
+#define LOGGING_STACK_H
+
+#include "logging_levels.h"
+
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#define SdkLogWithMetadata( level, message )                         \
+    do                                                               \
+    {                                                                \
+        SdkLog( ( "[%s] [%s] ", level, LIBRARY_LOG_NAME ) );         \
+        SdkLog( message );                                           \
+        SdkLog( ( "\n" ) );                                          \
+    } while( 0 )
+
+#if LIBRARY_LOG_LEVEL >= LOG_ERROR
+    #define LogError( message )    SdkLogWithMetadata( "ERROR", message )
+#else
+    #define LogError( message )
+#endif
+
+#if LIBRARY_LOG_LEVEL >= LOG_WARN
+    #define LogWarn( message )     SdkLogWithMetadata( "WARN", message )
+#else
+    #define LogWarn( message )
+#endif
+
+#if LIBRARY_LOG_LEVEL >= LOG_INFO
+    #define LogInfo( message )     SdkLogWithMetadata( "INFO", message )
+#else
+    #define LogInfo( message )
+#endif
+
+#if LIBRARY_LOG_LEVEL >= LOG_DEBUG
+    #define LogDebug( message )    SdkLogWithMetadata( "DEBUG", message )
+#else
+    #define LogDebug( message )
+#endif
+
+#endif //LOGGING_STACK_H
@@ -0,0 +1,10 @@
+/***********************************************************************************************************************
+ * File Name    : mbedtls_pkcs11.h
+ * Description  : Host build of the mbedTLS corePKCS11 glue header that cloud_prov_pkcs11.h includes
+ **********************************************************************************************************************/
+#ifndef MBEDTLS_PKCS11_H
+#define MBEDTLS_PKCS11_H
+
+#include "core_pkcs11.h"
+
+#endif //MBEDTLS_PKCS11_H
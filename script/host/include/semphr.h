@@ -0,0 +1,21 @@
+/***********************************************************************************************************************
+ * File Name    : semphr.h
+ * Description  : Host build of the FreeRTOS mutex API mbedtls_rng_pkcs11.c uses, single threaded so always taken
+ **********************************************************************************************************************/
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct
+{
+    int taken;
+}StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+#define xSemaphoreCreateMutexStatic(buffer)     (buffer)
+#define xSemaphoreTake(mutex, ticks)            ((mutex)->taken = 1, pdTRUE)
+#define xSemaphoreGive(mutex)                   ((mutex)->taken = 0, pdTRUE)
+
+#endif //SEMPHR_H
@@ -0,0 +1,252 @@
+/***********************************************************************************************************************
+ * File Name    : pkcs11_cache_bench.c
+ * Description  : Host benchmark of the TLS client credential work done on every reconnect, with and without the
+ *                parsed certificate cache of cloud_prov_pkcs11_cache.c
+ **********************************************************************************************************************/
+
+/* Build and run on the host from the repository root, against the mbedTLS of the host (2.28 or 3.x), e.g.
+ * cc -O2 -I script/host/include -I src/cloud_prov script/host/pkcs11_cache_bench.c \
+ *    -lmbedx509 -lmbedcrypto -o pkcs11_cache_bench
+ * ./pkcs11_cache_bench
+ *
+ * On every TLS connection the transport parses the client certificate DER it read through corePKCS11, and corePKCS11
+ * parses the private key DER twice, for CKA_KEY_TYPE and in C_SignInit. The cache now keeps the parsed certificate,
+ * so a reconnect compares the DER with the cached one instead of parsing it, while the key is still parsed twice:
+ * it is no longer kept in RAM between connections. The certificate is the claim certificate of cloud_prov_config.h,
+ * issued by AWS IoT like the device certificate. Keys are the RSA-2048 claim key and a P-256 key as generated in
+ * CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS. littleFS reads are not part of this benchmark, they only exist on target.
+ * Exits with 1 if a credential does not parse or the cache comparison does not tell certificates apart. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mbedtls/version.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "cloud_prov_config.h"
+
+/**********************************************************************************************************************
+                                    MACRO DEFINITIONS
+**********************************************************************************************************************/
+#define P11_CACHE_BENCH_ITERATIONS      (2000u)
+#define P11_CACHE_BENCH_DER_SIZE        (2048u)
+
+/** @brief Private key parses per connection: C_GetAttributeValue(CKA_KEY_TYPE) then C_SignInit */
+#define P11_CACHE_BENCH_KEY_PARSES      (2u)
+
+/**********************************************************************************************************************
+                                    TYPE DEFINITIONS
+**********************************************************************************************************************/
+typedef struct
+{
+    const char *name;
+    const unsigned char *der;
+    size_t length;
+}P11CacheBenchKey_t;
+
+/**********************************************************************************************************************
+                                    LOCAL VARIABLES
+**********************************************************************************************************************/
+
+/** @brief Throwaway P-256 key in the SEC1 DER layout corePKCS11 stores generated keys with, for this benchmark only */
+static const unsigned char P11CacheBenchEcKeyDer[] =
+        {
+            0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0x7a, 0x11, 0xe6, 0xd5, 0x36,
+            0xf6, 0x18, 0x70, 0x6a, 0x43, 0xe8, 0x03, 0x53, 0xa2, 0x6e, 0x89, 0xbf,
+            0xfc, 0x13, 0x2d, 0x3d, 0xbe, 0x5b, 0xb0, 0x8e, 0x18, 0xde, 0xa2, 0x68,
+            0x12, 0xa9, 0xe8, 0xa0, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d,
+            0x03, 0x01, 0x07, 0xa1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x67, 0x84, 0x90,
+            0x88, 0x47, 0x00, 0xf4, 0x5a, 0xfd, 0x22, 0x76, 0x34, 0xcd, 0xe6, 0x15,
+            0x29, 0x4e, 0x9d, 0x7f, 0x41, 0x70, 0xb5, 0x2c, 0x1d, 0x66, 0x92, 0x8d,
+            0x04, 0x91, 0x74, 0x67, 0x28, 0x64, 0x03, 0xa2, 0x60, 0xa8, 0x49, 0x9c,
+            0xcf, 0x8d, 0x20, 0xa4, 0xcd, 0x6d, 0x66, 0xde, 0x44, 0x48, 0xe8, 0xa1,
+            0x75, 0x77, 0x54, 0x37, 0x6a, 0x8f, 0x3c, 0xa3, 0xf1, 0x82, 0xe7, 0xf8,
+            0x70
+        };
+
+static unsigned char P11CacheBenchCertDer[P11_CACHE_BENCH_DER_SIZE];
+static size_t P11CacheBenchCertLength;
+static unsigned char P11CacheBenchRsaKeyDer[P11_CACHE_BENCH_DER_SIZE];
+static size_t P11CacheBenchRsaKeyLength;
+
+/** @brief Keeps the comparisons from being optimized out */
+static volatile int P11CacheBenchSink;
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+static double P11CacheBench_NowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+#if (MBEDTLS_VERSION_MAJOR >= 3)
+static int P11CacheBench_Rng(void *ctx, unsigned char *output, size_t length)
+{
+    (void)ctx;
+    for(size_t index = 0u; index < length; index++)
+    {
+        output[index] = (unsigned char)rand();
+    }
+    return 0;
+}
+#endif
+
+/** @brief DER body of a PEM object, as corePKCS11 stores it */
+static size_t P11CacheBench_PemToDer(const char *pem, unsigned char *der, size_t derSize)
+{
+    const char *body = strchr(pem, '\n');
+    const char *footer = strstr(pem, "-----END");
+    char base64[P11_CACHE_BENCH_DER_SIZE * 2u];
+    size_t base64Length = 0u;
+    size_t derLength = 0u;
+
+    for(const char *cursor = body; (cursor != NULL) && (cursor < footer); cursor++)
+    {
+        if((*cursor != '\n') && (*cursor != '\r') && (base64Length < sizeof(base64)))
+        {
+            base64[base64Length++] = *cursor;
+        }
+    }
+    if((body == NULL) || (footer == NULL) ||
+       (mbedtls_base64_decode(der, derSize, &derLength, (const unsigned char *)base64, base64Length) != 0))
+    {
+        derLength = 0u;
+    }
+    return derLength;
+}
+
+static int P11CacheBench_ParseCert(const unsigned char *der, size_t length)
+{
+    mbedtls_x509_crt cert;
+    int ret;
+
+    mbedtls_x509_crt_init(&cert);
+    ret = mbedtls_x509_crt_parse_der(&cert, der, length);
+    mbedtls_x509_crt_free(&cert);
+    return ret;
+}
+
+static int P11CacheBench_ParseKey(const unsigned char *der, size_t length)
+{
+    mbedtls_pk_context key;
+    int ret;
+
+    mbedtls_pk_init(&key);
+#if (MBEDTLS_VERSION_MAJOR >= 3)
+    ret = mbedtls_pk_parse_key(&key, der, length, NULL, 0u, P11CacheBench_Rng, NULL);
+#else
+    ret = mbedtls_pk_parse_key(&key, der, length, NULL, 0u);
+#endif
+    mbedtls_pk_free(&key);
+    return ret;
+}
+
+/** @brief Average time of one certificate parse, in microseconds */
+static double P11CacheBench_TimeCertParse(void)
+{
+    double start = P11CacheBench_NowUs();
+
+    for(uint32_t iteration = 0u; iteration < P11_CACHE_BENCH_ITERATIONS; iteration++)
+    {
+        P11CacheBenchSink += P11CacheBench_ParseCert(P11CacheBenchCertDer, P11CacheBenchCertLength);
+    }
+    return (P11CacheBench_NowUs() - start) / P11_CACHE_BENCH_ITERATIONS;
+}
+
+/** @brief Average time of the cache hit test of CloudProv_CredentialCacheParseCert, in microseconds */
+static double P11CacheBench_TimeCertCompare(const unsigned char *transportCopy)
+{
+    double start = P11CacheBench_NowUs();
+
+    for(uint32_t iteration = 0u; iteration < P11_CACHE_BENCH_ITERATIONS; iteration++)
+    {
+        P11CacheBenchSink += memcmp(P11CacheBenchCertDer, transportCopy, P11CacheBenchCertLength);
+    }
+    return (P11CacheBench_NowUs() - start) / P11_CACHE_BENCH_ITERATIONS;
+}
+
+/** @brief Average time of one private key parse, in microseconds */
+static double P11CacheBench_TimeKeyParse(const P11CacheBenchKey_t *key)
+{
+    double start = P11CacheBench_NowUs();
+
+    for(uint32_t iteration = 0u; iteration < P11_CACHE_BENCH_ITERATIONS; iteration++)
+    {
+        P11CacheBenchSink += P11CacheBench_ParseKey(key->der, key->length);
+    }
+    return (P11CacheBench_NowUs() - start) / P11_CACHE_BENCH_ITERATIONS;
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+int main(void)
+{
+    P11CacheBenchKey_t keys[2];
+    unsigned char transportCopy[P11_CACHE_BENCH_DER_SIZE];
+    double certParseUs;
+    double certCompareUs;
+    double keyParseUs;
+    double beforeUs;
+    double afterUs;
+    int failed = 0;
+
+    P11CacheBenchCertLength = P11CacheBench_PemToDer(CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM,
+                                                     P11CacheBenchCertDer, sizeof(P11CacheBenchCertDer));
+    P11CacheBenchRsaKeyLength = P11CacheBench_PemToDer(CLOUD_PROV_DEFAULT_CLAIM_PRIVATE_KEY_PEM,
+                                                       P11CacheBenchRsaKeyDer, sizeof(P11CacheBenchRsaKeyDer));
+    keys[0] = (P11CacheBenchKey_t){ "RSA-2048", P11CacheBenchRsaKeyDer, P11CacheBenchRsaKeyLength };
+    keys[1] = (P11CacheBenchKey_t){ "P-256", P11CacheBenchEcKeyDer, sizeof(P11CacheBenchEcKeyDer) };
+
+    if((P11CacheBenchCertLength == 0u) || (P11CacheBench_ParseCert(P11CacheBenchCertDer, P11CacheBenchCertLength) != 0))
+    {
+        printf("FAIL: claim certificate does not parse\n");
+        failed = 1;
+    }
+    for(uint32_t index = 0u; index < 2u; index++)
+    {
+        if((keys[index].length == 0u) || (P11CacheBench_ParseKey(keys[index].der, keys[index].length) != 0))
+        {
+            printf("FAIL: %s key does not parse\n", keys[index].name);
+            failed = 1;
+        }
+    }
+
+    /* The transport parses its own copy of the DER, read through C_GetAttributeValue. A certificate differing by
+     * its last byte, the signature, must not hit the cache */
+    memcpy(transportCopy, P11CacheBenchCertDer, P11CacheBenchCertLength);
+    transportCopy[P11CacheBenchCertLength - 1u] ^= 0x01u;
+    if(memcmp(P11CacheBenchCertDer, transportCopy, P11CacheBenchCertLength) == 0)
+    {
+        printf("FAIL: replaced certificate hits the cache\n");
+        failed = 1;
+    }
+    transportCopy[P11CacheBenchCertLength - 1u] ^= 0x01u;
+
+    if(failed == 0)
+    {
+        printf("mbedTLS %d.%d, certificate %zu bytes DER, %u iterations\n",
+               MBEDTLS_VERSION_MAJOR, MBEDTLS_VERSION_MINOR, P11CacheBenchCertLength, P11_CACHE_BENCH_ITERATIONS);
+        certParseUs = P11CacheBench_TimeCertParse();
+        certCompareUs = P11CacheBench_TimeCertCompare(transportCopy);
+        printf("certificate parse %8.2f us, cache hit compare %6.3f us\n", certParseUs, certCompareUs);
+
+        for(uint32_t index = 0u; index < 2u; index++)
+        {
+            keyParseUs = P11CacheBench_TimeKeyParse(&keys[index]);
+            beforeUs = certParseUs + (P11_CACHE_BENCH_KEY_PARSES * keyParseUs);
+            afterUs = certCompareUs + (P11_CACHE_BENCH_KEY_PARSES * keyParseUs);
+            printf("%-8s key parse %8.2f us, per reconnect %8.2f us -> %8.2f us (%.0f%% less)\n",
+                   keys[index].name, keyParseUs, beforeUs, afterUs, 100.0 * (beforeUs - afterUs) / beforeUs);
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,250 @@
+/***********************************************************************************************************************
+ * File Name    : rng_pool_bench.c
+ * Description  : Host benchmark of the mbedTLS random requests of a TLS handshake, served by C_GenerateRandom one
+ *                by one or by the CTR-DRBG pool of mbedtls_rng_pkcs11.c
+ **********************************************************************************************************************/
+
+/* Build and run on the host from the repository root, against the mbedTLS of the host (2.28 or 3.x), e.g.
+ * cc -O2 -I script/host/include -I src/cloud_prov script/host/rng_pool_bench.c -lmbedcrypto -o rng_pool_bench
+ * ./rng_pool_bench
+ *
+ * mbedtls_rng_pkcs11.c is built as is, with the FreeRTOS and corePKCS11 headers of script/host/include. The PKCS #11
+ * module is emulated the way corePKCS11 implements C_GenerateRandom, a CTR-DRBG of its own, seeded from the host
+ * entropy instead of the TRNG, so the times only compare the software paths: on target the DRBG AES runs on the SCE.
+ * The handshake trace is the list of mbedTLS RNG requests of an ECDHE P-256 client handshake, read from the mbedTLS
+ * sources, not counted on target: the client random, the ECDHE private key and the blinding of the two point
+ * multiplications. Client signatures go through C_Sign and the DRBG of corePKCS11, not the mbedTLS RNG.
+ * Exits with 1 if mbedtls_ssl_conf_rng does not get the pool, or a random request fails. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+#include "mbedtls/version.h"
+
+/** @brief SdkLog of the firmware logging stack, for the errors of mbedtls_rng_pkcs11.c */
+#define SdkLog(message)     printf message
+
+#include "mbedtls_rng_pkcs11.c"
+
+/**********************************************************************************************************************
+                                    MACRO DEFINITIONS
+**********************************************************************************************************************/
+#define RNG_POOL_BENCH_HANDSHAKES       (10000u)
+#define RNG_POOL_BENCH_STREAM_BYTES     (4u * 1024u * 1024u)
+#define RNG_POOL_BENCH_STREAM_REQUEST   (32u)
+#define RNG_POOL_BENCH_REQUESTS         (sizeof(RngPoolBenchHandshake) / sizeof(RngPoolBenchHandshake[0]))
+
+/**********************************************************************************************************************
+                                    TYPE DEFINITIONS
+**********************************************************************************************************************/
+typedef int (*RngPoolBenchRng_t)(void *ctx, unsigned char *output, size_t length);
+
+typedef struct
+{
+    uint32_t calls;
+    uint32_t bytes;
+}RngPoolBenchCounters_t;
+
+/**********************************************************************************************************************
+                                    LOCAL VARIABLES
+**********************************************************************************************************************/
+
+/** @brief mbedTLS RNG requests of one ECDHE P-256 client handshake */
+static const size_t RngPoolBenchHandshake[] =
+        {
+            32u,    /* ClientHello random */
+            32u,    /* ECDHE private key, mbedtls_ecp_gen_privkey */
+            32u,    /* Blinding of the ECDHE public key multiplication */
+            32u,    /* Blinding of the shared secret multiplication */
+        };
+
+/** @brief DRBG behind the emulated C_GenerateRandom, as in corePKCS11 */
+static mbedtls_ctr_drbg_context RngPoolBenchP11Drbg;
+
+/** @brief Last session opened by xInitializePkcs11Session, 0 once closed */
+static CK_SESSION_HANDLE RngPoolBenchOpenSession = CK_INVALID_HANDLE;
+
+static RngPoolBenchCounters_t RngPoolBenchP11Counters;
+
+/** @brief RNG the wrapped mbedtls_ssl_conf_rng handed over to mbedTLS */
+static RngPoolBenchRng_t RngPoolBenchConfiguredRng = NULL;
+
+static unsigned char RngPoolBenchOutput[RNG_POOL_BENCH_STREAM_REQUEST];
+
+/**********************************************************************************************************************
+                                    EMULATED MODULES
+**********************************************************************************************************************/
+static int RngPoolBench_HostEntropy(void *ctx, unsigned char *output, size_t length)
+{
+    (void)ctx;
+    return (getrandom(output, length, 0) == (ssize_t)length) ? 0 : -1;
+}
+
+static CK_RV RngPoolBench_GenerateRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pRandomData, CK_ULONG ulRandomLen)
+{
+    CK_RV result = CKR_FUNCTION_FAILED;
+
+    if((hSession != CK_INVALID_HANDLE) && (hSession == RngPoolBenchOpenSession) &&
+       (mbedtls_ctr_drbg_random(&RngPoolBenchP11Drbg, pRandomData, ulRandomLen) == 0))
+    {
+        RngPoolBenchP11Counters.calls++;
+        RngPoolBenchP11Counters.bytes += (uint32_t)ulRandomLen;
+        result = CKR_OK;
+    }
+    return result;
+}
+
+static CK_FUNCTION_LIST RngPoolBenchFunctionList = { RngPoolBench_GenerateRandom };
+
+CK_RV C_GetFunctionList(CK_FUNCTION_LIST_PTR_PTR ppFunctionList)
+{
+    *ppFunctionList = &RngPoolBenchFunctionList;
+    return CKR_OK;
+}
+
+CK_RV xInitializePkcs11Session(CK_SESSION_HANDLE *pxSession)
+{
+    *pxSession = ++RngPoolBenchOpenSession;
+    return CKR_OK;
+}
+
+CK_RV C_CloseSession(CK_SESSION_HANDLE hSession)
+{
+    (void)hSession;
+    RngPoolBenchOpenSession = CK_INVALID_HANDLE;
+    return CKR_OK;
+}
+
+/** @brief Direct path, as lMbedCryptoRngCallbackPKCS11 of cloud_prov_pkcs11.c */
+int lMbedCryptoRngCallbackPKCS11(void *pvCtx, unsigned char *pucOutput, size_t uxLen)
+{
+    CK_FUNCTION_LIST_PTR pxFunctionList = NULL;
+    int lRslt = -1;
+
+    if((pvCtx != NULL) && (pucOutput != NULL) && (C_GetFunctionList(&pxFunctionList) == CKR_OK))
+    {
+        lRslt = (int)pxFunctionList->C_GenerateRandom(*(CK_SESSION_HANDLE *)pvCtx, pucOutput, uxLen);
+    }
+    return lRslt;
+}
+
+void __real_mbedtls_ssl_conf_rng(mbedtls_ssl_config *conf,
+                                 int (*f_rng)(void *, unsigned char *, size_t),
+                                 void *p_rng)
+{
+    (void)conf;
+    (void)p_rng;
+    RngPoolBenchConfiguredRng = f_rng;
+}
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+static double RngPoolBench_NowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+/** @brief Replay the handshake trace, returns the average time of one handshake in microseconds or -1 on failure */
+static double RngPoolBench_Handshakes(RngPoolBenchRng_t rng, void *ctx)
+{
+    double start = RngPoolBench_NowUs();
+
+    for(uint32_t handshake = 0u; handshake < RNG_POOL_BENCH_HANDSHAKES; handshake++)
+    {
+        for(size_t request = 0u; request < RNG_POOL_BENCH_REQUESTS; request++)
+        {
+            if(rng(ctx, RngPoolBenchOutput, RngPoolBenchHandshake[request]) != 0)
+            {
+                return -1.0;
+            }
+        }
+    }
+    return (RngPoolBench_NowUs() - start) / RNG_POOL_BENCH_HANDSHAKES;
+}
+
+/** @brief Stream of fixed size requests, returns MB/s or -1 on failure */
+static double RngPoolBench_Stream(RngPoolBenchRng_t rng, void *ctx)
+{
+    double start = RngPoolBench_NowUs();
+
+    for(uint32_t done = 0u; done < RNG_POOL_BENCH_STREAM_BYTES; done += RNG_POOL_BENCH_STREAM_REQUEST)
+    {
+        if(rng(ctx, RngPoolBenchOutput, RNG_POOL_BENCH_STREAM_REQUEST) != 0)
+        {
+            return -1.0;
+        }
+    }
+    return RNG_POOL_BENCH_STREAM_BYTES / (RngPoolBench_NowUs() - start);
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+int main(void)
+{
+    CK_SESSION_HANDLE transportSession = CK_INVALID_HANDLE;
+    mbedtls_ssl_config conf;
+    RngPoolStats_t stats;
+    double directUs;
+    double poolUs;
+    double directMBps;
+    double poolMBps;
+    RngPoolBenchCounters_t direct;
+    int failed = 0;
+
+    mbedtls_ctr_drbg_init(&RngPoolBenchP11Drbg);
+    if(mbedtls_ctr_drbg_seed(&RngPoolBenchP11Drbg, RngPoolBench_HostEntropy, NULL, NULL, 0u) != 0)
+    {
+        printf("FAIL: host DRBG does not seed\n");
+        return 1;
+    }
+
+    /* The transport configures C_GenerateRandom on its session, the wrap must hand the pool to mbedTLS */
+    (void)xInitializePkcs11Session(&transportSession);
+    __wrap_mbedtls_ssl_conf_rng(&conf, lMbedCryptoRngCallbackPKCS11, &transportSession);
+    if(RngPoolBenchConfiguredRng != lMbedCryptoRngCallbackPool)
+    {
+        printf("FAIL: mbedtls_ssl_conf_rng does not configure the pool\n");
+        failed = 1;
+    }
+
+    directUs = RngPoolBench_Handshakes(lMbedCryptoRngCallbackPKCS11, &transportSession);
+    direct = RngPoolBenchP11Counters;
+    directMBps = RngPoolBench_Stream(lMbedCryptoRngCallbackPKCS11, &transportSession);
+    (void)C_CloseSession(transportSession);
+
+    /* The transport session is closed now, the pool must seed and reseed through a session of its own */
+    memset(&RngPoolBenchP11Counters, 0, sizeof(RngPoolBenchP11Counters));
+    poolUs = RngPoolBench_Handshakes(lMbedCryptoRngCallbackPool, &transportSession);
+    vMbedCryptoRngPoolGetStats(&stats);
+    poolMBps = RngPoolBench_Stream(lMbedCryptoRngCallbackPool, &transportSession);
+
+    if((directUs < 0.0) || (directMBps < 0.0) || (poolUs < 0.0) || (poolMBps < 0.0))
+    {
+        printf("FAIL: a random request failed\n");
+        failed = 1;
+    }
+
+    if(failed == 0)
+    {
+        printf("mbedTLS %d.%d, %u handshakes of %zu requests, pool of %u bytes reseeded every %d refills\n",
+               MBEDTLS_VERSION_MAJOR, MBEDTLS_VERSION_MINOR, RNG_POOL_BENCH_HANDSHAKES, RNG_POOL_BENCH_REQUESTS,
+               (unsigned int)mbedtlsRNG_PKCS11_POOL_SIZE, mbedtlsRNG_PKCS11_RESEED_INTERVAL);
+        printf("direct: %6.3f C_GenerateRandom calls per handshake, %7.3f us per handshake\n",
+               (double)direct.calls / RNG_POOL_BENCH_HANDSHAKES, directUs);
+        printf("pool:   %6.3f C_GenerateRandom calls per handshake, %7.3f us per handshake, %lu refills\n",
+               (double)stats.ulEntropyCalls / RNG_POOL_BENCH_HANDSHAKES, poolUs, (unsigned long)stats.ulPoolRefills);
+        printf("%u-byte requests: direct %7.2f MB/s, pool %7.2f MB/s\n",
+               RNG_POOL_BENCH_STREAM_REQUEST, directMBps, poolMBps);
+    }
+
+    mbedtls_ctr_drbg_free(&RngPoolBenchP11Drbg);
+    return failed;
+}
@@ -0,0 +1,417 @@
+/***********************************************************************************************************************
+ * File Name    : tls_handshake_profile.c
+ * Description  : Host benchmark of the TLS client handshake against a local mbedTLS server, broken down per
+ *                handshake state the same way as the CLOUD_PROV_TLS_PROFILER build of cloud_prov_tls_profiler.c
+ **********************************************************************************************************************/
+
+/* Build and run on the host from the repository root, against the mbedTLS of the host (2.28 or 3.x), e.g.
+ * cc -O2 -I script/host/include -I src/cloud_prov script/host/tls_handshake_profile.c \
+ *    -lmbedtls -lmbedx509 -lmbedcrypto -lpthread -o tls_handshake_profile
+ * ./tls_handshake_profile [handshakes] [port]
+ *
+ * A server thread listens on 127.0.0.1 with a P-256 certificate generated at start, and asks for a client
+ * certificate like AWS IoT. The client authenticates with the claim credentials of cloud_prov_config.h, RSA-2048, and
+ * offers the cipher suite of the low memory TLS profile, TLS 1.2 only as on target. Each mbedtls_ssl_handshake_step
+ * is charged to the state it started in, so the states waiting for a server flight include the server work, as the
+ * wait for the broker does on target. The key is used by mbedTLS directly, not through PKCS #11.
+ * Exits with 1 if a handshake fails. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "mbedtls/version.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/bignum.h"
+#if defined(MBEDTLS_PSA_CRYPTO_C)
+#include "psa/crypto.h"
+#endif
+#include "cloud_prov_config.h"
+
+/* mbedTLS 2.28 has public context members */
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member)     member
+#endif
+
+/**********************************************************************************************************************
+                                    MACRO DEFINITIONS
+**********************************************************************************************************************/
+#define TLS_PROFILE_DEFAULT_HANDSHAKES  (200u)
+#define TLS_PROFILE_DEFAULT_PORT        "14433"
+#define TLS_PROFILE_HOST                "127.0.0.1"
+#define TLS_PROFILE_SERVER_NAME         "localhost"
+#define TLS_PROFILE_CERT_SIZE           (1024u)
+
+/** @brief TLS 1.2 handshake states are all below MBEDTLS_SSL_HANDSHAKE_OVER, anything else lands in the last slot */
+#define TLS_PROFILE_STATE_COUNT         ((uint32_t)MBEDTLS_SSL_HANDSHAKE_OVER + 1u)
+
+/**********************************************************************************************************************
+                                    TYPE DEFINITIONS
+**********************************************************************************************************************/
+typedef struct
+{
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+    mbedtls_x509_crt cert;
+    mbedtls_pk_context key;
+}TlsProfileEndpoint_t;
+
+typedef struct
+{
+    double connectUs;
+    double stateUs[TLS_PROFILE_STATE_COUNT];
+    uint32_t stateSteps[TLS_PROFILE_STATE_COUNT];
+}TlsProfile_t;
+
+/**********************************************************************************************************************
+                                    LOCAL VARIABLES
+**********************************************************************************************************************/
+
+/** @brief Cipher suite of the low memory TLS profile, see cloud_prov_tls_profile.c */
+static const int TlsProfileCipherSuites[] =
+        {
+            MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+            0
+        };
+
+/** @brief Names of TLS 1.2 client handshake states, as in cloud_prov_tls_profiler.c */
+static const char * const TlsProfileStateNames[TLS_PROFILE_STATE_COUNT] =
+        {
+            [MBEDTLS_SSL_HELLO_REQUEST] =           "HELLO_REQUEST",
+            [MBEDTLS_SSL_CLIENT_HELLO] =            "CLIENT_HELLO",
+            [MBEDTLS_SSL_SERVER_HELLO] =            "SERVER_HELLO",
+            [MBEDTLS_SSL_SERVER_CERTIFICATE] =      "SERVER_CERTIFICATE",
+            [MBEDTLS_SSL_SERVER_KEY_EXCHANGE] =     "SERVER_KEY_EXCHANGE",
+            [MBEDTLS_SSL_CERTIFICATE_REQUEST] =     "CERTIFICATE_REQUEST",
+            [MBEDTLS_SSL_SERVER_HELLO_DONE] =       "SERVER_HELLO_DONE",
+            [MBEDTLS_SSL_CLIENT_CERTIFICATE] =      "CLIENT_CERTIFICATE",
+            [MBEDTLS_SSL_CLIENT_KEY_EXCHANGE] =     "CLIENT_KEY_EXCHANGE",
+            [MBEDTLS_SSL_CERTIFICATE_VERIFY] =      "CERTIFICATE_VERIFY",
+            [MBEDTLS_SSL_CLIENT_CHANGE_CIPHER_SPEC]="CLIENT_CHANGE_CIPHER_SPEC",
+            [MBEDTLS_SSL_CLIENT_FINISHED] =         "CLIENT_FINISHED",
+            [MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC]="SERVER_CHANGE_CIPHER_SPEC",
+            [MBEDTLS_SSL_SERVER_FINISHED] =         "SERVER_FINISHED",
+            [MBEDTLS_SSL_FLUSH_BUFFERS] =           "FLUSH_BUFFERS",
+            [MBEDTLS_SSL_HANDSHAKE_WRAPUP] =        "HANDSHAKE_WRAPUP",
+            [MBEDTLS_SSL_HANDSHAKE_OVER] =          "OTHER",
+        };
+
+static const char TlsProfileClaimCertPem[] = CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM;
+static const char TlsProfileClaimKeyPem[] = CLOUD_PROV_DEFAULT_CLAIM_PRIVATE_KEY_PEM;
+
+static TlsProfileEndpoint_t TlsProfileServer;
+static TlsProfileEndpoint_t TlsProfileClient;
+static mbedtls_net_context TlsProfileListen;
+static uint32_t TlsProfileHandshakes = TLS_PROFILE_DEFAULT_HANDSHAKES;
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+static double TlsProfile_NowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+static int TlsProfile_EndpointInit(TlsProfileEndpoint_t *endpoint, int role, const char *personalization)
+{
+    int ret;
+
+    mbedtls_entropy_init(&endpoint->entropy);
+    mbedtls_ctr_drbg_init(&endpoint->drbg);
+    mbedtls_ssl_config_init(&endpoint->conf);
+    mbedtls_ssl_init(&endpoint->ssl);
+    mbedtls_x509_crt_init(&endpoint->cert);
+    mbedtls_pk_init(&endpoint->key);
+
+    ret = mbedtls_ctr_drbg_seed(&endpoint->drbg, mbedtls_entropy_func, &endpoint->entropy,
+                                (const unsigned char *)personalization, strlen(personalization));
+    if(ret == 0)
+    {
+        ret = mbedtls_ssl_config_defaults(&endpoint->conf, role, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if(ret == 0)
+    {
+        mbedtls_ssl_conf_rng(&endpoint->conf, mbedtls_ctr_drbg_random, &endpoint->drbg);
+        mbedtls_ssl_conf_ciphersuites(&endpoint->conf, TlsProfileCipherSuites);
+#if (MBEDTLS_VERSION_NUMBER >= 0x03020000)
+        mbedtls_ssl_conf_max_tls_version(&endpoint->conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#else
+        mbedtls_ssl_conf_max_version(&endpoint->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+#endif
+    }
+    return ret;
+}
+
+/** @brief Self-signed P-256 certificate of the server, the client trusts it as its root CA */
+static int TlsProfile_ServerCredentials(TlsProfileEndpoint_t *server)
+{
+    mbedtls_x509write_cert writer;
+    mbedtls_mpi serial;
+    unsigned char der[TLS_PROFILE_CERT_SIZE];
+    int length;
+    int ret;
+
+    mbedtls_x509write_crt_init(&writer);
+    mbedtls_mpi_init(&serial);
+
+    ret = mbedtls_pk_setup(&server->key, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    if(ret == 0)
+    {
+        ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(server->key),
+                                  mbedtls_ctr_drbg_random, &server->drbg);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_mpi_lset(&serial, 1);
+    }
+    if(ret == 0)
+    {
+        mbedtls_x509write_crt_set_version(&writer, MBEDTLS_X509_CRT_VERSION_3);
+        mbedtls_x509write_crt_set_md_alg(&writer, MBEDTLS_MD_SHA256);
+        mbedtls_x509write_crt_set_subject_key(&writer, &server->key);
+        mbedtls_x509write_crt_set_issuer_key(&writer, &server->key);
+        ret = mbedtls_x509write_crt_set_subject_name(&writer, "CN=" TLS_PROFILE_SERVER_NAME);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_x509write_crt_set_issuer_name(&writer, "CN=" TLS_PROFILE_SERVER_NAME);
+    }
+    if(ret == 0)
+    {
+#if (MBEDTLS_VERSION_NUMBER >= 0x03040000)
+        unsigned char serialRaw[1] = { 1u };
+        ret = mbedtls_x509write_crt_set_serial_raw(&writer, serialRaw, sizeof(serialRaw));
+#else
+        ret = mbedtls_x509write_crt_set_serial(&writer, &serial);
+#endif
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_x509write_crt_set_validity(&writer, "20240101000000", "20991231235959");
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_x509write_crt_set_basic_constraints(&writer, 1, -1);
+    }
+    if(ret == 0)
+    {
+        /* The certificate is written at the end of the buffer */
+        length = mbedtls_x509write_crt_der(&writer, der, sizeof(der), mbedtls_ctr_drbg_random, &server->drbg);
+        ret = (length < 0) ? length : mbedtls_x509_crt_parse_der(&server->cert, &der[sizeof(der) - length],
+                                                                 (size_t)length);
+    }
+
+    mbedtls_mpi_free(&serial);
+    mbedtls_x509write_crt_free(&writer);
+    return ret;
+}
+
+static int TlsProfile_ClientCredentials(TlsProfileEndpoint_t *client)
+{
+    int ret;
+
+    ret = mbedtls_x509_crt_parse(&client->cert, (const unsigned char *)TlsProfileClaimCertPem,
+                                 sizeof(TlsProfileClaimCertPem));
+    if(ret == 0)
+    {
+#if (MBEDTLS_VERSION_MAJOR >= 3)
+        ret = mbedtls_pk_parse_key(&client->key, (const unsigned char *)TlsProfileClaimKeyPem,
+                                   sizeof(TlsProfileClaimKeyPem), NULL, 0u, mbedtls_ctr_drbg_random, &client->drbg);
+#else
+        ret = mbedtls_pk_parse_key(&client->key, (const unsigned char *)TlsProfileClaimKeyPem,
+                                   sizeof(TlsProfileClaimKeyPem), NULL, 0u);
+#endif
+    }
+    return ret;
+}
+
+static void *TlsProfile_ServerTask(void *arg)
+{
+    mbedtls_net_context connection;
+    int ret;
+
+    (void)arg;
+    mbedtls_net_init(&connection);
+
+    for(uint32_t handshake = 0u; handshake < TlsProfileHandshakes; handshake++)
+    {
+        if(mbedtls_net_accept(&TlsProfileListen, &connection, NULL, 0u, NULL) != 0)
+        {
+            break;
+        }
+        (void)mbedtls_ssl_session_reset(&TlsProfileServer.ssl);
+        mbedtls_ssl_set_bio(&TlsProfileServer.ssl, &connection, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+        do
+        {
+            ret = mbedtls_ssl_handshake(&TlsProfileServer.ssl);
+        }while((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE));
+
+        if(ret == 0)
+        {
+            (void)mbedtls_ssl_close_notify(&TlsProfileServer.ssl);
+        }
+        mbedtls_net_free(&connection);
+    }
+    return NULL;
+}
+
+/** @brief One client connection, its TCP connect and handshake steps added to the profile */
+static int TlsProfile_Connect(const char *port, TlsProfile_t *profile)
+{
+    mbedtls_net_context connection;
+    uint32_t state;
+    double startUs;
+    int ret;
+
+    mbedtls_net_init(&connection);
+
+    startUs = TlsProfile_NowUs();
+    ret = mbedtls_net_connect(&connection, TLS_PROFILE_HOST, port, MBEDTLS_NET_PROTO_TCP);
+    profile->connectUs += TlsProfile_NowUs() - startUs;
+
+    if(ret == 0)
+    {
+        ret = mbedtls_ssl_session_reset(&TlsProfileClient.ssl);
+    }
+    if(ret == 0)
+    {
+        mbedtls_ssl_set_bio(&TlsProfileClient.ssl, &connection, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+        /* Same loop as the handshake wrapper of cloud_prov_tls_profiler.c */
+        while((ret == 0) && (TlsProfileClient.ssl.MBEDTLS_PRIVATE(state) < MBEDTLS_SSL_HANDSHAKE_OVER))
+        {
+            state = (uint32_t)TlsProfileClient.ssl.MBEDTLS_PRIVATE(state);
+
+            startUs = TlsProfile_NowUs();
+            ret = mbedtls_ssl_handshake_step(&TlsProfileClient.ssl);
+            profile->stateUs[state] += TlsProfile_NowUs() - startUs;
+            profile->stateSteps[state]++;
+        }
+    }
+    if(ret == 0)
+    {
+        (void)mbedtls_ssl_close_notify(&TlsProfileClient.ssl);
+    }
+
+    mbedtls_net_free(&connection);
+    return ret;
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+int main(int argc, char *argv[])
+{
+    const char *port = (argc > 2) ? argv[2] : TLS_PROFILE_DEFAULT_PORT;
+    static TlsProfile_t profile;
+    pthread_t serverThread;
+    double handshakeUs = 0.0;
+    uint32_t handshake = 0u;
+    int ret;
+
+    if(argc > 1)
+    {
+        TlsProfileHandshakes = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+
+#if defined(MBEDTLS_PSA_CRYPTO_C)
+    (void)psa_crypto_init();
+#endif
+
+    mbedtls_net_init(&TlsProfileListen);
+    ret = TlsProfile_EndpointInit(&TlsProfileServer, MBEDTLS_SSL_IS_SERVER, "tls_profile_server");
+    if(ret == 0)
+    {
+        ret = TlsProfile_EndpointInit(&TlsProfileClient, MBEDTLS_SSL_IS_CLIENT, "tls_profile_client");
+    }
+    if(ret == 0)
+    {
+        ret = TlsProfile_ServerCredentials(&TlsProfileServer);
+    }
+    if(ret == 0)
+    {
+        ret = TlsProfile_ClientCredentials(&TlsProfileClient);
+    }
+    if(ret == 0)
+    {
+        /* Mutual authentication, as with AWS IoT. The server has no CA for the claim certificate, it asks for the
+         * client certificate and CertificateVerify all the same */
+        mbedtls_ssl_conf_authmode(&TlsProfileServer.conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+        ret = mbedtls_ssl_conf_own_cert(&TlsProfileServer.conf, &TlsProfileServer.cert, &TlsProfileServer.key);
+    }
+    if(ret == 0)
+    {
+        mbedtls_ssl_conf_authmode(&TlsProfileClient.conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&TlsProfileClient.conf, &TlsProfileServer.cert, NULL);
+        ret = mbedtls_ssl_conf_own_cert(&TlsProfileClient.conf, &TlsProfileClient.cert, &TlsProfileClient.key);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_ssl_setup(&TlsProfileServer.ssl, &TlsProfileServer.conf);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_ssl_setup(&TlsProfileClient.ssl, &TlsProfileClient.conf);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_ssl_set_hostname(&TlsProfileClient.ssl, TLS_PROFILE_SERVER_NAME);
+    }
+    if(ret == 0)
+    {
+        ret = mbedtls_net_bind(&TlsProfileListen, TLS_PROFILE_HOST, port, MBEDTLS_NET_PROTO_TCP);
+    }
+    if((ret == 0) && (pthread_create(&serverThread, NULL, TlsProfile_ServerTask, NULL) != 0))
+    {
+        ret = -1;
+    }
+    if(ret != 0)
+    {
+        printf("FAIL: setup error -0x%04x\n", (unsigned int)-ret);
+        return 1;
+    }
+
+    for(handshake = 0u; (handshake < TlsProfileHandshakes) && (ret == 0); handshake++)
+    {
+        ret = TlsProfile_Connect(port, &profile);
+    }
+    if(ret != 0)
+    {
+        printf("FAIL: handshake %u error -0x%04x\n", handshake - 1u, (unsigned int)-ret);
+        mbedtls_net_free(&TlsProfileListen);
+        return 1;
+    }
+    (void)pthread_join(serverThread, NULL);
+
+    printf("mbedTLS %d.%d, %u handshakes, TLS 1.2 ECDHE-ECDSA-AES128-GCM-SHA256, RSA-2048 client key\n",
+           MBEDTLS_VERSION_MAJOR, MBEDTLS_VERSION_MINOR, TlsProfileHandshakes);
+    printf("TLS connect profile (us): TCP connect %.1f\n", profile.connectUs / TlsProfileHandshakes);
+    for(uint32_t state = 0u; state < TLS_PROFILE_STATE_COUNT; state++)
+    {
+        if(profile.stateSteps[state] != 0u)
+        {
+            printf("    %-26s %10.1f us in %u steps\n", TlsProfileStateNames[state],
+                   profile.stateUs[state] / TlsProfileHandshakes, profile.stateSteps[state] / TlsProfileHandshakes);
+            handshakeUs += profile.stateUs[state];
+        }
+    }
+    printf("    %-26s %10.1f us\n", "HANDSHAKE", handshakeUs / TlsProfileHandshakes);
+
+    mbedtls_net_free(&TlsProfileListen);
+    return 0;
+}
@@ -3,12 +3,19 @@
  * Description  : Contains functions used in Renesas Cloud Connectivity application
  **********************************************************************************************************************/
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_APP)
+
 #include <cloud_app.h>
 #include "led/led.h"
 #include <console.h>
 #include <FreeRTOS_IP.h>
 #include <FreeRTOS_DHCP.h>
 #include <mqtt_subscription_manager.h>
+#include <cloud_prov_arena.h>
+#include <cloud_prov.h>
+#include <cloud_prov_session.h>
+#include <cloud_app_telemetry.h>
+#include <cloud_app_msg.h>
 #include <sensor_ob1203.h>
 #include <sensor_iaq.h>
 #include <sensor_oaq.h>
@@ -26,106 +33,19 @@
 
 #define CLOUD_APP_PUB_TOPIC_COUNT             (7)
 
-#define CLOUD_APP_PAYLOAD_FORMAT_IAQ_JSON     "{\r\n"\
-                                            "\"IAQ\" : {\r\n"\
-                                            "      \"TVOC (mg/m^3)\" :\"%f\",\r\n"\
-											"      \"Etoh (ppm)\" :\"%f\",\r\n"\
-											"      \"eco2 (ppm)\" :\"%f\"\r\n"\
-                                            "     }\r\n"\
-                                            "}\r\n"
-
-#define CLOUD_APP_PAYLOAD_FORMAT_OAQ_JSON     "{\r\n"\
-                                            "\"OAQ\" : {\r\n"\
-                                            "      \"air quality (Index)\" :\"%f\"\r\n"\
-                                            "\r\n         }\r\n"\
-                                            "}\r\n"
-
-#define CLOUD_APP_PAYLOAD_FORMAT_HS3001_JSON  "{\r\n"\
-                                            "\"HS3001\" : {\r\n"\
-                                            "      \"Humidity ()\" :\"%f\",\r\n"\
-                                            "      \"Temperature (F)\" :\"%f\"\r\n"\
-                                            "\r\n         }\r\n"\
-                                            "}\r\n"
-
-
-#define CLOUD_APP_PAYLOAD_FORMAT_ICM_JSON     "{\r\n"\
-                                            "\"ICM\" : {\r\n"\
-                                            "   \"acc\" : {\r\n"\
-                                            "      \"x \" :\"%f\",\r\n"\
-                                            "      \"y \" :\"%f\",\r\n"\
-                                            "      \"z \" :\"%f\"\r\n"\
-                                            "   \r\n      },\r\n"\
-                                            "   \"mag\" : {\r\n"\
-                                            "      \"x \" :\"%f\",\r\n"\
-                                            "      \"y \" :\"%f\",\r\n"\
-                                            "      \"z \" :\"%f\"\r\n"\
-                                            "   \r\n      },\r\n"\
-                                            "   \"gyr\" : {\r\n"\
-                                            "      \"x \" :\"%f\",\r\n"\
-                                            "      \"y \" :\"%f\",\r\n"\
-                                            "      \"z \" :\"%f\"\r\n"\
-                                            "   \r\n      }\r\n"\
-                                            "\r\n      }\r\n"\
-                                            "}\r\n"
-
-#define CLOUD_APP_PAYLOAD_FORMAT_ICP_JSON     "{\r\n"\
-                                            "\"ICP\" : {\r\n"\
-                                            "      \"Temperature (F)\" :\"%f\",\r\n"\
-                                            "      \"Pressure (Pa)\" :\"%f\"\r\n"\
-                                            "\r\n         }\r\n"\
-                                            "}\r\n"
-
-#define CLOUD_APP_PAYLOAD_FORMAT_OB1203_JSON  "{\r\n"\
-                                            "\"OB1203\" : {\r\n"\
-                                            "      \"spo2 ()\" :\"%f\",\r\n"\
-                                            "      \"Heart Rate ()\" :\"%f\",\r\n"\
-                                            "      \"Breath rate ()\" :\"%f\",\r\n"\
-                                            "      \"P2P ()\" :\"%f\"\r\n"\
-                                            "\r\n         }\r\n"\
-                                            "}\r\n"
-
-#define CLOUD_APP_PAYLOAD_FORMAT_BULK_JSON     "{\r\n"\
-                                             "\"IAQ\" : {\r\n"\
-                                             "      \"TVOC (mg/m^3)\" :\"%f\",\r\n"\
-                                             "      \"Etoh (ppm)\" :\"%f\",\r\n"\
-                                             "      \"eco2 (ppm)\" :\"%f\"\r\n"\
-                                             "          },\r\n"\
-                                             "\"OAQ\" : {\r\n"\
-	                                         "      \"air quality (Index)\" :\"%f\"\r\n"\
-	                                         "          },\r\n"\
-	                                         "\"HS3001\" : {\r\n"\
-	                                         "      \"Humidity ()\" :\"%f\",\r\n"\
-	                                         "      \"Temperature (F)\" :\"%f\"\r\n"\
-	                                         "             },\r\n"\
-                                             "\"ICM\" : {\r\n"\
-                                             "   \"acc\" : {\r\n"\
-                                             "      \"x \" :\"%f\",\r\n"\
-                                             "      \"y \" :\"%f\",\r\n"\
-                                             "      \"z \" :\"%f\"\r\n"\
-                                             "             },\r\n"\
-                                             "   \"mag\" : {\r\n"\
-                                             "      \"x \" :\"%f\",\r\n"\
-                                             "      \"y \" :\"%f\",\r\n"\
-                                             "      \"z \" :\"%f\"\r\n"\
-                                             "             },\r\n"\
-                                             "   \"gyr\" : {\r\n"\
-                                             "      \"x \" :\"%f\",\r\n"\
-                                             "      \"y \" :\"%f\",\r\n"\
-                                             "      \"z \" :\"%f\"\r\n"\
-                                             "             }\r\n"\
-                                             "         },\r\n"\
-                                             "\"ICP\" : {\r\n"\
-                                             "      \"Temperature (F)\" :\"%f\",\r\n"\
-                                             "      \"Pressure (Pa)\" :\"%f\"\r\n"\
-                                             "            },\r\n"\
-	                                         "\"OB1203\" : {\r\n"\
-	                                         "      \"spo2 ()\" :\"%f\",\r\n"\
-	                                         "      \"Heart Rate ()\" :\"%f\",\r\n"\
-	                                         "      \"Breath rate ()\" :\"%f\",\r\n"\
-	                                         "      \"P2P ()\" :\"%f\"\r\n"\
-	                                         "              }\r\n"\
-                                             "}\r\n"
-#define CLOUD_APP_PAYLOAD_BUFFER_SIZE ( sizeof( CLOUD_APP_PAYLOAD_FORMAT_BULK_JSON ) + 130u )
+/* Payload layouts are described in cloud_app_msg.json, cloud_app_msg.c holds the encoders generated from it.
+ * The bulk message holds all the others, so its payload is the largest. */
+#if CLOUD_APP_CBOR_TELEMETRY
+#define CLOUD_APP_PAYLOAD_BUFFER_SIZE         CLOUD_APP_MSG_BULK_CBOR_SIZE_MAX
+#define CLOUD_APP_ENCODE(msgName, msg)        CloudAppMsg_Encode##msgName##Cbor((msg), \
+                                                                              (uint8_t *)CloudAppPayloadBuffer, \
+                                                                              CLOUD_APP_PAYLOAD_BUFFER_SIZE)
+#else
+#define CLOUD_APP_PAYLOAD_BUFFER_SIZE         CLOUD_APP_MSG_BULK_JSON_SIZE_MAX
+#define CLOUD_APP_ENCODE(msgName, msg)        CloudAppMsg_Encode##msgName##Json((msg), \
+                                                                              CloudAppPayloadBuffer, \
+                                                                              CLOUD_APP_PAYLOAD_BUFFER_SIZE)
+#endif
 
 /* Topics used for the Publishing update in this Application Project. */
 
@@ -135,13 +55,13 @@
  */
 char *CloudAppPubTopicsNames[CLOUD_APP_PUB_TOPIC_COUNT] =
         {
-            "aws/topic/iaq_sensor_data",
-            "aws/topic/oaq_sensor_data",
-            "aws/topic/hs3001_sensor_data",
-            "aws/topic/icm_sensor_data",
-            "aws/topic/icp_sensor_data",
-            "aws/topic/ob1203_sensor_data",
-            "aws/topic/bulk_sensor_data",
+            CLOUD_APP_MSG_IAQ_TOPIC,
+            CLOUD_APP_MSG_OAQ_TOPIC,
+            CLOUD_APP_MSG_HS3001_TOPIC,
+            CLOUD_APP_MSG_ICM_TOPIC,
+            CLOUD_APP_MSG_ICP_TOPIC,
+            CLOUD_APP_MSG_OB1203_TOPIC,
+            CLOUD_APP_MSG_BULK_TOPIC,
         };
 
 /**
@@ -152,7 +72,8 @@ char *CloudAppPubTopicsNames[CLOUD_APP_PUB_TOPIC_COUNT] =
 extern TaskHandle_t cloud_app_thread;
 static CloudApp_SensorData_t CloudAppDataRequest = CLOUD_APP_NO_DATA;
 static CloudApp_SensorData_t CloudAppDataPush = CLOUD_APP_IAQ_DATA;
-static char CloudAppPayloadBuffer[CLOUD_APP_PAYLOAD_BUFFER_SIZE] = {0u};
+/** @brief Payload buffer borrowed from the arena, only valid while a sensor data publish is prepared */
+static char *CloudAppPayloadBuffer = NULL;
 static uint8_t CLoudAppSubAckReceived = 0u;
 
 /**********************************************************************************************************************
@@ -174,6 +95,13 @@ static void CloudApp_TempLedCallback( MQTTContext_t * pContext, MQTTPublishInfo_
 static void CloudApp_Spo2LedCallback( MQTTContext_t * pContext, MQTTPublishInfo_t * pPublishInfo );
 static void CloudApp_EnableDataPushTimer(void);
 static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext);
+static void CloudApp_ReadIaq(CloudAppMsgIaq_t *msg);
+static void CloudApp_ReadOaq(CloudAppMsgOaq_t *msg);
+static void CloudApp_ReadHs3001(CloudAppMsgHs3001_t *msg);
+static void CloudApp_ReadIcm(CloudAppMsgIcm_t *msg);
+static void CloudApp_ReadIcp(CloudAppMsgIcp_t *msg);
+static void CloudApp_ReadOb1203(CloudAppMsgOb1203_t *msg);
+static void CloudApp_CheckConnection(MQTTStatus_t mqttStatus);
 
 /**********************************************************************************************************************
                                     LOCAL FUNCTIONS
@@ -303,154 +231,161 @@ static void CloudApp_BulkDataCallback(MQTTContext_t * pContext, MQTTPublishInfo_
     CloudAppDataRequest = CLOUD_APP_BULK_SENS_DATA;
 }
 
+static void CloudApp_ReadIaq(CloudAppMsgIaq_t *msg)
+{
+    rm_zmod4xxx_iaq_1st_data_t iaqData;
+    SensorIaq_GetData(&iaqData);
+    msg->tvoc = iaqData.tvoc;
+    msg->etoh = iaqData.etoh;
+    msg->eco2 = iaqData.eco2;
+}
+
+static void CloudApp_ReadOaq(CloudAppMsgOaq_t *msg)
+{
+    SensorOaq_GetData(&msg->airQuality);
+}
+
+static void CloudApp_ReadHs3001(CloudAppMsgHs3001_t *msg)
+{
+    SensorHs3001_GetData(&msg->temperature, &msg->humidity);
+}
+
+static void CloudApp_ReadIcm(CloudAppMsgIcm_t *msg)
+{
+    xyzFloat acc, gyr, magnitude;
+    SensorIcm20948_GetData(&acc, &gyr, &magnitude);
+    msg->accX = acc.x;
+    msg->accY = acc.y;
+    msg->accZ = acc.z;
+    msg->magX = magnitude.x;
+    msg->magY = magnitude.y;
+    msg->magZ = magnitude.z;
+    msg->gyrX = gyr.x;
+    msg->gyrY = gyr.y;
+    msg->gyrZ = gyr.z;
+}
+
+static void CloudApp_ReadIcp(CloudAppMsgIcp_t *msg)
+{
+    SensorIcp10101_GetData(&msg->temperature, &msg->pressure);
+}
+
+static void CloudApp_ReadOb1203(CloudAppMsgOb1203_t *msg)
+{
+    ob1203_bio_data_t ob1203data;
+    Sensor_Ob1203GetData(&ob1203data);
+    msg->spo2 = ob1203data.spo2;
+    msg->heartRate = ob1203data.heart_rate;
+    msg->respirationRate = ob1203data.respiration_rate;
+    msg->perfusionIndex = ob1203data.perfusion_index;
+}
+
+
+/**
+ * @brief Save the publishes still waiting for their PUBACK in flash when mqttStatus tells the connection is lost.
+ *        Publishes are already saved when tracked, this drops the ones acknowledged since from the saved file.
+ */
+static void CloudApp_CheckConnection(MQTTStatus_t mqttStatus)
+{
+    if((mqttStatus == MQTTSendFailed) || (mqttStatus == MQTTRecvFailed) || (mqttStatus == MQTTKeepAliveTimeout))
+    {
+        CloudProv_SessionPersist();
+    }
+}
+
 static void CloudApp_PublishSensorData(MQTTContext_t *mqttContext, CloudApp_SensorData_t sensorData)
 {
     MQTTStatus_t mqttStatus;
+    uint16_t packetId;
     MQTTPublishInfo_t pubInfo = {
-            .pPayload = CloudAppPayloadBuffer,
             .qos = MQTTQoS1
     };
 
+    /* Telemetry only borrows the arena for the time of one publish, so a later provisioning can get it back */
+    if(CloudProv_ArenaBorrow(CLOUD_PROV_ARENA_TELEMETRY) == true)
+    {
+        CloudAppPayloadBuffer = CloudProv_ArenaAlloc(CLOUD_PROV_ARENA_TELEMETRY, CLOUD_APP_PAYLOAD_BUFFER_SIZE);
+        if(CloudAppPayloadBuffer == NULL)
+        {
+            CloudProv_ArenaRelease(CLOUD_PROV_ARENA_TELEMETRY);
+        }
+    }
+    if(CloudAppPayloadBuffer == NULL)
+    {
+        APP_ERR_PRINT("Could not get a payload buffer for CloudApp sensor data\r\n");
+        return;
+    }
+    pubInfo.pPayload = CloudAppPayloadBuffer;
+
     /* Populate Sensor data publish message */
     switch(sensorData)
     {
         case CLOUD_APP_IAQ_DATA:
         {
-            rm_zmod4xxx_iaq_1st_data_t iaqData;
-            SensorIaq_GetData(&iaqData);
+            CloudAppMsgIaq_t msg;
+            CloudApp_ReadIaq(&msg);
             pubInfo.pTopicName = CloudAppPubTopicsNames[0u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[0u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_IAQ_JSON,
-                                              (double)iaqData.tvoc,
-                                              (double)iaqData.etoh,
-                                              (double)iaqData.eco2);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Iaq, &msg);
             break;
         }
         case CLOUD_APP_OAQ_DATA:
         {
-            float_t oaqData;
-            SensorOaq_GetData(&oaqData);
+            CloudAppMsgOaq_t msg;
+            CloudApp_ReadOaq(&msg);
             pubInfo.pTopicName = CloudAppPubTopicsNames[1u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[1u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_OAQ_JSON,
-                                              (double)oaqData);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Oaq, &msg);
             break;
         }
         case CLOUD_APP_HS3001_DATA:
         {
-            float_t temperature, humidity;
-            SensorHs3001_GetData(&temperature, &humidity);
+            CloudAppMsgHs3001_t msg;
+            CloudApp_ReadHs3001(&msg);
             pubInfo.pTopicName = CloudAppPubTopicsNames[2u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[2u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_HS3001_JSON,
-                                              (double)humidity,
-                                              (double)temperature);
-            break;
-        }
-        case  CLOUD_APP_ICP_DATA:
-        {
-            float_t temperature, pressure;
-            SensorIcp10101_GetData(&temperature, &pressure);
-            pubInfo.pTopicName = CloudAppPubTopicsNames[4u];
-            pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[4u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_ICP_JSON,
-                                              (double)temperature,
-                                              (double)pressure);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Hs3001, &msg);
             break;
         }
         case CLOUD_APP_ICM_DATA:
         {
-            xyzFloat acc, gyr, magnitude;
-            SensorIcm20948_GetData(&acc, &gyr, &magnitude);
+            CloudAppMsgIcm_t msg;
+            CloudApp_ReadIcm(&msg);
             pubInfo.pTopicName = CloudAppPubTopicsNames[3u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[3u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_ICM_JSON,
-                                              acc.x,
-                                              acc.y,
-                                              acc.z,
-                                              magnitude.x,
-                                              magnitude.y,
-                                              magnitude.z,
-                                              gyr.x,
-                                              gyr.y,
-                                              gyr.z);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Icm, &msg);
+            break;
+        }
+        case CLOUD_APP_ICP_DATA:
+        {
+            CloudAppMsgIcp_t msg;
+            CloudApp_ReadIcp(&msg);
+            pubInfo.pTopicName = CloudAppPubTopicsNames[4u];
+            pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[4u]);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Icp, &msg);
             break;
         }
         case CLOUD_APP_OB1203_DATA:
         {
-            ob1203_bio_data_t ob1203data;
-            Sensor_Ob1203GetData(&ob1203data);
+            CloudAppMsgOb1203_t msg;
+            CloudApp_ReadOb1203(&msg);
             pubInfo.pTopicName = CloudAppPubTopicsNames[5u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[5u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_OB1203_JSON,
-                                              (double)ob1203data.spo2,
-                                              (double)ob1203data.heart_rate,
-                                              (double)ob1203data.respiration_rate,
-                                              (double)ob1203data.perfusion_index);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Ob1203, &msg);
             break;
-
         }
         case CLOUD_APP_BULK_SENS_DATA:
         {
-            rm_zmod4xxx_iaq_1st_data_t iaqData;
-            float_t oaqData;
-            float_t tempHs3001, humidity;
-            float_t tempIcp, pressure;
-            xyzFloat acc, gyr, magnitude;
-            ob1203_bio_data_t ob1203data;
-
-            SensorIaq_GetData(&iaqData);
-            SensorOaq_GetData(&oaqData);
-            SensorHs3001_GetData(&tempHs3001, &humidity);
-            SensorIcp10101_GetData(&tempIcp, &pressure);
-            SensorIcm20948_GetData(&acc, &gyr, &magnitude);
-            Sensor_Ob1203GetData(&ob1203data);
-
+            CloudAppMsgBulk_t msg;
+            CloudApp_ReadIaq(&msg.iaq);
+            CloudApp_ReadOaq(&msg.oaq);
+            CloudApp_ReadHs3001(&msg.hs3001);
+            CloudApp_ReadIcm(&msg.icm);
+            CloudApp_ReadIcp(&msg.icp);
+            CloudApp_ReadOb1203(&msg.ob1203);
             pubInfo.pTopicName = CloudAppPubTopicsNames[6u];
             pubInfo.topicNameLength = strlen(CloudAppPubTopicsNames[6u]);
-            /* Populate payload buffer and paayload length according to data format */
-            pubInfo.payloadLength = snprintf (CloudAppPayloadBuffer,
-                                              sizeof(CloudAppPayloadBuffer),
-                                              CLOUD_APP_PAYLOAD_FORMAT_BULK_JSON,
-                                              (double)iaqData.tvoc,
-                                              (double)iaqData.etoh,
-                                              (double)iaqData.eco2,
-                                              (double)oaqData,
-                                              (double)humidity,
-                                              (double)tempHs3001,
-                                              acc.x,
-                                              acc.y,
-                                              acc.z,
-                                              magnitude.x,
-                                              magnitude.y,
-                                              magnitude.z,
-                                              gyr.x,
-                                              gyr.y,
-                                              gyr.z,
-                                              (double)tempIcp,
-                                              (double)pressure,
-                                              (double)ob1203data.spo2,
-                                              (double)ob1203data.heart_rate,
-                                              (double)ob1203data.respiration_rate,
-                                              (double)ob1203data.perfusion_index);
+            pubInfo.payloadLength = CLOUD_APP_ENCODE(Bulk, &msg);
             break;
         }
 
@@ -463,28 +398,40 @@ static void CloudApp_PublishSensorData(MQTTContext_t *mqttContext, CloudApp_Sens
     {
         /* Toggle CLoudKit lit to indicate MQTT activity */
         AWS_ACTIVITY_INDICATION;
+        /* Keep the publish until its PUBACK, so it is resent if the connection is lost in between */
+        packetId = MQTT_GetPacketId(mqttContext);
+        (void)CloudProv_SessionTrackPublish(&pubInfo, packetId);
         mqttStatus = MQTT_Publish( mqttContext,
                                    &pubInfo,
-                                   MQTT_GetPacketId(mqttContext) );
+                                   packetId );
         AWS_ACTIVITY_INDICATION;
         if( mqttStatus == MQTTSuccess )
         {
             /* Check if PUBACK is received */
-            MQTT_ProcessLoop(mqttContext);
-
+            mqttStatus = MQTT_ProcessLoop(mqttContext);
         }
         else
         {
             APP_ERR_PRINT("Failed to publish CloudApp Sensor Data with error status = %s.\r\n",
                           MQTT_Status_strerror( mqttStatus ));
         }
+        CloudApp_CheckConnection(mqttStatus);
     }
 
 
-    APP_INFO_PRINT(("Published CloudApp sensor data %.*s\r\n"),
+#if CLOUD_APP_CBOR_TELEMETRY
+    APP_INFO_PRINT("Published CloudApp sensor data, %d bytes of CBOR on %s\r\n",
+                   pubInfo.payloadLength,
+                   pubInfo.pTopicName);
+#else
+    APP_INFO_PRINT("Published CloudApp sensor data %.*s\r\n",
                    pubInfo.payloadLength,
                    pubInfo.pPayload);
+#endif
 
+    /* The session keeps its own copy of the publish until its PUBACK, the payload buffer can be given back */
+    CloudProv_ArenaRelease(CLOUD_PROV_ARENA_TELEMETRY);
+    CloudAppPayloadBuffer = NULL;
 }
 
 static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext)
@@ -538,7 +485,13 @@ static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext)
      * receive callbacks/publishes will toggle it further */
     AWS_ACTIVITY_INDICATION;
 
-    if( managerStatus == SUBSCRIPTION_MANAGER_SUCCESS )
+    if((managerStatus == SUBSCRIPTION_MANAGER_SUCCESS) && (CloudProv_SessionPresent() == true))
+    {
+        /* Broker resumed the device session, which still holds the subscriptions */
+        APP_INFO_PRINT("MQTT session resumed, CloudApp topics are already subscribed.\r\n");
+        mqttStatus = MQTTSuccess;
+    }
+    else if( managerStatus == SUBSCRIPTION_MANAGER_SUCCESS )
     {
         APP_INFO_PRINT("Correctly registered callbacks to CloudApp topics.\r\n");
 
@@ -550,7 +503,7 @@ static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext)
                                     MQTT_GetPacketId( mqttContext ) );
         if(mqttStatus != MQTTSuccess )
         {
-            APP_WARN_PRINT( ( "Failed to send SUBSCRIBE packet to broker with error = %s.\r\n"),
+            APP_WARN_PRINT( "Failed to send SUBSCRIBE packet to broker with error = %s.\r\n",
                             MQTT_Status_strerror(mqttStatus) );
         }
         mqttStatus = MQTT_Subscribe(mqttContext,
@@ -559,12 +512,12 @@ static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext)
                                     MQTT_GetPacketId( mqttContext ) );
         if(mqttStatus != MQTTSuccess )
         {
-            APP_WARN_PRINT( ( "Failed to send SUBSCRIBE packet to broker with error = %s.\r\n"),
+            APP_WARN_PRINT( "Failed to send SUBSCRIBE packet to broker with error = %s.\r\n",
                             MQTT_Status_strerror(mqttStatus) );
         }
     }
 
-    if(mqttStatus == MQTTSuccess )
+    if((mqttStatus == MQTTSuccess) && (CloudProv_SessionPresent() == false))
     {
         uint16_t timeMs = 0u;
         /* Check until 2 SUBACK packets are received  */
@@ -576,7 +529,7 @@ static MQTTStatus_t CloudApp_SubscribeTopics(MQTTContext_t *mqttContext)
         }
         if(CLoudAppSubAckReceived < 2u)
         {
-            APP_WARN_PRINT( ( "Failed to receive SUBACK packets from broker with error = %s.\r\n"),
+            APP_WARN_PRINT( "Failed to receive SUBACK packets from broker with error = %s.\r\n",
                             MQTT_Status_strerror(mqttStatus) );
         }
     }
@@ -659,6 +612,7 @@ void CloudApp_MqttCallback( MQTTContext_t * pMqttContext,
 
             case MQTT_PACKET_TYPE_PUBACK:
                 APP_INFO_PRINT("PUBACK received for packet id %u.\r\n", pDeserializedInfo->packetIdentifier);
+                CloudProv_SessionRelease(pDeserializedInfo->packetIdentifier);
                 break;
 
             default:
@@ -722,12 +676,12 @@ void CloudApp_Init(MQTTContext_t *mqttContext)
 
     if(mqttStatus == MQTTSuccess)
     {
-        APP_PRINT(("Device is ready for Receiving/Publishing messages from AWS Iot \r\n\r\n"));
+        APP_PRINT("Device is ready for Receiving/Publishing messages from AWS Iot \r\n\r\n");
     }
     else
     {
-        APP_WARN_PRINT(("Device is not connected to AWS IoT server, but will still print sensor reading" \
-        " on Console. \r\n\r\n"));
+        APP_WARN_PRINT("Device is not connected to AWS IoT server, but will still print sensor reading" \
+        " on Console. \r\n\r\n");
     }
 
     /* Enable periodic timer to publish sensor data */
@@ -740,7 +694,7 @@ void CloudApp_MainFunction(MQTTContext_t *mqttContext)
      * update CloudAppDataRequest in CallBacks if data is received on request topics */
     if(mqttContext->transportInterface.recv != NULL)
     {
-        MQTT_ProcessLoop(mqttContext);
+        CloudApp_CheckConnection(MQTT_ProcessLoop(mqttContext));
     }
 
     /* Process data requested by MQTT broker */
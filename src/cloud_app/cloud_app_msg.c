@@ -0,0 +1,374 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_msg.c
+ * Description  : Specialised encoders of the CloudApp telemetry messages
+ *                Generated by script/cloud_app_msg_gen.py from src/cloud_app/cloud_app_msg.json, do not edit
+ **********************************************************************************************************************/
+
+#include <string.h>
+#include <cloud_app_msg.h>
+#include <cloud_app_telemetry.h>
+
+#if (CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX != 23u) || (CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX != 8u)
+#error "Value sizes changed in cloud_app_telemetry.h, update script/cloud_app_msg_gen.py and regenerate"
+#endif
+
+/** @brief Copy a string literal without its terminating NUL, then move out past it */
+#define CLOUD_APP_MSG_PUT(out, literal)     do { memcpy((out), (literal), sizeof(literal) - 1u); \
+                                                 (out) += sizeof(literal) - 1u; } while(0)
+
+size_t CloudAppMsg_EncodeIaqJson(const CloudAppMsgIaq_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_IAQ_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"IAQ\" : {\r\n      \"TVOC (mg/m^3)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->tvoc);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Etoh (ppm)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->etoh);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"eco2 (ppm)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->eco2);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n     }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeIaqCbor(const CloudAppMsgIaq_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_IAQ_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241cIAQ\243mTVOC (mg/m^3)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->tvoc, -2);
+        CLOUD_APP_MSG_PUT(out, "jEtoh (ppm)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->etoh, -2);
+        CLOUD_APP_MSG_PUT(out, "jeco2 (ppm)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->eco2, 0);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeOaqJson(const CloudAppMsgOaq_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_OAQ_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"OAQ\" : {\r\n      \"air quality (Index)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->airQuality);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n\r\n         }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeOaqCbor(const CloudAppMsgOaq_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_OAQ_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241cOAQ\241sair quality (Index)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->airQuality, -1);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeHs3001Json(const CloudAppMsgHs3001_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_HS3001_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"HS3001\" : {\r\n      \"Humidity ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->humidity);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Temperature (F)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->temperature);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n\r\n         }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeHs3001Cbor(const CloudAppMsgHs3001_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_HS3001_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241fHS3001\242kHumidity ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->humidity, -1);
+        CLOUD_APP_MSG_PUT(out, "oTemperature (F)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->temperature, -1);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeIcmJson(const CloudAppMsgIcm_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_ICM_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"ICM\" : {\r\n   \"acc\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->accX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->accY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->accZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n   \r\n      },\r\n   \"mag\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->magX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->magY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->magZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n   \r\n      },\r\n   \"gyr\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->gyrX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->gyrY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->gyrZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n   \r\n      }\r\n\r\n      }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeIcmCbor(const CloudAppMsgIcm_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_ICM_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241cICM\243cacc\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->accX, -2);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->accY, -2);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->accZ, -2);
+        CLOUD_APP_MSG_PUT(out, "cmag\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->magX, -1);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->magY, -1);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->magZ, -1);
+        CLOUD_APP_MSG_PUT(out, "cgyr\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->gyrX, -1);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->gyrY, -1);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->gyrZ, -1);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeIcpJson(const CloudAppMsgIcp_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_ICP_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"ICP\" : {\r\n      \"Temperature (F)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->temperature);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Pressure (Pa)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->pressure);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n\r\n         }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeIcpCbor(const CloudAppMsgIcp_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_ICP_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241cICP\242oTemperature (F)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->temperature, -1);
+        CLOUD_APP_MSG_PUT(out, "mPressure (Pa)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->pressure, 0);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeOb1203Json(const CloudAppMsgOb1203_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_OB1203_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"OB1203\" : {\r\n      \"spo2 ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->spo2);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Heart Rate ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->heartRate);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Breath rate ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->respirationRate);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"P2P ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->perfusionIndex);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n\r\n         }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeOb1203Cbor(const CloudAppMsgOb1203_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_OB1203_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\241fOB1203\244gspo2 ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->spo2, 0);
+        CLOUD_APP_MSG_PUT(out, "mHeart Rate ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->heartRate, 0);
+        CLOUD_APP_MSG_PUT(out, "nBreath rate ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->respirationRate, 0);
+        CLOUD_APP_MSG_PUT(out, "fP2P ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->perfusionIndex, -2);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeBulkJson(const CloudAppMsgBulk_t *msg, char *buffer, size_t size)
+{
+    char *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_BULK_JSON_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "{\r\n\"IAQ\" : {\r\n      \"TVOC (mg/m^3)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->iaq.tvoc);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Etoh (ppm)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->iaq.etoh);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"eco2 (ppm)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->iaq.eco2);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n          },\r\n\"OAQ\" : {\r\n      \"air quality (Index)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->oaq.airQuality);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n          },\r\n\"HS3001\" : {\r\n      \"Humidity ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->hs3001.humidity);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Temperature (F)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->hs3001.temperature);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n             },\r\n\"ICM\" : {\r\n   \"acc\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.accX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.accY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.accZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n             },\r\n   \"mag\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.magX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.magY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.magZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n             },\r\n   \"gyr\" : {\r\n      \"x \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.gyrX);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"y \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.gyrY);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"z \" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icm.gyrZ);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n             }\r\n         },\r\n\"ICP\" : {\r\n      \"Temperature (F)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icp.temperature);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Pressure (Pa)\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->icp.pressure);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n            },\r\n\"OB1203\" : {\r\n      \"spo2 ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->ob1203.spo2);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Heart Rate ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->ob1203.heartRate);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"Breath rate ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->ob1203.respirationRate);
+        CLOUD_APP_MSG_PUT(out, "\",\r\n      \"P2P ()\" :\"");
+        out = CloudApp_TelemetryWriteFixed(out, (double)msg->ob1203.perfusionIndex);
+        CLOUD_APP_MSG_PUT(out, "\"\r\n              }\r\n}\r\n");
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
+
+size_t CloudAppMsg_EncodeBulkCbor(const CloudAppMsgBulk_t *msg, uint8_t *buffer, size_t size)
+{
+    uint8_t *out = buffer;
+    size_t length = 0u;
+
+    if(size >= CLOUD_APP_MSG_BULK_CBOR_SIZE_MAX)
+    {
+        CLOUD_APP_MSG_PUT(out, "\246cIAQ\243mTVOC (mg/m^3)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->iaq.tvoc, -2);
+        CLOUD_APP_MSG_PUT(out, "jEtoh (ppm)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->iaq.etoh, -2);
+        CLOUD_APP_MSG_PUT(out, "jeco2 (ppm)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->iaq.eco2, 0);
+        CLOUD_APP_MSG_PUT(out, "cOAQ\241sair quality (Index)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->oaq.airQuality, -1);
+        CLOUD_APP_MSG_PUT(out, "fHS3001\242kHumidity ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->hs3001.humidity, -1);
+        CLOUD_APP_MSG_PUT(out, "oTemperature (F)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->hs3001.temperature, -1);
+        CLOUD_APP_MSG_PUT(out, "cICM\243cacc\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.accX, -2);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.accY, -2);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.accZ, -2);
+        CLOUD_APP_MSG_PUT(out, "cmag\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.magX, -1);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.magY, -1);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.magZ, -1);
+        CLOUD_APP_MSG_PUT(out, "cgyr\243bx ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.gyrX, -1);
+        CLOUD_APP_MSG_PUT(out, "by ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.gyrY, -1);
+        CLOUD_APP_MSG_PUT(out, "bz ");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icm.gyrZ, -1);
+        CLOUD_APP_MSG_PUT(out, "cICP\242oTemperature (F)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icp.temperature, -1);
+        CLOUD_APP_MSG_PUT(out, "mPressure (Pa)");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->icp.pressure, 0);
+        CLOUD_APP_MSG_PUT(out, "fOB1203\244gspo2 ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->ob1203.spo2, 0);
+        CLOUD_APP_MSG_PUT(out, "mHeart Rate ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->ob1203.heartRate, 0);
+        CLOUD_APP_MSG_PUT(out, "nBreath rate ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->ob1203.respirationRate, 0);
+        CLOUD_APP_MSG_PUT(out, "fP2P ()");
+        out = CloudApp_TelemetryWriteValue(out, (float_t)msg->ob1203.perfusionIndex, -2);
+        length = (size_t)(out - buffer);
+    }
+
+    return length;
+}
@@ -0,0 +1,181 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_msg.h
+ * Description  : CloudApp telemetry messages and their specialised encoders
+ *                Generated by script/cloud_app_msg_gen.py from src/cloud_app/cloud_app_msg.json, do not edit
+ **********************************************************************************************************************/
+#ifndef CLOUD_APP_MSG_H
+#define CLOUD_APP_MSG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+/** @brief Values of the aws/topic/iaq_sensor_data message */
+typedef struct
+{
+    float_t tvoc;
+    float_t etoh;
+    float_t eco2;
+}CloudAppMsgIaq_t;
+
+/** @brief Values of the aws/topic/oaq_sensor_data message */
+typedef struct
+{
+    float_t airQuality;
+}CloudAppMsgOaq_t;
+
+/** @brief Values of the aws/topic/hs3001_sensor_data message */
+typedef struct
+{
+    float_t humidity;
+    float_t temperature;
+}CloudAppMsgHs3001_t;
+
+/** @brief Values of the aws/topic/icm_sensor_data message */
+typedef struct
+{
+    double accX;
+    double accY;
+    double accZ;
+    double magX;
+    double magY;
+    double magZ;
+    double gyrX;
+    double gyrY;
+    double gyrZ;
+}CloudAppMsgIcm_t;
+
+/** @brief Values of the aws/topic/icp_sensor_data message */
+typedef struct
+{
+    float_t temperature;
+    float_t pressure;
+}CloudAppMsgIcp_t;
+
+/** @brief Values of the aws/topic/ob1203_sensor_data message */
+typedef struct
+{
+    uint16_t spo2;
+    uint16_t heartRate;
+    uint16_t respirationRate;
+    float_t perfusionIndex;
+}CloudAppMsgOb1203_t;
+
+/** @brief Values of the aws/topic/bulk_sensor_data message */
+typedef struct
+{
+    CloudAppMsgIaq_t iaq;
+    CloudAppMsgOaq_t oaq;
+    CloudAppMsgHs3001_t hs3001;
+    CloudAppMsgIcm_t icm;
+    CloudAppMsgIcp_t icp;
+    CloudAppMsgOb1203_t ob1203;
+}CloudAppMsgBulk_t;
+
+#define CLOUD_APP_MSG_IAQ_TOPIC            "aws/topic/iaq_sensor_data"
+#define CLOUD_APP_MSG_IAQ_JSON_SIZE_MAX    (171u)
+#define CLOUD_APP_MSG_IAQ_CBOR_SIZE_MAX    (66u)
+#define CLOUD_APP_MSG_OAQ_TOPIC            "aws/topic/oaq_sensor_data"
+#define CLOUD_APP_MSG_OAQ_JSON_SIZE_MAX    (87u)
+#define CLOUD_APP_MSG_OAQ_CBOR_SIZE_MAX    (34u)
+#define CLOUD_APP_MSG_HS3001_TOPIC         "aws/topic/hs3001_sensor_data"
+#define CLOUD_APP_MSG_HS3001_JSON_SIZE_MAX (135u)
+#define CLOUD_APP_MSG_HS3001_CBOR_SIZE_MAX (53u)
+#define CLOUD_APP_MSG_ICM_TOPIC            "aws/topic/icm_sensor_data"
+#define CLOUD_APP_MSG_ICM_JSON_SIZE_MAX    (471u)
+#define CLOUD_APP_MSG_ICM_CBOR_SIZE_MAX    (120u)
+#define CLOUD_APP_MSG_ICP_TOPIC            "aws/topic/icp_sensor_data"
+#define CLOUD_APP_MSG_ICP_JSON_SIZE_MAX    (134u)
+#define CLOUD_APP_MSG_ICP_CBOR_SIZE_MAX    (52u)
+#define CLOUD_APP_MSG_OB1203_TOPIC         "aws/topic/ob1203_sensor_data"
+#define CLOUD_APP_MSG_OB1203_JSON_SIZE_MAX (225u)
+#define CLOUD_APP_MSG_OB1203_CBOR_SIZE_MAX (85u)
+#define CLOUD_APP_MSG_BULK_TOPIC           "aws/topic/bulk_sensor_data"
+#define CLOUD_APP_MSG_BULK_JSON_SIZE_MAX   (1215u)
+#define CLOUD_APP_MSG_BULK_CBOR_SIZE_MAX   (405u)
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_IAQ_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIaqJson(const CloudAppMsgIaq_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_IAQ_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIaqCbor(const CloudAppMsgIaq_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_OAQ_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeOaqJson(const CloudAppMsgOaq_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_OAQ_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeOaqCbor(const CloudAppMsgOaq_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_HS3001_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeHs3001Json(const CloudAppMsgHs3001_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_HS3001_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeHs3001Cbor(const CloudAppMsgHs3001_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_ICM_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIcmJson(const CloudAppMsgIcm_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_ICM_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIcmCbor(const CloudAppMsgIcm_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_ICP_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIcpJson(const CloudAppMsgIcp_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_ICP_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeIcpCbor(const CloudAppMsgIcp_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_OB1203_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeOb1203Json(const CloudAppMsgOb1203_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_OB1203_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeOb1203Cbor(const CloudAppMsgOb1203_t *msg, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Write the JSON payload of msg, values as %f text.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_BULK_JSON_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeBulkJson(const CloudAppMsgBulk_t *msg, char *buffer, size_t size);
+
+/**
+ * @brief Write the CBOR payload of msg, values at the precision the schema declares.
+ * @return Payload length, 0 if size is under CLOUD_APP_MSG_BULK_CBOR_SIZE_MAX.
+ */
+size_t CloudAppMsg_EncodeBulkCbor(const CloudAppMsgBulk_t *msg, uint8_t *buffer, size_t size);
+
+#endif //CLOUD_APP_MSG_H
@@ -0,0 +1,201 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_telemetry.c
+ * Description  : CBOR encoding of CloudApp sensor values at their declared precision
+ **********************************************************************************************************************/
+
+#include <stdio.h>
+#include <cloud_app_telemetry.h>
+
+/** @brief Largest magnitude a half float holds */
+#define CLOUD_APP_TELEMETRY_HALF_MAX        (65504.0f)
+
+/** @brief Exponent, as returned by frexpf, of the smallest normal half float 2^-14 */
+#define CLOUD_APP_TELEMETRY_HALF_MIN_EXP    (-13)
+
+/** @brief Scaled values from this magnitude on do not fit the int32_t mantissa */
+#define CLOUD_APP_TELEMETRY_MANTISSA_LIMIT  (2147483648.0f)
+
+/** @brief Values from this magnitude on have more integer digits than CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX holds */
+#define CLOUD_APP_TELEMETRY_FIXED_LIMIT     (1e15)
+
+/** @brief 10^6, the 6 decimals of %f */
+#define CLOUD_APP_TELEMETRY_FIXED_SCALE     (1000000u)
+
+/** @brief 10^n for n in 0..-CLOUD_APP_TELEMETRY_PRECISION_MIN */
+static const float_t CloudAppTelemetryPow10[1 - CLOUD_APP_TELEMETRY_PRECISION_MIN] =
+        {
+            1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f
+        };
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTION PROTOTYPES
+**********************************************************************************************************************/
+/**
+ * @brief Tell if a half float keeps value within half of step.
+ * @details A half float has 11 significant bits, so it rounds value by at most half the distance between two half
+ *          floats of its binade. That distance has to be under step for the value to be given back.
+ */
+static bool CloudApp_TelemetryHalfKeeps(float_t value, float_t step);
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+static bool CloudApp_TelemetryHalfKeeps(float_t value, float_t step)
+{
+    bool keeps = false;
+    int exponent;
+
+    if(fabsf(value) <= CLOUD_APP_TELEMETRY_HALF_MAX)
+    {
+        (void)frexpf(value, &exponent);
+        if(exponent < CLOUD_APP_TELEMETRY_HALF_MIN_EXP)
+        {
+            /* Subnormal half floats are all 2^-24 apart */
+            exponent = CLOUD_APP_TELEMETRY_HALF_MIN_EXP;
+        }
+        keeps = (ldexpf(1.0f, exponent - 11) < step);
+    }
+
+    return keeps;
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+CborError CloudApp_TelemetryEncodeValue(CborEncoder *encoder, float_t value, int8_t precision)
+{
+    CborError cborRet;
+    CborEncoder fraction;
+    float_t scaled;
+    float_t scale;
+    int32_t mantissa;
+    int8_t exponent = precision;
+
+    if(precision < CLOUD_APP_TELEMETRY_PRECISION_MIN)
+    {
+        exponent = CLOUD_APP_TELEMETRY_PRECISION_MIN;
+    }
+    else if(precision > 0)
+    {
+        exponent = 0;
+    }
+    scale = CloudAppTelemetryPow10[-exponent];
+    scaled = roundf(value * scale);
+
+    if((isfinite(scaled) == 0) || (fabsf(scaled) >= CLOUD_APP_TELEMETRY_MANTISSA_LIMIT))
+    {
+        cborRet = cbor_encode_float(encoder, value);
+    }
+    else
+    {
+        /* Trailing zeros of the mantissa are precision the value does not use */
+        mantissa = (int32_t)scaled;
+        while((exponent < 0) && ((mantissa % 10) == 0))
+        {
+            mantissa /= 10;
+            exponent++;
+        }
+
+        if(exponent == 0)
+        {
+            cborRet = cbor_encode_int(encoder, mantissa);
+        }
+        else if(CloudApp_TelemetryHalfKeeps(scaled / scale, 1.0f / scale) == true)
+        {
+            cborRet = cbor_encode_float_as_half_float(encoder, scaled / scale);
+        }
+        else
+        {
+            cborRet = cbor_encode_tag(encoder, CborDecimalTag);
+            if((cborRet == CborNoError) || (cborRet == CborErrorOutOfMemory))
+            {
+                cborRet = cbor_encoder_create_array(encoder, &fraction, 2u);
+            }
+            if((cborRet == CborNoError) || (cborRet == CborErrorOutOfMemory))
+            {
+                cborRet = cbor_encode_int(&fraction, exponent);
+            }
+            if((cborRet == CborNoError) || (cborRet == CborErrorOutOfMemory))
+            {
+                cborRet = cbor_encode_int(&fraction, mantissa);
+            }
+            if((cborRet == CborNoError) || (cborRet == CborErrorOutOfMemory))
+            {
+                cborRet = cbor_encoder_close_container(encoder, &fraction);
+            }
+        }
+    }
+
+    return cborRet;
+}
+
+uint8_t *CloudApp_TelemetryWriteValue(uint8_t *out, float_t value, int8_t precision)
+{
+    CborEncoder encoder;
+
+    /* Cannot run out of room, the largest encoding fits CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX */
+    cbor_encoder_init(&encoder, out, CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX, 0);
+    (void)CloudApp_TelemetryEncodeValue(&encoder, value, precision);
+
+    return out + cbor_encoder_get_buffer_size(&encoder, out);
+}
+
+char *CloudApp_TelemetryWriteFixed(char *out, double value)
+{
+    double magnitude = fabs(value);
+    double integral;
+    double fraction;
+    double scaled;
+    double error;
+    double micros;
+    uint64_t whole;
+    uint32_t decimals;
+    char digits[CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX];
+    size_t count = 0u;
+
+    if((isfinite(value) == 0) || (magnitude >= CLOUD_APP_TELEMETRY_FIXED_LIMIT))
+    {
+        return out + snprintf(out, CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX, "%.6e", value);
+    }
+
+    /* Both parts are exact, so is the error of the scaled fraction given by fma */
+    integral = trunc(magnitude);
+    fraction = magnitude - integral;
+    scaled = fraction * 1e6;
+    error = fma(fraction, 1e6, -scaled);
+    micros = rint(scaled);
+    if((fabs(scaled - floor(scaled) - 0.5) == 0.0) && (error != 0.0))
+    {
+        /* scaled was rounded onto a tie the exact value is not on, %f rounds toward the exact value */
+        micros = (error > 0.0) ? ceil(scaled) : floor(scaled);
+    }
+
+    whole = (uint64_t)integral;
+    decimals = (uint32_t)micros;
+    if(decimals == CLOUD_APP_TELEMETRY_FIXED_SCALE)
+    {
+        whole++;
+        decimals = 0u;
+    }
+
+    if(signbit(value) != 0)
+    {
+        *out++ = '-';
+    }
+    do
+    {
+        digits[count++] = (char)('0' + (whole % 10u));
+        whole /= 10u;
+    } while(whole != 0u);
+    while(count > 0u)
+    {
+        *out++ = digits[--count];
+    }
+    *out++ = '.';
+    for(uint32_t divider = CLOUD_APP_TELEMETRY_FIXED_SCALE / 10u; divider != 0u; divider /= 10u)
+    {
+        *out++ = (char)('0' + ((decimals / divider) % 10u));
+    }
+
+    return out;
+}
@@ -0,0 +1,58 @@
+/***********************************************************************************************************************
+ * File Name    : cloud_app_telemetry.h
+ * Description  : CBOR encoding of CloudApp sensor values at their declared precision
+ **********************************************************************************************************************/
+#ifndef CLOUD_APP_TELEMETRY_H
+#define CLOUD_APP_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+#include <cbor.h>
+
+/**
+ * @brief Publish sensor data as CBOR instead of JSON, set by the CLOUD_APP_CBOR_TELEMETRY CMake option
+ */
+#ifndef CLOUD_APP_CBOR_TELEMETRY
+#define CLOUD_APP_CBOR_TELEMETRY        (0)
+#endif
+
+/** @brief Finest precision a field can declare, 10^-6 */
+#define CLOUD_APP_TELEMETRY_PRECISION_MIN   (-6)
+
+/** @brief Largest CBOR item CloudApp_TelemetryWriteValue writes: a decimal fraction with an int32_t mantissa */
+#define CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX  (8u)
+
+/** @brief Largest text CloudApp_TelemetryWriteFixed writes: sign, 15 integer digits, point and 6 decimals */
+#define CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX  (23u)
+
+/**
+ * @brief Encode a value in the smallest form that gives it back at precision.
+ * @details The value is rounded to precision then encoded, in that order of preference, as an integer when no
+ *          decimal is left, as a half float when its rounding error stays under half a step, or as a decimal
+ *          fraction (tag 4, [exponent, mantissa]). Values out of int32_t range once scaled, NaN and infinities are
+ *          encoded as single precision floats.
+ * @param[in] encoder Encoder of the map or array the value goes in.
+ * @param[in] value Value to encode.
+ * @param[in] precision Decimal exponent of the smallest step kept.
+ * @return tinycbor error of the encoding.
+ */
+CborError CloudApp_TelemetryEncodeValue(CborEncoder *encoder, float_t value, int8_t precision);
+
+/**
+ * @brief Write a value with CloudApp_TelemetryEncodeValue at out, which has CLOUD_APP_TELEMETRY_VALUE_SIZE_MAX
+ *        bytes of room.
+ * @return Position after the value.
+ */
+uint8_t *CloudApp_TelemetryWriteValue(uint8_t *out, float_t value, int8_t precision);
+
+/**
+ * @brief Write value as printf %f does, without parsing a format, at out which has
+ *        CLOUD_APP_TELEMETRY_FIXED_SIZE_MAX bytes of room. Nothing terminates the text.
+ * @details Values from 1e15 on are written as %.6e, infinities and NaN as printf writes them.
+ * @return Position after the text.
+ */
+char *CloudApp_TelemetryWriteFixed(char *out, double value);
+
+#endif //CLOUD_APP_TELEMETRY_H
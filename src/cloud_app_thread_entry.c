@@ -56,12 +56,17 @@ void cloud_app_thread_entry(void *pvParameters)
 
     FSP_PARAMETER_NOT_USED (pvParameters);
 
-    /* Wait for the cloud_app_thread to be notified before starting. This notification typically
-     * come from Console thread that takes user input before starting cloud app */
+    /* Wait for the cloud_app_thread to be notified before starting. This notification comes from Console thread
+     * as soon as the banner is displayed, the connection then proceeds while the boot menu can still be opened */
     xTaskNotifyWait(pdFALSE, pdFALSE, NULL, portMAX_DELAY);
 
     /* Try to connect to MQTT and provision device if needed */
     mqttStatus = CloudProv_Init(&CloudAppMqtt, CloudApp_MqttCallback);
+    while(mqttStatus == MQTTIllegalState)
+    {
+        /* Boot menu was opened, connect again once the menu starts the application */
+        mqttStatus = CloudProv_Restart(&CloudAppMqtt, CloudApp_MqttCallback);
+    }
 
     if(mqttStatus == MQTTSuccess)
     {
@@ -2,10 +2,21 @@
 // Created by Gabriel on 3/23/2024.
 //
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
 #include <cloud_prov.h>
 #include <cloud_prov_config.h>
 #include <cloud_prov_serializer.h>
+#include <cloud_prov_stream.h>
 #include <cloud_prov_pkcs11.h>
+#include <cloud_prov_arena.h>
+#include <cloud_prov_endpoint.h>
+#include <cloud_prov_session.h>
+#include <cloud_prov_ca_cache.h>
+#include <cloud_prov_journal.h>
+#if defined(CLOUD_PROV_TLS_PROFILER)
+#include <cloud_prov_tls_profiler.h>
+#endif
 #include <console.h>
 #include <led.h>
 #include <FreeRTOS_DNS.h>
@@ -19,9 +30,19 @@
 #define CLOUD_PROV_DEVICE_UUID_SIZE_BYTES (16u)
 
 /**
- * @brief Size of buffer in which to hold the certificate signing request (CSR).
+ * @brief Size of the scratch buffer of provisioning. Request payloads are streamed without buffer, it receives the
+ * certificate signing request (CSR), the DER device certificate and, in CreateKeysAndCertificate mode, the PEM
+ * private key, which all fit in it. Kept apart from CLOUD_PROV_MQTT_BUFFER_SIZE since the MQTT buffer grows for the
+ * CreateKeysAndCertificate response.
+ */
+#define CLOUD_PROV_PAYLOAD_BUFFER_SIZE                (2048)
+
+/**
+ * @brief Layout of the payload buffer once the certificate is issued: the DER device certificate first then, when
+ * provisioning resumes at RegisterThing, the ownership token read back from the journal.
  */
-#define CLOUD_PROV_CERT_BUFFER_SIZE                   (2048)
+#define CLOUD_PROV_CERT_DER_BUFFER_SIZE               (1024)
+#define CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE        (CLOUD_PROV_PAYLOAD_BUFFER_SIZE - CLOUD_PROV_CERT_DER_BUFFER_SIZE)
 
 /**
  * @brief The length of the outgoing publish records array used by the coreMQTT
@@ -42,22 +63,20 @@
  */
 #define CLOUD_PROV_FLEET_PROV_TOPIC_COUNT           (4u)
 
-#define CLOUD_PROV_CERT_ID_BUFFER_SIZE              (64)
-
-/**
- * @brief Size of buffer in which to hold the certificate ownership token.
- */
-#define CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE      (1024)
-
 /**
  * @brief Size of AWS IoT Thing name buffer.
  *
  * See https://docs.aws.amazon.com/iot/latest/apireference/API_CreateThing.html#iot-CreateThing-request-thingName
  */
 #define CLOUD_PROV_THING_NAME_BUFFER_SIZE           (128)
-#define CLOUD_PROV_MQTT_ENDPOINT_BUFFER_SIZE        (128)
-#define CLOUD_PROV_CLAIM_CERT_BUFFER_SIZE           (2048)
-#define CLOUD_PROV_CLAIM_PRIVATE_KEY_BUFFER_SIZE    (2048)
+
+/**
+ * @brief Boot decision event bits. The console confirms or aborts the connection started speculatively while the
+ *        boot menu can still be opened, and the cloud thread reports when an aborted connection is torn down.
+ */
+#define CLOUD_PROV_BOOT_CONFIRMED_BIT               (1u << 0u)
+#define CLOUD_PROV_BOOT_ABORTED_BIT                 (1u << 1u)
+#define CLOUD_PROV_BOOT_STOPPED_BIT                 (1u << 2u)
 
 
 /*************************************************************************************
@@ -87,8 +106,6 @@ struct NetworkContext
 /*************************************************************************************
  * Local Variables
  ************************************************************************************/
-static char cBuffer[16] = { RESET_VALUE };
-
 /** @brief The network context used for mbedTLS operation. */
 static CK_SESSION_HANDLE CloudProvP11Session;
 
@@ -132,10 +149,30 @@ static MQTTPubAckInfo_t CloudProvIncomingPublishRecords[ CLOUD_PROV_INCOMING_PUB
 static char CloudProvThingName[ CLOUD_PROV_THING_NAME_BUFFER_SIZE ];
 
 static FleetProvisioningTopic_t CloudProvFleetTopic = FleetProvisioningInvalidTopic;
+
+/** @brief Provisioning progress, persisted so that an interrupted provisioning resumes where it stopped */
+static CloudProvJournal_t CloudProvJournal;
+
+/** @brief Set when the broker resumed the persistent session of the device on last connection */
+static bool CloudProvSessionPresent = false;
 static bool CLoudProvForceProvisioning = false;
-static char CloudProvMqttEndpoint[CLOUD_PROV_MQTT_ENDPOINT_BUFFER_SIZE] = CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT;
-static char CloudProvClaimCert[CLOUD_PROV_CLAIM_CERT_BUFFER_SIZE] = CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM;
-static char CloudProvClaimPrivateKey[CLOUD_PROV_CLAIM_PRIVATE_KEY_BUFFER_SIZE] = CLOUD_PROV_DEFAULT_CLAIM_PRIVATE_KEY_PEM;
+
+/** @brief Set once littleFS, the PKCS #11 session and the IP stack are up, CloudProv_Init may run again after the
+ *         boot menu aborted a speculative connection */
+static bool CloudProvPlatformReady = false;
+
+/** @brief Boot decision taken by the console, see CLOUD_PROV_BOOT_CONFIRMED_BIT */
+static EventGroupHandle_t CloudProvBootEvents = NULL;
+static StaticEventGroup_t CloudProvBootEventsBuffer;
+
+/** @brief Claim credentials used to provision the device.
+ * @details These point either to the default credentials or directly to the credentials stored in data flash by the
+ *          console, which is memory mapped. No RAM copy is kept since claim credentials are only read once
+ *          by CloudProv_ProvisionDevice when they are imported into corePKCS11. */
+static const char *CloudProvClaimCert = CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM;
+static size_t CloudProvClaimCertLength = sizeof(CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM) - 1u;
+static const char *CloudProvClaimPrivateKey = CLOUD_PROV_DEFAULT_CLAIM_PRIVATE_KEY_PEM;
+static size_t CloudProvClaimPrivateKeyLength = sizeof(CLOUD_PROV_DEFAULT_CLAIM_PRIVATE_KEY_PEM) - 1u;
 
 /*************************************************************************************
  * Local Function Prototypes
@@ -179,9 +216,13 @@ static TlsTransportStatus_t CloudProv_ConnectTLS(NetworkContext_t * networkConte
  * MQTT connection.
  * @param[in] appMqttCallback The callback function used to receive incoming
  * publishes and incoming acks from MQTT library.
+ * @param[in] persistentSession true to resume the session kept by the broker (cleanSession = false) and resend
+ * publishes saved by #CloudProv_SessionTrackPublish. Only used with device credentials.
  * @return The MQTT status of the final connection attempt.
  */
-static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEventCallback_t appMqttCallback);
+static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext,
+                                          MQTTEventCallback_t appMqttCallback,
+                                          bool persistentSession);
 
 /**
  * @brief Function to resend the publishes if a session is re-established with
@@ -190,7 +231,80 @@ static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEvent
  *
  * @param[in] pxMqttContext MQTT context pointer.
  */
-static BaseType_t CloudProv_PublishResend(MQTTContext_t * pxMqttContext );
+static MQTTStatus_t CloudProv_PublishResend(MQTTContext_t * pxMqttContext );
+
+/**
+ * @brief Get the device key pair for provisioning. The key pair left pending in corePKCS11 by an interrupted
+ *        provisioning is reused, otherwise a new one is prepared and recorded in the journal.
+ * @return true if the device key pair is ready to sign the CSR.
+ */
+static bool CloudProv_JournalDeviceKey(void);
+
+/**
+ * @brief Load what previous boots left in littleFS and start the key pair pre-generation provisioning may need.
+ */
+static void CloudProv_LoadBootState(void);
+
+/**
+ * @brief Copy the certificate received from AWS IoT out of the MQTT buffer, which RegisterThing reuses, until it is
+ *        committed, and note its id in the journal.
+ * @param[in] certBuffer Buffer of CLOUD_PROV_CERT_DER_BUFFER_SIZE bytes receiving the DER certificate.
+ * @param[out] certLength Length of the DER certificate.
+ * @return true if the certificate fits in certBuffer.
+ */
+static bool CloudProv_KeepIssuedCertificate(const CloudProvCborView_t *certificate,
+                                            const CloudProvCborView_t *certificateId,
+                                            uint8_t *certBuffer,
+                                            size_t *certLength);
+
+/**
+ * @brief Save the issued certificate and ownership token in the journal, and mark the certificate as issued, so that
+ *        an interrupted provisioning resumes at RegisterThing. Failing to do so only loses that.
+ * @details The claim credentials are destroyed first: with an RSA-2048 claim key, they take 18 of the 32 littleFS
+ *          blocks, and the DER certificate and token about 12 more. They are only needed for the TLS handshake,
+ *          which is done, and every provisioning attempt imports them again.
+ */
+static void CloudProv_JournalIssuedCertificate(const uint8_t *certBuffer,
+                                               size_t certLength,
+                                               const CloudProvCborView_t *ownershipToken);
+
+/**
+ * @brief Read back the certificate and ownership token journaled by an interrupted provisioning, then release their
+ *        blocks for the claim credentials. They are journaled again by CloudProv_JournalIssuedCertificate.
+ * @param[in] payloadBuffer Payload buffer, receiving the DER certificate and the ownership token after it.
+ * @param[out] ownershipToken Ownership token, in place in payloadBuffer.
+ * @return Length of the DER certificate, 0 if a new certificate must be requested.
+ */
+static size_t CloudProv_ResumeIssuedCertificate(uint8_t *payloadBuffer, CloudProvCborView_t *ownershipToken);
+
+/**
+ * @brief Replace the claim credentials in corePKCS11 by the device key and certificate, and mark the device as
+ *        registered. With CreateKeysAndCertificate the device key is in corePKCS11 already.
+ * @param[in] certBuffer DER device certificate kept by CloudProv_KeepIssuedCertificate.
+ * @return true if device credentials are in corePKCS11.
+ */
+static bool CloudProv_CommitDeviceCredentials(const uint8_t *certBuffer, size_t certLength);
+
+/**
+ * @brief Store the PEM private key received from CreateKeysAndCertificate into corePKCS11 under the TLS private
+ *        key label, replacing the claim credentials. The key is scrubbed from the received publish and from
+ *        keyBuffer whatever the outcome.
+ * @param[in] privateKey PEM private key, in place in the MQTT buffer.
+ * @param[in] keyBuffer Scratch buffer of CLOUD_PROV_PAYLOAD_BUFFER_SIZE bytes, scrubbed on return.
+ * @return true if stored.
+ */
+static bool CloudProv_ImportIssuedKey(const CloudProvCborView_t *privateKey, uint8_t *keyBuffer);
+
+/**
+ * @brief Get the boot decision event group, creating it on first use by either the console or the cloud thread.
+ */
+static EventGroupHandle_t CloudProv_BootEvents(void);
+
+/**
+ * @brief Wait for the console to confirm or abort the connection started at boot.
+ * @return true if the application is confirmed, false if the boot menu was opened.
+ */
+static bool CloudProv_BootAwaitDecision(void);
 
 /*************************************************************************************
  * Local Functions
@@ -261,7 +375,7 @@ static void CloudProv_MqttCallback(MQTTContext_t * pxMqttContext,
 
         if( xStatus != FleetProvisioningSuccess )
         {
-            APP_WARN_PRINT( ( "Unexpected publish message received. Topic: %.*s.\r\n"),
+            APP_WARN_PRINT( "Unexpected publish message received. Topic: %.*s.\r\n",
                             ( int ) pxPublishInfo->topicNameLength,
                             ( const char * ) pxPublishInfo->pTopicName );
         }
@@ -271,19 +385,21 @@ static void CloudProv_MqttCallback(MQTTContext_t * pxMqttContext,
             memcpy((void *)&CloudProvPublishInfo,
                    (void *)pxDeserializedInfo->pPublishInfo,
                    sizeof(MQTTPublishInfo_t));
-            APP_INFO_PRINT( ( "Response from Fleet Provisioning Topic: %.*s.\r\n"),
+            APP_INFO_PRINT( "Response from Fleet Provisioning Topic: %.*s.\r\n",
                             ( int ) pxPublishInfo->topicNameLength,
                             ( const char * ) pxPublishInfo->pTopicName );
             switch (xApi)
             {
                 case FleetProvCborCreateCertFromCsrAccepted:
+                case FleetProvCborCreateKeysAndCertAccepted:
                 case FleetProvCborRegisterThingAccepted:
                 case FleetProvCborCreateCertFromCsrRejected:
+                case FleetProvCborCreateKeysAndCertRejected:
                 case FleetProvCborRegisterThingRejected:
                     CloudProvFleetTopic = xApi;
                     break;
                 default:
-                    APP_ERR_PRINT( ( "Received message on currently unsupported Fleet Provisioning topic.\r\n"));
+                    APP_ERR_PRINT( "Received message on currently unsupported Fleet Provisioning topic.\r\n");
             }
         }
     }
@@ -337,11 +453,12 @@ static uint32_t CloudProv_GetTimeMs(void )
 
 static TlsTransportStatus_t CloudProv_ConnectTLS(NetworkContext_t * networkContext)
 {
-    TlsTransportStatus_t connectionStatus = TLS_TRANSPORT_SUCCESS;
+    TlsTransportStatus_t connectionStatus = TLS_TRANSPORT_CONNECT_FAILURE;
     BackoffAlgorithmStatus_t backoffAlgStatus = BackoffAlgorithmSuccess;
     BackoffAlgorithmContext_t reconnectParams = {0 };
     NetworkCredentials_t networkCredentials = { 0 };
     uint16_t usNextRetryBackOff = 0U;
+    uint32_t connectStartMs;
 
 #if defined( CLOUD_PROV_CLIENT_USERNAME )
 
@@ -374,8 +491,8 @@ static TlsTransportStatus_t CloudProv_ConnectTLS(NetworkContext_t * networkConte
 #endif /* (CLOUD_PROV_MQTT_BROKER_PORT == 443U) */
 
     /* Set the credentials for establishing a TLS connection. */
-    networkCredentials.pRootCa = ( const unsigned char * ) CLOUD_PROV_DEV_ROOT_CA_PEM;
-    networkCredentials.rootCaSize = sizeof(CLOUD_PROV_DEV_ROOT_CA_PEM);
+    networkCredentials.pRootCa = CloudProvRootCaPem;
+    networkCredentials.rootCaSize = CloudProvRootCaPemSize;
     networkCredentials.pClientCertLabel = pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS;
     networkCredentials.pPrivateKeyLabel = pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS;
     networkCredentials.disableSni = pdFALSE;
@@ -386,19 +503,27 @@ static TlsTransportStatus_t CloudProv_ConnectTLS(NetworkContext_t * networkConte
                                       CLOUD_PROV_TLS_MAX_BACKOFF_DELAY_MS,
                                       CLOUD_PROV_TLS_RETRY_MAX_ATTEMPTS );
 
-    /* Attempt to connect to MQTT broker. If connection fails, retry after a timeout managed by backoff algorithm */
-    do
+    /* Attempt to connect to MQTT broker. If connection fails, retry after a timeout managed by backoff algorithm.
+     * Nothing is attempted once the boot menu asked to stop */
+    while((connectionStatus != TLS_TRANSPORT_SUCCESS ) && (backoffAlgStatus == BackoffAlgorithmSuccess ) &&
+          (CloudProv_BootAborted() == false))
     {
-        /* Establish a TLS connection with the MQTT broker */
-        LogInfo( ( "Create a TLS connection to %s:%d.",
-                CloudProvMqttEndpoint,
-                CLOUD_PROV_MQTT_BROKER_PORT ) );
-        connectionStatus = TLS_FreeRTOS_Connect(networkContext,
-                                                CloudProvMqttEndpoint,
-                                                CLOUD_PROV_MQTT_BROKER_PORT,
-                                                &networkCredentials,
-                                                CLOUD_PROV_MQTT_SEND_RECV_TIMEOUT_MS,
-                                                CLOUD_PROV_MQTT_SEND_RECV_TIMEOUT_MS );
+        /* Establish a TLS connection with the first MQTT broker endpoint that answers */
+        connectStartMs = CloudProv_GetTimeMs();
+        connectionStatus = CloudProv_EndpointConnect(networkContext,
+                                                     &networkCredentials,
+                                                     CLOUD_PROV_MQTT_SEND_RECV_TIMEOUT_MS);
+        /* The private key is not needed once the handshake is over, whatever its outcome */
+        CloudProv_CredentialCacheWipeKey();
+        /* Report connection latency and heap, so reconnects served by the credential cache can be compared
+         * with the first connection that reads credentials from littleFS, and TLS profiles with each other */
+        APP_INFO_PRINT("TLS connect took %lu ms, heap free %lu bytes, lowest ever %lu bytes\r\n",
+                       (unsigned long)(CloudProv_GetTimeMs() - connectStartMs),
+                       (unsigned long)xPortGetFreeHeapSize(),
+                       (unsigned long)xPortGetMinimumEverFreeHeapSize());
+#if defined(CLOUD_PROV_TLS_PROFILER)
+        CloudProv_TlsProfilerReport();
+#endif
 
         if(connectionStatus != TLS_TRANSPORT_SUCCESS )
         {
@@ -413,21 +538,23 @@ static TlsTransportStatus_t CloudProv_ConnectTLS(NetworkContext_t * networkConte
 
             if(backoffAlgStatus == BackoffAlgorithmRetriesExhausted )
             {
-                APP_ERR_PRINT( ( "Connection to the broker failed, all attempts exhausted.\r\n" ) );
+                APP_ERR_PRINT( "Connection to the broker failed, all attempts exhausted.\r\n" );
             }
             else if(backoffAlgStatus == BackoffAlgorithmSuccess )
             {
-                APP_WARN_PRINT( ( "Connection to the broker failed. "
-                           "Retrying connection with backoff and jitter.\r\n" ) );
+                APP_WARN_PRINT( "Connection to the broker failed. "
+                           "Retrying connection with backoff and jitter.\r\n" );
                 vTaskDelay( pdMS_TO_TICKS( usNextRetryBackOff ) );
             }
         }
-    } while((connectionStatus != TLS_TRANSPORT_SUCCESS ) && (backoffAlgStatus == BackoffAlgorithmSuccess ) );
+    }
 
     return connectionStatus;
 }
 
-static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEventCallback_t appMqttCallback)
+static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext,
+                                          MQTTEventCallback_t appMqttCallback,
+                                          bool persistentSession)
 {
     MQTTStatus_t mqttStatus = MQTTBadParameter;
     MQTTConnectInfo_t connectInfo;
@@ -474,16 +601,26 @@ static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEvent
         }
     }
 
+    if((mqttStatus == MQTTSuccess) && (persistentSession == true))
+    {
+        /* Continue packet identifiers where previous boot left them, so new publishes do not collide with
+         * the saved ones about to be resent */
+        CloudProv_SessionLoad();
+        if(CloudProv_SessionNextPacketId() != 0u)
+        {
+            mqttContext->nextPacketId = CloudProv_SessionNextPacketId();
+        }
+    }
+
     if(mqttStatus == MQTTSuccess)
     {
         /* Prepare send CONNECT packet. Init connectInfo struct */
         ( void ) memset(( void * ) &connectInfo, 0x00, sizeof( connectInfo ) );
 
-        /* Start with a clean session i.e. direct the MQTT broker to discard any
-         * previous session data. Also, establishing a connection with clean session
-         * will ensure that the broker does not store any data when this client
-         * gets disconnected. */
-        connectInfo.cleanSession = true;
+        /* Device connections resume the session kept by the broker, so that subscriptions and unacknowledged
+         * publishes survive a reset. Provisioning connections with claim credentials start with a clean session
+         * i.e. direct the MQTT broker to discard any previous session data. */
+        connectInfo.cleanSession = (persistentSession == true) ? false : true;
 
         /* The client identifier is used to uniquely identify this MQTT client to
          * the MQTT broker. In a production device the identifier can be something
@@ -516,19 +653,26 @@ static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEvent
                                   &sessionPresent );
         if(mqttStatus == MQTTRecvFailed)
         {
-            APP_ERR_PRINT(("TLS connection was done correctly but closed shortly after by AWS IoT Core. "
-                           "It is very likely the certificate chain is invalid.\r\n"));
+            APP_ERR_PRINT("TLS connection was done correctly but closed shortly after by AWS IoT Core. "
+                           "It is very likely the certificate chain is invalid.\r\n");
         }
         else if(mqttStatus != MQTTSuccess )
         {
-            APP_ERR_PRINT(( "MQTT_Connect() returns status code %s.\r\n"), MQTT_Status_strerror(mqttStatus ));
+            APP_ERR_PRINT("MQTT_Connect() returns status code %s.\r\n", MQTT_Status_strerror(mqttStatus ));
         }
         else
         {
             /* Connection successfull */
+            CloudProvSessionPresent = (persistentSession == true) ? sessionPresent : false;
         }
     }
 
+    if((mqttStatus == MQTTSuccess) && (persistentSession == true))
+    {
+        /* Publishes not acknowledged before the reset are sent again */
+        mqttStatus = CloudProv_PublishResend(mqttContext);
+    }
+
     if(mqttStatus == MQTTSuccess )
     {
         LogInfo( ( "MQTT connection successfully established with broker.\n\n" ) );
@@ -538,6 +682,33 @@ static MQTTStatus_t CloudProv_ConnectMQTT(MQTTContext_t * mqttContext, MQTTEvent
 }
 
 
+static MQTTStatus_t CloudProv_PublishResend(MQTTContext_t * pxMqttContext )
+{
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    MQTTPublishInfo_t pubInfo;
+    uint16_t packetId;
+
+    for(uint8_t slot = 0u; (slot < CLOUD_PROV_SESSION_INFLIGHT_MAX) && (mqttStatus == MQTTSuccess); slot++)
+    {
+        if(CloudProv_SessionGetPublish(slot, &pubInfo, &packetId) == true)
+        {
+            /* DUP tells the broker it may have received this publish already. Without a resumed session, the
+             * broker has no record of it and it is sent as a new publish */
+            pubInfo.dup = CloudProvSessionPresent;
+            mqttStatus = MQTT_Publish(pxMqttContext, &pubInfo, packetId);
+            APP_INFO_PRINT("Resent unacknowledged publish %d on %.*s\r\n", packetId,
+                           pubInfo.topicNameLength, pubInfo.pTopicName);
+        }
+    }
+
+    if(mqttStatus != MQTTSuccess)
+    {
+        APP_ERR_PRINT("Failed to resend unacknowledged publishes with error = %s.\r\n",
+                      MQTT_Status_strerror(mqttStatus));
+    }
+    return mqttStatus;
+}
+
 static MQTTStatus_t CloudProv_ManageFleetProvTopics(MQTTContext_t *mqttContext, CloudProvTopicAction_t action)
 {
     MQTTStatus_t mqttStatus;
@@ -545,10 +716,17 @@ static MQTTStatus_t CloudProv_ManageFleetProvTopics(MQTTContext_t *mqttContext,
     uint16_t packetId;
 
     /* Populate subscription list with hardcoded topic info */
+#if (CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS)
+    subscriptionList[0u].pTopicFilter = FP_CBOR_CREATE_KEYS_ACCEPTED_TOPIC;
+    subscriptionList[0u].topicFilterLength = FP_CBOR_CREATE_KEYS_ACCEPTED_LENGTH;
+    subscriptionList[1u].pTopicFilter = FP_CBOR_CREATE_KEYS_REJECTED_TOPIC;
+    subscriptionList[1u].topicFilterLength = FP_CBOR_CREATE_KEYS_REJECTED_LENGTH;
+#else
     subscriptionList[0u].pTopicFilter = FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC;
     subscriptionList[0u].topicFilterLength = FP_CBOR_CREATE_CERT_ACCEPTED_LENGTH;
     subscriptionList[1u].pTopicFilter = FP_CBOR_CREATE_CERT_REJECTED_TOPIC;
     subscriptionList[1u].topicFilterLength = FP_CBOR_CREATE_CERT_REJECTED_LENGTH;
+#endif
     subscriptionList[2u].pTopicFilter = FP_CBOR_REGISTER_ACCEPTED_TOPIC(CLOUD_PROV_TEMPLATE_NAME );
     subscriptionList[2u].topicFilterLength = FP_CBOR_REGISTER_ACCEPTED_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH);
     subscriptionList[3u].pTopicFilter = FP_CBOR_REGISTER_REJECTED_TOPIC(CLOUD_PROV_TEMPLATE_NAME );
@@ -601,45 +779,127 @@ static MQTTStatus_t CloudProv_ManageFleetProvTopics(MQTTContext_t *mqttContext,
     return mqttStatus;
 }
 
-static bool CloudProv_RequestCertificate(MQTTContext_t *mqttContext,
-                                  uint8_t *ownershipToken,
-                                  size_t *ownershipTokenLength)
+static bool CloudProv_KeepIssuedCertificate(const CloudProvCborView_t *certificate,
+                                            const CloudProvCborView_t *certificateId,
+                                            uint8_t *certBuffer,
+                                            size_t *certLength)
 {
-    uint8_t certBuffer[ CLOUD_PROV_CERT_BUFFER_SIZE ] = {0 };
-    uint8_t payloadBuffer[CLOUD_PROV_MQTT_BUFFER_SIZE];
-    size_t certLength = 0u;
-    uint8_t certIdBuffer[CLOUD_PROV_CERT_ID_BUFFER_SIZE];
-    size_t certIdLength = CLOUD_PROV_CERT_ID_BUFFER_SIZE;
-    size_t payloadLength = 0u;
-    bool status = false;
-    MQTTStatus_t mqttStatus = MQTTBadParameter;
+    bool status;
+
+    /* Kept in DER, the form corePKCS11 stores it in and the most compact one to journal */
+    *certLength = CLOUD_PROV_CERT_DER_BUFFER_SIZE;
+    status = CloudProv_CertificateToDer(certificate->pData, certificate->length, certBuffer, certLength);
 
-    status = CloudProv_GenerateCsr(CloudProvP11Session,
-                                   certBuffer,
-                                   CLOUD_PROV_CERT_BUFFER_SIZE,
-                                   &certLength);
     if(status == true)
     {
-        status = CloudProv_SerializeCsr(certBuffer,
-                                        certLength,
-                                        CLOUD_PROV_MQTT_BUFFER_SIZE,
-                                        payloadBuffer,
-                                        &payloadLength);
+        memset(CloudProvJournal.certificateId, 0x00, CLOUD_PROV_JOURNAL_CERT_ID_SIZE);
+        memcpy(CloudProvJournal.certificateId, certificateId->pData,
+               (certificateId->length < CLOUD_PROV_JOURNAL_CERT_ID_SIZE) ? certificateId->length :
+                                                                         (CLOUD_PROV_JOURNAL_CERT_ID_SIZE - 1u));
+        APP_INFO_PRINT("Device certificate %s issued\r\n", CloudProvJournal.certificateId);
     }
+    else
+    {
+        APP_ERR_PRINT("Device certificate of %u PEM bytes does not fit in %u DER bytes\r\n",
+                      (unsigned int)certificate->length, (unsigned int)CLOUD_PROV_CERT_DER_BUFFER_SIZE);
+        *certLength = 0u;
+    }
+
+    return status;
+}
+
+static void CloudProv_JournalIssuedCertificate(const uint8_t *certBuffer,
+                                               size_t certLength,
+                                               const CloudProvCborView_t *ownershipToken)
+{
+    bool status = (ownershipToken->length <= (size_t)CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE);
 
     if(status == true)
     {
+        /* The certificate and token do not fit next to the claim credentials, see CloudProvStage_t */
+        status = (xDestroyDefaultCryptoObjects(CloudProvP11Session) == CKR_OK);
+    }
+    if(status == true)
+    {
+        status = CloudProv_JournalSaveArtifact(CLOUD_PROV_ARTIFACT_CERTIFICATE, certBuffer, certLength);
+    }
+    if(status == true)
+    {
+        status = CloudProv_JournalSaveArtifact(CLOUD_PROV_ARTIFACT_OWNERSHIP_TOKEN,
+                                               ownershipToken->pData,
+                                               ownershipToken->length);
+    }
+    if(status == true)
+    {
+        status = CloudProv_JournalAdvance(&CloudProvJournal, CLOUD_PROV_STAGE_CERT_ISSUED);
+    }
+    if(status != true)
+    {
+        /* Registration goes on from RAM, only resuming it after a reset is lost */
+        APP_WARN_PRINT("Could not journal certificate %s, an interrupted provisioning requests a new one\r\n",
+                       CloudProvJournal.certificateId);
+        CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_KEY_GENERATED);
+    }
+}
+
+static size_t CloudProv_ResumeIssuedCertificate(uint8_t *payloadBuffer, CloudProvCborView_t *ownershipToken)
+{
+    uint8_t *tokenBuffer = &payloadBuffer[CLOUD_PROV_CERT_DER_BUFFER_SIZE];
+    size_t certLength = 0u;
+    bool status;
+
+    status = CloudProv_JournalLoadArtifact(CLOUD_PROV_ARTIFACT_CERTIFICATE,
+                                           payloadBuffer,
+                                           CLOUD_PROV_CERT_DER_BUFFER_SIZE,
+                                           &certLength);
+    if(status == true)
+    {
+        status = CloudProv_JournalLoadArtifact(CLOUD_PROV_ARTIFACT_OWNERSHIP_TOKEN,
+                                               tokenBuffer,
+                                               CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE,
+                                               &ownershipToken->length);
+    }
+    if(status == true)
+    {
+        ownershipToken->pData = (const char *)tokenBuffer;
+        /* The claim credentials are imported next and do not fit next to the artifacts. A reset before they are
+         * journaled again finds the stage without its artifacts, and requests a new certificate */
+        CloudProv_JournalReleaseArtifacts();
+    }
+    else
+    {
+        APP_WARN_PRINT("Certificate %s was issued but cannot be resumed, requesting a new one\r\n",
+                       CloudProvJournal.certificateId);
+        CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_KEY_GENERATED);
+        certLength = 0u;
+    }
+
+    return certLength;
+}
 
-        uint16_t packetId = MQTT_GetPacketId(mqttContext);
-        MQTTPublishInfo_t pubInfo = {
-            .pTopicName = FP_CBOR_CREATE_CERT_PUBLISH_TOPIC,
-            .topicNameLength = FP_CBOR_CREATE_CERT_PUBLISH_LENGTH,
-            .pPayload = payloadBuffer,
-            .payloadLength = payloadLength,
-            .qos = MQTTQoS1
-            };
+static bool CloudProv_RequestCertificate(MQTTContext_t *mqttContext,
+                                  uint8_t *payloadBuffer,
+                                  CloudProvCborView_t *ownershipToken,
+                                  size_t *certLength)
+{
+    CloudProvCborView_t certificate = { NULL, 0u };
+    CloudProvCborView_t certificateId = { NULL, 0u };
+    CloudProvCsrRequest_t csrRequest = { payloadBuffer, 0u };
+    bool status = false;
+    MQTTStatus_t mqttStatus = MQTTBadParameter;
 
-        mqttStatus = MQTT_Publish(mqttContext, &pubInfo, packetId);
+    /* The CSR is streamed from where it is generated, see CloudProv_PublishStream */
+    status = CloudProv_GenerateCsr(CloudProvP11Session,
+                                   payloadBuffer,
+                                   CLOUD_PROV_PAYLOAD_BUFFER_SIZE,
+                                   &csrRequest.xCsrLength);
+    if(status == true)
+    {
+        mqttStatus = CloudProv_PublishStream(mqttContext,
+                                             FP_CBOR_CREATE_CERT_PUBLISH_TOPIC,
+                                             FP_CBOR_CREATE_CERT_PUBLISH_LENGTH,
+                                             CloudProv_EncodeCsrRequest,
+                                             &csrRequest);
         if(mqttStatus != MQTTSuccess)
         {
             LogError( ( "Failed to publish to fleet provisioning topic: %.*s.\r\n",
@@ -663,24 +923,90 @@ static bool CloudProv_RequestCertificate(MQTTContext_t *mqttContext,
 
     if((mqttStatus == MQTTSuccess) && (CloudProvFleetTopic == FleetProvCborCreateCertFromCsrAccepted))
     {
-        /* From the response, extract the certificate, certificate ID, and
-         * certificate ownership token. */
-        /* set certLength to buffer size, since this is an input/output parameter that takes max buff
-         * size as input and gives string length written into buffer as output */
-        certLength = CLOUD_PROV_CERT_BUFFER_SIZE;
+        /* From the response, extract the certificate, certificate ID, and certificate ownership token. They are
+         * left in the MQTT buffer, the ownership token is serialized from there. The CSR was sent, the payload
+         * buffer now keeps the DER certificate */
         status = CloudProv_DeserializeCsrResponse((const uint8_t *)CloudProvPublishInfo.pPayload,
                                                    CloudProvPublishInfo.payloadLength,
-                                                   (char *)certBuffer,
-                                                   &certLength,
-                                                   (char *)certIdBuffer,
-                                                   &certIdLength,
-                                                   (char *)ownershipToken,
-                                                   ownershipTokenLength);
+                                                   &certificate,
+                                                   &certificateId,
+                                                   ownershipToken);
+        if(status == true)
+        {
+            status = CloudProv_KeepIssuedCertificate(&certificate, &certificateId, payloadBuffer, certLength);
+        }
+    }
+    else
+    {
+        status = false;
+    }
+
+    /* Reset cloud provision fleet topic for next publish */
+    CloudProvFleetTopic = FleetProvisioningInvalidTopic;
+    return status;
+}
+
+static bool CloudProv_RequestKeysAndCertificate(MQTTContext_t *mqttContext,
+                                                uint8_t *payloadBuffer,
+                                                CloudProvCborView_t *ownershipToken,
+                                                size_t *certLength)
+{
+    CloudProvCborView_t certificate = { NULL, 0u };
+    CloudProvCborView_t certificateId = { NULL, 0u };
+    CloudProvCborView_t privateKey = { NULL, 0u };
+    bool status = false;
+    MQTTStatus_t mqttStatus;
+
+    mqttStatus = CloudProv_PublishStream(mqttContext,
+                                         FP_CBOR_CREATE_KEYS_PUBLISH_TOPIC,
+                                         FP_CBOR_CREATE_KEYS_PUBLISH_LENGTH,
+                                         CloudProv_EncodeCreateKeysRequest,
+                                         NULL);
+    if(mqttStatus != MQTTSuccess)
+    {
+        LogError( ( "Failed to publish to fleet provisioning topic: %.*s.\r\n",
+                FP_CBOR_CREATE_KEYS_PUBLISH_LENGTH,
+                FP_CBOR_CREATE_KEYS_PUBLISH_TOPIC ));
+    }
+
+    if(mqttStatus == MQTTSuccess)
+    {
+        /* Server generates the key pair, wait for the response the same way as for CreateCertificateFromCsr */
+        uint16_t timeMs = 0u;
+        while((timeMs <= 5000u) && (CloudProvFleetTopic == FleetProvisioningInvalidTopic))
+        {
+            mqttStatus = MQTT_ProcessLoop( mqttContext);
+            timeMs += 1000u;
+            vTaskDelay(pdMS_TO_TICKS(1000u));
+        }
+    }
+
+    if((mqttStatus == MQTTSuccess) && (CloudProvFleetTopic == FleetProvCborCreateKeysAndCertAccepted))
+    {
+        status = CloudProv_DeserializeCreateKeysResponse((const uint8_t *)CloudProvPublishInfo.pPayload,
+                                                         CloudProvPublishInfo.payloadLength,
+                                                         &certificate,
+                                                         &certificateId,
+                                                         ownershipToken,
+                                                         &privateKey);
+        if(status == true)
+        {
+            /* The private key never reaches the journal, it goes to corePKCS11 right away */
+            status = CloudProv_ImportIssuedKey(&privateKey, payloadBuffer);
+        }
+        else if(privateKey.pData != NULL)
+        {
+            /* Response is not usable, still scrub the private key from the received publish */
+            memset((void *)privateKey.pData, 0x00, privateKey.length);
+        }
+        else
+        {
+            /* No private key received */
+        }
         if(status == true)
         {
-            status = CloudProv_LoadCertificate(CloudProvP11Session,
-                                               (const char *)certBuffer,
-                                               certLength);
+            /* The key was scrubbed from the payload buffer, which now keeps the certificate */
+            status = CloudProv_KeepIssuedCertificate(&certificate, &certificateId, payloadBuffer, certLength);
         }
     }
     else
@@ -694,46 +1020,31 @@ static bool CloudProv_RequestCertificate(MQTTContext_t *mqttContext,
 }
 
 static MQTTStatus_t CloudProv_RegisterDevice(MQTTContext_t *mqttContext,
-                                  uint8_t *ownershipToken,
-                                  size_t ownershipTokenLength)
+                                  const CloudProvCborView_t *ownershipToken)
 {
-    uint8_t payloadBuffer[CLOUD_PROV_MQTT_BUFFER_SIZE];
-    size_t payloadLength;
     bsp_unique_id_t const *deviceUniqueId = R_BSP_UniqueIdGet();
     CborError cborStatus;
-    MQTTStatus_t mqttStatus = MQTTBadParameter;
+    MQTTStatus_t mqttStatus;
     size_t thingNameLength = CLOUD_PROV_THING_NAME_BUFFER_SIZE;
     char deviceId[36u];
+    CloudProvRegisterThingRequest_t registerRequest = { *ownershipToken, deviceId, 0u };
     sprintf(deviceId, (void *) "%08x-%08x-%08x-%08x",
             (uint32_t) deviceUniqueId->unique_id_words[0], (uint32_t) deviceUniqueId->unique_id_words[1],
             (uint32_t) deviceUniqueId->unique_id_words[2], (uint32_t) deviceUniqueId->unique_id_words[3]);
-    APP_INFO_PRINT( ( "Device Unique ID : %s\r\n"),deviceId );
-
-    cborStatus = CloudProv_SerializeRegisterThingRequest( (const char *)ownershipToken,
-                                             ownershipTokenLength,
-                                                          deviceId,
-                                                          strlen(deviceId),
-                                            CLOUD_PROV_MQTT_BUFFER_SIZE,
-                                            payloadBuffer,
-                                            &payloadLength );
-
-    if(cborStatus == CborNoError)
-    {
-        uint16_t packetId = MQTT_GetPacketId(mqttContext);
-        MQTTPublishInfo_t pubInfo = {
-                .pTopicName = FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME ),
-                .topicNameLength = FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH ),
-                .pPayload = payloadBuffer,
-                .payloadLength = payloadLength,
-                .qos = MQTTQoS1
-        };
-        mqttStatus = MQTT_Publish(mqttContext, &pubInfo, packetId);
-        if(mqttStatus != MQTTSuccess)
-        {
-            LogError( ( "Failed to publish to fleet provisioning topic: %.*s.\r\n",
-                    FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH ),
-                    FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME ) ));
-        }
+    APP_INFO_PRINT( "Device Unique ID : %s\r\n",deviceId );
+    registerRequest.xSerialNbLength = strlen(deviceId);
+
+    /* The ownership token may point into the MQTT buffer, it is streamed before any MQTT API call reuses it */
+    mqttStatus = CloudProv_PublishStream(mqttContext,
+                                         FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME ),
+                                         FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH ),
+                                         CloudProv_EncodeRegisterThingRequest,
+                                         &registerRequest);
+    if(mqttStatus != MQTTSuccess)
+    {
+        LogError( ( "Failed to publish to fleet provisioning topic: %.*s.\r\n",
+                FP_CBOR_REGISTER_PUBLISH_LENGTH(CLOUD_PROV_TEMPLATE_NAME_LENGTH ),
+                FP_CBOR_REGISTER_PUBLISH_TOPIC(CLOUD_PROV_TEMPLATE_NAME ) ));
     }
 
     if(mqttStatus == MQTTSuccess)
@@ -756,7 +1067,7 @@ static MQTTStatus_t CloudProv_RegisterDevice(MQTTContext_t *mqttContext,
                                        &thingNameLength);
         if(cborStatus == CborNoError)
         {
-            APP_INFO_PRINT( ( "Received AWS IoT Thing name: %.*s\r\n"), ( int ) thingNameLength, CloudProvThingName );
+            APP_INFO_PRINT( "Received AWS IoT Thing name: %.*s\r\n", ( int ) thingNameLength, CloudProvThingName );
 
         }
         else
@@ -766,6 +1077,11 @@ static MQTTStatus_t CloudProv_RegisterDevice(MQTTContext_t *mqttContext,
             mqttStatus = MQTTBadParameter;
         }
     }
+    else if(CloudProvFleetTopic == FleetProvCborRegisterThingRejected)
+    {
+        /* Register thing was refused, ownership token or certificate is not valid anymore */
+        mqttStatus = MQTTServerRefused;
+    }
     else
     {
         /* Register thing was not accepted, so return a failed status */
@@ -774,6 +1090,143 @@ static MQTTStatus_t CloudProv_RegisterDevice(MQTTContext_t *mqttContext,
     return mqttStatus;
 }
 
+static EventGroupHandle_t CloudProv_BootEvents(void)
+{
+    taskENTER_CRITICAL();
+    if(CloudProvBootEvents == NULL)
+    {
+        CloudProvBootEvents = xEventGroupCreateStatic(&CloudProvBootEventsBuffer);
+    }
+    taskEXIT_CRITICAL();
+
+    return CloudProvBootEvents;
+}
+
+static bool CloudProv_BootAwaitDecision(void)
+{
+    EventBits_t bootBits = xEventGroupWaitBits(CloudProv_BootEvents(),
+                                               CLOUD_PROV_BOOT_CONFIRMED_BIT | CLOUD_PROV_BOOT_ABORTED_BIT,
+                                               pdFALSE,
+                                               pdFALSE,
+                                               portMAX_DELAY);
+
+    return ((bootBits & CLOUD_PROV_BOOT_ABORTED_BIT) == 0u);
+}
+
+static bool CloudProv_JournalDeviceKey(void)
+{
+    bool status = false;
+
+    if(CloudProvJournal.stage >= CLOUD_PROV_STAGE_KEY_GENERATED)
+    {
+        /* Resumed provisioning, the certificate may already be issued for the pending key pair */
+        status = CloudProv_DeviceKeyRestore(CloudProvP11Session);
+        if(status != true)
+        {
+            APP_WARN_PRINT("Pending device key is not usable, restarting provisioning from scratch\r\n");
+            CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_NONE);
+        }
+    }
+
+    if(CloudProvJournal.stage == CLOUD_PROV_STAGE_NONE)
+    {
+        status = CloudProv_DeviceKeyPrepare(CloudProvP11Session);
+        if(status == true)
+        {
+            status = CloudProv_JournalAdvance(&CloudProvJournal, CLOUD_PROV_STAGE_KEY_GENERATED);
+        }
+    }
+
+    return status;
+}
+
+static void CloudProv_LoadBootState(void)
+{
+    /* Try the endpoint that worked last time first */
+    CloudProv_EndpointLoadLastGood();
+    /* Find out how far provisioning went on previous boots */
+    CloudProv_JournalLoad(&CloudProvJournal);
+
+    if((CLoudProvForceProvisioning == true) || (CloudProvJournal.stage == CLOUD_PROV_STAGE_NONE))
+    {
+        /* Use the time spent waiting for the network to generate the key pair a provisioning would need.
+         * A registered device does not need one, and an interrupted provisioning restores its own */
+        CloudProv_PregenerateDeviceKey();
+    }
+}
+
+static bool CloudProv_ImportIssuedKey(const CloudProvCborView_t *privateKey, uint8_t *keyBuffer)
+{
+    CK_OBJECT_HANDLE pkHandle = CK_INVALID_HANDLE;
+    bool status;
+
+    /* Keep room for the terminating null character expected by the PEM parser */
+    status = (privateKey->length < CLOUD_PROV_PAYLOAD_BUFFER_SIZE);
+    if(status == true)
+    {
+        memcpy(keyBuffer, privateKey->pData, privateKey->length);
+        keyBuffer[privateKey->length] = '\0';
+
+        /* The claim credentials were only needed for the TLS handshake, which is done. Current corePKCS11
+         * integration has room for a single key and certificate, thus destroy them before importing */
+        status = (xDestroyDefaultCryptoObjects(CloudProvP11Session) == CKR_OK);
+    }
+    if(status == true)
+    {
+        status = (xProvisionPrivateKey(CloudProvP11Session,
+                                       keyBuffer,
+                                       privateKey->length + 1u,
+                                       (uint8_t *)pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS,
+                                       &pkHandle) == CKR_OK);
+    }
+    if(status != true)
+    {
+        APP_ERR_PRINT("Failed to store the issued private key into corePKCS11\r\n");
+    }
+    memset((void *)privateKey->pData, 0x00, privateKey->length);
+    memset(keyBuffer, 0x00, CLOUD_PROV_PAYLOAD_BUFFER_SIZE);
+
+    return status;
+}
+
+static bool CloudProv_CommitDeviceCredentials(const uint8_t *certBuffer, size_t certLength)
+{
+    bool status;
+
+    if(CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS)
+    {
+        /* The key pair made by AWS IoT replaced the claim credentials when it was received */
+        status = true;
+    }
+    else
+    {
+        /* Current corePKCS11 integration does not allow for new certificate and private key, thus
+         * destroy claim credentials to free their spot in corePKCS's memory integration (littleFS). If committing
+         * fails, the next provisioning attempt imports the claim credentials again */
+        status = (xDestroyDefaultCryptoObjects(CloudProvP11Session) == CKR_OK);
+        if(status == true)
+        {
+            status = CloudProv_DeviceKeyCommit(CloudProvP11Session);
+        }
+    }
+
+    if(status == true)
+    {
+        status = CloudProv_LoadCertificate(CloudProvP11Session, certBuffer, certLength);
+    }
+    if(status == true)
+    {
+        strncpy(CloudProvJournal.thingName, CloudProvThingName, CLOUD_PROV_JOURNAL_THING_NAME_SIZE - 1u);
+        status = CloudProv_JournalAdvance(&CloudProvJournal, CLOUD_PROV_STAGE_REGISTERED);
+    }
+    else
+    {
+        APP_ERR_PRINT("Failed to store device credentials into corePKCS11\r\n");
+    }
+
+    return status;
+}
+
 
 /*************************************************************************************
  * global functions
@@ -788,14 +1241,55 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
     MQTTStatus_t mqttStatus = MQTTRecvFailed;
     bool connected = false;
     bool status = false;
-    uint8_t ownershipToken[ CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE ];
-    size_t ownershipTokenLength = CLOUD_PROV_OWNERSHIP_TOKEN_BUFFER_SIZE;
+    uint8_t *payloadBuffer = NULL;
+    size_t certLength = 0u;
+    CloudProvCborView_t ownershipToken = { NULL, 0u };
+    TickType_t startTick = xTaskGetTickCount();
+
+    CloudProv_ArenaReport("Before provisioning");
+
+    /* Provisioning buffers are borrowed from the arena instead of the CloudApp thread stack. Request payloads are
+     * streamed, the payload buffer only holds the CSR and the credentials being committed. Everything is given
+     * back once provisioning is done so telemetry can reuse the RAM */
+    if(CloudProv_ArenaBorrow(CLOUD_PROV_ARENA_PROVISIONING) != true)
+    {
+        return MQTTNoMemory;
+    }
+    payloadBuffer = CloudProv_ArenaAlloc(CLOUD_PROV_ARENA_PROVISIONING, CLOUD_PROV_PAYLOAD_BUFFER_SIZE);
 
+    if((CloudProvJournal.stage == CLOUD_PROV_STAGE_REGISTERED) ||
+       ((CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS) &&
+        (CloudProvJournal.stage != CLOUD_PROV_STAGE_NONE)))
+    {
+        /* Device credentials of a previous provisioning were refused, or an on-device key pair was left by a CSR
+         * provisioning that this mode does not use, start over */
+        CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_NONE);
+        if(CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS)
+        {
+            CloudProv_DiscardPendingKey(CloudProvP11Session);
+        }
+    }
 
-    xPkcs11Ret = xDestroyDefaultCryptoObjects(CloudProvP11Session );
+    if(payloadBuffer == NULL)
+    {
+        xPkcs11Ret = CKR_HOST_MEMORY;
+    }
+    else if((CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CSR) &&
+            (CloudProv_JournalDeviceKey() != true))
+    {
+        xPkcs11Ret = CKR_FUNCTION_FAILED;
+    }
+    else
+    {
+        if(CloudProvJournal.stage == CLOUD_PROV_STAGE_CERT_ISSUED)
+        {
+            certLength = CloudProv_ResumeIssuedCertificate(payloadBuffer, &ownershipToken);
+        }
+        xPkcs11Ret = xDestroyDefaultCryptoObjects(CloudProvP11Session );
+    }
     if(xPkcs11Ret != CKR_OK)
     {
-        APP_ERR_PRINT( ( "Failed to Destroy corePKCS11 Crypto Objects.\r\n" ) );
+        APP_ERR_PRINT( "Failed to Destroy corePKCS11 Crypto Objects.\r\n" );
     }
 
     if( xPkcs11Ret == CKR_OK )
@@ -803,12 +1297,12 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
         /* Provision Claim Private Key */
         xPkcs11Ret = xProvisionPrivateKey(CloudProvP11Session,
                                           (unsigned char *) CloudProvClaimPrivateKey,
-                                          strlen(CloudProvClaimPrivateKey) + 1,
+                                          CloudProvClaimPrivateKeyLength + 1,
                                           ( uint8_t * ) pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS,
                                           &pkHandle );
         if(xPkcs11Ret != CKR_OK)
         {
-            APP_WARN_PRINT( ( "Failed to import claim private key to corePKCS11.\r\n" ) );
+            APP_WARN_PRINT( "Failed to import claim private key to corePKCS11.\r\n" );
         }
     }
 
@@ -817,12 +1311,12 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
         /* Provision Claim Certificate */
         xPkcs11Ret = xProvisionCertificate(CloudProvP11Session,
                                            (unsigned char *) CloudProvClaimCert,
-                                            1 + strlen(CloudProvClaimCert),
+                                            1 + CloudProvClaimCertLength,
                                            ( uint8_t * ) pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS,
                                            &certHandle );
         if(xPkcs11Ret != CKR_OK)
         {
-            APP_WARN_PRINT( ( "Failed to import claim certificate to corePKCS11.\r\n" ) );
+            APP_WARN_PRINT( "Failed to import claim certificate to corePKCS11.\r\n" );
         }
     }
 
@@ -830,8 +1324,8 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
     if( xPkcs11Ret == CKR_OK )
     {
         /* Try to connect to MQTT broker with claim credentials */
-        APP_INFO_PRINT( ( "Trying to connect to MQTT broker with claim credentials to provision Cloud Kit...\r\n" ) );
-        mqttStatus = CloudProv_ConnectMQTT(mqttContext, CloudProv_MqttCallback);
+        APP_INFO_PRINT( "Trying to connect to MQTT broker with claim credentials to provision Cloud Kit...\r\n" );
+        mqttStatus = CloudProv_ConnectMQTT(mqttContext, CloudProv_MqttCallback, false);
     }
 
     if(mqttStatus == MQTTSuccess)
@@ -841,15 +1335,45 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
         mqttStatus = CloudProv_ManageFleetProvTopics(mqttContext, CloudProv_Subscribe);
     }
 
-    if(mqttStatus == MQTTSuccess)
+    if((mqttStatus == MQTTSuccess) && (certLength != 0u))
+    {
+        /* Certificate was issued before provisioning got interrupted, only registration is left */
+        APP_INFO_PRINT("Resuming provisioning with certificate %s\r\n", CloudProvJournal.certificateId);
+        status = true;
+    }
+    else if((mqttStatus == MQTTSuccess) &&
+            (CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS))
+    {
+        /* Request a key pair and its certificate from AWS IoT and store them */
+        status = CloudProv_RequestKeysAndCertificate(mqttContext, payloadBuffer, &ownershipToken, &certLength);
+    }
+    else if(mqttStatus == MQTTSuccess)
     {
         /* Request a certificate from AWS IoT and store it  */
-        status = CloudProv_RequestCertificate(mqttContext, ownershipToken, &ownershipTokenLength);
+        status = CloudProv_RequestCertificate(mqttContext, payloadBuffer, &ownershipToken, &certLength);
+    }
+    else
+    {
+        /* Not connected */
+    }
+
+    if((status == true) && (CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CSR))
+    {
+        /* A key pair made by AWS IoT cannot be resumed, it already replaced the claim key in corePKCS11 */
+        CloudProv_JournalIssuedCertificate(payloadBuffer, certLength, &ownershipToken);
     }
 
     if(status == true)
     {
-        mqttStatus = CloudProv_RegisterDevice(mqttContext,ownershipToken,ownershipTokenLength);
+        /* If interrupted, the next attempt resumes at RegisterThing. With CreateKeysAndCertificate, it starts
+         * over with a new key pair */
+        mqttStatus = CloudProv_RegisterDevice(mqttContext, &ownershipToken);
+        if((mqttStatus == MQTTServerRefused) && (CloudProvJournal.stage == CLOUD_PROV_STAGE_CERT_ISSUED))
+        {
+            /* Ownership tokens expire, the next attempt requests a new certificate for the same key pair */
+            APP_WARN_PRINT("Certificate %s refused by RegisterThing\r\n", CloudProvJournal.certificateId);
+            CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_KEY_GENERATED);
+        }
     }
 
     if((status == true) && (mqttStatus == MQTTSuccess))
@@ -866,10 +1390,29 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
     /* Close TLS connection.  */
     TLS_FreeRTOS_Disconnect( &CloudProvNetworkContext );
 
+    if((status == true) && (mqttStatus == MQTTSuccess))
+    {
+        /* Thing is registered, claim credentials are not needed anymore */
+        status = CloudProv_CommitDeviceCredentials(payloadBuffer, certLength);
+    }
+
+    /* Provisioning buffers are not needed anymore, give the arena back */
+    CloudProv_ArenaRelease(CLOUD_PROV_ARENA_PROVISIONING);
+    CloudProv_ArenaReport("After provisioning");
+
+    if((status == true) && (mqttStatus == MQTTSuccess))
+    {
+        /* Time from claim credentials import to device credentials commit, to compare provisioning modes */
+        APP_INFO_PRINT("Provisioned with %s in %d ms\r\n",
+                       (CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS) ?
+                       "CreateKeysAndCertificate" : "CreateCertificateFromCsr",
+                       (xTaskGetTickCount() - startTick) * portTICK_PERIOD_MS);
+    }
+
     if((status == true) && (mqttStatus == MQTTSuccess))
     {
         /* Reconnect with new generated device credentials */
-        mqttStatus = CloudProv_ConnectMQTT(mqttContext, mqttCallback);
+        mqttStatus = CloudProv_ConnectMQTT(mqttContext, mqttCallback, true);
 
         /* Try to read incoming packets for come seconds, in case the TLS connection is cut by the client
          * in case of bad chain of certificate */
@@ -882,16 +1425,16 @@ MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCall
         }
         if(mqttStatus == MQTTRecvFailed)
         {
-            APP_WARN_PRINT( ( "There is a strong possibility that the certificate chain is invalid. "\
+            APP_WARN_PRINT( "There is a strong possibility that the certificate chain is invalid. "\
                                     "Make sure the claim certificate + claim private key + root CA are correctly "\
-                                  "associated to a provision template on AWS IoT.\r\n"),
+                                  "associated to a provision template on AWS IoT.\r\n",
                             MQTT_Status_strerror(mqttStatus) );
         }
     }
 
     if((status != true) || (mqttStatus != MQTTSuccess))
     {
-        APP_ERR_PRINT(("Could not Provision device on AWS IoT Server. \r\n"));
+        APP_ERR_PRINT("Could not Provision device on AWS IoT Server. \r\n");
         mqttStatus = MQTTServerRefused;
     }
 
@@ -904,136 +1447,257 @@ MQTTStatus_t CloudProv_Init(MQTTContext_t * mqttContext, MQTTEventCallback_t app
     MQTTStatus_t mqttStatus = MQTTBadParameter;
     fsp_err_t fspError = FSP_ERR_ASSERTION;
     CK_RV   pkcs11status = CKR_GENERAL_ERROR;
-    uint32_t ipAddress = 0u;
+    bool deviceCredentialsTried = false;
 
     /* Set MQTT context in known state */
     memset(mqttContext, 0x00, sizeof(MQTTContext_t ));
 
-    /* Initialize littleFS to store crypto secrets with corePKCS11 */
-    lfsStatus = CloudProv_InitLittleFs();
-
-    if(lfsStatus == LFS_ERR_OK)
+    if(CloudProvPlatformReady == true)
     {
-        /* Initialize the PKCS #11 module */
-        mbedtls_platform_setup(NULL);
-        pkcs11status = xInitializePkcs11Session( &CloudProvP11Session );
+        /* Started again from the boot menu, storage, PKCS #11 and network are up already */
+        pkcs11status = CKR_OK;
+        if(CloudProv_BootAborted() == false)
+        {
+            CloudProv_LoadBootState();
+        }
     }
-
-    if(pkcs11status == CKR_OK)
+    else
     {
-        /* Initialize FreeRTOS's IP network stack */
-        CloudProv_InitIPStack();
-        /* Get the IP address for the MQTT END POINT used for the application */
-        ipAddress = FreeRTOS_gethostbyname((char*)CloudProvMqttEndpoint);
+        /* Initialize littleFS to store crypto secrets with corePKCS11 */
+        lfsStatus = CloudProv_InitLittleFs();
     }
 
-    if(0u == ipAddress)
+    if(lfsStatus == LFS_ERR_OK)
     {
-        FAILURE_INDICATION;
-        APP_WARN_PRINT("FreeRTOS_gethostbyname() Failed to get IP address from End point address for %s\r\n\r\n",
-                      CloudProvMqttEndpoint);
-        while(1)
+        /* Initialize the PKCS #11 module */
+        CloudProv_CryptoPlatformSetup();
+        pkcs11status = xInitializePkcs11Session( &CloudProvP11Session );
+        if(pkcs11status == CKR_OK)
         {
-            APP_WARN_PRINT("MQTT Broker endpoint is not reachable"
-                           "\r\nPlease reset Cloud Kit [ORANGE]while spamming BACKSPACE KEY[YELLOW] "
-                           "to open MENU and try new MQTT Broker endpoint\r\n\r\n");
-            vTaskDelay(10000);
+            if(CloudProv_BootAborted() == false)
+            {
+                /* Before the network wait, so that the key pair pre-generation overlaps it */
+                CloudProv_LoadBootState();
+            }
+            /* Initialize FreeRTOS's IP network stack */
+            CloudProv_InitIPStack();
+            CloudProvPlatformReady = true;
         }
     }
-    else
+
+    /* The boot menu may have been opened while waiting for the network link, it then owns the flash */
+    if((pkcs11status == CKR_OK) && (CloudProv_BootAborted() == false))
     {
-        /* Convert the IP address to a string to print on to the console. */
-        FreeRTOS_inet_ntoa(ipAddress, ( char * ) cBuffer);
-        APP_PRINT("\r\nDNS Lookup for \"%s\" is      : %s  \r\n", CloudProvMqttEndpoint, cBuffer);
+        /* The key pair pre-generation writes littleFS, which is not thread safe, and uses the SCE through the
+         * CTR-DRBG as TLS does. Nothing below runs until it is done */
+        CloudProv_DeviceKeyWait();
 
-        if(CLoudProvForceProvisioning == false)
+        if(CLoudProvForceProvisioning == true)
+        {
+            /* Force Provisioning of device, thus do not attempt to connect MQTT with credentials
+             * stored in corePKCS11, and drop whatever a previous provisioning left. */
+            CloudProv_JournalRewind(&CloudProvJournal, CLOUD_PROV_STAGE_NONE);
+            mqttStatus = MQTTBadParameter;
+        }
+        else if((CloudProvJournal.stage == CLOUD_PROV_STAGE_KEY_GENERATED) ||
+                (CloudProvJournal.stage == CLOUD_PROV_STAGE_CERT_ISSUED))
+        {
+            /* Provisioning was interrupted, corePKCS11 holds the claim credentials or, once the certificate was
+             * journaled, no credentials at all. Resume provisioning rather than trying them as device credentials */
+            mqttStatus = MQTTBadParameter;
+        }
+        else
         {
             /* Assume the device is provisioned already and try to connect to MQTT with MQTT Broker
              * endpoint + Device credentials stored in corePKCS11. If connection fails, because credentials
              * are bad for example, the fault status is returned and caller is responsible to call
              * CloudProv_ProvisionDevice to try again nwith new credentials */
-            APP_INFO_PRINT( ( "Assuming Cloud Kit is already provisioned, trying to connect to "
-                              "MQTT broker with device credentials... \r\n") );
-            mqttStatus = CloudProv_ConnectMQTT(mqttContext, appMqttCallback);
+            if(CloudProvJournal.stage == CLOUD_PROV_STAGE_REGISTERED)
+            {
+                APP_INFO_PRINT("Cloud Kit provisioned as %s, trying to connect to MQTT broker with device "
+                               "credentials... \r\n", CloudProvJournal.thingName);
+            }
+            else
+            {
+                APP_INFO_PRINT( "Assuming Cloud Kit is already provisioned, trying to connect to "
+                                  "MQTT broker with device credentials... \r\n" );
+            }
+            deviceCredentialsTried = true;
+            mqttStatus = CloudProv_ConnectMQTT(mqttContext, appMqttCallback, true);
+            if(mqttStatus == MQTTSuccess)
+            {
+                /* Device credentials are good, the key pair generated for provisioning is not needed */
+                CloudProv_DiscardPendingKey(CloudProvP11Session);
+                if(CloudProvJournal.stage == CLOUD_PROV_STAGE_NONE)
+                {
+                    /* Provisioned before the journal existed, record it so next boots know */
+                    (void)CloudProv_JournalAdvance(&CloudProvJournal, CLOUD_PROV_STAGE_REGISTERED);
+                }
+            }
         }
-        else
+
+        if((mqttStatus != MQTTSuccess) && (deviceCredentialsTried == true) &&
+           (CloudProv_EndpointReachable() == false) && (CloudProv_BootAborted() == false))
         {
-            /* Force Provisioning of device, thus do not attempt to connect MQTT with credentials
-             * stored in corePKCS11. */
-            mqttStatus = MQTTBadParameter;
+            /* No endpoint answered, device credentials were not even tried. Provisioning would destroy them for
+             * nothing, thus give up until the network or the broker comes back */
+            FAILURE_INDICATION;
+            APP_WARN_PRINT("MQTT Broker endpoint is not reachable"
+                           "\r\nPlease reset Cloud Kit " CONSOLE_ORANGE "while spamming BACKSPACE KEY" CONSOLE_YELLOW
+                           " to open MENU and try new MQTT Broker endpoint\r\n\r\n");
+            mqttStatus = MQTTSendFailed;
         }
-
-        if(mqttStatus != MQTTSuccess)
+        else if((mqttStatus != MQTTSuccess) && (CloudProv_BootAwaitDecision() == true))
         {
             /* Connection to MQTT was unsuccessful. This might be caused by the certificate chain being invalid,
-             * Thus, try to provision device via fleet provisioning */
+             * Thus, try to provision device via fleet provisioning. Provisioning rewrites credentials, so it only
+             * starts once the console confirmed the boot menu is not opened */
             mqttStatus = CloudProv_ProvisionDevice(mqttContext, appMqttCallback);
             if(mqttStatus != MQTTSuccess)
             {
                 APP_WARN_PRINT("CloudApp could not authenticate with given claim credentials."
-                               "\r\nPlease reset Cloud Kit [ORANGE]while spamming BACKSPACE KEY[YELLOW] "
-                               "to open MENU and try new credentials\r\n\r\n");
+                               "\r\nPlease reset Cloud Kit "
+                               CONSOLE_ORANGE "while spamming BACKSPACE KEY" CONSOLE_YELLOW
+                               " to open MENU and try new credentials\r\n\r\n");
             }
         }
+        else
+        {
+            /* Connected with device credentials, or boot menu opened */
+        }
+    }
+
+    /* Everything above ran speculatively while the boot menu could still be opened */
+    if(CloudProv_BootAwaitDecision() == false)
+    {
+        if(mqttStatus == MQTTSuccess)
+        {
+            (void)MQTT_Disconnect(mqttContext);
+            TLS_FreeRTOS_Disconnect(&CloudProvNetworkContext);
+        }
+        APP_INFO_PRINT("Boot menu opened, MQTT broker connection closed\r\n");
+        mqttStatus = MQTTIllegalState;
+
+        /* Wait for the menu to start the application again */
+        (void)xEventGroupSetBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_STOPPED_BIT);
+        (void)xEventGroupClearBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_ABORTED_BIT);
     }
 
     return mqttStatus;
 }
 
+void CloudProv_BootDecide(bool startApplication)
+{
+    if(startApplication == true)
+    {
+        (void)xEventGroupClearBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_STOPPED_BIT);
+        (void)xEventGroupSetBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_CONFIRMED_BIT);
+    }
+    else
+    {
+        (void)xEventGroupClearBits(CloudProv_BootEvents(),
+                                   CLOUD_PROV_BOOT_CONFIRMED_BIT | CLOUD_PROV_BOOT_STOPPED_BIT);
+        (void)xEventGroupSetBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_ABORTED_BIT);
+    }
+}
+
+bool CloudProv_BootAborted(void)
+{
+    return ((xEventGroupGetBits(CloudProv_BootEvents()) & CLOUD_PROV_BOOT_ABORTED_BIT) != 0u);
+}
+
+void CloudProv_BootIdle(void)
+{
+    if(CloudProv_BootAborted() == true)
+    {
+        /* Every flash or network access checks CloudProv_BootAborted first, the menu can go on once a key pair
+         * pre-generation, that may be writing littleFS, is done */
+        CloudProv_DeviceKeyWait();
+        (void)xEventGroupSetBits(CloudProv_BootEvents(), CLOUD_PROV_BOOT_STOPPED_BIT);
+    }
+}
+
+bool CloudProv_BootAwaitStopped(uint32_t timeoutMs)
+{
+    EventBits_t bootBits = xEventGroupWaitBits(CloudProv_BootEvents(),
+                                               CLOUD_PROV_BOOT_STOPPED_BIT,
+                                               pdFALSE,
+                                               pdTRUE,
+                                               pdMS_TO_TICKS(timeoutMs));
+
+    return ((bootBits & CLOUD_PROV_BOOT_STOPPED_BIT) != 0u);
+}
+
+MQTTStatus_t CloudProv_Restart(MQTTContext_t * mqttContext, MQTTEventCallback_t appMqttCallback)
+{
+    /* Wait for the boot menu to start the application */
+    (void)CloudProv_BootAwaitDecision();
+    return CloudProv_Init(mqttContext, appMqttCallback);
+}
+
 uint8_t CloudProv_ImportMqttEndpoint(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning)
 {
     uint8_t status = 0u;
 
-    if(endpointLength < CLOUD_PROV_MQTT_ENDPOINT_BUFFER_SIZE)
+    /* The buffer may hold several endpoints separated by CLOUD_PROV_ENDPOINT_SEPARATOR */
+    if(CloudProv_EndpointSetList((const char *)endpointBuffer, endpointLength) != 0u)
     {
-        memset(CloudProvMqttEndpoint, 0, strlen (CloudProvMqttEndpoint));
-        memcpy((void*)CloudProvMqttEndpoint, (void *)endpointBuffer, endpointLength);
         CLoudProvForceProvisioning = forceProvisioning;
     }
     else
     {
-        APP_ERR_PRINT("\r\nCannot import MQTT Broker Endpoint into CloudProv module, buffer insufficient");
         status = 1u;
     }
     return status;
 }
 
+bool CloudProv_SessionPresent(void)
+{
+    return CloudProvSessionPresent;
+}
+
 void CloudProv_ForceProvisioning(void)
 {
     CLoudProvForceProvisioning = true;
 }
 
-uint8_t CloudProv_ImportClaimCertificate(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning)
+uint8_t CloudProv_ImportClaimCertificate(uint8_t *endpointBuffer, size_t endpointLength, size_t bufferSize,
+                                         bool forceProvisioning)
 {
     uint8_t status = 0u;
 
-    if(endpointLength < CLOUD_PROV_CLAIM_CERT_BUFFER_SIZE)
+    /* The buffer is referenced, not copied, thus it must stay valid and be null terminated since corePKCS11
+     * parses the PEM including its terminating null char, which must lie within the buffer */
+    if((endpointLength < bufferSize) && (endpointBuffer[endpointLength] == '\0'))
     {
-        memset(CloudProvClaimCert, 0, strlen (CloudProvClaimCert));
-        memcpy((void*)CloudProvClaimCert, (void *)endpointBuffer, endpointLength);
+        CloudProvClaimCert = (const char *)endpointBuffer;
+        CloudProvClaimCertLength = endpointLength;
         CLoudProvForceProvisioning = forceProvisioning;
     }
     else
     {
-        APP_ERR_PRINT("\r\nCannot import Claim Certificate into CloudProv module, buffer insufficient");
+        APP_ERR_PRINT("\r\nCannot import Claim Certificate into CloudProv module, certificate not null terminated");
         status = 1u;
     }
     return status;
 }
 
-uint8_t CloudProv_ImportClaimPrivateKey(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning)
+uint8_t CloudProv_ImportClaimPrivateKey(uint8_t *endpointBuffer, size_t endpointLength, size_t bufferSize,
+                                        bool forceProvisioning)
 {
     uint8_t status = 0u;
 
-    if(endpointLength <  CLOUD_PROV_CLAIM_PRIVATE_KEY_BUFFER_SIZE)
+    /* The buffer is referenced, not copied, thus it must stay valid and be null terminated since corePKCS11
+     * parses the PEM including its terminating null char, which must lie within the buffer */
+    if((endpointLength < bufferSize) && (endpointBuffer[endpointLength] == '\0'))
     {
-        memset(CloudProvClaimPrivateKey, 0, strlen (CloudProvClaimPrivateKey));
-        memcpy((void*)CloudProvClaimPrivateKey, (void *)endpointBuffer, endpointLength);
+        CloudProvClaimPrivateKey = (const char *)endpointBuffer;
+        CloudProvClaimPrivateKeyLength = endpointLength;
         CLoudProvForceProvisioning = forceProvisioning;
     }
     else
     {
-        APP_ERR_PRINT("\r\nCannot import Claim Private Key into CloudProv module, buffer insufficient");
+        APP_ERR_PRINT("\r\nCannot import Claim Private Key into CloudProv module, private key not null terminated");
         status = 1u;
     }
     return status;
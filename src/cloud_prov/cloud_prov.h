@@ -9,10 +9,51 @@
 
 MQTTStatus_t CloudProv_ProvisionDevice(MQTTContext_t *mqttContext, MQTTEventCallback_t mqttCallback);
 uint8_t CloudProv_ImportMqttEndpoint(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning);
-uint8_t CloudProv_ImportClaimCertificate(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning);
-uint8_t CloudProv_ImportClaimPrivateKey(uint8_t *endpointBuffer, size_t endpointLength, bool forceProvisioning);
+uint8_t CloudProv_ImportClaimCertificate(uint8_t *endpointBuffer, size_t endpointLength, size_t bufferSize,
+                                         bool forceProvisioning);
+uint8_t CloudProv_ImportClaimPrivateKey(uint8_t *endpointBuffer, size_t endpointLength, size_t bufferSize,
+                                        bool forceProvisioning);
 void CloudProv_InitIPStack(void);
+
+/**
+ * @brief Connect to the MQTT broker, provisioning the device first if needed.
+ * @details The connection starts while the console boot menu can still be opened. Provisioning and the return to
+ *          the caller wait for CloudProv_BootDecide. If the menu is opened, the connection is closed and
+ *          MQTTIllegalState is returned, the caller then calls CloudProv_Restart.
+ */
 MQTTStatus_t CloudProv_Init(MQTTContext_t * mqttContext, MQTTEventCallback_t appMqttCallback);
+
+/**
+ * @brief Wait for the boot menu to start the application, then run CloudProv_Init again.
+ */
+MQTTStatus_t CloudProv_Restart(MQTTContext_t * mqttContext, MQTTEventCallback_t appMqttCallback);
+
+/**
+ * @brief Boot decision from the console: go on with the connection started at boot (true), or close it because
+ *        the boot menu is opened (false).
+ */
+void CloudProv_BootDecide(bool startApplication);
+
+/**
+ * @brief Wait until the connection aborted by CloudProv_BootDecide(false) is closed. Once stopped, the cloud thread
+ *        does not touch littleFS or the network until the application is started again.
+ * @param[in] timeoutMs Max wait, connection attempts in progress are not interrupted.
+ * @return true if stopped, false if the cloud thread is still busy.
+ */
+bool CloudProv_BootAwaitStopped(uint32_t timeoutMs);
+
+/**
+ * @brief Tell if the boot menu asked the cloud thread to stop. Connections and littleFS writes are skipped until the
+ *        cloud thread is stopped.
+ */
+bool CloudProv_BootAborted(void);
+
+/**
+ * @brief Called by the cloud thread while it waits on something else than flash or network, so that the boot menu
+ *        does not wait for it to be stopped.
+ */
+void CloudProv_BootIdle(void);
 void CloudProv_ForceProvisioning(void);
+bool CloudProv_SessionPresent(void);
 
 #endif //CLOUD_PROV_H
@@ -0,0 +1,116 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_arena.h>
+#include <console.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Alignment of every block returned by the arena. Matches the strictest alignment needed by
+ *        the buffers handed to mbedTLS and tinycbor.
+ */
+#define CLOUD_PROV_ARENA_ALIGNMENT      (8u)
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief RAM shared by the application phases. Provisioning borrows it first, telemetry reuses it afterwards */
+static uint8_t CloudProvArena[CLOUD_PROV_ARENA_SIZE] __attribute__((aligned(CLOUD_PROV_ARENA_ALIGNMENT)));
+
+/** @brief Phase currently owning the arena */
+static CloudProvArenaPhase_t CloudProvArenaOwner = CLOUD_PROV_ARENA_FREE;
+
+/** @brief Offset of the next free byte in the arena */
+static size_t CloudProvArenaOffset = 0u;
+
+/** @brief Highest offset reached since the arena was last borrowed */
+static size_t CloudProvArenaPeak = 0u;
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+bool CloudProv_ArenaBorrow(CloudProvArenaPhase_t phase)
+{
+    bool status = false;
+
+    taskENTER_CRITICAL();
+    if((CloudProvArenaOwner == CLOUD_PROV_ARENA_FREE) && (phase != CLOUD_PROV_ARENA_FREE))
+    {
+        CloudProvArenaOwner = phase;
+        CloudProvArenaOffset = 0u;
+        CloudProvArenaPeak = 0u;
+        status = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if(status != true)
+    {
+        APP_ERR_PRINT("Arena requested by phase %d but still owned by phase %d\r\n", phase, CloudProvArenaOwner);
+    }
+
+    return status;
+}
+
+void * CloudProv_ArenaAlloc(CloudProvArenaPhase_t phase, size_t size)
+{
+    void *block = NULL;
+    size_t alignedSize = (size + (CLOUD_PROV_ARENA_ALIGNMENT - 1u)) & ~(size_t)(CLOUD_PROV_ARENA_ALIGNMENT - 1u);
+
+    if(phase != CloudProvArenaOwner)
+    {
+        APP_ERR_PRINT("Arena not owned by phase %d\r\n", phase);
+    }
+    else if(alignedSize > (CLOUD_PROV_ARENA_SIZE - CloudProvArenaOffset))
+    {
+        APP_ERR_PRINT("Arena exhausted, %u bytes requested, %u bytes left\r\n",
+                      (unsigned int)size, (unsigned int)(CLOUD_PROV_ARENA_SIZE - CloudProvArenaOffset));
+    }
+    else
+    {
+        block = &CloudProvArena[CloudProvArenaOffset];
+        memset(block, 0x00, alignedSize);
+        CloudProvArenaOffset += alignedSize;
+        if(CloudProvArenaOffset > CloudProvArenaPeak)
+        {
+            CloudProvArenaPeak = CloudProvArenaOffset;
+        }
+    }
+
+    return block;
+}
+
+void CloudProv_ArenaRelease(CloudProvArenaPhase_t phase)
+{
+    if(phase == CloudProvArenaOwner)
+    {
+        /* Scrub what was left by the phase, since provisioning stores credentials like the issued certificate
+         * in the arena */
+        memset(CloudProvArena, 0x00, CloudProvArenaPeak);
+        CloudProvArenaOffset = 0u;
+        CloudProvArenaOwner = CLOUD_PROV_ARENA_FREE;
+    }
+    else
+    {
+        APP_ERR_PRINT("Arena released by phase %d but owned by phase %d\r\n", phase, CloudProvArenaOwner);
+    }
+}
+
+void CloudProv_ArenaReport(const char *label)
+{
+    APP_INFO_PRINT("%s: arena peak %u/%u bytes, task stack high water mark %u words\r\n",
+                   label,
+                   (unsigned int)CloudProvArenaPeak,
+                   (unsigned int)CLOUD_PROV_ARENA_SIZE,
+                   (unsigned int)uxTaskGetStackHighWaterMark(NULL));
+}
@@ -0,0 +1,73 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_ARENA_H
+#define CLOUD_PROV_ARENA_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Size of the RAM arena shared by the application phases.
+ * @details Sized for the provisioning phase payload buffer, which holds the CSR or the issued private key, then the
+ *          issued DER certificate until it is committed. Request payloads are streamed to the transport and the
+ *          ownership token of the response is used in place in the MQTT buffer, or read back from the journal into
+ *          the second half of the payload buffer when provisioning resumes at RegisterThing.
+ */
+#define CLOUD_PROV_ARENA_SIZE           (2048u)
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+
+/**
+ * @brief Application phases that can borrow the arena. Only one phase can own the arena at a time.
+ */
+typedef enum
+{
+    CLOUD_PROV_ARENA_FREE =         (uint8_t)0u,
+    CLOUD_PROV_ARENA_PROVISIONING = (uint8_t)1u,
+    CLOUD_PROV_ARENA_TELEMETRY =    (uint8_t)2u,
+}CloudProvArenaPhase_t;
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Borrow the arena for an application phase.
+ * @param[in] phase Phase that will own the arena until #CloudProv_ArenaRelease is called.
+ * @return true if the arena is now owned by phase, false if another phase still owns it.
+ */
+bool CloudProv_ArenaBorrow(CloudProvArenaPhase_t phase);
+
+/**
+ * @brief Allocate a block in the arena. Blocks are only freed all at once by #CloudProv_ArenaRelease.
+ * @param[in] phase Phase requesting the block, must be the current arena owner.
+ * @param[in] size Number of bytes requested.
+ * @return Pointer to a zeroed, word aligned block, or NULL if the arena is not owned by phase or is full.
+ */
+void * CloudProv_ArenaAlloc(CloudProvArenaPhase_t phase, size_t size);
+
+/**
+ * @brief Release every block allocated by phase and give the arena back.
+ * @param[in] phase Phase releasing the arena, must be the current arena owner.
+ */
+void CloudProv_ArenaRelease(CloudProvArenaPhase_t phase);
+
+/**
+ * @brief Print arena peak usage and the stack high water mark of the calling task on the console.
+ * @param[in] label Text printed in front of the report, typically the name of the phase that just ended.
+ */
+void CloudProv_ArenaReport(const char *label);
+
+#endif /* CLOUD_PROV_ARENA_H */
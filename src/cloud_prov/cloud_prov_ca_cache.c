@@ -0,0 +1,116 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_ca_cache.c
+ * @brief Root CA chain parsed once and shared by every TLS connection.
+ *
+ * @details The TLS transport receives the root CA as PEM and parses it into its own mbedtls_x509_crt on every
+ *          TLS_FreeRTOS_Connect, only to free it again on disconnect. mbedtls_x509_crt_parse and
+ *          mbedtls_ssl_conf_ca_chain are wrapped at link time (-Wl,--wrap) so that CloudProvRootCaPem is parsed the
+ *          first time only. Later connections skip the parse and have the cached chain configured instead of their
+ *          empty one. The wrap sees every certificate parse of the image: the client certificate of the transport
+ *          is handed to the credential cache of cloud_prov_pkcs11_cache.c, any other buffer is parsed by mbedTLS
+ *          unchanged. The cached chain is never freed, an SSL configuration still alive may point to it.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_config.h>
+#include <cloud_prov_ca_cache.h>
+#include <cloud_prov_pkcs11.h>
+#include <console.h>
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/ssl.h"
+
+/*************************************************************************************
+ * Global Variables
+ ************************************************************************************/
+const unsigned char CloudProvRootCaPem[] = CLOUD_PROV_DEV_ROOT_CA_PEM;
+const size_t CloudProvRootCaPemSize = sizeof(CloudProvRootCaPem);
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Root CA chain parsed from CloudProvRootCaPem, alive until reset */
+static mbedtls_x509_crt CloudProvCaCacheChain;
+
+/** @brief Set once CloudProvCaCacheChain holds the parsed root CA */
+static bool CloudProvCaCacheParsed = false;
+
+/** @brief Chain left empty by the last skipped parse, to be swapped for the cached chain when configured */
+static const mbedtls_x509_crt *CloudProvCaCacheSkippedChain = NULL;
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+int __real_mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen);
+void __real_mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config *conf,
+                                      mbedtls_x509_crt *ca_chain,
+                                      mbedtls_x509_crl *ca_crl);
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+int __wrap_mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen)
+{
+    int mbedtlsRet = 0;
+    size_t heapBefore;
+    TickType_t startTick;
+
+    if((buf != CloudProvRootCaPem) || (buflen != CloudProvRootCaPemSize) || (chain->version != 0))
+    {
+        /* Client certificate is parsed once by the credential cache, any other certificate is not cached */
+        if(CloudProv_CredentialCacheParseCert(chain, buf, buflen, &mbedtlsRet) == false)
+        {
+            mbedtlsRet = __real_mbedtls_x509_crt_parse(chain, buf, buflen);
+        }
+    }
+    else if(CloudProvCaCacheParsed == true)
+    {
+        /* Already parsed, the transport chain stays empty until mbedtls_ssl_conf_ca_chain */
+        CloudProvCaCacheSkippedChain = chain;
+    }
+    else
+    {
+        heapBefore = xPortGetFreeHeapSize();
+        startTick = xTaskGetTickCount();
+        mbedtls_x509_crt_init(&CloudProvCaCacheChain);
+        mbedtlsRet = __real_mbedtls_x509_crt_parse(&CloudProvCaCacheChain, buf, buflen);
+
+        if(mbedtlsRet == 0)
+        {
+            APP_INFO_PRINT("Root CA parsed in %u ms, %u bytes of heap kept for next connections\r\n",
+                           (unsigned int) ((xTaskGetTickCount() - startTick) * portTICK_PERIOD_MS),
+                           (unsigned int) (heapBefore - xPortGetFreeHeapSize()));
+            CloudProvCaCacheParsed = true;
+            CloudProvCaCacheSkippedChain = chain;
+        }
+        else
+        {
+            /* Never configured, nothing refers to it */
+            mbedtls_x509_crt_free(&CloudProvCaCacheChain);
+        }
+    }
+
+    return mbedtlsRet;
+}
+
+void __wrap_mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config *conf,
+                                      mbedtls_x509_crt *ca_chain,
+                                      mbedtls_x509_crl *ca_crl)
+{
+    if((ca_chain != NULL) && (ca_chain == CloudProvCaCacheSkippedChain))
+    {
+        /* The chain of the transport is empty, hand over the cached one. It is never freed by the transport */
+        ca_chain = &CloudProvCaCacheChain;
+        CloudProvCaCacheSkippedChain = NULL;
+    }
+    __real_mbedtls_ssl_conf_ca_chain(conf, ca_chain, ca_crl);
+}
@@ -0,0 +1,27 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_CA_CACHE_H
+#define CLOUD_PROV_CA_CACHE_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+
+/*************************************************************************************
+ * Global Variables
+ ************************************************************************************/
+
+/**
+ * @brief Root CA of the MQTT broker, CLOUD_PROV_DEV_ROOT_CA_PEM, given to the TLS transport.
+ * @details A single object so that cloud_prov_ca_cache.c recognises the root CA by its address: only parses of this
+ *          buffer are cached, every other certificate parse goes to mbedTLS unchanged.
+ */
+extern const unsigned char CloudProvRootCaPem[];
+
+/** @brief Size of CloudProvRootCaPem, terminating null included as mbedtls_x509_crt_parse expects for PEM */
+extern const size_t CloudProvRootCaPemSize;
+
+#endif //CLOUD_PROV_CA_CACHE_H
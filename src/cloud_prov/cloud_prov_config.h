@@ -105,6 +105,9 @@ extern void vLoggingPrintf( const char * pcFormatString,
  * @note Your AWS IoT Core endpoint can be found in the AWS IoT console under
  * Settings/Custom Endpoint, or using the describe-endpoint API.
  *
+ * @note Several endpoints (ATS endpoint, custom domain, other region) can be given in order of preference,
+ * separated by commas. The first one answering is used, see CloudProv_EndpointConnect.
+ *
  * #define CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT     "...insert here..."
  */
 #define CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT     "a28vtc6sjqvs1u-ats.iot.us-east-1.amazonaws.com"
@@ -156,12 +159,48 @@ extern void vLoggingPrintf( const char * pcFormatString,
  */
 #define CLOUD_PROV_MQTT_CONNACK_RECV_TIMEOUT_MS           ( 5000U )
 
+/**
+ * @brief Provisioning modes. CLOUD_PROV_PROVISIONING_MODE is set by the CLOUD_PROV_CREATE_KEYS CMake option.
+ * The CSR mode generates the device key pair on the kit and only sends a CSR signed with it. The create keys mode
+ * has AWS IoT generate the key pair with CreateKeysAndCertificate, saving the on-device key generation and CSR
+ * signature at the cost of a private key sent over the network.
+ */
+#define CLOUD_PROV_PROVISIONING_MODE_CSR          (0)
+#define CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS  (1)
+
+#ifndef CLOUD_PROV_PROVISIONING_MODE
+#define CLOUD_PROV_PROVISIONING_MODE      CLOUD_PROV_PROVISIONING_MODE_CSR
+#endif
+
 /**
  * @brief Size of the network buffer for MQTT packets. Must be large enough to
  * hold the GetCertificateFromCsr response, which, among other things, includes
- * a PEM encoded certificate.
+ * a PEM encoded certificate. The CreateKeysAndCertificate response also holds
+ * the PEM encoded RSA 2048 private key.
  */
+#if (CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CREATE_KEYS)
+#define CLOUD_PROV_MQTT_BUFFER_SIZE       ( 4096U)
+#else
 #define CLOUD_PROV_MQTT_BUFFER_SIZE       ( 2048U)
+#endif
+
+/**
+ * @brief TLS profiles. CLOUD_PROV_TLS_PROFILE is set by the CLOUD_PROV_TLS_LOW_MEMORY CMake option, since the
+ * low memory profile also changes the mbedTLS record buffer sizes, see cloud_prov_tls_profile.c.
+ */
+#define CLOUD_PROV_TLS_PROFILE_DEFAULT    (0)
+#define CLOUD_PROV_TLS_PROFILE_LOW_MEMORY (1)
+
+#ifndef CLOUD_PROV_TLS_PROFILE
+#define CLOUD_PROV_TLS_PROFILE            CLOUD_PROV_TLS_PROFILE_DEFAULT
+#endif
+
+/**
+ * @brief Max fragment length negotiated by the low memory TLS profile. 4096 is the largest value of the extension,
+ * and the smallest the broker handshake records fit in, since mbedTLS does not reassemble handshake messages
+ * split across records. Must match MBEDTLS_SSL_IN_CONTENT_LEN set by CMake.
+ */
+#define CLOUD_PROV_TLS_MAX_FRAG_LEN_CODE  MBEDTLS_SSL_MAX_FRAG_LEN_4096
 
 /**
  * @brief Server's root CA certificate.
@@ -250,6 +289,22 @@ extern void vLoggingPrintf( const char * pcFormatString,
         "-----END RSA PRIVATE KEY-----"*/
 
 //TODO remove when testing access to different IoT Core account
+#if (CLOUD_PROV_TLS_PROFILE == CLOUD_PROV_TLS_PROFILE_LOW_MEMORY)
+/* Amazon Root CA 3, ECC P-256: the low memory TLS profile only offers ECDHE-ECDSA cipher suites, thus the broker
+ * has to present its ECC certificate chain */
+#define CLOUD_PROV_DEV_ROOT_CA_PEM "-----BEGIN CERTIFICATE-----\n" \
+        "MIIBtjCCAVugAwIBAgITBmyf1XSXNmY/Owua2eiedgPySjAKBggqhkjOPQQDAjA5\n" \
+        "MQswCQYDVQQGEwJVUzEPMA0GA1UEChMGQW1hem9uMRkwFwYDVQQDExBBbWF6b24g\n" \
+        "Um9vdCBDQSAzMB4XDTE1MDUyNjAwMDAwMFoXDTQwMDUyNjAwMDAwMFowOTELMAkG\n" \
+        "A1UEBhMCVVMxDzANBgNVBAoTBkFtYXpvbjEZMBcGA1UEAxMQQW1hem9uIFJvb3Qg\n" \
+        "Q0EgMzBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABCmXp8ZBf8ANm+gBG1bG8lKl\n" \
+        "ui2yEujSLtf6ycXYqm0fc4E7O5hrOXwzpcVOho6AF2hiRVd9RFgdszflZwjrZt6j\n" \
+        "QjBAMA8GA1UdEwEB/wQFMAMBAf8wDgYDVR0PAQH/BAQDAgGGMB0GA1UdDgQWBBSr\n" \
+        "ttvXBp43rDCGB5Fwx5zEGbF4wDAKBggqhkjOPQQDAgNJADBGAiEA4IWSoxe3jfkr\n" \
+        "BqWTrBqYaGFy+uGh0PsceGCmQ5nFuMQCIQCcAu/xlJyzlvnrxir4tiz+OpAUFteM\n" \
+        "YyRIHN8wfdVoOw==\n" \
+        "-----END CERTIFICATE-----"
+#else
 #define CLOUD_PROV_DEV_ROOT_CA_PEM "-----BEGIN CERTIFICATE-----\n" \
         "MIIDQTCCAimgAwIBAgITBmyfz5m/jAo54vB4ikPmljZbyjANBgkqhkiG9w0BAQsF\n" \
         "ADA5MQswCQYDVQQGEwJVUzEPMA0GA1UEChMGQW1hem9uMRkwFwYDVQQDExBBbWF6\n" \
@@ -270,6 +325,7 @@ extern void vLoggingPrintf( const char * pcFormatString,
         "5MsI+yMRQ+hDKXJioaldXgjUkK642M4UwtBV8ob2xJNDd2ZhwLnoQdeXeGADbkpy\n" \
         "rqXRfboQnoZsG4q5WTP468SQvvG5\n" \
         "-----END CERTIFICATE-----"
+#endif
 
 #define CLOUD_PROV_DEFAULT_CLAIM_CERT_PEM 	    "-----BEGIN CERTIFICATE-----\n" \
         "MIIDWjCCAkKgAwIBAgIVAOv2VqoKkShI1NeLRSQM8DPb7pj1MA0GCSqGSIb3DQEB\n" \
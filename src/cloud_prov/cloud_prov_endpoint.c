@@ -0,0 +1,402 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_endpoint.h>
+#include <cloud_prov_config.h>
+#include <cloud_prov_storage.h>
+#include <console.h>
+#include <FreeRTOS_IP.h>
+#include <FreeRTOS_Sockets.h>
+#include <FreeRTOS_DNS.h>
+#include <ctype.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Delay between the start of two endpoint probes. The preferred endpoint gets this much time to answer
+ *        alone before the next endpoint is probed too.
+ */
+#define CLOUD_PROV_ENDPOINT_STAGGER_MS          (250u)
+
+/**
+ * @brief Max time given to a probe to resolve its endpoint and open a TCP connection with it.
+ */
+#define CLOUD_PROV_ENDPOINT_PROBE_TIMEOUT_MS    (3000u)
+
+/**
+ * @brief Stack size (in words) of a probe task. Only the DNS resolver and a TCP socket are used.
+ */
+#define CLOUD_PROV_ENDPOINT_PROBE_STACK_SIZE    (512u)
+
+/**
+ * @brief littleFS file in which the endpoint of the last successful connection is saved.
+ */
+#define CLOUD_PROV_ENDPOINT_LAST_GOOD_FILE      "cp_ep_last"
+
+/** @brief Event group bits set by a probe when its endpoint answered, and when the probe is done */
+#define CLOUD_PROV_ENDPOINT_ANSWERED_BIT(idx)   ((EventBits_t)1u << (idx))
+#define CLOUD_PROV_ENDPOINT_FINISHED_BIT(idx)   ((EventBits_t)1u << ((idx) + CLOUD_PROV_ENDPOINT_MAX_COUNT))
+#define CLOUD_PROV_ENDPOINT_ALL_BITS            (((EventBits_t)1u << (2u * CLOUD_PROV_ENDPOINT_MAX_COUNT)) - 1u)
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+
+/**
+ * @brief Parameters of a probe task. Allocated for each probe and freed by the probe itself, since a probe can
+ *        outlive the connection attempt that started it.
+ */
+typedef struct
+{
+    const char *endpoint;
+    uint8_t index;
+    uint32_t round;
+    TickType_t startDelay;
+}CloudProvEndpointProbe_t;
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Endpoint list. Separators are replaced by null chars so every endpoint can be used as is */
+static char CloudProvEndpointList[CLOUD_PROV_ENDPOINT_LIST_BUFFER_SIZE] = CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT;
+static const char *CloudProvEndpoints[CLOUD_PROV_ENDPOINT_MAX_COUNT] = { CloudProvEndpointList };
+static uint8_t CloudProvEndpointCount = 1u;
+
+/** @brief Endpoint indexes in order of preference, last good endpoint first */
+static uint8_t CloudProvEndpointOrder[CLOUD_PROV_ENDPOINT_MAX_COUNT] = { 0u };
+
+/** @brief Index of the endpoint used by the last connection */
+static uint8_t CloudProvEndpointCurrentIndex = 0u;
+static bool CloudProvEndpointAnswered = false;
+
+/** @brief Probe results. Probes of a previous connection attempt do not report anything once round changed */
+static EventGroupHandle_t CloudProvEndpointEvents = NULL;
+static volatile uint32_t CloudProvEndpointRound = 0u;
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+static void CloudProv_EndpointProbeTask(void *pvParameters);
+static bool CloudProv_EndpointStartProbe(uint8_t index, uint32_t round, TickType_t startDelay);
+
+/*************************************************************************************
+ * Local Functions
+ ************************************************************************************/
+
+/**
+ * @brief Resolve an endpoint and open then close a TCP connection with it. The answer also warms the DNS cache
+ *        of FreeRTOS+TCP, so the TLS connection that follows does not resolve the endpoint again.
+ */
+static void CloudProv_EndpointProbeTask(void *pvParameters)
+{
+    CloudProvEndpointProbe_t *probe = (CloudProvEndpointProbe_t *)pvParameters;
+    struct freertos_sockaddr brokerAddress = { 0 };
+    TickType_t socketTimeout = pdMS_TO_TICKS(CLOUD_PROV_ENDPOINT_PROBE_TIMEOUT_MS);
+    Socket_t probeSocket = FREERTOS_INVALID_SOCKET;
+    EventBits_t resultBits = CLOUD_PROV_ENDPOINT_FINISHED_BIT(probe->index);
+
+    vTaskDelay(probe->startDelay);
+
+    /* Connection may have succeeded with a preferred endpoint while waiting */
+    if(probe->round == CloudProvEndpointRound)
+    {
+        brokerAddress.sin_addr = FreeRTOS_gethostbyname(probe->endpoint);
+        brokerAddress.sin_port = FreeRTOS_htons(CLOUD_PROV_MQTT_BROKER_PORT);
+        brokerAddress.sin_family = FREERTOS_AF_INET;
+    }
+
+    if(brokerAddress.sin_addr != 0u)
+    {
+        probeSocket = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP);
+    }
+
+    if(probeSocket != FREERTOS_INVALID_SOCKET)
+    {
+        (void)FreeRTOS_setsockopt(probeSocket, 0, FREERTOS_SO_RCVTIMEO, &socketTimeout, sizeof(socketTimeout));
+        (void)FreeRTOS_setsockopt(probeSocket, 0, FREERTOS_SO_SNDTIMEO, &socketTimeout, sizeof(socketTimeout));
+        if(FreeRTOS_connect(probeSocket, &brokerAddress, sizeof(brokerAddress)) == 0)
+        {
+            resultBits |= CLOUD_PROV_ENDPOINT_ANSWERED_BIT(probe->index);
+        }
+        (void)FreeRTOS_closesocket(probeSocket);
+    }
+
+    /* Scheduler is suspended so that round cannot change between the check and the report */
+    vTaskSuspendAll();
+    if(probe->round == CloudProvEndpointRound)
+    {
+        (void)xEventGroupSetBits(CloudProvEndpointEvents, resultBits);
+    }
+    (void)xTaskResumeAll();
+
+    vPortFree(probe);
+    vTaskDelete(NULL);
+}
+
+static bool CloudProv_EndpointStartProbe(uint8_t index, uint32_t round, TickType_t startDelay)
+{
+    CloudProvEndpointProbe_t *probe = pvPortMalloc(sizeof(CloudProvEndpointProbe_t));
+    BaseType_t status = pdFAIL;
+
+    if(probe != NULL)
+    {
+        probe->endpoint = CloudProvEndpoints[index];
+        probe->index = index;
+        probe->round = round;
+        probe->startDelay = startDelay;
+        status = xTaskCreate(CloudProv_EndpointProbeTask,
+                             "CloudProvProbe",
+                             CLOUD_PROV_ENDPOINT_PROBE_STACK_SIZE,
+                             probe,
+                             uxTaskPriorityGet(NULL),
+                             NULL);
+        if(status != pdPASS)
+        {
+            vPortFree(probe);
+        }
+    }
+    return (status == pdPASS);
+}
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+uint8_t CloudProv_EndpointSetList(const char *endpointList, size_t length)
+{
+    uint8_t count = 0u;
+    char *endpoint;
+
+    if((length == 0u) || (length >= CLOUD_PROV_ENDPOINT_LIST_BUFFER_SIZE))
+    {
+        APP_ERR_PRINT("\r\nCannot import MQTT Broker Endpoint into CloudProv module, buffer insufficient");
+    }
+    else
+    {
+        memset(CloudProvEndpointList, 0, sizeof(CloudProvEndpointList));
+        memcpy(CloudProvEndpointList, endpointList, length);
+
+        /* Split list in place, trimming whitespace around every endpoint and skipping empty entries */
+        endpoint = CloudProvEndpointList;
+        while((endpoint != NULL) && (count < CLOUD_PROV_ENDPOINT_MAX_COUNT))
+        {
+            char *separator = strchr(endpoint, CLOUD_PROV_ENDPOINT_SEPARATOR);
+            char *endpointEnd;
+
+            if(separator != NULL)
+            {
+                *separator = '\0';
+            }
+            while(isspace((unsigned char)*endpoint) != 0)
+            {
+                endpoint++;
+            }
+            endpointEnd = endpoint + strlen(endpoint);
+            while((endpointEnd > endpoint) && (isspace((unsigned char)endpointEnd[-1]) != 0))
+            {
+                endpointEnd--;
+            }
+            *endpointEnd = '\0';
+
+            if((size_t)(endpointEnd - endpoint) > CLOUD_PROV_ENDPOINT_MAX_LENGTH)
+            {
+                APP_WARN_PRINT("MQTT Broker Endpoint %s longer than %u chars, skipped\r\n",
+                               endpoint, (unsigned int)CLOUD_PROV_ENDPOINT_MAX_LENGTH);
+            }
+            else if(endpointEnd != endpoint)
+            {
+                CloudProvEndpoints[count] = endpoint;
+                CloudProvEndpointOrder[count] = count;
+                count++;
+            }
+            endpoint = (separator != NULL) ? (separator + 1) : NULL;
+        }
+        CloudProvEndpointCount = count;
+        CloudProvEndpointCurrentIndex = 0u;
+
+        if(count == 0u)
+        {
+            /* Nothing usable, fall back on default endpoint */
+            (void)CloudProv_EndpointSetList(CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT,
+                                            sizeof(CLOUD_PROV_DEFAULT_MQTT_BROKER_ENDPOINT) - 1u);
+        }
+    }
+    return count;
+}
+
+void CloudProv_EndpointLoadLastGood(void)
+{
+    char lastGood[CLOUD_PROV_ENDPOINT_MAX_LENGTH + 1u] = { 0 };
+    size_t lastGoodLength = 0u;
+    uint8_t rank;
+
+    if(CloudProv_StorageRead(CLOUD_PROV_ENDPOINT_LAST_GOOD_FILE, lastGood, sizeof(lastGood) - 1u,
+                             &lastGoodLength) == LFS_ERR_OK)
+    {
+        for(rank = 0u; rank < CloudProvEndpointCount; rank++)
+        {
+            if(0 == strcmp(CloudProvEndpoints[CloudProvEndpointOrder[rank]], lastGood))
+            {
+                break;
+            }
+        }
+
+        /* Move last good endpoint in front, other endpoints keep their order */
+        if(rank < CloudProvEndpointCount)
+        {
+            uint8_t lastGoodIndex = CloudProvEndpointOrder[rank];
+
+            for(; rank > 0u; rank--)
+            {
+                CloudProvEndpointOrder[rank] = CloudProvEndpointOrder[rank - 1u];
+            }
+            CloudProvEndpointOrder[0u] = lastGoodIndex;
+            CloudProvEndpointCurrentIndex = lastGoodIndex;
+        }
+    }
+}
+
+TlsTransportStatus_t CloudProv_EndpointConnect(NetworkContext_t *networkContext,
+                                               NetworkCredentials_t *networkCredentials,
+                                               uint32_t sendRecvTimeoutMs)
+{
+    TlsTransportStatus_t connectionStatus = TLS_TRANSPORT_CONNECT_FAILURE;
+    EventBits_t finishedBits = 0u;
+    EventBits_t triedBits = 0u;
+    EventBits_t eventBits = 0u;
+    EventBits_t candidateBits;
+    uint32_t round;
+    uint32_t startMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint8_t rank;
+    uint8_t index;
+
+    if(CloudProvEndpointEvents == NULL)
+    {
+        CloudProvEndpointEvents = xEventGroupCreate();
+        if(CloudProvEndpointEvents == NULL)
+        {
+            return TLS_TRANSPORT_INSUFFICIENT_MEMORY;
+        }
+    }
+
+    /* New round, results of probes still running from a previous attempt are ignored */
+    vTaskSuspendAll();
+    round = ++CloudProvEndpointRound;
+    (void)xEventGroupClearBits(CloudProvEndpointEvents, CLOUD_PROV_ENDPOINT_ALL_BITS);
+    (void)xTaskResumeAll();
+    CloudProvEndpointAnswered = false;
+
+    if(CloudProvEndpointCount == 1u)
+    {
+        /* Nothing to race against, go straight to TLS */
+        finishedBits = CLOUD_PROV_ENDPOINT_FINISHED_BIT(0u);
+        (void)xEventGroupSetBits(CloudProvEndpointEvents,
+                                 CLOUD_PROV_ENDPOINT_FINISHED_BIT(0u) | CLOUD_PROV_ENDPOINT_ANSWERED_BIT(0u));
+    }
+    for(rank = 0u; (rank < CloudProvEndpointCount) && (CloudProvEndpointCount > 1u); rank++)
+    {
+        index = CloudProvEndpointOrder[rank];
+        finishedBits |= CLOUD_PROV_ENDPOINT_FINISHED_BIT(index);
+        if(CloudProv_EndpointStartProbe(index, round, pdMS_TO_TICKS(rank * CLOUD_PROV_ENDPOINT_STAGGER_MS)) != true)
+        {
+            (void)xEventGroupSetBits(CloudProvEndpointEvents, CLOUD_PROV_ENDPOINT_FINISHED_BIT(index));
+        }
+    }
+
+    while(connectionStatus != TLS_TRANSPORT_SUCCESS)
+    {
+        eventBits = xEventGroupGetBits(CloudProvEndpointEvents);
+        candidateBits = eventBits & ~triedBits & (finishedBits >> CLOUD_PROV_ENDPOINT_MAX_COUNT);
+
+        if(candidateBits != 0u)
+        {
+            /* Among endpoints that answered, try the preferred one first */
+            for(rank = 0u; (candidateBits & CLOUD_PROV_ENDPOINT_ANSWERED_BIT(CloudProvEndpointOrder[rank])) == 0u;
+                rank++)
+            {
+            }
+            index = CloudProvEndpointOrder[rank];
+            triedBits |= CLOUD_PROV_ENDPOINT_ANSWERED_BIT(index);
+
+            LogInfo( ( "Create a TLS connection to %s:%d.", CloudProvEndpoints[index], CLOUD_PROV_MQTT_BROKER_PORT ) );
+            connectionStatus = TLS_FreeRTOS_Connect(networkContext,
+                                                    CloudProvEndpoints[index],
+                                                    CLOUD_PROV_MQTT_BROKER_PORT,
+                                                    networkCredentials,
+                                                    sendRecvTimeoutMs,
+                                                    sendRecvTimeoutMs);
+            if((connectionStatus == TLS_TRANSPORT_SUCCESS) || (connectionStatus == TLS_TRANSPORT_HANDSHAKE_FAILED))
+            {
+                /* Broker answered, whatever the handshake result */
+                CloudProvEndpointAnswered = true;
+            }
+            if(connectionStatus == TLS_TRANSPORT_SUCCESS)
+            {
+                CloudProvEndpointCurrentIndex = index;
+            }
+            else
+            {
+                APP_WARN_PRINT("TLS connection to %s failed, trying next endpoint\r\n", CloudProvEndpoints[index]);
+            }
+        }
+        else if((eventBits & finishedBits) == finishedBits)
+        {
+            /* Every probe is done and every endpoint that answered was tried */
+            break;
+        }
+        else
+        {
+            /* Wait for the next probe result */
+            (void)xEventGroupWaitBits(CloudProvEndpointEvents,
+                                      (finishedBits | (finishedBits >> CLOUD_PROV_ENDPOINT_MAX_COUNT)) & ~eventBits,
+                                      pdFALSE,
+                                      pdFALSE,
+                                      pdMS_TO_TICKS(CLOUD_PROV_ENDPOINT_PROBE_TIMEOUT_MS +
+                                                    (CLOUD_PROV_ENDPOINT_MAX_COUNT * CLOUD_PROV_ENDPOINT_STAGGER_MS)));
+        }
+    }
+
+    /* Probes not started yet are cancelled, the others will not report anymore */
+    CloudProvEndpointRound++;
+
+    if(connectionStatus == TLS_TRANSPORT_SUCCESS)
+    {
+        APP_INFO_PRINT("Connected to %s in %d ms\r\n", CloudProvEndpoints[CloudProvEndpointCurrentIndex],
+                       (xTaskGetTickCount() * portTICK_PERIOD_MS) - startMs);
+
+        /* Remember the endpoint for next boot, only when it changed to spare flash writes */
+        if(CloudProvEndpointOrder[0u] != CloudProvEndpointCurrentIndex)
+        {
+            (void)CloudProv_StorageWrite(CLOUD_PROV_ENDPOINT_LAST_GOOD_FILE,
+                                         CloudProvEndpoints[CloudProvEndpointCurrentIndex],
+                                         strlen(CloudProvEndpoints[CloudProvEndpointCurrentIndex]));
+            CloudProv_EndpointLoadLastGood();
+        }
+    }
+    else
+    {
+        APP_WARN_PRINT("No MQTT broker endpoint could be connected, %d endpoint(s) tried\r\n",
+                       __builtin_popcount(triedBits));
+    }
+
+    return connectionStatus;
+}
+
+bool CloudProv_EndpointReachable(void)
+{
+    return CloudProvEndpointAnswered;
+}
+
+const char * CloudProv_EndpointCurrent(void)
+{
+    return CloudProvEndpoints[CloudProvEndpointCurrentIndex];
+}
@@ -0,0 +1,89 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_ENDPOINT_H
+#define CLOUD_PROV_ENDPOINT_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <transport_mbedtls_pkcs11.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Max number of MQTT broker endpoints, e.g. ATS endpoint, custom domain and endpoint of another region.
+ */
+#define CLOUD_PROV_ENDPOINT_MAX_COUNT           (4u)
+
+/**
+ * @brief Character separating endpoints when several are given in the same string, e.g.
+ *        "xxx-ats.iot.us-east-1.amazonaws.com,xxx-ats.iot.eu-west-1.amazonaws.com"
+ */
+#define CLOUD_PROV_ENDPOINT_SEPARATOR           ','
+
+/**
+ * @brief Max length of an endpoint hostname. AWS IoT endpoints are a bit more than 50 chars long, e.g.
+ *        "xxxxxxxxxxxxxx-ats.iot.ap-southeast-2.amazonaws.com".
+ */
+#define CLOUD_PROV_ENDPOINT_MAX_LENGTH          (63u)
+
+/**
+ * @brief Size of the buffer holding the endpoint list, enough for #CLOUD_PROV_ENDPOINT_MAX_COUNT endpoints of
+ *        #CLOUD_PROV_ENDPOINT_MAX_LENGTH chars, each followed by a separator or the null terminator.
+ *        Matches the endpoint slot of the console data flash.
+ */
+#define CLOUD_PROV_ENDPOINT_LIST_BUFFER_SIZE    (CLOUD_PROV_ENDPOINT_MAX_COUNT * (CLOUD_PROV_ENDPOINT_MAX_LENGTH + 1u))
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Replace the endpoint list.
+ * @param[in] endpointList Endpoints, in order of preference, separated by #CLOUD_PROV_ENDPOINT_SEPARATOR.
+ *                         Whitespace around each endpoint is ignored, endpoints longer than
+ *                         #CLOUD_PROV_ENDPOINT_MAX_LENGTH are skipped.
+ * @param[in] length Length of endpointList, without null terminator.
+ * @return Number of endpoints in the new list, 0 if endpointList is invalid, in which case the list is unchanged.
+ */
+uint8_t CloudProv_EndpointSetList(const char *endpointList, size_t length);
+
+/**
+ * @brief Move the endpoint of the last successful connection, saved in littleFS, in front of the list.
+ *        littleFS must be mounted.
+ */
+void CloudProv_EndpointLoadLastGood(void);
+
+/**
+ * @brief Establish a TLS connection with the first endpoint that answers.
+ * @details Reachability of every endpoint (DNS + TCP) is probed in parallel, each probe started
+ *          CLOUD_PROV_ENDPOINT_STAGGER_MS after the previous one, in order of preference. The TLS handshake is done
+ *          with endpoints in the order they answered, until one succeeds, without waiting for slower probes.
+ *          With a single endpoint, no probe is done.
+ * @return TLS_TRANSPORT_SUCCESS when connected, error of the last TLS attempt or TLS_TRANSPORT_CONNECT_FAILURE
+ *         if no endpoint answered.
+ */
+TlsTransportStatus_t CloudProv_EndpointConnect(NetworkContext_t *networkContext,
+                                               NetworkCredentials_t *networkCredentials,
+                                               uint32_t sendRecvTimeoutMs);
+
+/**
+ * @brief Tell if the TLS handshake could be started with at least one endpoint during the last call to
+ *        #CloudProv_EndpointConnect.
+ * @details Allows callers to tell a network/broker outage apart from credentials refused by the broker.
+ */
+bool CloudProv_EndpointReachable(void);
+
+/**
+ * @brief Get the endpoint used by the last connection, or the preferred endpoint if never connected.
+ */
+const char * CloudProv_EndpointCurrent(void);
+
+#endif /* CLOUD_PROV_ENDPOINT_H */
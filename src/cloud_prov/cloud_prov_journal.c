@@ -0,0 +1,146 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_journal.h>
+#include <cloud_prov_config.h>
+#include <cloud_prov_storage.h>
+#include <console.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+#define CLOUD_PROV_JOURNAL_MAGIC            (0x4A564F54u)
+#define CLOUD_PROV_JOURNAL_FILE             "cp_prov_journal"
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief littleFS file of each artifact, indexed by CloudProvArtifact_t */
+static const char * const CloudProvJournalArtifactFiles[CLOUD_PROV_ARTIFACT_COUNT] =
+        {
+            "cp_prov_cert",
+            "cp_prov_token",
+        };
+
+/** @brief First stage needing each artifact. Rewinding before this stage removes the artifact */
+static const CloudProvStage_t CloudProvJournalArtifactStages[CLOUD_PROV_ARTIFACT_COUNT] =
+        {
+            CLOUD_PROV_STAGE_CERT_ISSUED,
+            CLOUD_PROV_STAGE_CERT_ISSUED,
+        };
+
+/** @brief Name printed for each stage */
+static const char * const CloudProvJournalStageNames[] =
+        {
+            "none",
+            "key generated",
+            "certificate issued",
+            "registered",
+        };
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+void CloudProv_JournalLoad(CloudProvJournal_t *journal)
+{
+    size_t readLength = 0u;
+
+    if((CloudProv_StorageRead(CLOUD_PROV_JOURNAL_FILE, journal, sizeof(CloudProvJournal_t), &readLength)
+        != LFS_ERR_OK) ||
+       (readLength != sizeof(CloudProvJournal_t)) ||
+       (journal->magic != CLOUD_PROV_JOURNAL_MAGIC) ||
+       (journal->stage > CLOUD_PROV_STAGE_REGISTERED))
+    {
+        memset(journal, 0x00, sizeof(CloudProvJournal_t));
+    }
+
+    /* Make sure strings are terminated whatever was read */
+    journal->templateName[CLOUD_PROV_JOURNAL_TEMPLATE_SIZE - 1u] = '\0';
+    journal->certificateId[CLOUD_PROV_JOURNAL_CERT_ID_SIZE - 1u] = '\0';
+    journal->thingName[CLOUD_PROV_JOURNAL_THING_NAME_SIZE - 1u] = '\0';
+
+    if((journal->stage != CLOUD_PROV_STAGE_NONE) && (journal->stage != CLOUD_PROV_STAGE_REGISTERED) &&
+       (0 != strcmp(journal->templateName, CLOUD_PROV_TEMPLATE_NAME)))
+    {
+        APP_WARN_PRINT("Unfinished provisioning used template %s, restarting it with %s\r\n",
+                       journal->templateName, CLOUD_PROV_TEMPLATE_NAME);
+        CloudProv_JournalRewind(journal, CLOUD_PROV_STAGE_NONE);
+    }
+
+    APP_INFO_PRINT("Provisioning journal: stage %s\r\n", CloudProvJournalStageNames[journal->stage]);
+}
+
+bool CloudProv_JournalAdvance(CloudProvJournal_t *journal, CloudProvStage_t stage)
+{
+    bool status;
+
+    journal->magic = CLOUD_PROV_JOURNAL_MAGIC;
+    journal->stage = stage;
+    strncpy(journal->templateName, CLOUD_PROV_TEMPLATE_NAME, CLOUD_PROV_JOURNAL_TEMPLATE_SIZE - 1u);
+
+    status = (CloudProv_StorageWrite(CLOUD_PROV_JOURNAL_FILE, journal, sizeof(CloudProvJournal_t)) == LFS_ERR_OK);
+
+    if((status == true) && (stage == CLOUD_PROV_STAGE_REGISTERED))
+    {
+        /* Device credentials now live in corePKCS11, artifacts were only kept to resume provisioning */
+        CloudProv_JournalReleaseArtifacts();
+    }
+    return status;
+}
+
+void CloudProv_JournalRewind(CloudProvJournal_t *journal, CloudProvStage_t stage)
+{
+    /* Journal goes back first, so that a reset in the middle never leaves a stage without its artifacts */
+    if(stage == CLOUD_PROV_STAGE_NONE)
+    {
+        (void)CloudProv_StorageRemove(CLOUD_PROV_JOURNAL_FILE);
+        memset(journal, 0x00, sizeof(CloudProvJournal_t));
+    }
+    else if(journal->stage > stage)
+    {
+        if(stage < CLOUD_PROV_STAGE_CERT_ISSUED)
+        {
+            memset(journal->certificateId, 0x00, CLOUD_PROV_JOURNAL_CERT_ID_SIZE);
+        }
+        memset(journal->thingName, 0x00, CLOUD_PROV_JOURNAL_THING_NAME_SIZE);
+        (void)CloudProv_JournalAdvance(journal, stage);
+    }
+    else
+    {
+        /* Already at or before stage */
+    }
+
+    for(uint8_t artifact = 0u; artifact < CLOUD_PROV_ARTIFACT_COUNT; artifact++)
+    {
+        if(CloudProvJournalArtifactStages[artifact] > stage)
+        {
+            (void)CloudProv_StorageRemove(CloudProvJournalArtifactFiles[artifact]);
+        }
+    }
+}
+
+bool CloudProv_JournalSaveArtifact(CloudProvArtifact_t artifact, const void *data, size_t length)
+{
+    return (CloudProv_StorageWrite(CloudProvJournalArtifactFiles[artifact], data, length) == LFS_ERR_OK);
+}
+
+bool CloudProv_JournalLoadArtifact(CloudProvArtifact_t artifact, void *buffer, size_t bufferSize, size_t *length)
+{
+    return (CloudProv_StorageRead(CloudProvJournalArtifactFiles[artifact], buffer, bufferSize, length) == LFS_ERR_OK);
+}
+
+void CloudProv_JournalReleaseArtifacts(void)
+{
+    for(uint8_t artifact = 0u; artifact < CLOUD_PROV_ARTIFACT_COUNT; artifact++)
+    {
+        (void)CloudProv_StorageRemove(CloudProvJournalArtifactFiles[artifact]);
+    }
+}
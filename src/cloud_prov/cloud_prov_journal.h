@@ -0,0 +1,110 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_JOURNAL_H
+#define CLOUD_PROV_JOURNAL_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+#define CLOUD_PROV_JOURNAL_TEMPLATE_SIZE    (64u)
+#define CLOUD_PROV_JOURNAL_CERT_ID_SIZE     (65u)
+#define CLOUD_PROV_JOURNAL_THING_NAME_SIZE  (129u)
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+
+/**
+ * @brief Last completed provisioning stage. Each stage keeps what the next ones need, so an interrupted
+ *        provisioning resumes where it stopped.
+ * @details The device key pair stays pending in corePKCS11 until the thing is registered. The issued certificate,
+ *          in DER, and the ownership token are journaled once the claim credentials are destroyed: they do not fit
+ *          next to each other in the data flash, see CloudProv_JournalIssuedCertificate in cloud_prov.c.
+ */
+typedef enum
+{
+    CLOUD_PROV_STAGE_NONE =             (uint8_t)0u,    /**< Nothing done, or unknown for devices provisioned
+                                                             before the journal existed */
+    CLOUD_PROV_STAGE_KEY_GENERATED =    (uint8_t)1u,    /**< Device key pair pending in corePKCS11 */
+    CLOUD_PROV_STAGE_CERT_ISSUED =      (uint8_t)2u,    /**< Certificate id, certificate and ownership token saved */
+    CLOUD_PROV_STAGE_REGISTERED =       (uint8_t)3u,    /**< Thing registered, device credentials in corePKCS11 */
+}CloudProvStage_t;
+
+/**
+ * @brief Data saved alongside a stage, too large to be part of the journal itself.
+ */
+typedef enum
+{
+    CLOUD_PROV_ARTIFACT_CERTIFICATE =   (uint8_t)0u,    /**< DER device certificate, from CERT_ISSUED */
+    CLOUD_PROV_ARTIFACT_OWNERSHIP_TOKEN=(uint8_t)1u,    /**< Certificate ownership token, from CERT_ISSUED */
+    CLOUD_PROV_ARTIFACT_COUNT =         (uint8_t)2u,
+}CloudProvArtifact_t;
+
+/**
+ * @brief Provisioning journal, as saved in littleFS.
+ */
+typedef struct
+{
+    uint32_t magic;
+    CloudProvStage_t stage;
+    char templateName[CLOUD_PROV_JOURNAL_TEMPLATE_SIZE];
+    char certificateId[CLOUD_PROV_JOURNAL_CERT_ID_SIZE];
+    char thingName[CLOUD_PROV_JOURNAL_THING_NAME_SIZE];
+}CloudProvJournal_t;
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Read the journal from littleFS. littleFS must be mounted.
+ * @details A missing or corrupted journal reads as stage NONE. An unfinished provisioning started with another
+ *          template than CLOUD_PROV_TEMPLATE_NAME is dropped and restarts from scratch.
+ * @param[out] journal Journal read.
+ */
+void CloudProv_JournalLoad(CloudProvJournal_t *journal);
+
+/**
+ * @brief Mark a stage as completed and save the journal. Reaching CLOUD_PROV_STAGE_REGISTERED removes every artifact.
+ * @param[in, out] journal Journal, with the data of the completed stage already filled in.
+ * @param[in] stage Stage completed.
+ * @return true if the journal is saved.
+ */
+bool CloudProv_JournalAdvance(CloudProvJournal_t *journal, CloudProvStage_t stage);
+
+/**
+ * @brief Go back to a stage, discarding the data of every later stage.
+ * @param[in, out] journal Journal to rewind.
+ * @param[in] stage Stage to go back to. CLOUD_PROV_STAGE_NONE removes the journal and every artifact.
+ */
+void CloudProv_JournalRewind(CloudProvJournal_t *journal, CloudProvStage_t stage);
+
+/**
+ * @brief Save an artifact needed by a later stage.
+ * @return true if saved, false if littleFS has not enough free blocks left for it.
+ */
+bool CloudProv_JournalSaveArtifact(CloudProvArtifact_t artifact, const void *data, size_t length);
+
+/**
+ * @brief Read an artifact saved by a previous stage.
+ * @param[out] length Number of bytes read.
+ * @return true if read.
+ */
+bool CloudProv_JournalLoadArtifact(CloudProvArtifact_t artifact, void *buffer, size_t bufferSize, size_t *length);
+
+/**
+ * @brief Remove every artifact but keep the stage, once the artifacts were read back in RAM and their blocks are
+ *        needed. A reset then leaves the stage without its artifacts, which CloudProv_JournalLoadArtifact reports.
+ */
+void CloudProv_JournalReleaseArtifacts(void);
+
+#endif /* CLOUD_PROV_JOURNAL_H */
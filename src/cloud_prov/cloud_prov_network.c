@@ -3,11 +3,14 @@
  * Description  : Contains functions used in Renesas Cloud Connectivity application
  **********************************************************************************************************************/
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
 #include "cloud_app/cloud_app.h"
 #include "led/led.h"
 #include "console/console.h"
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_DHCP.h"
+#include "cloud_prov/cloud_prov.h"
 
 
 #define CLOUD_PROV_ETH_CONFIG    "\r\n\r\n--------------------------------------------------------------------------------"\
@@ -21,6 +24,11 @@
  */
 #define CLOUD_PROV_MINIMUM_IP_CONFIG_BUFF_SIZE  16u
 
+/**
+ * @brief Period at which the wait for the network link lets the boot menu know the cloud thread is idle
+ */
+#define CLOUD_PROV_LINK_WAIT_POLL_MS            (500u)
+
 /**
  * @brief External reference to task handle of cloud app.
  * @details This is needed to be used as input parameter in xTaskNotifyFromISR(), called in
@@ -122,9 +130,6 @@ void vApplicationIPNetworkEventHook(eIPCallbackEvent_t eNetworkEvent)
         uint8_t lGatewayAddress[ipIP_ADDRESS_LENGTH_BYTES] =   { RESET_VALUE };
         uint8_t lDNSServerAddress[ipIP_ADDRESS_LENGTH_BYTES] = {75, 75, 75, 75};
 
-        /* Signal application the network is UP */
-        xTaskNotifyFromISR(cloud_app_thread, eNetworkUp, eSetBits, NULL);
-
         /* The network is up and configured.  Print out the configuration
          obtained from the DHCP server. */
         FreeRTOS_GetAddressConfiguration (&lulIPAddress,
@@ -132,17 +137,28 @@ void vApplicationIPNetworkEventHook(eIPCallbackEvent_t eNetworkEvent)
                                           &lulGatewayAddress,
                                           &lulDNSServerAddress);
 
-        /* Convert the IP address to a string then print it out. */
-        FreeRTOS_inet_ntoa (lulIPAddress, (char*) ucIPAddress);
+        if(lulIPAddress == 0u)
+        {
+            /* DHCP gave up, the static configuration has no address, take the network down to start DHCP over */
+            FreeRTOS_NetworkDown();
+        }
+        else
+        {
+            /* Signal application the network is UP */
+            xTaskNotifyFromISR(cloud_app_thread, eNetworkUp, eSetBits, NULL);
+
+            /* Convert the IP address to a string then print it out. */
+            FreeRTOS_inet_ntoa (lulIPAddress, (char*) ucIPAddress);
 
-        /* Convert the net mask to a string then print it out. */
-        FreeRTOS_inet_ntoa (lulNetMask, (char*) ucNetMask);
+            /* Convert the net mask to a string then print it out. */
+            FreeRTOS_inet_ntoa (lulNetMask, (char*) ucNetMask);
 
-        /* Convert the IP address of the gateway to a string then print it out. */
-        FreeRTOS_inet_ntoa (lulGatewayAddress, (char*) ucGatewayAddress);
+            /* Convert the IP address of the gateway to a string then print it out. */
+            FreeRTOS_inet_ntoa (lulGatewayAddress, (char*) ucGatewayAddress);
 
-        /* Convert the IP address of the DNS server to a string then print it out. */
-        FreeRTOS_inet_ntoa (lulDNSServerAddress, (char*) ucDNSServerAddress);
+            /* Convert the IP address of the DNS server to a string then print it out. */
+            FreeRTOS_inet_ntoa (lulDNSServerAddress, (char*) ucDNSServerAddress);
+        }
     }
 }
 #endif
@@ -160,11 +176,15 @@ void CloudProv_InitIPStack(void)
     }
     else
     {
-        APP_PRINT("[ORANGE]Waiting for IP stack link up...[WHITE]");
+        APP_PRINT(CONSOLE_ORANGE "Waiting for IP stack link up..." CONSOLE_WHITE);
         /* Wait on notification for cloud_app_thread Task. This notification will come from
          * vApplicationIPNetworkEventHook() function, which is a FreeRTOS callback defined by the user. Using
          * this patterns allows to have a synchronous IP stack initialization */
-        xTaskNotifyWait(pdFALSE, pdFALSE, NULL, portMAX_DELAY);
+        while(xTaskNotifyWait(pdFALSE, pdFALSE, NULL, pdMS_TO_TICKS(CLOUD_PROV_LINK_WAIT_POLL_MS)) != pdTRUE)
+        {
+            /* No flash access while waiting for the link, a boot menu opened meanwhile does not have to wait */
+            CloudProv_BootIdle();
+        }
 
         /* Indicate that network is up with a LED on the device */
         NETWORK_CONNECT_INDICATION;
@@ -5,81 +5,136 @@
 /*************************************************************************************
  *                                  INCLUDES
  ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
 #include <cloud_prov_pkcs11.h>
 #include <cloud_prov_config.h>
 #include <console.h>
 #include "mbedtls/x509_csr.h"
 #include <mbedtls_utils.h>
+#include "aws_dev_mode_key_provisioning.h"
+#include "semphr.h"
 
 
 /*************************************************************************************
  * DEFINE MACROS
  ************************************************************************************/
 
+/**
+ * @brief Stack size (in words) and priority of the task pre-generating the device key pair.
+ * @details Priority is just above idle so key generation only uses CPU time no one else needs.
+ */
+#define CLOUD_PROV_KEYGEN_TASK_STACK_SIZE       (1536u)
+#define CLOUD_PROV_KEYGEN_TASK_PRIORITY         (tskIDLE_PRIORITY + 1u)
+
+/**
+ * @brief Max time provisioning waits for a pending key generation already in progress.
+ */
+#define CLOUD_PROV_PENDING_KEY_WAIT_MS          (10000u)
 
 /*************************************************************************************
  * Type Definitions
  ************************************************************************************/
 
+/**
+ * @brief State of the device key pair generated ahead of provisioning
+ */
+typedef enum
+{
+    CLOUD_PROV_PENDING_KEY_NONE =       (uint8_t)0u,
+    CLOUD_PROV_PENDING_KEY_GENERATING = (uint8_t)1u,
+    CLOUD_PROV_PENDING_KEY_READY =      (uint8_t)2u,
+}CloudProvPendingKeyState_t;
 
 /*************************************************************************************
  * Local Variables
  ************************************************************************************/
 
+/** @brief State of the device key pair pending in corePKCS11 under the CLOUD_PROV_LABEL_PENDING_* labels */
+static volatile CloudProvPendingKeyState_t CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
+
+/**
+ * @brief Guards the pending key pair and its state. Held by the key generation task for the whole generation, hence
+ *        a binary semaphore: it is taken by CloudProv_PregenerateDeviceKey and given back by the task.
+ */
+static SemaphoreHandle_t CloudProvPendingKeyLock = NULL;
+static StaticSemaphore_t CloudProvPendingKeyLockBuffer;
+
+/** @brief Set once mbedtls_platform_setup was called, whichever task gets there first */
+static bool CloudProvCryptoPlatformReady = false;
 
 /*************************************************************************************
  * Local Function Prototypes
  ************************************************************************************/
-
+static CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
+                                         CK_OBJECT_HANDLE_PTR xPrivateKeyHandlePtr,
+                                         CK_OBJECT_HANDLE_PTR xPublicKeyHandlePtr );
+static CK_RV CloudProv_PendingKeyFind(CK_SESSION_HANDLE xP11Session, CK_OBJECT_HANDLE_PTR pxPrivKeyHandle);
+static void CloudProv_DeviceKeyGenerate(CK_SESSION_HANDLE xP11Session);
+static void CloudProv_KeyGenTask(void *pvParameters);
+static bool CloudProv_PendingKeyTake(TickType_t waitTicks);
+static void CloudProv_PendingKeyGive(void);
+static void CloudProv_PendingKeyDestroy(CK_SESSION_HANDLE xP11Session);
 
 /*************************************************************************************
  * Local Functions
  ************************************************************************************/
 
+/**
+ * @brief Take the pending key lock, creating it on first use.
+ * @param[in] waitTicks Max wait, a key generation in progress holds the lock until it is done.
+ * @return true if taken.
+ */
+static bool CloudProv_PendingKeyTake(TickType_t waitTicks)
+{
+    taskENTER_CRITICAL();
+    if(CloudProvPendingKeyLock == NULL)
+    {
+        CloudProvPendingKeyLock = xSemaphoreCreateBinaryStatic(&CloudProvPendingKeyLockBuffer);
+        (void)xSemaphoreGive(CloudProvPendingKeyLock);
+    }
+    taskEXIT_CRITICAL();
 
-/*************************************************************************************
- * global functions
- ************************************************************************************/
+    return (xSemaphoreTake(CloudProvPendingKeyLock, waitTicks) == pdTRUE);
+}
 
-int lMbedCryptoRngCallbackPKCS11( void * pvCtx,
-                                  unsigned char * pucOutput,
-                                  size_t uxLen )
+static void CloudProv_PendingKeyGive(void)
 {
-    int lRslt;
-    CK_FUNCTION_LIST_PTR pxFunctionList = NULL;
-    CK_SESSION_HANDLE * pxSessionHandle = ( CK_SESSION_HANDLE * ) pvCtx;
+    (void)xSemaphoreGive(CloudProvPendingKeyLock);
+}
 
-    if( pucOutput == NULL )
-    {
-        lRslt = -1;
-    }
-    else if( pvCtx == NULL )
-    {
-        lRslt = -1;
-        LogError( ( "pvCtx must not be NULL." ) );
-    }
-    else
-    {
-        lRslt = ( int ) C_GetFunctionList( &pxFunctionList );
-    }
+/**
+ * @brief Destroy the pending key pair objects, whatever the state. Pending key lock must be held.
+ */
+static void CloudProv_PendingKeyDestroy(CK_SESSION_HANDLE xP11Session)
+{
+    CK_FUNCTION_LIST_PTR xFunctionList = NULL;
+    CK_OBJECT_HANDLE xHandle = CK_INVALID_HANDLE;
+    const char * const pendingLabels[] = { CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY, CLOUD_PROV_LABEL_PENDING_PUBLIC_KEY };
+    const CK_OBJECT_CLASS pendingClasses[] = { CKO_PRIVATE_KEY, CKO_PUBLIC_KEY };
 
-    if( ( lRslt != CKR_OK ) ||
-        ( pxFunctionList == NULL ) ||
-        ( pxFunctionList->C_GenerateRandom == NULL ) )
-    {
-        lRslt = -1;
-    }
-    else
+    if(C_GetFunctionList(&xFunctionList) == CKR_OK)
     {
-        lRslt = ( int ) pxFunctionList->C_GenerateRandom( *pxSessionHandle, pucOutput, uxLen );
+        for(uint8_t index = 0u; index < 2u; index++)
+        {
+            xHandle = CK_INVALID_HANDLE;
+            if((xFindObjectWithLabelAndClass(xP11Session,
+                                             (char *)pendingLabels[index],
+                                             strlen(pendingLabels[index]),
+                                             pendingClasses[index],
+                                             &xHandle) == CKR_OK) &&
+               (xHandle != CK_INVALID_HANDLE))
+            {
+                (void)xFunctionList->C_DestroyObject(xP11Session, xHandle);
+            }
+        }
     }
-
-    return lRslt;
+    CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
 }
 
-CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
-                                  CK_OBJECT_HANDLE_PTR xPrivateKeyHandlePtr,
-                                  CK_OBJECT_HANDLE_PTR xPublicKeyHandlePtr )
+static CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
+                                         CK_OBJECT_HANDLE_PTR xPrivateKeyHandlePtr,
+                                         CK_OBJECT_HANDLE_PTR xPublicKeyHandlePtr )
 {
     CK_RV xResult;
     CK_MECHANISM xMechanism = { CKM_EC_KEY_PAIR_GEN, NULL_PTR, 0 };
@@ -93,7 +148,7 @@ CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
                     { CKA_KEY_TYPE,  NULL /* &keyType */,         sizeof( xKeyType )             },
                     { CKA_VERIFY,    NULL /* &trueObject */,      sizeof( xTrueObject )          },
                     { CKA_EC_PARAMS, NULL /* ecParams */,         sizeof( pxEcParams )           },
-                    { CKA_LABEL,     ( void * ) pkcs11configLABEL_DEVICE_PUBLIC_KEY_FOR_TLS, strnlen( pkcs11configLABEL_DEVICE_PUBLIC_KEY_FOR_TLS, pkcs11configMAX_LABEL_LENGTH )}
+                    { CKA_LABEL,     ( void * ) CLOUD_PROV_LABEL_PENDING_PUBLIC_KEY, strlen( CLOUD_PROV_LABEL_PENDING_PUBLIC_KEY )}
             };
 
     /* Aggregate initializers must not use the address of an automatic variable. */
@@ -107,7 +162,7 @@ CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
                     { CKA_TOKEN,    NULL /* &trueObject */,       sizeof( xTrueObject )          },
                     { CKA_PRIVATE,  NULL /* &trueObject */,       sizeof( xTrueObject )          },
                     { CKA_SIGN,     NULL /* &trueObject */,       sizeof( xTrueObject )          },
-                    { CKA_LABEL,    ( void * ) pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS, strnlen( pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS, pkcs11configMAX_LABEL_LENGTH )}
+                    { CKA_LABEL,    ( void * ) CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY, strlen( CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY )}
             };
 
     /* Aggregate initializers must not use the address of an automatic variable. */
@@ -137,35 +192,273 @@ CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
     return xResult;
 }
 
+/**
+ * @brief Look for the pending private key in corePKCS11.
+ * @param[out] pxPrivKeyHandle Handle of the pending private key, CK_INVALID_HANDLE if there is none.
+ */
+static CK_RV CloudProv_PendingKeyFind(CK_SESSION_HANDLE xP11Session, CK_OBJECT_HANDLE_PTR pxPrivKeyHandle)
+{
+    *pxPrivKeyHandle = CK_INVALID_HANDLE;
+    return xFindObjectWithLabelAndClass(xP11Session,
+                                        (char *)CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY,
+                                        strlen(CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY),
+                                        CKO_PRIVATE_KEY,
+                                        pxPrivKeyHandle);
+}
+
+/**
+ * @brief Generate a P-256 device key pair into corePKCS11 under the pending labels. Writing it under the TLS labels
+ *        right away would overwrite the claim credentials or the credentials of an already provisioned device. A
+ *        pending key pair left by a previous boot is kept instead. Pending key lock must be held.
+ */
+static void CloudProv_DeviceKeyGenerate(CK_SESSION_HANDLE xP11Session)
+{
+    CK_OBJECT_HANDLE xPrivKeyHandle = CK_INVALID_HANDLE;
+    CK_OBJECT_HANDLE xPubKeyHandle = CK_INVALID_HANDLE;
+    CK_RV xPkcs11Ret;
+    TickType_t startTick = xTaskGetTickCount();
+
+    xPkcs11Ret = CloudProv_PendingKeyFind(xP11Session, &xPrivKeyHandle);
+    if((xPkcs11Ret == CKR_OK) && (xPrivKeyHandle == CK_INVALID_HANDLE))
+    {
+        xPkcs11Ret = CloudProv_GenerateKeyPairEC(xP11Session, &xPrivKeyHandle, &xPubKeyHandle);
+        if(xPkcs11Ret == CKR_OK)
+        {
+            APP_DBG_PRINT("Device key pair generated in %lu ms\r\n",
+                          (unsigned long)((xTaskGetTickCount() - startTick) * portTICK_PERIOD_MS));
+        }
+    }
+
+    if((xPkcs11Ret == CKR_OK) && (xPrivKeyHandle != CK_INVALID_HANDLE))
+    {
+        CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_READY;
+    }
+    else
+    {
+        APP_WARN_PRINT("Device key pair generation failed, PKCS #11 error = 0x%lx\r\n", (unsigned long)xPkcs11Ret);
+        CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
+    }
+}
+
+static void CloudProv_KeyGenTask(void *pvParameters)
+{
+    CK_SESSION_HANDLE xP11Session = CK_INVALID_HANDLE;
+    CK_FUNCTION_LIST_PTR xFunctionList = NULL;
+
+    FSP_PARAMETER_NOT_USED(pvParameters);
+
+    /* On failure, provisioning generates the key pair again when it needs it. The lock was taken for this task by
+     * CloudProv_PregenerateDeviceKey. The task has its own session, the cloud thread may use its own meanwhile */
+    if(xInitializePkcs11Session(&xP11Session) == CKR_OK)
+    {
+        CloudProv_DeviceKeyGenerate(xP11Session);
+        if(C_GetFunctionList(&xFunctionList) == CKR_OK)
+        {
+            (void)xFunctionList->C_CloseSession(xP11Session);
+        }
+    }
+    else
+    {
+        CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
+    }
+    CloudProv_PendingKeyGive();
+    vTaskDelete(NULL);
+}
+
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+void CloudProv_CryptoPlatformSetup(void)
+{
+    bool setupNeeded = false;
+
+    taskENTER_CRITICAL();
+    if(CloudProvCryptoPlatformReady == false)
+    {
+        CloudProvCryptoPlatformReady = true;
+        setupNeeded = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if(setupNeeded == true)
+    {
+        mbedtls_platform_setup(NULL);
+    }
+}
+
+void CloudProv_DeviceKeyWait(void)
+{
+    (void)CloudProv_PendingKeyTake(portMAX_DELAY);
+    CloudProv_PendingKeyGive();
+}
+
+void CloudProv_DiscardPendingKey(CK_SESSION_HANDLE xP11Session)
+{
+    /* A generation in progress is waited for, so that its key pair is destroyed too instead of becoming ready later */
+    (void)CloudProv_PendingKeyTake(portMAX_DELAY);
+    CloudProv_PendingKeyDestroy(xP11Session);
+    CloudProv_PendingKeyGive();
+}
+
+void CloudProv_PregenerateDeviceKey(void)
+{
+    BaseType_t status = pdFAIL;
+
+    /* With CreateKeysAndCertificate, the key pair comes from AWS IoT. A lock already held means a key pair is
+     * being generated or used */
+    if((CLOUD_PROV_PROVISIONING_MODE == CLOUD_PROV_PROVISIONING_MODE_CSR) && (CloudProv_PendingKeyTake(0u) == true))
+    {
+        if(CloudProvPendingKeyState == CLOUD_PROV_PENDING_KEY_NONE)
+        {
+            /* The task gives the lock back once the key pair is generated */
+            CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_GENERATING;
+            status = xTaskCreate(CloudProv_KeyGenTask,
+                                 "CloudProvKeyGen",
+                                 CLOUD_PROV_KEYGEN_TASK_STACK_SIZE,
+                                 NULL,
+                                 CLOUD_PROV_KEYGEN_TASK_PRIORITY,
+                                 NULL);
+            if(status != pdPASS)
+            {
+                CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
+            }
+        }
+        if(status != pdPASS)
+        {
+            CloudProv_PendingKeyGive();
+        }
+    }
+}
+
+bool CloudProv_DeviceKeyPrepare(CK_SESSION_HANDLE xP11Session)
+{
+    bool status = false;
+
+    /* A key pair pre-generation may still be running, waiting for it is never longer than generating
+     * a new key pair from scratch */
+    if(CloudProv_PendingKeyTake(pdMS_TO_TICKS(CLOUD_PROV_PENDING_KEY_WAIT_MS)) == true)
+    {
+        if(CloudProvPendingKeyState == CLOUD_PROV_PENDING_KEY_NONE)
+        {
+            CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_GENERATING;
+            CloudProv_DeviceKeyGenerate(xP11Session);
+        }
+        status = (CloudProvPendingKeyState == CLOUD_PROV_PENDING_KEY_READY);
+        CloudProv_PendingKeyGive();
+    }
+
+    return status;
+}
+
+bool CloudProv_DeviceKeyRestore(CK_SESSION_HANDLE xP11Session)
+{
+    CK_OBJECT_HANDLE xPrivKeyHandle = CK_INVALID_HANDLE;
+
+    /* The key pair pending in corePKCS11 is the one the certificate may already be issued for */
+    (void)CloudProv_PendingKeyTake(portMAX_DELAY);
+    if((CloudProv_PendingKeyFind(xP11Session, &xPrivKeyHandle) == CKR_OK) && (xPrivKeyHandle != CK_INVALID_HANDLE))
+    {
+        CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_READY;
+    }
+    else
+    {
+        APP_ERR_PRINT("No device key pair pending in corePKCS11\r\n");
+        CloudProvPendingKeyState = CLOUD_PROV_PENDING_KEY_NONE;
+    }
+    CloudProv_PendingKeyGive();
+
+    return (xPrivKeyHandle != CK_INVALID_HANDLE);
+}
+
+bool CloudProv_DeviceKeyCommit(CK_SESSION_HANDLE xP11Session)
+{
+    bool status = false;
+
+    (void)CloudProv_PendingKeyTake(portMAX_DELAY);
+    if(CloudProvPendingKeyState == CLOUD_PROV_PENDING_KEY_READY)
+    {
+        /* Copied first, destroyed once copied: a reset in between leaves the pending key pair to copy again */
+        status = CloudProv_CredentialPendingKeyPromote();
+    }
+    if(status == true)
+    {
+        /* The key now lives under the TLS labels only, the next provisioning needs a fresh one */
+        CloudProv_PendingKeyDestroy(xP11Session);
+    }
+    else
+    {
+        APP_ERR_PRINT("Failed to store device key into corePKCS11\r\n");
+    }
+    CloudProv_PendingKeyGive();
+
+    return status;
+}
+
+int lMbedCryptoRngCallbackPKCS11( void * pvCtx,
+                                  unsigned char * pucOutput,
+                                  size_t uxLen )
+{
+    int lRslt;
+    CK_FUNCTION_LIST_PTR pxFunctionList = NULL;
+    CK_SESSION_HANDLE * pxSessionHandle = ( CK_SESSION_HANDLE * ) pvCtx;
+
+    if( pucOutput == NULL )
+    {
+        lRslt = -1;
+    }
+    else if( pvCtx == NULL )
+    {
+        lRslt = -1;
+        LogError( ( "pvCtx must not be NULL." ) );
+    }
+    else
+    {
+        lRslt = ( int ) C_GetFunctionList( &pxFunctionList );
+    }
+
+    if( ( lRslt != CKR_OK ) ||
+        ( pxFunctionList == NULL ) ||
+        ( pxFunctionList->C_GenerateRandom == NULL ) )
+    {
+        lRslt = -1;
+    }
+    else
+    {
+        lRslt = ( int ) pxFunctionList->C_GenerateRandom( *pxSessionHandle, pucOutput, uxLen );
+    }
+
+    return lRslt;
+}
+
 bool CloudProv_GenerateCsr(CK_SESSION_HANDLE xP11Session,
                            uint8_t * pcCsrBuffer,
                            size_t xCsrBufferLength,
                            size_t * pxOutCsrLength ) {
-    CK_OBJECT_HANDLE xPrivKeyHandle;
-    CK_OBJECT_HANDLE xPubKeyHandle;
-    CK_RV xPkcs11Ret = CKR_OK;
+    CK_OBJECT_HANDLE xPrivKeyHandle = CK_INVALID_HANDLE;
+    CK_RV xPkcs11Ret = CKR_OBJECT_HANDLE_INVALID;
     mbedtls_pk_context xPrivKey;
-    mbedtls_ecdsa_context xEcdsaContext;
     mbedtls_x509write_csr xReq;
     int32_t ulMbedtlsRet = -1;
-    const mbedtls_pk_info_t *pxHeader = mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY);
 
+    *pxOutCsrLength = 0u;
 
-    /* Current corePKCS11 integration does not allow for new certificate and private key, thus
-         * destroy claim credentials to free their spot in corePKCS's memory integration (littleFS) */
-    xPkcs11Ret = xDestroyDefaultCryptoObjects(xP11Session );
-
-    if (xPkcs11Ret == CKR_OK)
+    /* The CSR is signed by corePKCS11 with the pending device key, which stays under its own label until the
+     * thing is registered, so the claim credentials remain usable if provisioning is interrupted */
+    (void)CloudProv_PendingKeyTake(portMAX_DELAY);
+    if (CloudProvPendingKeyState == CLOUD_PROV_PENDING_KEY_READY)
     {
-        xPkcs11Ret = CloudProv_GenerateKeyPairEC(xP11Session,
-                                                 &xPrivKeyHandle,
-                                                 &xPubKeyHandle);
+        xPkcs11Ret = CloudProv_PendingKeyFind(xP11Session, &xPrivKeyHandle);
     }
-
-    if (xPkcs11Ret == CKR_OK)
+    if ((xPkcs11Ret == CKR_OK) && (xPrivKeyHandle != CK_INVALID_HANDLE))
     {
         xPkcs11Ret = xPKCS11_initMbedtlsPkContext(&xPrivKey, xP11Session, xPrivKeyHandle);
     }
+    else
+    {
+        xPkcs11Ret = CKR_OBJECT_HANDLE_INVALID;
+    }
 
     if (xPkcs11Ret == CKR_OK)
     {
@@ -188,28 +481,74 @@ bool CloudProv_GenerateCsr(CK_SESSION_HANDLE xP11Session,
             ulMbedtlsRet = mbedtls_x509write_csr_pem(&xReq,
                                                      (unsigned char *) pcCsrBuffer,
                                                      xCsrBufferLength,
-                                                     &lMbedCryptoRngCallbackPKCS11,
+                                                     &lMbedCryptoRngCallbackPool,
                                                      &xP11Session);
         }
 
         if( ulMbedtlsRet != 0U )
         {
-            APP_ERR_PRINT( ( "Failed to generate Key and Certificate Signing Request.\r\n" ) );
+            APP_ERR_PRINT( "Failed to generate Certificate Signing Request.\r\n" );
+        }
+        else
+        {
+            RngPoolStats_t xRngStats;
+            vMbedCryptoRngPoolGetStats(&xRngStats);
+            APP_INFO_PRINT("RNG pool: %lu requests (%lu bytes) served with %lu C_GenerateRandom calls (%lu bytes)\r\n",
+                           (unsigned long)xRngStats.ulRequests, (unsigned long)xRngStats.ulRequestedBytes,
+                           (unsigned long)xRngStats.ulEntropyCalls, (unsigned long)xRngStats.ulEntropyBytes);
+            *pxOutCsrLength = strlen(pcCsrBuffer);
         }
 
         mbedtls_x509write_csr_free(&xReq);
 
         mbedtls_pk_free(&xPrivKey);
     }
-
-    *pxOutCsrLength = strlen(pcCsrBuffer);
+    else
+    {
+        APP_ERR_PRINT("No device key to sign the Certificate Signing Request\r\n");
+    }
+    CloudProv_PendingKeyGive();
 
     return (ulMbedtlsRet == 0);
 }
 
 
+bool CloudProv_CertificateToDer(const char * pcCertificate,
+                                size_t xCertificateLength,
+                                uint8_t * pucDerBuffer,
+                                size_t * pxDerLength )
+{
+    uint8_t * pucPemObject = NULL;
+    int32_t ulConversion = -1;
+
+    /* The PEM parser expects a null terminated string, and the certificate is usually left in place in the
+     * received publish */
+    pucPemObject = ( uint8_t * ) malloc( xCertificateLength + 1 );
+
+    if( pucPemObject != NULL )
+    {
+        memcpy( pucPemObject, pcCertificate, xCertificateLength );
+        pucPemObject[ xCertificateLength ] = '\0';
+        ulConversion = convert_pem_to_der( pucPemObject,
+                                           xCertificateLength + 1,
+                                           pucDerBuffer, pxDerLength );
+
+        if( 0 != ulConversion )
+        {
+            LogError( ( "Failed to convert provided certificate." ) );
+        }
+        free( pucPemObject );
+    }
+    else
+    {
+        LogError( ( "Failed to allocate buffer for converting certificate to DER." ) );
+    }
+
+    return( ulConversion == 0 );
+}
+
 bool CloudProv_LoadCertificate(CK_SESSION_HANDLE xP11Session,
-                               const char * pcCertificate,
+                               const uint8_t * pucCertificate,
                                size_t xCertificateLength )
 {
     PKCS11_CertificateTemplate_t xCertificateTemplate;
@@ -217,46 +556,16 @@ bool CloudProv_LoadCertificate(CK_SESSION_HANDLE xP11Session,
     CK_CERTIFICATE_TYPE xCertificateType = CKC_X_509;
     CK_FUNCTION_LIST_PTR xFunctionList = NULL;
     CK_RV xResult = CKR_OK;
-    uint8_t * pucDerObject = NULL;
-    int32_t ulConversion = 0;
-    size_t xDerLen = 0;
     CK_BBOOL xTokenStorage = CK_TRUE;
     CK_BYTE pxSubject[] = "TestSubject";
     CK_OBJECT_HANDLE xObjectHandle = CK_INVALID_HANDLE;
 
-    if( pcCertificate == NULL )
+    if( pucCertificate == NULL )
     {
         LogError( ( "Certificate cannot be null." ) );
         xResult = CKR_ATTRIBUTE_VALUE_INVALID;
     }
 
-    if( xResult == CKR_OK )
-    {
-        /* Convert the certificate to DER format from PEM. The DER key should
-         * be about 3/4 the size of the PEM key, so mallocing the PEM key size
-         * is sufficient. */
-        pucDerObject = ( uint8_t * ) malloc( xCertificateLength + 1 );
-        xDerLen = xCertificateLength + 1;
-
-        if( pucDerObject != NULL )
-        {
-            ulConversion = convert_pem_to_der( ( unsigned char * ) pcCertificate,
-                                               xCertificateLength + 1,
-                                               pucDerObject, &xDerLen );
-
-            if( 0 != ulConversion )
-            {
-                LogError( ( "Failed to convert provided certificate." ) );
-                xResult = CKR_ARGUMENTS_BAD;
-            }
-        }
-        else
-        {
-            LogError( ( "Failed to allocate buffer for converting certificate to DER." ) );
-            xResult = CKR_HOST_MEMORY;
-        }
-    }
-
     if( xResult == CKR_OK )
     {
         xResult = C_GetFunctionList( &xFunctionList );
@@ -277,8 +586,8 @@ bool CloudProv_LoadCertificate(CK_SESSION_HANDLE xP11Session,
         xCertificateTemplate.xSubject.pValue = pxSubject;
         xCertificateTemplate.xSubject.ulValueLen = strlen( ( const char * ) pxSubject );
         xCertificateTemplate.xValue.type = CKA_VALUE;
-        xCertificateTemplate.xValue.pValue = pucDerObject;
-        xCertificateTemplate.xValue.ulValueLen = xDerLen;
+        xCertificateTemplate.xValue.pValue = ( CK_VOID_PTR ) pucCertificate;
+        xCertificateTemplate.xValue.ulValueLen = xCertificateLength;
         xCertificateTemplate.xLabel.type = CKA_LABEL;
         xCertificateTemplate.xLabel.pValue = ( CK_VOID_PTR ) pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS;
         xCertificateTemplate.xLabel.ulValueLen = strnlen( pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS, pkcs11configMAX_LABEL_LENGTH );
@@ -298,11 +607,6 @@ bool CloudProv_LoadCertificate(CK_SESSION_HANDLE xP11Session,
                                                  &xObjectHandle );
     }
 
-    if( pucDerObject != NULL )
-    {
-        free( pucDerObject );
-    }
-
     return( xResult == CKR_OK );
 }
 
@@ -6,18 +6,144 @@
 #define CLOUD_PROV_PKCS11_H
 
 #include "mbedtls_pkcs11.h"
+#include "mbedtls/x509_crt.h"
 
-CK_RV CloudProv_GenerateKeyPairEC(CK_SESSION_HANDLE xSession,
-                                  CK_OBJECT_HANDLE_PTR xPrivateKeyHandlePtr,
-                                  CK_OBJECT_HANDLE_PTR xPublicKeyHandlePtr );
+/**
+ * @brief Size of buffer large enough for the DER encoded device private or public key.
+ */
+#define CLOUD_PROV_DEVICE_KEY_DER_SIZE  (256u)
 
+/**
+ * @brief corePKCS11 labels of the device key pair generated ahead of provisioning. It is kept apart from the TLS
+ *        credentials, still used by the claim or the current device credentials, until provisioning commits it.
+ */
+#define CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY    "Pending Priv Key"
+#define CLOUD_PROV_LABEL_PENDING_PUBLIC_KEY     "Pending Pub Key"
+
+/**
+ * @brief Usage counters of the mbedTLS RNG pool implemented in mbedtls_rng_pkcs11.c
+ */
+typedef struct
+{
+    uint32_t ulRequests;        /* Random requests issued by mbedTLS */
+    uint32_t ulRequestedBytes;  /* Random bytes requested by mbedTLS */
+    uint32_t ulPoolRefills;     /* CTR-DRBG generate calls done to refill the pool */
+    uint32_t ulEntropyCalls;    /* C_GenerateRandom calls done to seed/reseed the CTR-DRBG */
+    uint32_t ulEntropyBytes;    /* Random bytes drawn from C_GenerateRandom */
+} RngPoolStats_t;
+
+/**
+ * @brief mbedTLS RNG callback served from a CTR-DRBG pool seeded by the PKCS #11 module.
+ * @param[in] pvCtx Unused, the pool opens its own PKCS #11 session to draw entropy from.
+ */
+int lMbedCryptoRngCallbackPool( void * pvCtx,
+                                unsigned char * pucOutput,
+                                size_t uxLen );
+
+void vMbedCryptoRngPoolGetStats( RngPoolStats_t * pxStats );
+
+/**
+ * @brief Call mbedtls_platform_setup once, whichever task needs the crypto hardware first.
+ */
+void CloudProv_CryptoPlatformSetup(void);
+
+/**
+ * @brief Start generating the device key pair into corePKCS11, under the pending labels, in a low priority background
+ *        task with its own PKCS #11 session, so that provisioning only has to sign the CSR. Does nothing if a key pair
+ *        is already pending, or in CreateKeysAndCertificate provisioning mode.
+ */
+void CloudProv_PregenerateDeviceKey(void);
+
+/**
+ * @brief Wait for a key pair pre-generation in progress to be done. Called once the network is up, before any TLS
+ *        handshake or littleFS access, and before handing the flash over to the boot menu, so that the generation
+ *        never shares the crypto engine or littleFS with them.
+ */
+void CloudProv_DeviceKeyWait(void);
+
+/**
+ * @brief Destroy the pending key pair, if any, once it is known provisioning will not need it. A generation in
+ *        progress is waited for and its key pair destroyed.
+ */
+void CloudProv_DiscardPendingKey(CK_SESSION_HANDLE xP11Session);
+
+/**
+ * @brief Make the pending device key pair available for CloudProv_GenerateCsr, waiting for the pre-generation or
+ *        generating it now if none was started.
+ * @return true if a device key pair is pending in corePKCS11.
+ */
+bool CloudProv_DeviceKeyPrepare(CK_SESSION_HANDLE xP11Session);
+
+/**
+ * @brief Use the key pair left pending in corePKCS11 by an interrupted provisioning instead of generating a new one.
+ * @return true if a device key pair is pending in corePKCS11.
+ */
+bool CloudProv_DeviceKeyRestore(CK_SESSION_HANDLE xP11Session);
+
+/**
+ * @brief Move the pending key pair under the TLS key labels, replacing the claim key pair, then destroy the pending
+ *        objects. The private key never leaves the PKCS #11 storage layer.
+ * @return true if moved.
+ */
+bool CloudProv_DeviceKeyCommit(CK_SESSION_HANDLE xP11Session);
+
+/**
+ * @brief Generate a Certificate Signing Request signed with the device key pair made ready by
+ *        CloudProv_DeviceKeyPrepare or CloudProv_DeviceKeyRestore.
+ */
 bool CloudProv_GenerateCsr(CK_SESSION_HANDLE xP11Session,
                            uint8_t * pcCsrBuffer,
                            size_t xCsrBufferLength,
                            size_t * pxOutCsrLength );
 
+/**
+ * @brief Convert a PEM certificate to DER.
+ * @param[in] pcCertificate PEM certificate, not necessarily null terminated.
+ * @param[out] pucDerBuffer Buffer receiving the DER certificate.
+ * @param[in, out] pxDerLength Size of pucDerBuffer on input, length of the DER certificate on output.
+ * @return true if converted.
+ */
+bool CloudProv_CertificateToDer(const char * pcCertificate,
+                                size_t xCertificateLength,
+                                uint8_t * pucDerBuffer,
+                                size_t * pxDerLength );
+
+/**
+ * @brief Store a DER certificate into corePKCS11 under the TLS certificate label.
+ */
 bool CloudProv_LoadCertificate(CK_SESSION_HANDLE xP11Session,
-                               const char * pcCertificate,
+                               const uint8_t * pucCertificate,
                                size_t xCertificateLength );
 
+/**
+ * @brief Drop the RAM copies of the TLS client certificate and private key, forcing the next TLS connection to
+ *        read them back from corePKCS11 storage.
+ */
+void CloudProv_CredentialCacheInvalidate(void);
+
+/**
+ * @brief Scrub and free the RAM copy of the TLS private key. Called after every connection attempt, so that the key
+ *        is only held in plaintext while a handshake needs it.
+ */
+void CloudProv_CredentialCacheWipeKey(void);
+
+/**
+ * @brief Parse the TLS client certificate once, called from the mbedtls_x509_crt_parse wrap of cloud_prov_ca_cache.c.
+ * @details A buffer holding the cached client certificate is parsed into a chain kept across connections, chain
+ *          itself is left empty and swapped for the kept one by the mbedtls_ssl_conf_own_cert wrap.
+ * @param[out] pMbedtlsRet Result of the parse, only set when buf is the client certificate.
+ * @return true when buf is the cached client certificate, false to have the caller parse it.
+ */
+bool CloudProv_CredentialCacheParseCert(mbedtls_x509_crt *chain,
+                                        const unsigned char *buf,
+                                        size_t buflen,
+                                        int *pMbedtlsRet);
+
+/**
+ * @brief Copy the pending key pair objects under the TLS key labels, at the PKCS #11 PAL level since corePKCS11 does
+ *        not export private keys. The pending objects are left in place for the caller to destroy.
+ * @return true if the pending private key was copied.
+ */
+bool CloudProv_CredentialPendingKeyPromote(void);
+
 #endif /*CLOUD_PROV_PKCS11_H*/
@@ -0,0 +1,483 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_pkcs11_cache.c
+ * @brief RAM cache of the TLS client credentials stored by corePKCS11 in littleFS, and storage of the pending device
+ *        key pair objects.
+ *
+ * @details The TLS transport resolves the client certificate and private key by label through corePKCS11 on every
+ *          connection, which reads both objects back from littleFS each time, then parses the certificate. The
+ *          corePKCS11 PAL functions are wrapped at link time (-Wl,--wrap) so that the certificate is read from flash
+ *          and parsed once, then served from RAM on reconnects: the mbedtls_x509_crt_parse wrap of
+ *          cloud_prov_ca_cache.c hands the client certificate to CloudProv_CredentialCacheParseCert and the
+ *          mbedtls_ssl_conf_own_cert wrap configures the kept chain. The private key is only kept for the duration
+ *          of one connection attempt, where corePKCS11 reads it twice (key type, then signature), and is scrubbed
+ *          by CloudProv_CredentialCacheWipeKey afterwards. Any write or destroy of a PKCS #11 object invalidates its
+ *          cache entry, which covers CloudProv_LoadCertificate, xProvisionCertificate, xProvisionPrivateKey, key
+ *          generation and xDestroyDefaultCryptoObjects.
+ *
+ *          The littleFS PAL only knows the fixed TLS, code verification and root labels. The same wraps serve the
+ *          CLOUD_PROV_LABEL_PENDING_* objects of the key pair generated ahead of provisioning from their own littleFS
+ *          files, stored like the PAL stores every other object, so that it lives in corePKCS11 next to the claim
+ *          credentials until provisioning commits it.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <cloud_prov_pkcs11.h>
+#include <cloud_prov_storage.h>
+#include <console.h>
+#include "core_pkcs11_config.h"
+#include "core_pkcs11_pal.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl.h"
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+#define CLOUD_PROV_P11_CACHE_ENTRY_COUNT    (2u)
+#define CLOUD_PROV_P11_CACHE_CERT           (0u)
+#define CLOUD_PROV_P11_CACHE_KEY            (1u)
+
+#define CLOUD_PROV_P11_PENDING_COUNT        (2u)
+
+/** @brief Handle of the first pending object, well above the handles of the fixed labels of the littleFS PAL */
+#define CLOUD_PROV_P11_PENDING_HANDLE_FIRST ((CK_OBJECT_HANDLE)0x100u)
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+typedef struct
+{
+    const char *label;
+    CK_OBJECT_HANDLE handle;
+    CK_BYTE_PTR data;
+    CK_ULONG dataSize;
+    CK_BBOOL isPrivate;
+}CloudProvP11CacheEntry_t;
+
+typedef struct
+{
+    const char *label;
+    const char *promotedLabel;      /* TLS label the object takes when provisioning commits it */
+    const char *fileName;
+    CK_BBOOL isPrivate;
+    CK_BYTE_PTR value;              /* Value handed out by PKCS11_PAL_GetObjectValue, until its cleanup */
+}CloudProvP11PendingObject_t;
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Cached objects. Only the objects resolved on every TLS connection are worth caching */
+static CloudProvP11CacheEntry_t CloudProvP11Cache[CLOUD_PROV_P11_CACHE_ENTRY_COUNT] =
+        {
+            { pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS, CK_INVALID_HANDLE, NULL, 0u, CK_FALSE },
+            { pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS, CK_INVALID_HANDLE, NULL, 0u, CK_FALSE },
+        };
+
+/** @brief Pending device key pair objects, the handle of each is CLOUD_PROV_P11_PENDING_HANDLE_FIRST + index */
+static CloudProvP11PendingObject_t CloudProvP11Pending[CLOUD_PROV_P11_PENDING_COUNT] =
+        {
+            { CLOUD_PROV_LABEL_PENDING_PRIVATE_KEY, pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS, "cp_p11_pend_key",
+              CK_TRUE, NULL },
+            { CLOUD_PROV_LABEL_PENDING_PUBLIC_KEY, pkcs11configLABEL_DEVICE_PUBLIC_KEY_FOR_TLS, "cp_p11_pend_pub",
+              CK_FALSE, NULL },
+        };
+
+/** @brief Client certificate parsed from the cached DER, kept across connections */
+static mbedtls_x509_crt CloudProvP11CacheCert;
+
+/** @brief Set while CloudProvP11CacheCert holds the parse of the cached certificate */
+static bool CloudProvP11CacheCertParsed = false;
+
+/** @brief Set when the certificate was replaced while CloudProvP11CacheCert may still be configured in the live
+ *         connection. It is freed at the next client certificate parse, TLS connections being made one at a time */
+static bool CloudProvP11CacheCertRetired = false;
+
+/** @brief Chain left empty by the last skipped parse, to be swapped for CloudProvP11CacheCert when configured */
+static const mbedtls_x509_crt *CloudProvP11CacheSkippedCert = NULL;
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+CK_OBJECT_HANDLE __real_PKCS11_PAL_FindObject(CK_BYTE_PTR pxLabel, CK_ULONG usLength);
+CK_RV __real_PKCS11_PAL_GetObjectValue(CK_OBJECT_HANDLE xHandle,
+                                       CK_BYTE_PTR *ppucData,
+                                       CK_ULONG_PTR pulDataSize,
+                                       CK_BBOOL *pIsPrivate);
+void __real_PKCS11_PAL_GetObjectValueCleanup(CK_BYTE_PTR pucData, CK_ULONG ulDataSize);
+CK_OBJECT_HANDLE __real_PKCS11_PAL_SaveObject(CK_ATTRIBUTE_PTR pxLabel, CK_BYTE_PTR pucData, CK_ULONG ulDataSize);
+CK_RV __real_PKCS11_PAL_DestroyObject(CK_OBJECT_HANDLE xHandle);
+CK_OBJECT_HANDLE __wrap_PKCS11_PAL_SaveObject(CK_ATTRIBUTE_PTR pxLabel, CK_BYTE_PTR pucData, CK_ULONG ulDataSize);
+int __real_mbedtls_ssl_conf_own_cert(mbedtls_ssl_config *conf,
+                                     mbedtls_x509_crt *own_cert,
+                                     mbedtls_pk_context *pk_key);
+
+/*************************************************************************************
+ * Local Functions
+ ************************************************************************************/
+static CloudProvP11CacheEntry_t * CloudProv_P11CacheFindLabel(const char *label, size_t labelLength)
+{
+    CloudProvP11CacheEntry_t *entry = NULL;
+
+    for(uint8_t index = 0u; index < CLOUD_PROV_P11_CACHE_ENTRY_COUNT; index++)
+    {
+        if((strlen(CloudProvP11Cache[index].label) == labelLength) &&
+           (0 == strncmp(CloudProvP11Cache[index].label, label, labelLength)))
+        {
+            entry = &CloudProvP11Cache[index];
+        }
+    }
+    return entry;
+}
+
+static CloudProvP11CacheEntry_t * CloudProv_P11CacheFindHandle(CK_OBJECT_HANDLE handle)
+{
+    CloudProvP11CacheEntry_t *entry = NULL;
+
+    for(uint8_t index = 0u; (index < CLOUD_PROV_P11_CACHE_ENTRY_COUNT) && (handle != CK_INVALID_HANDLE); index++)
+    {
+        if(CloudProvP11Cache[index].handle == handle)
+        {
+            entry = &CloudProvP11Cache[index];
+        }
+    }
+    return entry;
+}
+
+static void CloudProv_P11CacheDropData(CloudProvP11CacheEntry_t *entry)
+{
+    if(entry->data != NULL)
+    {
+        /* Private key material is scrubbed before being returned to the heap */
+        mbedtls_platform_zeroize(entry->data, entry->dataSize);
+        vPortFree(entry->data);
+    }
+    entry->data = NULL;
+    entry->dataSize = 0u;
+    entry->isPrivate = CK_FALSE;
+}
+
+static void CloudProv_P11CacheDrop(CloudProvP11CacheEntry_t *entry)
+{
+    CloudProv_P11CacheDropData(entry);
+    entry->handle = CK_INVALID_HANDLE;
+
+    if((entry == &CloudProvP11Cache[CLOUD_PROV_P11_CACHE_CERT]) && (CloudProvP11CacheCertParsed == true))
+    {
+        /* The live connection may still refer to the parsed certificate, it is freed at the next parse */
+        CloudProvP11CacheCertParsed = false;
+        CloudProvP11CacheCertRetired = true;
+    }
+}
+
+static CK_OBJECT_HANDLE CloudProv_P11PendingFindLabel(const char *label, size_t labelLength)
+{
+    CK_OBJECT_HANDLE handle = CK_INVALID_HANDLE;
+
+    for(uint8_t index = 0u; index < CLOUD_PROV_P11_PENDING_COUNT; index++)
+    {
+        if((strlen(CloudProvP11Pending[index].label) == labelLength) &&
+           (0 == strncmp(CloudProvP11Pending[index].label, label, labelLength)))
+        {
+            handle = CLOUD_PROV_P11_PENDING_HANDLE_FIRST + index;
+        }
+    }
+    return handle;
+}
+
+static CloudProvP11PendingObject_t * CloudProv_P11PendingFindHandle(CK_OBJECT_HANDLE handle)
+{
+    CloudProvP11PendingObject_t *object = NULL;
+
+    if((handle >= CLOUD_PROV_P11_PENDING_HANDLE_FIRST) &&
+       (handle < (CLOUD_PROV_P11_PENDING_HANDLE_FIRST + CLOUD_PROV_P11_PENDING_COUNT)))
+    {
+        object = &CloudProvP11Pending[handle - CLOUD_PROV_P11_PENDING_HANDLE_FIRST];
+    }
+    return object;
+}
+
+/**
+ * @brief Read a pending object from its littleFS file.
+ * @return LFS_ERR_OK if read, a negative littleFS error code otherwise, LFS_ERR_NOENT if the object does not exist.
+ */
+static int CloudProv_P11PendingRead(const CloudProvP11PendingObject_t *object, uint8_t *derBuffer, size_t *derLength)
+{
+    return CloudProv_StorageRead(object->fileName, derBuffer, CLOUD_PROV_DEVICE_KEY_DER_SIZE, derLength);
+}
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+bool CloudProv_CredentialPendingKeyPromote(void)
+{
+    uint8_t derBuffer[CLOUD_PROV_DEVICE_KEY_DER_SIZE];
+    CK_ATTRIBUTE label = { CKA_LABEL, NULL, 0u };
+    size_t derLength = 0u;
+    bool status = true;
+
+    for(uint8_t index = 0u; (index < CLOUD_PROV_P11_PENDING_COUNT) && (status == true); index++)
+    {
+        if(CloudProv_P11PendingRead(&CloudProvP11Pending[index], derBuffer, &derLength) == LFS_ERR_OK)
+        {
+            /* Through the wrap, so that the cache entry of the TLS label is dropped */
+            label.pValue = (CK_VOID_PTR)CloudProvP11Pending[index].promotedLabel;
+            label.ulValueLen = strlen(CloudProvP11Pending[index].promotedLabel);
+            status = (__wrap_PKCS11_PAL_SaveObject(&label, derBuffer, derLength) != CK_INVALID_HANDLE);
+        }
+        else
+        {
+            /* The public key is not needed by the TLS transport, only the private key is mandatory */
+            status = (CloudProvP11Pending[index].isPrivate == CK_FALSE);
+        }
+    }
+    mbedtls_platform_zeroize(derBuffer, sizeof(derBuffer));
+
+    return status;
+}
+
+void CloudProv_CredentialCacheInvalidate(void)
+{
+    for(uint8_t index = 0u; index < CLOUD_PROV_P11_CACHE_ENTRY_COUNT; index++)
+    {
+        CloudProv_P11CacheDrop(&CloudProvP11Cache[index]);
+    }
+}
+
+void CloudProv_CredentialCacheWipeKey(void)
+{
+    /* The handle is kept, it says nothing about the key */
+    CloudProv_P11CacheDropData(&CloudProvP11Cache[CLOUD_PROV_P11_CACHE_KEY]);
+}
+
+bool CloudProv_CredentialCacheParseCert(mbedtls_x509_crt *chain,
+                                        const unsigned char *buf,
+                                        size_t buflen,
+                                        int *pMbedtlsRet)
+{
+    CloudProvP11CacheEntry_t *entry = &CloudProvP11Cache[CLOUD_PROV_P11_CACHE_CERT];
+    bool clientCert = false;
+
+    /* The transport parses the DER it just read through corePKCS11, that is the cached object itself */
+    if((entry->data != NULL) && (entry->dataSize == buflen) && (chain->version == 0) &&
+       (0 == memcmp(entry->data, buf, buflen)))
+    {
+        clientCert = true;
+        *pMbedtlsRet = 0;
+
+        if(CloudProvP11CacheCertRetired == true)
+        {
+            /* A new connection is being set up, the one using the replaced certificate is over */
+            mbedtls_x509_crt_free(&CloudProvP11CacheCert);
+            CloudProvP11CacheCertRetired = false;
+        }
+
+        if(CloudProvP11CacheCertParsed == false)
+        {
+            mbedtls_x509_crt_init(&CloudProvP11CacheCert);
+            *pMbedtlsRet = mbedtls_x509_crt_parse_der(&CloudProvP11CacheCert, buf, buflen);
+            if(*pMbedtlsRet == 0)
+            {
+                CloudProvP11CacheCertParsed = true;
+            }
+            else
+            {
+                /* Never configured, nothing refers to it */
+                mbedtls_x509_crt_free(&CloudProvP11CacheCert);
+            }
+        }
+
+        if(*pMbedtlsRet == 0)
+        {
+            /* The transport chain stays empty until mbedtls_ssl_conf_own_cert */
+            CloudProvP11CacheSkippedCert = chain;
+        }
+    }
+
+    return clientCert;
+}
+
+int __wrap_mbedtls_ssl_conf_own_cert(mbedtls_ssl_config *conf,
+                                     mbedtls_x509_crt *own_cert,
+                                     mbedtls_pk_context *pk_key)
+{
+    if((own_cert != NULL) && (own_cert == CloudProvP11CacheSkippedCert))
+    {
+        /* The certificate of the transport is empty, hand over the cached one. It is never freed by the transport */
+        own_cert = &CloudProvP11CacheCert;
+        CloudProvP11CacheSkippedCert = NULL;
+    }
+    return __real_mbedtls_ssl_conf_own_cert(conf, own_cert, pk_key);
+}
+
+CK_OBJECT_HANDLE __wrap_PKCS11_PAL_FindObject(CK_BYTE_PTR pxLabel, CK_ULONG usLength)
+{
+    CloudProvP11CacheEntry_t *entry = CloudProv_P11CacheFindLabel((const char *)pxLabel, usLength);
+    CK_OBJECT_HANDLE handle = CloudProv_P11PendingFindLabel((const char *)pxLabel, usLength);
+    uint8_t derBuffer[CLOUD_PROV_DEVICE_KEY_DER_SIZE];
+    size_t derLength = 0u;
+
+    if(handle != CK_INVALID_HANDLE)
+    {
+        /* Pending object, found if its file exists */
+        if(CloudProv_P11PendingRead(CloudProv_P11PendingFindHandle(handle), derBuffer, &derLength) != LFS_ERR_OK)
+        {
+            handle = CK_INVALID_HANDLE;
+        }
+        mbedtls_platform_zeroize(derBuffer, derLength);
+    }
+    else if((entry != NULL) && (entry->handle != CK_INVALID_HANDLE))
+    {
+        handle = entry->handle;
+    }
+    else
+    {
+        handle = __real_PKCS11_PAL_FindObject(pxLabel, usLength);
+        if(entry != NULL)
+        {
+            entry->handle = handle;
+        }
+    }
+    return handle;
+}
+
+CK_RV __wrap_PKCS11_PAL_GetObjectValue(CK_OBJECT_HANDLE xHandle,
+                                       CK_BYTE_PTR *ppucData,
+                                       CK_ULONG_PTR pulDataSize,
+                                       CK_BBOOL *pIsPrivate)
+{
+    CloudProvP11CacheEntry_t *entry = CloudProv_P11CacheFindHandle(xHandle);
+    CloudProvP11PendingObject_t *object = CloudProv_P11PendingFindHandle(xHandle);
+    CK_RV xResult = CKR_OK;
+    size_t derLength = 0u;
+
+    if(object != NULL)
+    {
+        /* Pending object, read from its own file. Only one value of each is handed out at a time by corePKCS11 */
+        object->value = pvPortMalloc(CLOUD_PROV_DEVICE_KEY_DER_SIZE);
+        if(object->value == NULL)
+        {
+            xResult = CKR_HOST_MEMORY;
+        }
+        else if(CloudProv_P11PendingRead(object, object->value, &derLength) != LFS_ERR_OK)
+        {
+            vPortFree(object->value);
+            object->value = NULL;
+            xResult = CKR_OBJECT_HANDLE_INVALID;
+        }
+        else
+        {
+            *ppucData = object->value;
+            *pulDataSize = derLength;
+            *pIsPrivate = object->isPrivate;
+        }
+    }
+    else if((entry != NULL) && (entry->data != NULL))
+    {
+        *ppucData = entry->data;
+        *pulDataSize = entry->dataSize;
+        *pIsPrivate = entry->isPrivate;
+    }
+    else
+    {
+        xResult = __real_PKCS11_PAL_GetObjectValue(xHandle, ppucData, pulDataSize, pIsPrivate);
+
+        if((xResult == CKR_OK) && (entry != NULL))
+        {
+            /* Keep a copy of the object so that next reads do not go to flash again, until the end of the
+             * connection attempt for the private key. If heap is too low, the object is simply not cached */
+            entry->data = pvPortMalloc(*pulDataSize);
+            if(entry->data != NULL)
+            {
+                memcpy(entry->data, *ppucData, *pulDataSize);
+                entry->dataSize = *pulDataSize;
+                entry->isPrivate = *pIsPrivate;
+                __real_PKCS11_PAL_GetObjectValueCleanup(*ppucData, *pulDataSize);
+                *ppucData = entry->data;
+            }
+        }
+    }
+    return xResult;
+}
+
+void __wrap_PKCS11_PAL_GetObjectValueCleanup(CK_BYTE_PTR pucData, CK_ULONG ulDataSize)
+{
+    bool cached = false;
+
+    for(uint8_t index = 0u; index < CLOUD_PROV_P11_CACHE_ENTRY_COUNT; index++)
+    {
+        if((pucData != NULL) && (CloudProvP11Cache[index].data == pucData))
+        {
+            cached = true;
+        }
+    }
+    for(uint8_t index = 0u; index < CLOUD_PROV_P11_PENDING_COUNT; index++)
+    {
+        if((pucData != NULL) && (CloudProvP11Pending[index].value == pucData))
+        {
+            /* Pending objects are read for each use, the private key is scrubbed before being returned to the heap */
+            mbedtls_platform_zeroize(pucData, ulDataSize);
+            vPortFree(pucData);
+            CloudProvP11Pending[index].value = NULL;
+            cached = true;
+        }
+    }
+
+    /* Cached objects stay alive until invalidated */
+    if(cached == false)
+    {
+        __real_PKCS11_PAL_GetObjectValueCleanup(pucData, ulDataSize);
+    }
+}
+
+CK_OBJECT_HANDLE __wrap_PKCS11_PAL_SaveObject(CK_ATTRIBUTE_PTR pxLabel, CK_BYTE_PTR pucData, CK_ULONG ulDataSize)
+{
+    CloudProvP11CacheEntry_t *entry = CloudProv_P11CacheFindLabel((const char *)pxLabel->pValue,
+                                                                   pxLabel->ulValueLen);
+    CK_OBJECT_HANDLE handle = CloudProv_P11PendingFindLabel((const char *)pxLabel->pValue, pxLabel->ulValueLen);
+
+    if(handle != CK_INVALID_HANDLE)
+    {
+        if(CloudProv_StorageWrite(CloudProv_P11PendingFindHandle(handle)->fileName, pucData, ulDataSize)
+           != LFS_ERR_OK)
+        {
+            handle = CK_INVALID_HANDLE;
+        }
+    }
+    else
+    {
+        if(entry != NULL)
+        {
+            CloudProv_P11CacheDrop(entry);
+        }
+        handle = __real_PKCS11_PAL_SaveObject(pxLabel, pucData, ulDataSize);
+    }
+    return handle;
+}
+
+CK_RV __wrap_PKCS11_PAL_DestroyObject(CK_OBJECT_HANDLE xHandle)
+{
+    CloudProvP11CacheEntry_t *entry = CloudProv_P11CacheFindHandle(xHandle);
+    CloudProvP11PendingObject_t *object = CloudProv_P11PendingFindHandle(xHandle);
+    CK_RV xResult;
+
+    if(object != NULL)
+    {
+        xResult = (CloudProv_StorageRemove(object->fileName) == LFS_ERR_OK) ? CKR_OK : CKR_FUNCTION_FAILED;
+    }
+    else
+    {
+        if(entry != NULL)
+        {
+            CloudProv_P11CacheDrop(entry);
+        }
+        xResult = __real_PKCS11_PAL_DestroyObject(xHandle);
+    }
+    return xResult;
+}
@@ -38,11 +38,30 @@
  * DEFINE MACROS
  ************************************************************************************/
 
+/**
+ * @brief Encoding goes on after CborErrorOutOfMemory, which is how tinycbor counts the bytes of a payload measured
+ *        without buffer, see CloudProv_PublishStream.
+ */
+#define CLOUD_PROV_CBOR_CONTINUE( xCborRet )    ( ( ( xCborRet ) == CborNoError ) || \
+                                                  ( ( xCborRet ) == CborErrorOutOfMemory ) )
+
+/**
+ * @brief Max number of keys CloudProv_ExtractTextViews can look for in a map.
+ */
+#define CLOUD_PROV_CBOR_FIELD_MAX               ( 32u )
 
 /*************************************************************************************
  * Type Definitions
  ************************************************************************************/
 
+/**
+ * @brief Key wanted from a response map and where to point at its text string value.
+ */
+typedef struct
+{
+    const char * pcKey;
+    CloudProvCborView_t * pxView;
+}CloudProvCborField_t;
 
 /*************************************************************************************
  * Local Variables
@@ -53,141 +72,311 @@
  * Local Function Prototypes
  ************************************************************************************/
 
+/**
+ * @brief Point at a definite length text string in the parsed buffer, instead of copying it.
+ * @param[in] pxValue Text string item, left where it is.
+ * @param[out] pxView Text string, inside the buffer given to cbor_parser_init.
+ * @return CborNoError, CborErrorUnknownLength for a chunked string which is not contiguous in the buffer.
+ */
+static CborError CloudProv_GetTextView(const CborValue * pxValue,
+                                       CloudProvCborView_t * pxView );
+
+/**
+ * @brief Find the text string values of several keys in one walk of a map, instead of walking the map again from
+ * its start for every key.
+ * @param[in] pxMap Map to search.
+ * @param[in] pxFields Keys to find and their views, filled as the keys are met. Unknown keys are skipped.
+ * @param[in] xFieldCount Number of fields, up to #CLOUD_PROV_CBOR_FIELD_MAX.
+ * @param[in] pcApiName Fleet provisioning API the map is the response of, for error messages.
+ * @return CborNoError if every key is found with a definite length text string value.
+ */
+static CborError CloudProv_ExtractTextViews(const CborValue * pxMap,
+                                            const CloudProvCborField_t * pxFields,
+                                            size_t xFieldCount,
+                                            const char * pcApiName );
+
+/**
+ * @brief Parse a fleet provisioning response map and extract the text string values of pxFields from it.
+ */
+static bool CloudProv_DeserializeTextViews(const uint8_t * pucResponse,
+                                           size_t xLength,
+                                           const CloudProvCborField_t * pxFields,
+                                           size_t xFieldCount,
+                                           const char * pcApiName );
+
 /*************************************************************************************
  * Local Functions
  ************************************************************************************/
+static CborError CloudProv_GetTextView(const CborValue * pxValue,
+                                       CloudProvCborView_t * pxView )
+{
+    CborError xCborRet = CborErrorUnknownLength;
+    CborValue xString = *pxValue;
+
+    pxView->pData = NULL;
+    pxView->length = 0u;
+
+    /* A definite length string is a single chunk, got without copy. AWS IoT never sends a chunked one */
+    if( cbor_value_is_length_known( &xString ) )
+    {
+        xCborRet = cbor_value_begin_string_iteration( &xString );
+        if( xCborRet == CborNoError )
+        {
+            xCborRet = cbor_value_get_text_string_chunk( &xString, &pxView->pData, &pxView->length, &xString );
+        }
+        if( ( xCborRet == CborNoError ) && ( pxView->pData == NULL ) )
+        {
+            xCborRet = CborErrorUnexpectedEOF;
+        }
+    }
+
+    return xCborRet;
+}
+
+static CborError CloudProv_ExtractTextViews(const CborValue * pxMap,
+                                            const CloudProvCborField_t * pxFields,
+                                            size_t xFieldCount,
+                                            const char * pcApiName )
+{
+    CborError xCborRet;
+    CborValue xItem;
+    CloudProvCborView_t xKey;
+    uint32_t ulFoundMask = 0u;
+    size_t xField;
+    size_t xMatch;
+
+    configASSERT( xFieldCount <= CLOUD_PROV_CBOR_FIELD_MAX );
+
+    xCborRet = cbor_value_enter_container( pxMap, &xItem );
+
+    while( ( xCborRet == CborNoError ) && !cbor_value_at_end( &xItem ) )
+    {
+        xMatch = xFieldCount;
+
+        /* Keys are short text strings, compared in place. Any other key type cannot be one of the fields */
+        if( cbor_value_is_text_string( &xItem ) && ( CloudProv_GetTextView( &xItem, &xKey ) == CborNoError ) )
+        {
+            for( xField = 0u; ( xField < xFieldCount ) && ( xMatch == xFieldCount ); xField++ )
+            {
+                if( ( strlen( pxFields[ xField ].pcKey ) == xKey.length ) &&
+                    ( memcmp( pxFields[ xField ].pcKey, xKey.pData, xKey.length ) == 0 ) )
+                {
+                    xMatch = xField;
+                }
+            }
+        }
+
+        xCborRet = cbor_value_advance( &xItem );
+
+        if( ( xCborRet == CborNoError ) && cbor_value_at_end( &xItem ) )
+        {
+            LogError( ( "%s response map has a key without value.", pcApiName ) );
+            xCborRet = CborErrorUnexpectedEOF;
+        }
+        else if( ( xCborRet == CborNoError ) && ( xMatch < xFieldCount ) )
+        {
+            if( !cbor_value_is_text_string( &xItem ) )
+            {
+                LogError( ( "\"%s\" is an unexpected type in %s response.", pxFields[ xMatch ].pcKey, pcApiName ) );
+                xCborRet = CborErrorIllegalType;
+            }
+            else
+            {
+                xCborRet = CloudProv_GetTextView( &xItem, pxFields[ xMatch ].pxView );
+                if( xCborRet != CborNoError )
+                {
+                    LogError( ( "Failed to parse \"%s\" value from %s response: %s.", pxFields[ xMatch ].pcKey,
+                                pcApiName, cbor_error_string( xCborRet ) ) );
+                }
+            }
+            ulFoundMask |= ( 1uL << xMatch );
+        }
+        else
+        {
+            /* Value of a key that is not wanted, skipped below without being read */
+        }
+
+        if( xCborRet == CborNoError )
+        {
+            /* Strings are skipped by their length, the large values are never walked byte by byte */
+            xCborRet = cbor_value_advance( &xItem );
+        }
+    }
+
+    if( xCborRet != CborNoError )
+    {
+        LogError( ( "Error searching %s response: %s.", pcApiName, cbor_error_string( xCborRet ) ) );
+    }
+
+    for( xField = 0u; ( xField < xFieldCount ) && ( xCborRet == CborNoError ); xField++ )
+    {
+        if( ( ulFoundMask & ( 1uL << xField ) ) == 0u )
+        {
+            LogError( ( "\"%s\" not found in %s response.", pxFields[ xField ].pcKey, pcApiName ) );
+            xCborRet = CborErrorUnknownType;
+        }
+    }
+
+    return xCborRet;
+}
+
+static bool CloudProv_DeserializeTextViews(const uint8_t * pucResponse,
+                                           size_t xLength,
+                                           const CloudProvCborField_t * pxFields,
+                                           size_t xFieldCount,
+                                           const char * pcApiName )
+{
+    CborError xCborRet;
+    CborParser xParser;
+    CborValue xMap;
+
+    configASSERT( pucResponse != NULL );
+
+    xCborRet = cbor_parser_init( pucResponse, xLength, 0, &xParser, &xMap );
+
+    if( xCborRet != CborNoError )
+    {
+        LogError( ( "Error initializing parser for %s response: %s.", pcApiName, cbor_error_string( xCborRet ) ) );
+    }
+    else if( !cbor_value_is_map( &xMap ) )
+    {
+        LogError( ( "%s response is not a valid map container type.", pcApiName ) );
+        xCborRet = CborErrorIllegalType;
+    }
+    else
+    {
+        /* Certificates and keys are handed to mbedTLS and corePKCS11 as they are, text strings that are not valid
+         * UTF-8 are rejected first. Strings are mostly ASCII PEM, checked a word at a time by tinycbor */
+        xCborRet = cbor_value_validate( &xMap, CborValidateUtf8 );
+        if( xCborRet != CborNoError )
+        {
+            LogError( ( "%s response is not valid CBOR: %s.", pcApiName, cbor_error_string( xCborRet ) ) );
+        }
+        else
+        {
+            xCborRet = CloudProv_ExtractTextViews( &xMap, pxFields, xFieldCount, pcApiName );
+        }
+    }
+
+    return( xCborRet == CborNoError );
+}
 
 
 /*************************************************************************************
  * global functions
  ************************************************************************************/
 
-bool CloudProv_SerializeCsr(const uint8_t * csrBuffer,
-                            size_t csrLength,
-                            size_t payloadBufferSize,
-                            uint8_t * payloadBuffer,
-                            size_t * payloadLength )
+CborError CloudProv_EncodeCsrRequest(CborEncoder * pxEncoder, const void * pvRequest )
 {
-    CborEncoder xEncoder, xMapEncoder;
+    const CloudProvCsrRequest_t * pxRequest = ( const CloudProvCsrRequest_t * ) pvRequest;
+    CborEncoder xMapEncoder;
     CborError xCborRet;
 
-    configASSERT(payloadBuffer != NULL );
-    configASSERT(csrBuffer != NULL );
-    configASSERT(payloadLength != NULL );
+    configASSERT( pxRequest->pucCsr != NULL );
 
     /* For details on the CreateCertificatefromCsr request payload format, see:
      * https://docs.aws.amazon.com/iot/latest/developerguide/fleet-provision-api.html#create-cert-csr-request-payload
      */
-    cbor_encoder_init(&xEncoder, payloadBuffer, payloadBufferSize, 0 );
 
     /* The request document is a map with 1 key value pair. */
-    xCborRet = cbor_encoder_create_map( &xEncoder, &xMapEncoder, 1 );
+    xCborRet = cbor_encoder_create_map( pxEncoder, &xMapEncoder, 1 );
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         xCborRet = cbor_encode_text_stringz( &xMapEncoder, "certificateSigningRequest" );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
-        xCborRet = cbor_encode_text_string(&xMapEncoder, csrBuffer, csrLength );
+        xCborRet = cbor_encode_text_string( &xMapEncoder, ( const char * ) pxRequest->pucCsr, pxRequest->xCsrLength );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
-        xCborRet = cbor_encoder_close_container( &xEncoder, &xMapEncoder );
+        xCborRet = cbor_encoder_close_container( pxEncoder, &xMapEncoder );
     }
 
-    if( xCborRet == CborNoError )
-    {
-        *payloadLength = cbor_encoder_get_buffer_size(&xEncoder, ( uint8_t * ) payloadBuffer );
-    }
-    else
-    {
-        LogError( ( "Error during CBOR encoding: %s", cbor_error_string( xCborRet ) ) );
+    return xCborRet;
+}
+/*-----------------------------------------------------------*/
 
-        if( ( xCborRet & CborErrorOutOfMemory ) != 0 )
-        {
-            LogError( ( "Cannot fit CreateCertificateFromCsr request payload into buffer." ) );
-        }
+CborError CloudProv_EncodeCreateKeysRequest(CborEncoder * pxEncoder, const void * pvRequest )
+{
+    CborEncoder xMapEncoder;
+    CborError xCborRet;
+
+    ( void ) pvRequest;
+
+    /* For details on the CreateKeysAndCertificate request payload format, see:
+     * https://docs.aws.amazon.com/iot/latest/developerguide/fleet-provision-api.html#create-keys-cert-request-payload
+     */
+
+    /* The request document is an empty map. */
+    xCborRet = cbor_encoder_create_map( pxEncoder, &xMapEncoder, 0 );
+
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
+    {
+        xCborRet = cbor_encoder_close_container( pxEncoder, &xMapEncoder );
     }
 
-    return( xCborRet == CborNoError );
+    return xCborRet;
 }
 /*-----------------------------------------------------------*/
 
-CborError CloudProv_SerializeRegisterThingRequest(const char *certOwnershipToken,
-                                             size_t certOwnershipTokenLenght,
-                                             const char *serialNb,
-                                             size_t serialNbLenght,
-                                             size_t payloadBufferSize,
-                                             uint8_t *payloadBuffer,
-                                             size_t *payloadLength )
+CborError CloudProv_EncodeRegisterThingRequest(CborEncoder * pxEncoder, const void * pvRequest )
 {
-    CborEncoder xEncoder, xMapEncoder, xParametersEncoder;
+    const CloudProvRegisterThingRequest_t * pxRequest = ( const CloudProvRegisterThingRequest_t * ) pvRequest;
+    CborEncoder xMapEncoder, xParametersEncoder;
     CborError xCborRet;
 
-
     /* For details on the RegisterThing request payload format, see:
      * https://docs.aws.amazon.com/iot/latest/developerguide/fleet-provision-api.html#register-thing-request-payload
      */
-    cbor_encoder_init( &xEncoder, payloadBuffer, payloadBufferSize, 0 );
+
     /* The RegisterThing request payload is a map with two keys. */
-    xCborRet = cbor_encoder_create_map( &xEncoder, &xMapEncoder, 2 );
+    xCborRet = cbor_encoder_create_map( pxEncoder, &xMapEncoder, 2 );
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         xCborRet = cbor_encode_text_stringz( &xMapEncoder, "certificateOwnershipToken" );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
-        xCborRet = cbor_encode_text_string( &xMapEncoder, certOwnershipToken, certOwnershipTokenLenght );
+        xCborRet = cbor_encode_text_string( &xMapEncoder,
+                                            pxRequest->xOwnershipToken.pData,
+                                            pxRequest->xOwnershipToken.length );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         xCborRet = cbor_encode_text_stringz( &xMapEncoder, "parameters" );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         /* Parameters in this example is length 1. */
         xCborRet = cbor_encoder_create_map( &xMapEncoder, &xParametersEncoder, 1 );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         xCborRet = cbor_encode_text_stringz( &xParametersEncoder, "SerialNumber" );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
-        xCborRet = cbor_encode_text_string( &xParametersEncoder, serialNb, serialNbLenght );
+        xCborRet = cbor_encode_text_string( &xParametersEncoder, pxRequest->pcSerialNb, pxRequest->xSerialNbLength );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
         xCborRet = cbor_encoder_close_container( &xMapEncoder, &xParametersEncoder );
     }
 
-    if( xCborRet == CborNoError )
+    if( CLOUD_PROV_CBOR_CONTINUE( xCborRet ) )
     {
-        xCborRet = cbor_encoder_close_container( &xEncoder, &xMapEncoder );
-    }
-
-    if( xCborRet == CborNoError )
-    {
-        *payloadLength = cbor_encoder_get_buffer_size(&xEncoder, ( uint8_t * ) payloadBuffer );
-    }
-    else
-    {
-        LogError( ( "Error during CBOR encoding: %s", cbor_error_string( xCborRet ) ) );
-
-        if( ( xCborRet & CborErrorOutOfMemory ) != 0 )
-        {
-            LogError( ( "Cannot fit RegisterThing request payload into buffer." ) );
-        }
+        xCborRet = cbor_encoder_close_container( pxEncoder, &xMapEncoder );
     }
 
     return xCborRet;
@@ -196,140 +385,54 @@ CborError CloudProv_SerializeRegisterThingRequest(const char *certOwnershipToken
 
 bool CloudProv_DeserializeCsrResponse(const uint8_t * pucResponse,
                                       size_t xLength,
-                                      char * pcCertificateBuffer,
-                                      size_t * pxCertificateBufferLength,
-                                      char * pcCertificateIdBuffer,
-                                      size_t * pxCertificateIdBufferLength,
-                                      char * pcOwnershipTokenBuffer,
-                                      size_t * pxOwnershipTokenBufferLength )
+                                      CloudProvCborView_t * pxCertificate,
+                                      CloudProvCborView_t * pxCertificateId,
+                                      CloudProvCborView_t * pxOwnershipToken )
 {
-    CborError xCborRet;
-    CborParser xParser;
-    CborValue xMap;
-    CborValue xValue;
+    const CloudProvCborField_t xFields[] =
+    {
+        { "certificatePem", pxCertificate },
+        { "certificateId", pxCertificateId },
+        { "certificateOwnershipToken", pxOwnershipToken },
+    };
 
-    configASSERT( pucResponse != NULL );
-    configASSERT( pcCertificateBuffer != NULL );
-    configASSERT( pxCertificateBufferLength != NULL );
-    configASSERT( pcCertificateIdBuffer != NULL );
-    configASSERT( pxCertificateIdBufferLength != NULL );
-    configASSERT( *pxCertificateIdBufferLength >= 64 );
-    configASSERT( pcOwnershipTokenBuffer != NULL );
-    configASSERT( pxOwnershipTokenBufferLength != NULL );
+    configASSERT( pxCertificate != NULL );
+    configASSERT( pxCertificateId != NULL );
+    configASSERT( pxOwnershipToken != NULL );
 
     /* For details on the CreateCertificatefromCsr response payload format, see:
      * https://docs.aws.amazon.com/iot/latest/developerguide/fleet-provision-api.html#register-thing-response-payload
      */
-    xCborRet = cbor_parser_init( pucResponse, xLength, 0, &xParser, &xMap );
-
-    if( xCborRet != CborNoError )
-    {
-        LogError( ( "Error initializing parser for CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-    }
-    else if( !cbor_value_is_map( &xMap ) )
-    {
-        LogError( ( "CreateCertificateFromCsr response is not a valid map container type." ) );
-    }
-    else
-    {
-        xCborRet = cbor_value_map_find_value( &xMap, "certificatePem", &xValue );
-
-        if( xCborRet != CborNoError )
-        {
-            LogError( ( "Error searching CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-        }
-        else if( xValue.type == CborInvalidType )
-        {
-            LogError( ( "\"certificatePem\" not found in CreateCertificateFromCsr response." ) );
-        }
-        else if( xValue.type != CborTextStringType )
-        {
-            LogError( ( "Value for \"certificatePem\" key in CreateCertificateFromCsr response is not a text string type." ) );
-        }
-        else
-        {
-            xCborRet = cbor_value_copy_text_string( &xValue, pcCertificateBuffer, pxCertificateBufferLength, NULL );
-
-            if( xCborRet == CborErrorOutOfMemory )
-            {
-                size_t requiredLen = 0;
-                ( void ) cbor_value_calculate_string_length( &xValue, &requiredLen );
-                LogError( ( "Certificate buffer insufficiently large. Certificate length: %lu", ( unsigned long ) requiredLen ) );
-            }
-            else if( xCborRet != CborNoError )
-            {
-                LogError( ( "Failed to parse \"certificatePem\" value from CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-            }
-        }
-    }
-
-    if( xCborRet == CborNoError )
-    {
-        xCborRet = cbor_value_map_find_value( &xMap, "certificateId", &xValue );
-
-        if( xCborRet != CborNoError )
-        {
-            LogError( ( "Error searching CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-        }
-        else if( xValue.type == CborInvalidType )
-        {
-            LogError( ( "\"certificateId\" not found in CreateCertificateFromCsr response." ) );
-        }
-        else if( xValue.type != CborTextStringType )
-        {
-            LogError( ( "\"certificateId\" is an unexpected type in CreateCertificateFromCsr response." ) );
-        }
-        else
-        {
-            xCborRet = cbor_value_copy_text_string( &xValue, pcCertificateIdBuffer, pxCertificateIdBufferLength, NULL );
-
-            if( xCborRet == CborErrorOutOfMemory )
-            {
-                size_t requiredLen = 0;
-                ( void ) cbor_value_calculate_string_length( &xValue, &requiredLen );
-                LogError( ( "Certificate ID buffer insufficiently large. Certificate ID length: %lu", ( unsigned long ) requiredLen ) );
-            }
-            else if( xCborRet != CborNoError )
-            {
-                LogError( ( "Failed to parse \"certificateId\" value from CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-            }
-        }
-    }
+    return CloudProv_DeserializeTextViews( pucResponse, xLength, xFields, sizeof( xFields ) / sizeof( xFields[ 0 ] ),
+                                           "CreateCertificateFromCsr" );
+}
+/*-----------------------------------------------------------*/
 
-    if( xCborRet == CborNoError )
+bool CloudProv_DeserializeCreateKeysResponse(const uint8_t * pucResponse,
+                                             size_t xLength,
+                                             CloudProvCborView_t * pxCertificate,
+                                             CloudProvCborView_t * pxCertificateId,
+                                             CloudProvCborView_t * pxOwnershipToken,
+                                             CloudProvCborView_t * pxPrivateKey )
+{
+    const CloudProvCborField_t xFields[] =
     {
-        xCborRet = cbor_value_map_find_value( &xMap, "certificateOwnershipToken", &xValue );
-
-        if( xCborRet != CborNoError )
-        {
-            LogError( ( "Error searching CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-        }
-        else if( xValue.type == CborInvalidType )
-        {
-            LogError( ( "\"certificateOwnershipToken\" not found in CreateCertificateFromCsr response." ) );
-        }
-        else if( xValue.type != CborTextStringType )
-        {
-            LogError( ( "\"certificateOwnershipToken\" is an unexpected type in CreateCertificateFromCsr response." ) );
-        }
-        else
-        {
-            xCborRet = cbor_value_copy_text_string( &xValue, pcOwnershipTokenBuffer, pxOwnershipTokenBufferLength, NULL );
-
-            if( xCborRet == CborErrorOutOfMemory )
-            {
-                size_t requiredLen = 0;
-                ( void ) cbor_value_calculate_string_length( &xValue, &requiredLen );
-                LogError( ( "Certificate ownership token buffer insufficiently large. Certificate ownership token buffer length: %lu", ( unsigned long ) requiredLen ) );
-            }
-            else if( xCborRet != CborNoError )
-            {
-                LogError( ( "Failed to parse \"certificateOwnershipToken\" value from CreateCertificateFromCsr response: %s.", cbor_error_string( xCborRet ) ) );
-            }
-        }
-    }
-
-    return( xCborRet == CborNoError );
+        { "certificatePem", pxCertificate },
+        { "certificateId", pxCertificateId },
+        { "certificateOwnershipToken", pxOwnershipToken },
+        { "privateKey", pxPrivateKey },
+    };
+
+    configASSERT( pxCertificate != NULL );
+    configASSERT( pxCertificateId != NULL );
+    configASSERT( pxOwnershipToken != NULL );
+    configASSERT( pxPrivateKey != NULL );
+
+    /* For details on the CreateKeysAndCertificate response payload format, see:
+     * https://docs.aws.amazon.com/iot/latest/developerguide/fleet-provision-api.html#create-keys-cert-response-payload
+     * It is the CreateCertificateFromCsr response plus the private key */
+    return CloudProv_DeserializeTextViews( pucResponse, xLength, xFields, sizeof( xFields ) / sizeof( xFields[ 0 ] ),
+                                           "CreateKeysAndCertificate" );
 }
 /*-----------------------------------------------------------*/
 
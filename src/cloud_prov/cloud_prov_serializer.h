@@ -13,53 +13,91 @@
 #include <stdbool.h>
 #include <cbor.h>
 
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+
+/**
+ * @brief Text string of a parsed CBOR document, pointing inside the parsed buffer. Not null terminated.
+ */
+typedef struct
+{
+    const char *pData;
+    size_t length;
+}CloudProvCborView_t;
+
+/**
+ * @brief Request payload encoder. Called once to measure the payload and once to stream it, so it must encode the
+ *        same bytes both times.
+ */
+typedef CborError (*CloudProvCborEncode_t)(CborEncoder *encoder, const void *request);
+
+/**
+ * @brief CreateCertificateFromCsr request.
+ */
+typedef struct
+{
+    const uint8_t *pucCsr;
+    size_t xCsrLength;
+}CloudProvCsrRequest_t;
+
+/**
+ * @brief RegisterThing request. The ownership token may point inside the MQTT buffer, which the request is
+ *        encoded from while the publish is sent, see CloudProv_PublishStream.
+ */
+typedef struct
+{
+    CloudProvCborView_t xOwnershipToken;
+    const char *pcSerialNb;
+    size_t xSerialNbLength;
+}CloudProvRegisterThingRequest_t;
+
 /*************************************************************************************
  *                             GLOBAL FUNCTION PROTOTYPES
  ************************************************************************************/
+/**
+ * @brief Parse the CreateCertificateFromCsr response without copying its strings. The views point inside
+ * pucResponse, thus inside the MQTT buffer, and are only valid until the next MQTT API call reuses it.
+ */
 bool CloudProv_DeserializeCsrResponse(const uint8_t * pucResponse,
                                       size_t xLength,
-                                      char * pcCertificateBuffer,
-                                      size_t * pxCertificateBufferLength,
-                                      char * pcCertificateIdBuffer,
-                                      size_t * pxCertificateIdBufferLength,
-                                      char * pcOwnershipTokenBuffer,
-                                      size_t * pxOwnershipTokenBufferLength );
+                                      CloudProvCborView_t * pxCertificate,
+                                      CloudProvCborView_t * pxCertificateId,
+                                      CloudProvCborView_t * pxOwnershipToken );
+
+/**
+ * @brief Parse the CreateKeysAndCertificate response, which is the CreateCertificateFromCsr response plus the
+ * PEM encoded private key generated by AWS IoT. Same view lifetime as CloudProv_DeserializeCsrResponse.
+ */
+bool CloudProv_DeserializeCreateKeysResponse(const uint8_t * pucResponse,
+                                             size_t xLength,
+                                             CloudProvCborView_t * pxCertificate,
+                                             CloudProvCborView_t * pxCertificateId,
+                                             CloudProvCborView_t * pxOwnershipToken,
+                                             CloudProvCborView_t * pxPrivateKey );
+
+/**
+ * @brief Encodes the CreateCertificateFromCsr request payload.
+ * @param[in] pxEncoder Encoder to write the payload to, with or without buffer.
+ * @param[in] pvRequest CloudProvCsrRequest_t holding the PEM encoded CSR.
+ * @return Last tinycbor status, CborErrorOutOfMemory when pxEncoder only measures the payload.
+ */
+CborError CloudProv_EncodeCsrRequest(CborEncoder * pxEncoder, const void * pvRequest );
 
 /**
- * @brief Creates the request payload to be published to the
- * CreateCertificateFromCsr API in order to request a certificate from AWS IoT
- * for the included Certificate Signing Request (CSR).
- * @param[in] csrBuffer The CSR to include in the request payload.
- * @param[in] csrLength The length of #csrBuffer.
- * @param[in] payloadBufferSize Length of #payloadBuffer.
- * @param[out] payloadBuffer Buffer into which to write the publish request payload.
- * @param[out] payloadLength The length of the publish request payload.
+ * @brief Encodes the CreateKeysAndCertificate request payload, an empty map.
+ * @param[in] pxEncoder Encoder to write the payload to, with or without buffer.
+ * @param[in] pvRequest Unused, the request has no parameter.
  */
-bool CloudProv_SerializeCsr(const uint8_t * csrBuffer,
-                            size_t csrLength,
-                            size_t payloadBufferSize,
-                            uint8_t * payloadBuffer,
-                            size_t * payloadLength );
+CborError CloudProv_EncodeCreateKeysRequest(CborEncoder * pxEncoder, const void * pvRequest );
 
 /**
- * @brief Creates the request payload to be published to the RegisterThing API
- * in order to activate the provisioned certificate and receive a Thing name.
- *
- * @param[in] certOwnershipToken The certificate's certificate ownership token.
- * @param[in] certOwnershipTokenLenght Length of #certificateOwnershipToken.
- * @param[in] serialNb Device serial number
- * @param[in] serialNbLenght lenght of serial number string
- * @param[in] payloadBufferSize Length of #buffer.
- * @param[out] payloadBuffer Buffer into which to write the publish request payload.
- * @param[out] payloadLength The length of the publish request payload.
+ * @brief Encodes the RegisterThing request payload, in order to activate the provisioned certificate and receive a
+ * Thing name.
+ * @param[in] pxEncoder Encoder to write the payload to, with or without buffer.
+ * @param[in] pvRequest CloudProvRegisterThingRequest_t holding the ownership token and device serial number.
  */
-CborError CloudProv_SerializeRegisterThingRequest(const char *certOwnershipToken,
-                                             size_t certOwnershipTokenLenght,
-                                             const char *serialNb,
-                                             size_t serialNbLenght,
-                                             size_t payloadBufferSize,
-                                             uint8_t *payloadBuffer,
-                                             size_t *payloadLength );
+CborError CloudProv_EncodeRegisterThingRequest(CborEncoder * pxEncoder, const void * pvRequest );
 
 CborError CloudProv_DeserializeThingName(const uint8_t * pucResponse,
                                          size_t xLength,
@@ -0,0 +1,314 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_session.c
+ * @brief Unacknowledged QoS1 publishes, saved in littleFS so they survive a reset.
+ *
+ * @details coreMQTT only keeps packet identifiers and states of in-flight publishes, in RAM. Publishes tracked here
+ *          are copied in RAM and saved in a single littleFS file, bounded by CLOUD_PROV_SESSION_PERSIST_MAX_SIZE,
+ *          before being sent, so a watchdog reset or a power cycle does not lose them. They are released when their
+ *          PUBACK is received, and the file is removed once none is left in flight. After a reboot, they are loaded
+ *          and resent by CloudProv_ConnectMQTT, the file is kept until they are acknowledged.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_session.h>
+#include <cloud_prov_config.h>
+#include <cloud_prov_storage.h>
+#include <console.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+#define CLOUD_PROV_SESSION_RECORD_MAGIC     (0x51534553u)
+
+/**
+ * @brief Max size of a tracked publish, header included. A publish never holds more than the MQTT buffer.
+ */
+#define CLOUD_PROV_SESSION_RECORD_MAX_SIZE  (sizeof(CloudProvSessionRecord_t) + CLOUD_PROV_MQTT_BUFFER_SIZE)
+
+/** @brief littleFS file holding the publishes saved on a lost connection, one record after the other */
+#define CLOUD_PROV_SESSION_FILE_NAME        "cp_pub"
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+
+/**
+ * @brief Header of a tracked publish, followed by topic name then payload, in RAM and in littleFS.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;          /**< Increments with each tracked publish, the latest one holds the packet id counter */
+    uint16_t packetId;
+    uint16_t nextPacketId;      /**< Packet identifier counter of the MQTT context when the publish was tracked */
+    uint16_t topicNameLength;
+    uint16_t payloadLength;
+}CloudProvSessionRecord_t;
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Tracked publishes, NULL for free slots */
+static CloudProvSessionRecord_t *CloudProvSessionSlots[CLOUD_PROV_SESSION_INFLIGHT_MAX] = { NULL };
+static uint32_t CloudProvSessionSequence = 0u;
+static uint16_t CloudProvSessionNextPacketId = 0u;
+static bool CloudProvSessionLoaded = false;
+
+/** @brief Set when tracked publishes changed since they were last saved in littleFS */
+static bool CloudProvSessionChanged = false;
+
+/** @brief Set while CLOUD_PROV_SESSION_FILE_NAME may exist in littleFS */
+static bool CloudProvSessionFileSaved = true;
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+static size_t CloudProv_SessionRecordSize(const CloudProvSessionRecord_t *record);
+
+/*************************************************************************************
+ * Local Functions
+ ************************************************************************************/
+static size_t CloudProv_SessionRecordSize(const CloudProvSessionRecord_t *record)
+{
+    return sizeof(CloudProvSessionRecord_t) + record->topicNameLength + record->payloadLength;
+}
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+void CloudProv_SessionLoad(void)
+{
+    CloudProvSessionRecord_t header;
+    size_t recordSize;
+    uint8_t *readBuffer = NULL;
+    size_t readLength = 0u;
+    size_t position = 0u;
+    uint32_t latestSequence = 0u;
+    uint8_t restored = 0u;
+    uint8_t slot = 0u;
+    bool firstLoad = (CloudProvSessionLoaded == false);
+
+    if(firstLoad == true)
+    {
+        CloudProvSessionLoaded = true;
+        readBuffer = pvPortMalloc(CLOUD_PROV_SESSION_PERSIST_MAX_SIZE);
+        if(readBuffer == NULL)
+        {
+            APP_WARN_PRINT("Not enough heap to load saved MQTT publishes\r\n");
+        }
+        else if(CloudProv_StorageRead(CLOUD_PROV_SESSION_FILE_NAME, readBuffer, CLOUD_PROV_SESSION_PERSIST_MAX_SIZE,
+                                      &readLength) != LFS_ERR_OK)
+        {
+            readLength = 0u;
+        }
+    }
+
+    while((position + sizeof(CloudProvSessionRecord_t)) <= readLength)
+    {
+        /* Records follow each other unaligned in the file */
+        memcpy(&header, &readBuffer[position], sizeof(header));
+        recordSize = CloudProv_SessionRecordSize(&header);
+        if((header.magic != CLOUD_PROV_SESSION_RECORD_MAGIC) || ((position + recordSize) > readLength) ||
+           (slot >= CLOUD_PROV_SESSION_INFLIGHT_MAX))
+        {
+            /* Torn or foreign content, nothing more can be resent from it */
+            break;
+        }
+
+        CloudProvSessionSlots[slot] = pvPortMalloc(recordSize);
+        if(CloudProvSessionSlots[slot] != NULL)
+        {
+            memcpy(CloudProvSessionSlots[slot], &readBuffer[position], recordSize);
+            restored++;
+            slot++;
+            if(header.sequence >= latestSequence)
+            {
+                latestSequence = header.sequence;
+                CloudProvSessionNextPacketId = header.nextPacketId;
+            }
+        }
+        position += recordSize;
+    }
+
+    if(readBuffer != NULL)
+    {
+        vPortFree(readBuffer);
+    }
+
+    if(restored != 0u)
+    {
+        /* The file already holds the restored publishes, it is kept until they are acknowledged */
+        CloudProvSessionSequence = latestSequence;
+        APP_INFO_PRINT("%d unacknowledged MQTT publish(es) restored from previous session\r\n", restored);
+    }
+    else if(firstLoad == true)
+    {
+        /* Nothing could be restored from a file left, it would only be read again after the next reboot */
+        if(CloudProv_StorageRemove(CLOUD_PROV_SESSION_FILE_NAME) == LFS_ERR_OK)
+        {
+            CloudProvSessionFileSaved = false;
+        }
+    }
+}
+
+uint16_t CloudProv_SessionNextPacketId(void)
+{
+    return CloudProvSessionNextPacketId;
+}
+
+bool CloudProv_SessionTrackPublish(const MQTTPublishInfo_t *pubInfo, uint16_t packetId)
+{
+    CloudProvSessionRecord_t *record = NULL;
+    size_t recordSize = sizeof(CloudProvSessionRecord_t) + pubInfo->topicNameLength + pubInfo->payloadLength;
+    uint8_t slot;
+
+    for(slot = 0u; (slot < CLOUD_PROV_SESSION_INFLIGHT_MAX) && (CloudProvSessionSlots[slot] != NULL); slot++)
+    {
+    }
+
+    if((slot < CLOUD_PROV_SESSION_INFLIGHT_MAX) && (recordSize <= CLOUD_PROV_SESSION_RECORD_MAX_SIZE))
+    {
+        record = pvPortMalloc(recordSize);
+    }
+
+    if(record != NULL)
+    {
+        record->magic = CLOUD_PROV_SESSION_RECORD_MAGIC;
+        record->sequence = ++CloudProvSessionSequence;
+        record->packetId = packetId;
+        /* Packet identifier 0 is not allowed by MQTT */
+        record->nextPacketId = (packetId == UINT16_MAX) ? 1u : (uint16_t)(packetId + 1u);
+        record->topicNameLength = pubInfo->topicNameLength;
+        record->payloadLength = (uint16_t)pubInfo->payloadLength;
+        memcpy(&record[1], pubInfo->pTopicName, pubInfo->topicNameLength);
+        memcpy((uint8_t *)&record[1] + pubInfo->topicNameLength, pubInfo->pPayload, pubInfo->payloadLength);
+        CloudProvSessionSlots[slot] = record;
+        CloudProvSessionChanged = true;
+
+        /* Saved before the publish is sent, a reset can happen any time before its PUBACK */
+        CloudProv_SessionPersist();
+    }
+    else
+    {
+        APP_WARN_PRINT("MQTT publish %d not tracked, it will not be resent if the connection is lost before its "
+                       "PUBACK\r\n", packetId);
+    }
+
+    return (record != NULL);
+}
+
+void CloudProv_SessionRelease(uint16_t packetId)
+{
+    bool inFlight = false;
+
+    for(uint8_t slot = 0u; slot < CLOUD_PROV_SESSION_INFLIGHT_MAX; slot++)
+    {
+        if((CloudProvSessionSlots[slot] != NULL) && (CloudProvSessionSlots[slot]->packetId == packetId))
+        {
+            vPortFree(CloudProvSessionSlots[slot]);
+            CloudProvSessionSlots[slot] = NULL;
+            CloudProvSessionChanged = true;
+        }
+        inFlight |= (CloudProvSessionSlots[slot] != NULL);
+    }
+
+    /* Removing the file only commits littleFS metadata. While other publishes are in flight, the file keeps the
+     * acknowledged one until the next save, it is resent as a duplicate if a reset happens in between */
+    if(inFlight == false)
+    {
+        CloudProv_SessionPersist();
+    }
+}
+
+void CloudProv_SessionPersist(void)
+{
+    uint8_t *writeBuffer;
+    size_t writeLength = 0u;
+    size_t recordSize;
+
+    if(CloudProvSessionChanged == false)
+    {
+        /* littleFS already holds the publishes in flight, or none are */
+        return;
+    }
+
+    writeBuffer = pvPortMalloc(CLOUD_PROV_SESSION_PERSIST_MAX_SIZE);
+    if(writeBuffer == NULL)
+    {
+        APP_WARN_PRINT("Not enough heap to save MQTT publishes in flight\r\n");
+        return;
+    }
+
+    for(uint8_t slot = 0u; slot < CLOUD_PROV_SESSION_INFLIGHT_MAX; slot++)
+    {
+        if(CloudProvSessionSlots[slot] != NULL)
+        {
+            recordSize = CloudProv_SessionRecordSize(CloudProvSessionSlots[slot]);
+            if((writeLength + recordSize) <= CLOUD_PROV_SESSION_PERSIST_MAX_SIZE)
+            {
+                memcpy(&writeBuffer[writeLength], CloudProvSessionSlots[slot], recordSize);
+                writeLength += recordSize;
+            }
+            else
+            {
+                APP_WARN_PRINT("MQTT publish %d too large to be saved in flash\r\n",
+                               CloudProvSessionSlots[slot]->packetId);
+            }
+        }
+    }
+
+    if(writeLength != 0u)
+    {
+        /* Refused without writing if littleFS is short of free blocks, see CloudProv_StorageWrite */
+        if(CloudProv_StorageWrite(CLOUD_PROV_SESSION_FILE_NAME, writeBuffer, writeLength) == LFS_ERR_OK)
+        {
+            CloudProvSessionFileSaved = true;
+            CloudProvSessionChanged = false;
+        }
+    }
+    else if(CloudProvSessionFileSaved == true)
+    {
+        if(CloudProv_StorageRemove(CLOUD_PROV_SESSION_FILE_NAME) == LFS_ERR_OK)
+        {
+            CloudProvSessionFileSaved = false;
+            CloudProvSessionChanged = false;
+        }
+    }
+    else
+    {
+        CloudProvSessionChanged = false;
+    }
+    vPortFree(writeBuffer);
+}
+
+bool CloudProv_SessionGetPublish(uint8_t slot, MQTTPublishInfo_t *pubInfo, uint16_t *packetId)
+{
+    CloudProvSessionRecord_t *record = NULL;
+
+    if(slot < CLOUD_PROV_SESSION_INFLIGHT_MAX)
+    {
+        record = CloudProvSessionSlots[slot];
+    }
+
+    if(record != NULL)
+    {
+        memset(pubInfo, 0x00, sizeof(MQTTPublishInfo_t));
+        pubInfo->qos = MQTTQoS1;
+        pubInfo->pTopicName = (const char *)&record[1];
+        pubInfo->topicNameLength = record->topicNameLength;
+        pubInfo->pPayload = (const uint8_t *)&record[1] + record->topicNameLength;
+        pubInfo->payloadLength = record->payloadLength;
+        *packetId = record->packetId;
+    }
+    return (record != NULL);
+}
@@ -0,0 +1,82 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_SESSION_H
+#define CLOUD_PROV_SESSION_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <core_mqtt.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Max number of unacknowledged QoS1 publishes tracked. Further publishes are still sent, but are not resent
+ *        after a lost connection.
+ */
+#define CLOUD_PROV_SESSION_INFLIGHT_MAX     (4u)
+
+/**
+ * @brief Max size of the publishes saved in littleFS, headers included. littleFS shares 32 data flash blocks of
+ *        128 bytes with the device credentials, a file of 252 bytes fits 2 of them since the second block starts
+ *        with a pointer to the first. Publishes that do not fit, like bulk sensor data, are not saved.
+ */
+#define CLOUD_PROV_SESSION_PERSIST_MAX_SIZE (252u)
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Load the unacknowledged publishes saved in littleFS before a reboot. The file is kept until they are
+ *        acknowledged, it is only read on the first call. littleFS must be mounted.
+ */
+void CloudProv_SessionLoad(void);
+
+/**
+ * @brief Get the packet identifier to continue from after a reboot, so that new publishes do not reuse the
+ *        identifier of a publish still waiting for its PUBACK.
+ * @return Next packet identifier, 0 if no publish was saved.
+ */
+uint16_t CloudProv_SessionNextPacketId(void);
+
+/**
+ * @brief Keep a copy of a QoS1 publish before it is sent, until its PUBACK is received. The publishes in flight are
+ *        saved in littleFS right away, see CloudProv_SessionPersist.
+ * @param[in] pubInfo Publish about to be sent. Topic and payload are copied.
+ * @param[in] packetId Packet identifier the publish is sent with.
+ * @return true if tracked, false if every slot is used or heap is short.
+ */
+bool CloudProv_SessionTrackPublish(const MQTTPublishInfo_t *pubInfo, uint16_t packetId);
+
+/**
+ * @brief Forget a tracked publish once its PUBACK is received, and remove the littleFS file when no publish is left
+ *        in flight. Unknown packet identifiers are ignored.
+ */
+void CloudProv_SessionRelease(uint16_t packetId);
+
+/**
+ * @brief Save the publishes still waiting for their PUBACK in littleFS, so they are resent after a reboot. Called
+ *        when a publish is tracked, when the last one is released and when the connection is lost. Written only
+ *        if the tracked publishes changed since the last save, if they fit in #CLOUD_PROV_SESSION_PERSIST_MAX_SIZE
+ *        and if littleFS has the free blocks for them.
+ */
+void CloudProv_SessionPersist(void);
+
+/**
+ * @brief Get a tracked publish, to be resent after a reconnection.
+ * @param[in] slot Slot index, from 0 to #CLOUD_PROV_SESSION_INFLIGHT_MAX - 1.
+ * @param[out] pubInfo Tracked publish. Topic and payload stay valid until the publish is released.
+ * @param[out] packetId Packet identifier of the tracked publish.
+ * @return true if slot holds a publish.
+ */
+bool CloudProv_SessionGetPublish(uint8_t slot, MQTTPublishInfo_t *pubInfo, uint16_t *packetId);
+
+#endif /* CLOUD_PROV_SESSION_H */
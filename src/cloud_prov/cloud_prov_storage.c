@@ -0,0 +1,117 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_storage.h>
+#include <cloud_prov.h>
+#include <console.h>
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+int CloudProv_StorageRead(const char *fileName, void *buffer, size_t bufferSize, size_t *readLength)
+{
+    lfs_file_t file;
+    lfs_ssize_t fileSize;
+    lfs_ssize_t readSize = 0;
+    int lfsStatus;
+
+    *readLength = 0u;
+    lfsStatus = lfs_file_open(&g_rm_littlefs0_lfs, &file, fileName, LFS_O_RDONLY);
+
+    if(lfsStatus == LFS_ERR_OK)
+    {
+        fileSize = lfs_file_size(&g_rm_littlefs0_lfs, &file);
+        if((fileSize < 0) || ((size_t)fileSize > bufferSize))
+        {
+            lfsStatus = LFS_ERR_FBIG;
+        }
+        else
+        {
+            readSize = lfs_file_read(&g_rm_littlefs0_lfs, &file, buffer, (lfs_size_t)fileSize);
+            lfsStatus = (readSize == fileSize) ? LFS_ERR_OK : LFS_ERR_CORRUPT;
+        }
+        (void)lfs_file_close(&g_rm_littlefs0_lfs, &file);
+    }
+
+    if(lfsStatus == LFS_ERR_OK)
+    {
+        *readLength = (size_t)readSize;
+    }
+    return lfsStatus;
+}
+
+int32_t CloudProv_StorageFreeBlocks(void)
+{
+    lfs_ssize_t usedBlocks = lfs_fs_size(&g_rm_littlefs0_lfs);
+
+    if(usedBlocks >= 0)
+    {
+        usedBlocks = (lfs_ssize_t)g_rm_littlefs0_lfs_cfg.block_count - usedBlocks;
+    }
+    return (int32_t)usedBlocks;
+}
+
+int CloudProv_StorageWrite(const char *fileName, const void *buffer, size_t length)
+{
+    lfs_file_t file;
+    lfs_ssize_t writeSize;
+    int32_t freeBlocks;
+    size_t blockSize = g_rm_littlefs0_lfs_cfg.block_size;
+    /* Content blocks, plus one for the metadata pair update. The previous content is only freed once the new one
+     * is committed */
+    size_t neededBlocks = ((length + blockSize - 1u) / blockSize) + 1u + CLOUD_PROV_STORAGE_RESERVED_BLOCKS;
+    int lfsStatus;
+
+    /* The boot menu writes flash as soon as the cloud thread is stopped */
+    freeBlocks = (CloudProv_BootAborted() == true) ? LFS_ERR_IO : CloudProv_StorageFreeBlocks();
+    if(freeBlocks < 0)
+    {
+        lfsStatus = (int)freeBlocks;
+    }
+    else if((size_t)freeBlocks < neededBlocks)
+    {
+        lfsStatus = LFS_ERR_NOSPC;
+    }
+    else
+    {
+        lfsStatus = lfs_file_open(&g_rm_littlefs0_lfs, &file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    }
+
+    if(lfsStatus == LFS_ERR_OK)
+    {
+        writeSize = lfs_file_write(&g_rm_littlefs0_lfs, &file, buffer, (lfs_size_t)length);
+        lfsStatus = lfs_file_close(&g_rm_littlefs0_lfs, &file);
+        if((lfsStatus == LFS_ERR_OK) && (writeSize != (lfs_ssize_t)length))
+        {
+            lfsStatus = (writeSize < 0) ? (int)writeSize : LFS_ERR_NOSPC;
+        }
+    }
+
+    if(lfsStatus != LFS_ERR_OK)
+    {
+        APP_WARN_PRINT("Failed to write %s to littleFs, error = %d\r\n", fileName, lfsStatus);
+    }
+    return lfsStatus;
+}
+
+int CloudProv_StorageRemove(const char *fileName)
+{
+    int lfsStatus = LFS_ERR_IO;
+
+    if(CloudProv_BootAborted() == false)
+    {
+        lfsStatus = lfs_remove(&g_rm_littlefs0_lfs, fileName);
+    }
+    if(lfsStatus == LFS_ERR_NOENT)
+    {
+        lfsStatus = LFS_ERR_OK;
+    }
+    return lfsStatus;
+}
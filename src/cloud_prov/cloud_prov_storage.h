@@ -0,0 +1,65 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_STORAGE_H
+#define CLOUD_PROV_STORAGE_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Blocks CloudProv_StorageWrite leaves free on the littleFS volume, so that corePKCS11 can still replace the
+ *        device credentials once the files of this module are written.
+ */
+#define CLOUD_PROV_STORAGE_RESERVED_BLOCKS  (2u)
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Read a whole file from the littleFS volume shared with corePKCS11.
+ * @param[in] fileName Name of the file to read.
+ * @param[out] buffer Buffer receiving the file content.
+ * @param[in] bufferSize Size of buffer. Files larger than buffer are rejected.
+ * @param[out] readLength Number of bytes read.
+ * @return LFS_ERR_OK on success, a negative littleFS error code otherwise.
+ */
+int CloudProv_StorageRead(const char *fileName, void *buffer, size_t bufferSize, size_t *readLength);
+
+/**
+ * @brief Get the number of free blocks of the littleFS volume shared with corePKCS11.
+ * @return Number of free blocks, a negative littleFS error code otherwise.
+ */
+int32_t CloudProv_StorageFreeBlocks(void);
+
+/**
+ * @brief Replace the content of a file on the littleFS volume shared with corePKCS11.
+ * @details littleFS commits the new content on close only, so a reset during the write leaves the previous
+ *          content in place. The write is refused with LFS_ERR_NOSPC, before anything is written, if the volume
+ *          would be left with less than #CLOUD_PROV_STORAGE_RESERVED_BLOCKS free blocks, and with LFS_ERR_IO while
+ *          the boot menu stops the cloud thread, see CloudProv_BootAborted.
+ * @param[in] fileName Name of the file to write.
+ * @param[in] buffer Content to write.
+ * @param[in] length Number of bytes to write.
+ * @return LFS_ERR_OK on success, a negative littleFS error code otherwise.
+ */
+int CloudProv_StorageWrite(const char *fileName, const void *buffer, size_t length);
+
+/**
+ * @brief Remove a file from the littleFS volume shared with corePKCS11. Removing a missing file is not an error.
+ *        Refused with LFS_ERR_IO while the boot menu stops the cloud thread.
+ * @param[in] fileName Name of the file to remove.
+ * @return LFS_ERR_OK on success, a negative littleFS error code otherwise.
+ */
+int CloudProv_StorageRemove(const char *fileName);
+
+#endif /* CLOUD_PROV_STORAGE_H */
@@ -0,0 +1,203 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_stream.c
+ * @brief QoS1 publish of a CBOR payload encoded straight to the transport.
+ *
+ * @details MQTT_Publish needs the whole payload in a buffer, which for the CreateCertificateFromCsr and RegisterThing
+ *          requests means a copy of the CSR or ownership token next to the buffer it already sits in. Here the PUBLISH
+ *          header is serialized with the payload length measured by a first tinycbor pass without buffer, then a
+ *          second pass with cbor_encoder_init_writer hands each encoded item to the transport send function.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <string.h>
+#include <cloud_prov_stream.h>
+#include <cloud_prov_config.h>
+#include <core_mqtt_serializer.h>
+#include <core_mqtt_state.h>
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+typedef struct
+{
+    MQTTContext_t *mqttContext;
+    uint8_t buffer[CLOUD_PROV_STREAM_BUFFER_SIZE];
+    size_t used;
+    MQTTStatus_t status;
+}CloudProvStream_t;
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+
+/**
+ * @brief Send bytes on the MQTT transport, retrying partial sends until MQTT_SEND_TIMEOUT_MS elapses without progress.
+ */
+static MQTTStatus_t CloudProv_StreamSend(MQTTContext_t *mqttContext, const uint8_t *data, size_t length);
+
+/**
+ * @brief Send what the staging buffer holds. Nothing is sent anymore once a send failed.
+ */
+static void CloudProv_StreamFlush(CloudProvStream_t *stream);
+
+/**
+ * @brief tinycbor writer function of the streaming pass, token is the CloudProvStream_t.
+ */
+static CborError CloudProv_StreamWrite(void *token, const void *data, size_t length, CborEncoderAppendType appendType);
+
+/*************************************************************************************
+ * Local Functions
+ ************************************************************************************/
+static MQTTStatus_t CloudProv_StreamSend(MQTTContext_t *mqttContext, const uint8_t *data, size_t length)
+{
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    uint32_t lastSendMs = mqttContext->getTime();
+    size_t sent = 0u;
+    int32_t sendRet;
+
+    while((sent < length) && (mqttStatus == MQTTSuccess))
+    {
+        sendRet = mqttContext->transportInterface.send(mqttContext->transportInterface.pNetworkContext,
+                                                        &data[sent],
+                                                        length - sent);
+        if(sendRet < 0)
+        {
+            mqttStatus = MQTTSendFailed;
+        }
+        else if(sendRet > 0)
+        {
+            sent += (size_t)sendRet;
+            lastSendMs = mqttContext->getTime();
+        }
+        else if((mqttContext->getTime() - lastSendMs) > MQTT_SEND_TIMEOUT_MS)
+        {
+            mqttStatus = MQTTSendFailed;
+        }
+        else
+        {
+            /* Transport cannot take more data yet, try again */
+        }
+    }
+
+    return mqttStatus;
+}
+
+static void CloudProv_StreamFlush(CloudProvStream_t *stream)
+{
+    if((stream->status == MQTTSuccess) && (stream->used > 0u))
+    {
+        stream->status = CloudProv_StreamSend(stream->mqttContext, stream->buffer, stream->used);
+    }
+    stream->used = 0u;
+}
+
+static CborError CloudProv_StreamWrite(void *token, const void *data, size_t length, CborEncoderAppendType appendType)
+{
+    CloudProvStream_t *stream = (CloudProvStream_t *)token;
+    (void)appendType;
+
+    if(length > (CLOUD_PROV_STREAM_BUFFER_SIZE - stream->used))
+    {
+        CloudProv_StreamFlush(stream);
+    }
+
+    if(stream->status != MQTTSuccess)
+    {
+        /* Publish is already broken, the connection has to be closed */
+    }
+    else if(length > CLOUD_PROV_STREAM_BUFFER_SIZE)
+    {
+        /* CSR, ownership token: sent from where they are instead of being copied */
+        stream->status = CloudProv_StreamSend(stream->mqttContext, (const uint8_t *)data, length);
+    }
+    else
+    {
+        memcpy(&stream->buffer[stream->used], data, length);
+        stream->used += length;
+    }
+
+    return (stream->status == MQTTSuccess) ? CborNoError : CborErrorIO;
+}
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+MQTTStatus_t CloudProv_PublishStream(MQTTContext_t *mqttContext,
+                                     const char *topic,
+                                     uint16_t topicLength,
+                                     CloudProvCborEncode_t encode,
+                                     const void *request)
+{
+    CloudProvStream_t stream = { .mqttContext = mqttContext, .used = 0u, .status = MQTTSuccess };
+    MQTTFixedBuffer_t headerBuffer = { .pBuffer = stream.buffer, .size = CLOUD_PROV_STREAM_BUFFER_SIZE };
+    MQTTPublishInfo_t pubInfo = { .qos = MQTTQoS1, .pTopicName = topic, .topicNameLength = topicLength };
+    MQTTPublishState_t publishState = MQTTStateNull;
+    MQTTStatus_t mqttStatus = MQTTBadParameter;
+    CborEncoder encoder;
+    CborError cborStatus;
+    size_t remainingLength = 0u;
+    size_t packetSize = 0u;
+    uint16_t packetId = 0u;
+
+    /* Measuring pass: without buffer, tinycbor reports out of memory on every item but counts the bytes needed */
+    cbor_encoder_init(&encoder, NULL, 0u, 0);
+    cborStatus = encode(&encoder, request);
+    if((cborStatus == CborNoError) || (cborStatus == CborErrorOutOfMemory))
+    {
+        pubInfo.payloadLength = cbor_encoder_get_extra_bytes_needed(&encoder);
+        mqttStatus = MQTT_GetPublishPacketSize(&pubInfo, &remainingLength, &packetSize);
+    }
+    else
+    {
+        LogError( ( "Error during CBOR encoding: %s", cbor_error_string( cborStatus ) ) );
+    }
+
+    if((mqttStatus == MQTTSuccess) && ((packetSize - pubInfo.payloadLength) > CLOUD_PROV_STREAM_BUFFER_SIZE))
+    {
+        LogError( ( "PUBLISH header of %.*s does not fit CLOUD_PROV_STREAM_BUFFER_SIZE.", topicLength, topic ) );
+        mqttStatus = MQTTNoMemory;
+    }
+
+    if(mqttStatus == MQTTSuccess)
+    {
+        /* Same bookkeeping as MQTT_Publish, so that MQTT_ProcessLoop accepts the PUBACK */
+        packetId = MQTT_GetPacketId(mqttContext);
+        mqttStatus = MQTT_ReserveState(mqttContext, packetId, MQTTQoS1);
+    }
+
+    if(mqttStatus == MQTTSuccess)
+    {
+        mqttStatus = MQTT_SerializePublishHeader(&pubInfo, packetId, remainingLength, &headerBuffer, &stream.used);
+    }
+
+    if(mqttStatus == MQTTSuccess)
+    {
+        /* Streaming pass: the header waits in the staging buffer and goes out with the first payload items */
+        cbor_encoder_init_writer(&encoder, CloudProv_StreamWrite, &stream);
+        cborStatus = encode(&encoder, request);
+        CloudProv_StreamFlush(&stream);
+        mqttStatus = stream.status;
+
+        if((mqttStatus == MQTTSuccess) && (cborStatus != CborNoError))
+        {
+            /* Part of the packet is already sent, only closing the connection recovers from this */
+            LogError( ( "Error during CBOR encoding: %s", cbor_error_string( cborStatus ) ) );
+            mqttStatus = MQTTSendFailed;
+        }
+    }
+
+    if(mqttStatus == MQTTSuccess)
+    {
+        mqttContext->lastPacketTxTime = mqttContext->getTime();
+        mqttStatus = MQTT_UpdateStatePublish(mqttContext, packetId, MQTT_SEND, MQTTQoS1, &publishState);
+    }
+
+    return mqttStatus;
+}
@@ -0,0 +1,51 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_STREAM_H
+#define CLOUD_PROV_STREAM_H
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <core_mqtt.h>
+#include <cloud_prov_serializer.h>
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/**
+ * @brief Size of the staging buffer of a streamed publish. It holds the PUBLISH header with its topic, then
+ *        gathers the small CBOR items so that they do not each go out in their own TLS record. Strings longer than
+ *        the buffer are sent straight from where they are.
+ */
+#define CLOUD_PROV_STREAM_BUFFER_SIZE       (160u)
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Publish a CBOR payload at QoS1 without encoding it in a buffer first.
+ * @details The payload is encoded twice. A first pass without buffer measures its length for the PUBLISH fixed
+ *          header, the second pass hands the encoded bytes to the transport as tinycbor writes them. The publish
+ *          is recorded in the coreMQTT state the same way as by MQTT_Publish, so its PUBACK is processed as usual.
+ * @param[in] mqttContext Connected MQTT context.
+ * @param[in] topic Topic to publish to.
+ * @param[in] topicLength Length of topic, the PUBLISH header must fit in #CLOUD_PROV_STREAM_BUFFER_SIZE.
+ * @param[in] encode Payload encoder, called once per pass with request.
+ * @param[in] request Data encode reads, must not change between both passes.
+ * @return MQTTSuccess once the whole publish is sent, MQTTBadParameter if the payload cannot be encoded,
+ *         MQTTNoMemory if the header does not fit the staging buffer, MQTTSendFailed on transport failure.
+ */
+MQTTStatus_t CloudProv_PublishStream(MQTTContext_t *mqttContext,
+                                     const char *topic,
+                                     uint16_t topicLength,
+                                     CloudProvCborEncode_t encode,
+                                     const void *request);
+
+#endif /* CLOUD_PROV_STREAM_H */
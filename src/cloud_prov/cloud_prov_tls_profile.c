@@ -0,0 +1,68 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_tls_profile.c
+ * @brief Reduced-memory TLS profile, selected with the CLOUD_PROV_TLS_LOW_MEMORY CMake option.
+ *
+ * @details The TLS transport configures mbedTLS on its own, so mbedtls_ssl_setup is wrapped at link time
+ *          (-Wl,--wrap) to apply the profile to the transport configuration right before the record buffers are
+ *          allocated. The profile negotiates the max_fragment_length extension and offers a single cipher suite,
+ *          while CMake shrinks the mbedTLS record buffers to match (MBEDTLS_SSL_IN_CONTENT_LEN and
+ *          MBEDTLS_SSL_OUT_CONTENT_LEN).
+ *
+ * @note ECDHE-ECDSA requires the broker to present an ECC certificate, thus cloud_prov_config.h selects Amazon Root
+ *       CA 3 instead of Amazon Root CA 1 as CLOUD_PROV_DEV_ROOT_CA_PEM with this profile.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#include <cloud_prov_config.h>
+#include <console.h>
+#include "mbedtls/ssl.h"
+
+#if (CLOUD_PROV_TLS_PROFILE == CLOUD_PROV_TLS_PROFILE_LOW_MEMORY)
+
+#if !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+#error "The low memory TLS profile needs MBEDTLS_SSL_MAX_FRAGMENT_LENGTH, see the CLOUD_PROV_TLS_LOW_MEMORY option"
+#endif
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Only cipher suite offered, AES-GCM and P-256 are both hardware accelerated on the RA6M5 */
+static const int CloudProvTlsProfileCipherSuites[] =
+        {
+            MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+            0
+        };
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+int __real_mbedtls_ssl_setup(mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf);
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+int __wrap_mbedtls_ssl_setup(mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf)
+{
+    /* The configuration belongs to the transport and is not shared, it is only const for mbedtls_ssl_setup */
+    mbedtls_ssl_config *transportConf = (mbedtls_ssl_config *)conf;
+    int mbedtlsRet;
+
+    mbedtls_ssl_conf_ciphersuites(transportConf, CloudProvTlsProfileCipherSuites);
+    mbedtlsRet = mbedtls_ssl_conf_max_frag_len(transportConf, CLOUD_PROV_TLS_MAX_FRAG_LEN_CODE);
+
+    if(mbedtlsRet == 0)
+    {
+        mbedtlsRet = __real_mbedtls_ssl_setup(ssl, conf);
+    }
+    return mbedtlsRet;
+}
+
+#endif /* (CLOUD_PROV_TLS_PROFILE == CLOUD_PROV_TLS_PROFILE_LOW_MEMORY) */
@@ -0,0 +1,207 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+/**
+ * @file cloud_prov_tls_profiler.c
+ * @brief Per-phase cycle counts of TLS_FreeRTOS_Connect, built with the CLOUD_PROV_TLS_PROFILER CMake option.
+ *
+ * @details TCP_Sockets_Connect, FreeRTOS_gethostbyname and mbedtls_ssl_handshake are wrapped at link time
+ *          (-Wl,--wrap). The handshake wrapper runs the mbedtls_ssl_handshake_step loop itself, the same way
+ *          mbedtls_ssl_handshake does for TLS, and charges the DWT cycles of each step to the state it started in.
+ *          Steps blocked on the network are charged too, so the SERVER_HELLO state holds the wait for the broker,
+ *          SERVER_CERTIFICATE the certificate verification, CLIENT_KEY_EXCHANGE the ECDHE computation and
+ *          CERTIFICATE_VERIFY the signature made through PKCS #11.
+ */
+
+/*************************************************************************************
+ *                                  INCLUDES
+ ************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_CLOUD_PROV)
+
+#include <cloud_prov_tls_profiler.h>
+#include <console.h>
+#include <FreeRTOS_IP.h>
+#include <FreeRTOS_DNS.h>
+#include "tcp_sockets_wrapper.h"
+#include "mbedtls/ssl.h"
+
+/*************************************************************************************
+ * DEFINE MACROS
+ ************************************************************************************/
+
+/** @brief TLS 1.2 handshake states are all below MBEDTLS_SSL_HANDSHAKE_OVER, anything else lands in the last slot */
+#define CLOUD_PROV_TLS_PROFILER_STATE_COUNT     ((uint32_t)MBEDTLS_SSL_HANDSHAKE_OVER + 1u)
+
+#define CLOUD_PROV_TLS_PROFILER_CYCLES_TO_US(cycles) \
+    ((uint32_t)(((uint64_t)(cycles) * 1000000u) / SystemCoreClock))
+
+/*************************************************************************************
+ * Type Definitions
+ ************************************************************************************/
+typedef struct
+{
+    uint32_t dnsCycles;
+    uint32_t connectCycles;         /* TCP_Sockets_Connect, DNS included */
+    uint32_t stateCycles[CLOUD_PROV_TLS_PROFILER_STATE_COUNT];
+    uint16_t stateSteps[CLOUD_PROV_TLS_PROFILER_STATE_COUNT];
+}CloudProvTlsProfile_t;
+
+/*************************************************************************************
+ * Local Variables
+ ************************************************************************************/
+
+/** @brief Phases of the last TLS connection, reset when a new one starts */
+static CloudProvTlsProfile_t CloudProvTlsProfile;
+
+/** @brief Task running TCP_Sockets_Connect, only its name resolution is charged to the profile */
+static TaskHandle_t CloudProvTlsProfilerConnectTask = NULL;
+
+/** @brief Names of TLS 1.2 client handshake states, indexed by mbedtls_ssl_states */
+static const char * const CloudProvTlsProfilerStateNames[CLOUD_PROV_TLS_PROFILER_STATE_COUNT] =
+        {
+            [MBEDTLS_SSL_HELLO_REQUEST] =           "HELLO_REQUEST",
+            [MBEDTLS_SSL_CLIENT_HELLO] =            "CLIENT_HELLO",
+            [MBEDTLS_SSL_SERVER_HELLO] =            "SERVER_HELLO",
+            [MBEDTLS_SSL_SERVER_CERTIFICATE] =      "SERVER_CERTIFICATE",
+            [MBEDTLS_SSL_SERVER_KEY_EXCHANGE] =     "SERVER_KEY_EXCHANGE",
+            [MBEDTLS_SSL_CERTIFICATE_REQUEST] =     "CERTIFICATE_REQUEST",
+            [MBEDTLS_SSL_SERVER_HELLO_DONE] =       "SERVER_HELLO_DONE",
+            [MBEDTLS_SSL_CLIENT_CERTIFICATE] =      "CLIENT_CERTIFICATE",
+            [MBEDTLS_SSL_CLIENT_KEY_EXCHANGE] =     "CLIENT_KEY_EXCHANGE",
+            [MBEDTLS_SSL_CERTIFICATE_VERIFY] =      "CERTIFICATE_VERIFY",
+            [MBEDTLS_SSL_CLIENT_CHANGE_CIPHER_SPEC]="CLIENT_CHANGE_CIPHER_SPEC",
+            [MBEDTLS_SSL_CLIENT_FINISHED] =         "CLIENT_FINISHED",
+            [MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC]="SERVER_CHANGE_CIPHER_SPEC",
+            [MBEDTLS_SSL_SERVER_FINISHED] =         "SERVER_FINISHED",
+            [MBEDTLS_SSL_FLUSH_BUFFERS] =           "FLUSH_BUFFERS",
+            [MBEDTLS_SSL_HANDSHAKE_WRAPUP] =        "HANDSHAKE_WRAPUP",
+            [MBEDTLS_SSL_HANDSHAKE_OVER] =          "OTHER",
+        };
+
+/*************************************************************************************
+ * Local Function Prototypes
+ ************************************************************************************/
+BaseType_t __real_TCP_Sockets_Connect(Socket_t *pTcpSocket,
+                                      const char *pHostName,
+                                      uint16_t port,
+                                      uint32_t receiveTimeoutMs,
+                                      uint32_t sendTimeoutMs);
+uint32_t __real_FreeRTOS_gethostbyname(const char *pcHostName);
+int __real_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl);
+
+static uint32_t CloudProv_TlsProfilerCycles(void);
+
+/*************************************************************************************
+ * Local Functions
+ ************************************************************************************/
+static uint32_t CloudProv_TlsProfilerCycles(void)
+{
+    /* Start the DWT cycle counter on first use, it is left running afterwards */
+    if((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0u)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0u;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+}
+
+/*************************************************************************************
+ * global functions
+ ************************************************************************************/
+
+BaseType_t __wrap_TCP_Sockets_Connect(Socket_t *pTcpSocket,
+                                      const char *pHostName,
+                                      uint16_t port,
+                                      uint32_t receiveTimeoutMs,
+                                      uint32_t sendTimeoutMs)
+{
+    uint32_t startCycles;
+    BaseType_t status;
+
+    /* Every TLS_FreeRTOS_Connect starts here, so a new profile starts too */
+    memset(&CloudProvTlsProfile, 0x00, sizeof(CloudProvTlsProfile));
+
+    CloudProvTlsProfilerConnectTask = xTaskGetCurrentTaskHandle();
+    startCycles = CloudProv_TlsProfilerCycles();
+    status = __real_TCP_Sockets_Connect(pTcpSocket, pHostName, port, receiveTimeoutMs, sendTimeoutMs);
+    CloudProvTlsProfile.connectCycles = CloudProv_TlsProfilerCycles() - startCycles;
+    CloudProvTlsProfilerConnectTask = NULL;
+
+    return status;
+}
+
+uint32_t __wrap_FreeRTOS_gethostbyname(const char *pcHostName)
+{
+    uint32_t startCycles = CloudProv_TlsProfilerCycles();
+    uint32_t address = __real_FreeRTOS_gethostbyname(pcHostName);
+
+    /* Endpoint probes resolve names concurrently from their own tasks, only the resolution made inside
+     * TCP_Sockets_Connect is part of connectCycles */
+    if(xTaskGetCurrentTaskHandle() == CloudProvTlsProfilerConnectTask)
+    {
+        CloudProvTlsProfile.dnsCycles = CloudProv_TlsProfilerCycles() - startCycles;
+    }
+    return address;
+}
+
+int __wrap_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl)
+{
+    int mbedtlsRet = 0;
+    uint32_t state;
+    uint32_t startCycles;
+
+    if((ssl == NULL) || (ssl->MBEDTLS_PRIVATE(conf) == NULL))
+    {
+        /* Same argument check as mbedtls_ssl_handshake */
+        mbedtlsRet = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    else if(ssl->MBEDTLS_PRIVATE(conf)->MBEDTLS_PRIVATE(transport) != MBEDTLS_SSL_TRANSPORT_STREAM)
+    {
+        /* Only TLS is profiled, DTLS goes through the checks of its own in mbedtls_ssl_handshake */
+        mbedtlsRet = __real_mbedtls_ssl_handshake(ssl);
+    }
+    else
+    {
+        /* Same loop as mbedtls_ssl_handshake, mbedtls_ssl_handshake_step checks the handshake context */
+        while((mbedtlsRet == 0) && (mbedtls_ssl_is_handshake_over(ssl) == 0))
+        {
+            state = (uint32_t)ssl->MBEDTLS_PRIVATE(state);
+            if(state >= CLOUD_PROV_TLS_PROFILER_STATE_COUNT)
+            {
+                state = CLOUD_PROV_TLS_PROFILER_STATE_COUNT - 1u;
+            }
+
+            startCycles = CloudProv_TlsProfilerCycles();
+            mbedtlsRet = mbedtls_ssl_handshake_step(ssl);
+            CloudProvTlsProfile.stateCycles[state] += CloudProv_TlsProfilerCycles() - startCycles;
+            CloudProvTlsProfile.stateSteps[state]++;
+        }
+    }
+
+    return mbedtlsRet;
+}
+
+void CloudProv_TlsProfilerReport(void)
+{
+    uint32_t handshakeCycles = 0u;
+
+    APP_INFO_PRINT("TLS connect profile (us): DNS %d, TCP connect %d\r\n",
+                   CLOUD_PROV_TLS_PROFILER_CYCLES_TO_US(CloudProvTlsProfile.dnsCycles),
+                   CLOUD_PROV_TLS_PROFILER_CYCLES_TO_US(CloudProvTlsProfile.connectCycles -
+                                                        CloudProvTlsProfile.dnsCycles));
+
+    for(uint32_t state = 0u; state < CLOUD_PROV_TLS_PROFILER_STATE_COUNT; state++)
+    {
+        if(CloudProvTlsProfile.stateSteps[state] != 0u)
+        {
+            APP_INFO_PRINT("    %-26s %8d us in %d steps\r\n",
+                           CloudProvTlsProfilerStateNames[state],
+                           CLOUD_PROV_TLS_PROFILER_CYCLES_TO_US(CloudProvTlsProfile.stateCycles[state]),
+                           CloudProvTlsProfile.stateSteps[state]);
+            handshakeCycles += CloudProvTlsProfile.stateCycles[state];
+        }
+    }
+    APP_INFO_PRINT("    %-26s %8d us\r\n", "HANDSHAKE", CLOUD_PROV_TLS_PROFILER_CYCLES_TO_US(handshakeCycles));
+}
@@ -0,0 +1,18 @@
+//
+// Created by Gabriel on 3/23/2024.
+//
+
+#ifndef CLOUD_PROV_TLS_PROFILER_H
+#define CLOUD_PROV_TLS_PROFILER_H
+
+/*************************************************************************************
+ *                             GLOBAL FUNCTION PROTOTYPES
+ ************************************************************************************/
+
+/**
+ * @brief Print the time spent in each phase of the last TLS connection: DNS, TCP connect, then every mbedTLS
+ *        handshake state. Only available when built with the CLOUD_PROV_TLS_PROFILER CMake option.
+ */
+void CloudProv_TlsProfilerReport(void);
+
+#endif /* CLOUD_PROV_TLS_PROFILER_H */
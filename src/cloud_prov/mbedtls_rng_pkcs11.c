@@ -39,13 +39,210 @@
 /**
  * @file mbedtls_rng_pkcs11.c
  * @brief Implements an mbedtls RNG callback using the PKCS#11 API
+ *
+ * @details Calling C_GenerateRandom for every mbedTLS random request is expensive, since the TLS handshake and
+ * CSR generation issue many small requests. Instead, a CTR-DRBG is seeded from C_GenerateRandom (hardware TRNG
+ * behind corePKCS11), reseeded every mbedtlsRNG_PKCS11_RESEED_INTERVAL generate calls, and requests are served
+ * from a refillable pool of DRBG output. mbedtls_ssl_conf_rng is wrapped at link time (-Wl,--wrap) so that the
+ * TLS transport draws its handshake randoms from the pool too. ECDSA signatures made by C_Sign use the DRBG of
+ * corePKCS11 itself, not an mbedTLS RNG callback.
  */
 
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
 #include "core_pkcs11_config.h"
 #include "core_pkcs11.h"
+#include "cloud_prov_pkcs11.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/ssl.h"
+
+/**
+ * @brief Size of the pool of DRBG output random requests are served from.
+ */
+#ifndef mbedtlsRNG_PKCS11_POOL_SIZE
+    #define mbedtlsRNG_PKCS11_POOL_SIZE          ( 128U )
+#endif
+
+/**
+ * @brief Number of DRBG generate calls after which the DRBG reseeds from C_GenerateRandom.
+ */
+#ifndef mbedtlsRNG_PKCS11_RESEED_INTERVAL
+    #define mbedtlsRNG_PKCS11_RESEED_INTERVAL    ( 256 )
+#endif
+
+/**
+ * @brief Personalization string mixed in the initial DRBG seed.
+ */
+#define mbedtlsRNG_PKCS11_PERSONALIZATION        "CloudProvRngPool"
+
+/*-----------------------------------------------------------*/
+
+static mbedtls_ctr_drbg_context xCtrDrbgContext;
+static CK_SESSION_HANDLE xEntropySession = CK_INVALID_HANDLE;
+static uint8_t ucRngPool[ mbedtlsRNG_PKCS11_POOL_SIZE ];
+static size_t uxRngPoolAvailable = 0U;
+static BaseType_t xRngPoolSeeded = pdFALSE;
+static SemaphoreHandle_t xRngPoolMutex = NULL;
+static StaticSemaphore_t xRngPoolMutexBuffer;
+static RngPoolStats_t xRngPoolStats;
+
+/*-----------------------------------------------------------*/
+
+int lMbedCryptoRngCallbackPKCS11( void * pvCtx,
+                                  unsigned char * pucOutput,
+                                  size_t uxLen );
+
+void __real_mbedtls_ssl_conf_rng( mbedtls_ssl_config * conf,
+                                  int ( * f_rng )( void *, unsigned char *, size_t ),
+                                  void * p_rng );
+
+/**
+ * @brief Entropy callback of the CTR-DRBG. Draws entropy from the PKCS #11 module.
+ */
+static int prvEntropyCallbackPKCS11( void * pvCtx,
+                                     unsigned char * pucOutput,
+                                     size_t uxLen )
+{
+    xRngPoolStats.ulEntropyCalls++;
+    xRngPoolStats.ulEntropyBytes += uxLen;
+
+    return lMbedCryptoRngCallbackPKCS11( pvCtx, pucOutput, uxLen );
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvSeedRngPool( void )
+{
+    int lRslt = -1;
+
+    /* The pool has its own session: the ones of its callers, like the TLS transport, are closed while the DRBG
+     * still needs to reseed */
+    if( xInitializePkcs11Session( &xEntropySession ) != CKR_OK )
+    {
+        LogError( ( "Failed to open the PKCS #11 session of the RNG pool." ) );
+        return lRslt;
+    }
+
+    mbedtls_ctr_drbg_init( &xCtrDrbgContext );
+    lRslt = mbedtls_ctr_drbg_seed( &xCtrDrbgContext,
+                                   prvEntropyCallbackPKCS11,
+                                   &xEntropySession,
+                                   ( const unsigned char * ) mbedtlsRNG_PKCS11_PERSONALIZATION,
+                                   sizeof( mbedtlsRNG_PKCS11_PERSONALIZATION ) - 1U );
+
+    if( lRslt == 0 )
+    {
+        mbedtls_ctr_drbg_set_reseed_interval( &xCtrDrbgContext, mbedtlsRNG_PKCS11_RESEED_INTERVAL );
+        xRngPoolSeeded = pdTRUE;
+    }
+    else
+    {
+        LogError( ( "Failed to seed CTR-DRBG, mbedTLS error = %d.", lRslt ) );
+        mbedtls_ctr_drbg_free( &xCtrDrbgContext );
+        ( void ) C_CloseSession( xEntropySession );
+        xEntropySession = CK_INVALID_HANDLE;
+    }
+
+    return lRslt;
+}
 
 /*-----------------------------------------------------------*/
 
+int lMbedCryptoRngCallbackPool( void * pvCtx,
+                                unsigned char * pucOutput,
+                                size_t uxLen )
+{
+    int lRslt = 0;
+    size_t uxChunk;
+
+    /* The pool draws entropy through its own session, whatever context the caller configured */
+    ( void ) pvCtx;
+
+    if( pucOutput == NULL )
+    {
+        LogError( ( "pucOutput must not be NULL." ) );
+        lRslt = -1;
+    }
+    else
+    {
+        if( xRngPoolMutex == NULL )
+        {
+            taskENTER_CRITICAL();
+
+            if( xRngPoolMutex == NULL )
+            {
+                xRngPoolMutex = xSemaphoreCreateMutexStatic( &xRngPoolMutexBuffer );
+            }
+
+            taskEXIT_CRITICAL();
+        }
+
+        ( void ) xSemaphoreTake( xRngPoolMutex, portMAX_DELAY );
+
+        if( xRngPoolSeeded == pdFALSE )
+        {
+            lRslt = prvSeedRngPool();
+        }
+
+        xRngPoolStats.ulRequests++;
+        xRngPoolStats.ulRequestedBytes += uxLen;
+
+        while( ( lRslt == 0 ) && ( uxLen > 0U ) )
+        {
+            if( uxRngPoolAvailable == 0U )
+            {
+                /* Refill the pool. The DRBG reseeds itself from the PKCS #11 module
+                 * when its reseed interval is reached. */
+                lRslt = mbedtls_ctr_drbg_random( &xCtrDrbgContext, ucRngPool, sizeof( ucRngPool ) );
+
+                if( lRslt == 0 )
+                {
+                    uxRngPoolAvailable = sizeof( ucRngPool );
+                    xRngPoolStats.ulPoolRefills++;
+                }
+                else
+                {
+                    LogError( ( "Failed to refill RNG pool, mbedTLS error = %d.", lRslt ) );
+                }
+            }
+
+            if( lRslt == 0 )
+            {
+                /* Serve from the end of the pool, then wipe what was handed out */
+                uxChunk = ( uxLen < uxRngPoolAvailable ) ? uxLen : uxRngPoolAvailable;
+                uxRngPoolAvailable -= uxChunk;
+                memcpy( pucOutput, &ucRngPool[ uxRngPoolAvailable ], uxChunk );
+                memset( &ucRngPool[ uxRngPoolAvailable ], 0, uxChunk );
+                pucOutput += uxChunk;
+                uxLen -= uxChunk;
+            }
+        }
+
+        ( void ) xSemaphoreGive( xRngPoolMutex );
+    }
+
+    return lRslt;
+}
+
+/*-----------------------------------------------------------*/
+
+void vMbedCryptoRngPoolGetStats( RngPoolStats_t * pxStats )
+{
+    *pxStats = xRngPoolStats;
+}
+
+/*-----------------------------------------------------------*/
 
+void __wrap_mbedtls_ssl_conf_rng( mbedtls_ssl_config * conf,
+                                  int ( * f_rng )( void *, unsigned char *, size_t ),
+                                  void * p_rng )
+{
+    /* The transport configures C_GenerateRandom on its own session, every handshake random is served from the
+     * pool instead */
+    ( void ) f_rng;
+    __real_mbedtls_ssl_conf_rng( conf, lMbedCryptoRngCallbackPool, p_rng );
+}
 
 /*-----------------------------------------------------------*/
@@ -273,7 +273,22 @@ static inline CborError validate_utf8_string(const void *ptr, size_t n)
     const uint8_t *buffer = (const uint8_t *)ptr;
     const uint8_t * const end = buffer + n;
     while (buffer < end) {
-        uint32_t uc = get_utf8(&buffer, end);
+        uint32_t uc;
+
+        /* ASCII fast path: PEM certificates and ownership tokens are plain
+         * ASCII, check four bytes at a time for a byte with the high bit set */
+        while (end - buffer >= (ptrdiff_t)sizeof(uint32_t)) {
+            uint32_t word;
+            memcpy(&word, buffer, sizeof(word));
+            if (word & 0x80808080U)
+                break;
+            buffer += sizeof(word);
+        }
+        if (buffer == end)
+            break;
+
+        /* non-ASCII byte in the next word, or tail shorter than a word */
+        uc = get_utf8(&buffer, end);
         if (uc == ~0U)
             return CborErrorInvalidUtf8TextString;
     }
@@ -22,11 +22,14 @@
  ***********************************************************************************************************************/
 #include "console.h"
 #include "console_flash.h"
+#include "console_log.h"
+#include "cloud_prov.h"
 
 
 #define AP_VERSION      ("2.0")
 #define MODULE_NAME     "AWS Core MQTT"
-#define BANNER_INFO     "\r\n[CYAN]********************************************************************************"\
+#define BANNER_INFO     "\r\n" CONSOLE_CYAN \
+                        "********************************************************************************"\
                         "\r\n*   Renesas FSP Application Project for "MODULE_NAME"                          *"\
                         "\r\n*   Application Project Version %s                                            *"\
                         "\r\n*   Flex Software Pack Version  %d.%d.%d                                          *"\
@@ -34,7 +37,8 @@
                         "\r\n********************************************************************************"\
                         "\r\nRefer to Application Note for more details on Application Project and              " \
                         "\r\nFSP User's Manual for more information about "MODULE_NAME"                    "\
-                        "\r\n********************************************************************************[WHITE]\r\n"
+                        "\r\n********************************************************************************"
+                        CONSOLE_WHITE "\r\n"
 #define CONSOLE_MENU_RETURN         "\r\n\r\n> Press BACKSPACE key to return to MENU\r\n"
 #define CONSOLE_SUB_OPTIONS         "\r\n> Select from the options in the menu below:\r\n"
 #define CONSOLE_FLASH_CHECK_CREDENTIALS        "\r\nCHECK CREDENTIALS STORED IN DATA FLASH\r\n"
@@ -51,6 +55,8 @@
 #define CONSOLE_CURSOR_TEMP         "\x1b[8;41H\x1b[K"
 #define CONSOLE_CURSOR_FREQUENCY    "\x1b[9;41H\x1b[K"
 #define CONSOLE_CURSOR_INTENSITY    "\x1b[10;41H\x1b[K"
+#define CONSOLE_MENU_WINDOW_MS      (3000u)
+#define CONSOLE_MENU_STOP_TIMEOUT_MS (10000u)
 
 typedef struct
 {
@@ -70,14 +76,18 @@ static void Console_FlashWriteKeyMeu (int8_t selectedMenu);
 static void Console_FlashWriteIotNameMenu(int8_t selectedMenu);
 static void Console_FlashWriteEndPointMenu(int8_t selectedMenu);
 static void Console_FlashCheckCredentialsMenu(int8_t selectedMenu);
+static bool Console_LogLevelMenu(int8_t selectedMenu);
+static void Console_AppRunning(void);
 static char Console_ParseUserCredentials(ConsoleCredential_t credential);
 
 
 extern TaskHandle_t cloud_app_thread; // @suppress("Global (API or Non-API) variable prefix")
+extern TaskHandle_t console_thread; // @suppress("Global (API or Non-API) variable prefix")
 
 static uint8_t  ConsoleInputBuffer[TRANSFER_LENGTH] = {0};
-static bool ConsoleTransmitDone = false;
 static bool ConsoleUserInputReceived  = false;
+/** @brief Set while the console thread waits for a key without polling, so the UART callback wakes it up */
+static volatile bool ConsoleNotifyOnKey = false;
 static uint32_t ConsoleInputIndex = 0;
 static char ConsoleCredentialBuffer[TRANSFER_LENGTH]= {0};
 static uint8_t ConsoleReadCredential = false;
@@ -100,115 +110,13 @@ static ConsoleMenu_t ConsoleMainMenus[] =
                 {"", NULL }
         };
 
-/*********************************************************************************************************************
- * Function Name: Console_GetColour
- *                Get the escape code string for the supplied colour tag
- * @param[in] char *string : the escape code
- * @param[out] bool *found : true if the tag was found, false if not
- * @retval the escape code for the colour tag, or the original string if there
- *         was no match
-*********************************************************************************************************************/
-static const char *Console_GetColour(const char *string, bool *found)
-{
-    const char *colour_codes[] = {"[BLACK]", "\x1B[30m", "[RED]", "\x1B[91m", "[GREEN]", "\x1B[92m", "[YELLOW]", "\x1B[93m",
-                                  "[BLUE]", "\x1B[94m", "[MAGENTA]", "\x1B[95m", "[CYAN]", "\x1B[96m", "[WHITE]", "\x1B[97m",
-                                  "[ORANGE]", "\x1B[38;5;208m", "[PINK]", "\x1B[38;5;212m", "[BROWN]", "\x1B[38;5;94m",
-                                  "[PURPLE]", "\x1B[35m"};
-	uint8_t index;
-
-    for (index = 0; index < 12; index++)
-    {
-        if (0 == strcmp (string, colour_codes[index << 1]))
-        {
-            *found = true;
-            return colour_codes[(index << 1) + 1];
-        }
-    }
-
-    *found = false;
-    return (string);
-}
-
-/*********************************************************************************************************************
- * Function Name: Console_Detokenise
- *                Replace colour tokens with terminal colour escape codes
- * @param[in] char *input : input string possibly containing colour tokens
- * @param[in] output *output : string with colour tokens replaced with escape codes
- * @retval
- *
-*********************************************************************************************************************/
-static void Console_Detokenise(const char * input, char *output)
-{
-    int16_t start_bracket_index;
-    int16_t end_bracket_index;
-    int16_t start_bracket_output_index;
-    size_t token_length;
-    int16_t index;
-    int16_t o_index;
-    bool token_found;
-    bool token_replaced;
-    const char *colour_code;
-    char token[MAXIMUM_TOKEN_LENGTH + 1];
-
-    start_bracket_index = -1;
-    end_bracket_index = -1;
-    start_bracket_output_index = 0;
-    o_index = 0;
-
-    /* scan the input string */
-    for (index = 0; '\0' != input[index]; index++)
-    {
-        token_replaced = false;
-
-        /* token start? */
-        if ('[' == input[index])
-        {
-            start_bracket_index = index;
-            start_bracket_output_index = o_index;
-        }
-
-        /* token end? */
-        if (']' == input[index])
-        {
-            end_bracket_index = index;
-
-            /* check to see if we have a token */
-            if (start_bracket_index >= 0)
-            {
-                token_length = (size_t) (end_bracket_index - start_bracket_index + 1);
-
-                if ((token_length >= MINIMUM_TOKEN_LENGTH) && (token_length <= MAXIMUM_TOKEN_LENGTH))
-                {
-                    /* copy the token to a buffer */
-                    strncpy (token, &input[start_bracket_index], token_length);
-                    token[token_length] = '\0';
+/* Name of each module in the log level menu, in ConsoleLogModule_t order */
+static const char * const ConsoleLogModuleNames[CONSOLE_LOG_MODULE_COUNT] =
+        {"cloud_app", "cloud_prov", "sensor", "ob1203", "console", "led"};
 
-                    /* check for a valid token */
-                    colour_code = Console_GetColour(token, &token_found);
-
-                    /* if we have a colour token, then replace it in the output with the associated escape code */
-                    if (token_found)
-                    {
-                        strcpy (&output[start_bracket_output_index], colour_code);
-                        o_index = (int16_t) (start_bracket_output_index + (int16_t) strlen (colour_code));
-                        token_replaced = true;
-                    }
-                }
-            }
-            /* reset and start looking for another token */
-            start_bracket_index = -1;
-            end_bracket_index = -1;
-        }
-        /* if we didn't replace a token, then carry on copying input to output */
-        if (!token_replaced)
-        {
-            output[o_index] = input[index];
-            o_index++;
-        }
-    }
-    /* terminate the output string */
-    output[o_index] = '\0';
-}
+/* Name of each log level, LOG_NONE to LOG_DEBUG */
+static const char * const ConsoleLogLevelNames[LOG_DEBUG + 1] =
+        {"none", "error", "warning", "info", "debug"};
 
 /*********************************************************************************************************************
  * @brief  wait for key pressed
@@ -237,15 +145,12 @@ static void Console_StartAppMenu(int8_t selectedMenu)
     fsp_err_t err = FSP_SUCCESS;
     int8_t key_pressed = -1;
 
-    Console_ColorPrintf("\r\n[GREEN]Starting AWS cloud Application....[WHITE]\r\n");
-    /* Send notify to start aws thread */
-    xTaskNotifyFromISR(cloud_app_thread, 1, 1, NULL);
+    Console_ColorPrintf("\r\n" CONSOLE_GREEN "Starting AWS cloud Application...." CONSOLE_WHITE "\r\n");
+    /* Let cloud app thread connect again */
+    CloudProv_BootDecide(true);
 
-    /* Disable console thread with infinite loop.*/
-    while (true)
-    {
-        vTaskDelay (5000);
-    }
+    /* Only the log level menu is left to the console once the application runs */
+    Console_AppRunning();
 }
 
 static void Console_DefaultClaimCredMenu(int8_t selectedMenu)
@@ -253,9 +158,9 @@ static void Console_DefaultClaimCredMenu(int8_t selectedMenu)
     int8_t key_pressed = -1;
 
     Console_ResetClaimCredentials();
-    Console_ColorPrintf("[GREEN]\r\nClaim Credentials erased from flash. Default ones will be used "
+    Console_ColorPrintf(CONSOLE_GREEN "\r\nClaim Credentials erased from flash. Default ones will be used "
                         "if device is not provisioned.\r\n"
-                        "\r\n[YELLOW]Please Restart CloudKit...\r\n");
+                        "\r\n" CONSOLE_YELLOW "Please Restart CloudKit...\r\n");
     while ((CONSOLE_MENU_EXIT_KEY != key_pressed) && (CONSOLE_CONNECTION_ABORT != key_pressed))
     {
         /* Cant recover from that without rereading flash data, thus for simpler setup,
@@ -267,7 +172,7 @@ static void Console_DefaultClaimCredMenu(int8_t selectedMenu)
 static void Console_ForceDeviceProvisioning(int8_t selectedMenu)
 {
     CloudProv_ForceProvisioning();
-    Console_ColorPrintf("[PINK]\r\nCheat Code Activated. Forcing device provisioning\r\n");
+    Console_ColorPrintf(CONSOLE_PINK "\r\nCheat Code Activated. Forcing device provisioning\r\n");
 }
 
 
@@ -284,6 +189,7 @@ static void Console_HelpMenu (int8_t selectedMenu)
                         "  Type 5 to save IOT thing name in flash memory\r\n"
                         "  Type 6 to check if credentials saved and their validity (format, length, etc.)\r\n"
                         "  Type 7 to get information about flash memory usage of this Renesas Cloud Kit\r\n"
+                        "  Type L to set the log level of each module, also while the application runs\r\n"
                             CONSOLE_MENU_RETURN);
     while ((CONSOLE_MENU_EXIT_KEY != key_pressed) && (CONSOLE_CONNECTION_ABORT != key_pressed))
     {
@@ -315,8 +221,8 @@ static void Console_FlashWriteCertMenu(int8_t selectedMenu)
     int8_t key_pressed = -1;
     char lastParsedChar;
     Console_ColorPrintf((void *) "\r\n %d) DATA FLASH WRITE CLAIM CERTIFICATE\r\n"
-                                 "\r\n[ORANGE]Paste claim certificate "
-                                 "[WHITE](or press BACKSPACE key to return to menu)\r\n", selectedMenu);
+                                 "\r\n" CONSOLE_ORANGE "Paste claim certificate "
+                                 CONSOLE_WHITE "(or press BACKSPACE key to return to menu)\r\n", selectedMenu);
     lastParsedChar = Console_ParseUserCredentials(CONSOLE_CERTIFICATE);
     if(lastParsedChar != CONSOLE_MENU_EXIT_KEY)
     {
@@ -337,8 +243,8 @@ static void Console_FlashWriteKeyMeu (int8_t selectedMenu)
     char lastParsedChar;
 
     Console_ColorPrintf((void *) "\r\n %d) DATA FLASH WRITE RSA CLAIM PRIVATE KEY\r\n"
-                                 "\r\n[ORANGE]Paste claim private key "
-                                 "[WHITE](or press BACKSPACE key to return to menu)\r\n", selectedMenu);
+                                 "\r\n" CONSOLE_ORANGE "Paste claim private key "
+                                 CONSOLE_WHITE "(or press BACKSPACE key to return to menu)\r\n", selectedMenu);
     lastParsedChar = Console_ParseUserCredentials(CONSOLE_RSA_PRIVATE_KEY);
     if(lastParsedChar != CONSOLE_MENU_EXIT_KEY)
     {
@@ -359,8 +265,8 @@ static void Console_FlashWriteIotNameMenu(int8_t selectedMenu)
     char lastParsedChar;
 
     Console_ColorPrintf((void *) "\r\n %d) DATA FLASH WRITE IOT THING NAME\r\n"
-                                 "\r\nPaste Iot Thing name then press [ORANGE]ENTER "
-                                 "[WHITE](or press BACKSPACE key to return to menu)\r\n", selectedMenu);
+                                 "\r\nPaste Iot Thing name then press " CONSOLE_ORANGE "ENTER "
+                                 CONSOLE_WHITE "(or press BACKSPACE key to return to menu)\r\n", selectedMenu);
     lastParsedChar = Console_ParseUserCredentials(CONSOLE_IOT_THING_NAME);
     if(lastParsedChar != CONSOLE_MENU_EXIT_KEY)
     {
@@ -383,8 +289,10 @@ static void Console_FlashWriteEndPointMenu(int8_t selectedMenu)
     char lastParsedChar;
 
     Console_ColorPrintf((void *) "\r\n %d) DATA FLASH WRITE MQTT BROKER ENDPOINT\r\n"
-                                 "\r\nPaste MQTT broker endpoint then press [ORANGE]ENTER "
-                                 "[WHITE](or press BACKSPACE key bar to return to menu)\r\n", selectedMenu);
+                                 "\r\nPaste MQTT broker endpoint then press " CONSOLE_ORANGE "ENTER "
+                                 CONSOLE_WHITE "(or press BACKSPACE key bar to return to menu)\r\n"
+                                 "Several endpoints can be given in order of preference, separated by "
+                                 CONSOLE_ORANGE "," CONSOLE_WHITE "\r\n", selectedMenu);
     lastParsedChar = Console_ParseUserCredentials(CONSOLE_MQTT_ENDPOINT);
     if(lastParsedChar != CONSOLE_MENU_EXIT_KEY)
     {
@@ -417,6 +325,69 @@ static void Console_FlashCheckCredentialsMenu(int8_t selectedMenu)
 }
 
 
+/* Levels are only changed in RAM, the caller saves them in data flash when it is allowed to write it */
+static bool Console_LogLevelMenu(int8_t selectedMenu)
+{
+    int8_t key_pressed = -1;
+    int8_t module;
+    int8_t level;
+    bool levelsChanged = false;
+
+    while ((CONSOLE_MENU_EXIT_KEY != key_pressed) && (CONSOLE_CONNECTION_ABORT != key_pressed))
+    {
+        Console_ColorPrintf("\r\n LOG LEVELS\r\n");
+        for (module = 0; module < (int8_t) CONSOLE_LOG_MODULE_COUNT; module++)
+        {
+            Console_ColorPrintf("\r\n %d. %-12s" CONSOLE_ORANGE "%s" CONSOLE_WHITE, (module + 1),
+                                ConsoleLogModuleNames[module], ConsoleLogLevelNames[ConsoleLogLevels[module]]);
+        }
+        Console_ColorPrintf("\r\n\r\n> Enter (1-%d) to select a module, then its level: 0 none, 1 error, 2 warning, "
+                            "3 info, 4 debug" CONSOLE_MENU_RETURN, CONSOLE_LOG_MODULE_COUNT);
+
+        key_pressed = Console_WaitForKeypress();
+        module = (int8_t) (key_pressed - '1');
+        if ((module >= 0) && (module < (int8_t) CONSOLE_LOG_MODULE_COUNT))
+        {
+            key_pressed = Console_WaitForKeypress();
+            level = (int8_t) (key_pressed - '0');
+            if ((level >= LOG_NONE) && (level <= LOG_DEBUG))
+            {
+                /* Taken into account by the next APP_*_PRINT of the module */
+                ConsoleLogLevels[module] = (uint8_t) level;
+                levelsChanged = true;
+            }
+        }
+    }
+
+    return levelsChanged;
+}
+
+static void Console_AppRunning(void)
+{
+    uint8_t rx_buf;
+
+    /* A read left pending by the boot menu window would take the next key */
+    (void) R_SCI_UART_Abort(&g_console_uart_ctrl, UART_DIR_RX);
+    Console_ColorPrintf("\r\n" CONSOLE_ORANGE " Press L to set log levels..." CONSOLE_WHITE "\r\n");
+    while (true)
+    {
+        /* Sleep until a key is received, the UART callback wakes this thread up */
+        rx_buf = 0u;
+        (void)ulTaskNotifyTake(pdTRUE, 0u);
+        ConsoleNotifyOnKey = true;
+        R_SCI_UART_Read (&g_console_uart_ctrl, &rx_buf, 1);
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ConsoleNotifyOnKey = false;
+
+        /* Data flash is shared with littleFS used by the cloud thread, levels changed here are not saved */
+        if (((rx_buf == 'l') || (rx_buf == 'L')) && (Console_LogLevelMenu(0) == true))
+        {
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "Log levels apply until reset, set them from the boot MENU "
+                                "to keep them." CONSOLE_WHITE "\r\n");
+        }
+    }
+}
+
 static char Console_ParseUserCredentials(ConsoleCredential_t credential)
 {
     bool inputCompleted = false;
@@ -489,7 +460,10 @@ static char Console_ParseUserCredentials(ConsoleCredential_t credential)
 
 /*****************************************************************************
  * Function Name: Console_ColorPrintf
- *                As printf, but replaces colour tags with escape codes
+ *                As printf. Colours are CONSOLE_<COLOUR> escape codes put in
+ *                the format string at compile time. The text is formatted in
+ *                the console log ring and sent from the UART interrupts, the
+ *                caller does not wait for the transmission
  * @param[in] char *format : the format string
  * @param[in] ... : argument list, 0 or more parameters
  * @retval None
@@ -497,34 +471,59 @@ static char Console_ParseUserCredentials(ConsoleCredential_t credential)
 void Console_ColorPrintf(const char *format, ...)
 {
     va_list arglist;
-    fsp_err_t err = FSP_SUCCESS;
-    static char colour_format[PRINT_BUFFER];
-    static char final_buffer[PRINT_BUFFER];
+    ConsoleLogRecord_t record;
+    int length;
 
-    /* Check if we can obtain the mutex.  If the mutex is not available
-     * wait 10 ticks to see if it becomes free.*/
-    if ((g_console_out_mutex != NULL) &&
-        (xSemaphoreTakeRecursive( g_console_out_mutex, ( TickType_t ) 10 ) == pdTRUE))
+    /* A full ring drops a log according to CONSOLE_LOG_OVERFLOW_POLICY, see Console_LogDropped */
+    if (Console_LogReserve(&record) == true)
     {
-        /*We were able to obtain the mutex and can now access the
-         * shared resource.*/
         va_start(arglist, format);
-        /* replace colour tokens with terminal colour escape codes */
-        Console_Detokenise(format, colour_format);
-        vsprintf (final_buffer, colour_format, arglist);
+        length = vsnprintf (record.text, CONSOLE_LOG_RECORD_SIZE, format, arglist);
         va_end(arglist);
 
-        ConsoleTransmitDone = false;
-        /* Uart write data */
-        err = R_SCI_UART_Write (&g_console_uart_ctrl, (uint8_t*) final_buffer, strlen (final_buffer));
-        assert(FSP_SUCCESS == err);
+        if (length < 0)
+        {
+            length = 0;
+        }
+        else if (length >= (int) CONSOLE_LOG_RECORD_SIZE)
+        {
+            length = (int) CONSOLE_LOG_RECORD_SIZE - 1;
+        }
+        else
+        {
+            /* Whole text formatted */
+        }
+        Console_LogCommit(&record, (size_t) length);
+    }
+}
+
+/*********************************************************************************************************************
+ * @brief  Print a text longer than a log, such as a credential, in CONSOLE_LOG_RECORD_SIZE - 1 byte chunks. Each chunk
+ *         waits for the ring to drain so that the overflow policy does not drop part of the text. Not for the
+ *         application tasks, the caller blocks while the UART sends the text.
+ *
+ * @param[in]   text                    Text to print, not NUL terminated
+ * @param[in]   length                  Length of the text
+ *********************************************************************************************************************/
+void Console_PrintText(const char *text, size_t length)
+{
+    ConsoleLogRecord_t record;
+    size_t chunk;
 
-        while (ConsoleTransmitDone != true)
+    while (length > 0u)
+    {
+        chunk = (length < (CONSOLE_LOG_RECORD_SIZE - 1u)) ? length : (CONSOLE_LOG_RECORD_SIZE - 1u);
+        while (Console_LogIdle() == false)
         {
-            vTaskDelay(1);
+            vTaskDelay (1);
         }
-        /* Release mutex so it can be taken by other tasks */
-        xSemaphoreGiveRecursive(g_console_out_mutex);
+        if (Console_LogReserve(&record) == true)
+        {
+            memcpy(record.text, text, chunk);
+            Console_LogCommit(&record, chunk);
+        }
+        text += chunk;
+        length -= chunk;
     }
 }
 
@@ -570,12 +569,17 @@ void Console_UartCallback(uart_callback_args_t *p_args)
         case UART_EVENT_RX_COMPLETE:
         {
             ConsoleUserInputReceived = true;
+            if(ConsoleNotifyOnKey == true)
+            {
+                vTaskNotifyGiveFromISR(console_thread, NULL);
+            }
             break;
         }
             /* Transmit complete */
         case UART_EVENT_TX_COMPLETE:
         {
-            ConsoleTransmitDone = true;
+            /* Release the log sent and chain the next one */
+            Console_LogTransmitDone();
             break;
         }
         default:
@@ -598,6 +602,8 @@ void Console_Init(void)
     /* Initialize UART channel with baud rate 115200 */
     err = R_SCI_UART_Open (&g_console_uart_ctrl, &g_console_uart_cfg);
     assert(err == FSP_SUCCESS);
+    /* Send the logs written before the UART was open */
+    Console_LogStart();
 
     /* Open Flash_HP */
     err = R_FLASH_HP_Open(&user_flash_ctrl, &user_flash_cfg);
@@ -605,6 +611,8 @@ void Console_Init(void)
     {
         /* Load credential storage status from flash memory */
          Console_LoadCredentialsFromFlash();
+        /* Log levels saved from the log level menu replace the default ones */
+        Console_LoadLogLevelsFromFlash();
 
         /* version get API for FLEX pack information */
         R_FSP_VersionGet(&ConsoleFSPversion);
@@ -634,37 +642,54 @@ void Console_DisplayMenu(void)
             (uint32_t) ConsoleDeviceUUID->unique_id_words[2], (uint32_t) ConsoleDeviceUUID->unique_id_words[3]);
     Console_ColorPrintf(consoleBanner);
 
+    Console_ColorPrintf("\r\n" CONSOLE_ORANGE " Press BACKSPACE key to open menu..." CONSOLE_WHITE "\r\n");
+    /* Start connecting with the credentials stored in flash right away, DHCP, DNS and TLS then run during the
+     * menu window instead of after it */
+    xTaskNotifyGive( cloud_app_thread );
 
-    Console_ColorPrintf("\r\n[ORANGE] Press BACKSPACE key to open menu...[WHITE]\r\n");
     /* Give possibility to user to avoid automatic connection with credentials stored in flash.
-     * Allow a 1 sec window where user can press BACKSPACE key to avoid starting cloud app and display menu*/
+     * Allow a window where user can press BACKSPACE key to stop the cloud app and display menu. The UART callback
+     * wakes this thread up on the first key, the window is only waited in full if no key is pressed */
+    (void)ulTaskNotifyTake(pdTRUE, 0u);
+    ConsoleNotifyOnKey = true;
     R_SCI_UART_Read (&g_console_uart_ctrl, &rx_buf, 1);
-    vTaskDelay(3000);
+    (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONSOLE_MENU_WINDOW_MS));
+    ConsoleNotifyOnKey = false;
 
     if(rx_buf != CONSOLE_MENU_EXIT_KEY)
     {
         /* User did NOT press BACKSPACE key, thus try to connect with to MQTT broker with credential stored in flash. */
-        Console_ColorPrintf("\r\n[GREEN]Starting AWS cloud Application....[WHITE]\r\n");
+        Console_ColorPrintf("\r\n" CONSOLE_GREEN "Starting AWS cloud Application...." CONSOLE_WHITE "\r\n");
         /* Give some feedback to user on credentials used */
         if(ConsoleClaimCertificateStored == true)
         {
-            Console_ColorPrintf("\r\n[YELLOW]Loading Claim Certificate from flash memory instead of default.[WHITE]\r\n");
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "Loading Claim Certificate from flash memory instead of default."
+                                CONSOLE_WHITE "\r\n");
         }
         if(ConsoleClaimPrivateKeyStored == true)
         {
-            Console_ColorPrintf("\r\n[YELLOW]Loading Claim PrivateKey from flash memory instead of default.[WHITE]\r\n");
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "Loading Claim PrivateKey from flash memory instead of default."
+                                CONSOLE_WHITE "\r\n");
         }
         if(ConsoleMqttEndpointStored == true)
         {
-            Console_ColorPrintf("\r\n[YELLOW]Loading MQTT Broker Endpoint from flash memory instead of default.[WHITE]\r\n");
-        }
-        /* Notify cloud app thread so that it can try to use stored credentials to connect the device */
-        xTaskNotifyGive( cloud_app_thread );
-        /* Stop this thread's execution. If the mqtt broker endpoint exists in flash */
-        while(true)
-        {
-            vTaskDelay(5000);
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "Loading MQTT Broker Endpoint from flash memory instead of "
+                                "default." CONSOLE_WHITE "\r\n");
         }
+        /* Let cloud app thread go on with the connection made with stored credentials */
+        CloudProv_BootDecide(true);
+        /* Only the log level menu is left to the console once the application runs */
+        Console_AppRunning();
+    }
+
+    /* Close the connection started at boot before the menu can change credentials */
+    Console_ColorPrintf("\r\n" CONSOLE_ORANGE "Stopping AWS cloud Application..." CONSOLE_WHITE "\r\n");
+    CloudProv_BootDecide(false);
+    while(CloudProv_BootAwaitStopped(CONSOLE_MENU_STOP_TIMEOUT_MS) != true)
+    {
+        /* Menu options write the flash shared with littleFS, they must not run while the cloud thread uses it */
+        Console_ColorPrintf("\r\n" CONSOLE_ORANGE "Still waiting for AWS cloud Application to stop..."
+                            CONSOLE_WHITE "\r\n");
     }
 
     /* Wait user inputs an option available on menu OR until uart is disconnected */
@@ -678,11 +703,12 @@ void Console_DisplayMenu(void)
         {
             Console_ColorPrintf((void *) "\r\n %d. %s", (item + 1), ConsoleMainMenus[menuItemCount++].menuName);
         }
+        Console_ColorPrintf("\r\n L. Log levels");
         Console_ColorPrintf("\r\n\r\n> Enter (1-%d) to select options\r\n\r\n", menuItemCount);
 
         if(optionValid == false)
         {
-            Console_ColorPrintf("\r\n[ORANGE]Please enter valid option.[WHITE]");
+            Console_ColorPrintf("\r\n" CONSOLE_ORANGE "Please enter valid option." CONSOLE_WHITE);
         }
 
         key_pressed = Console_WaitForKeypress();
@@ -696,6 +722,16 @@ void Console_DisplayMenu(void)
             Console_ColorPrintf(consoleBanner);
             ConsoleMainMenus[num_key_pressed - 1].displayMenu(num_key_pressed);
         }
+        else if((key_pressed == 'l') || (key_pressed == 'L'))
+        {
+            optionValid = true;
+            Console_ColorPrintf(consoleBanner);
+            /* Cloud thread is stopped, levels can be kept for the next start up */
+            if(Console_LogLevelMenu(0) == true)
+            {
+                (void) Console_StoreLogLevels();
+            }
+        }
         else if(key_pressed == 'f')
         {
             Console_ForceDeviceProvisioning(0u);
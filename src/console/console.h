@@ -27,14 +27,26 @@
 #include <logging_levels.h>
 #include <SEGGER_RTT.h>
 #include <console_thread.h>
+#include <console_log.h>
 
 
 
-#define MINIMUM_TOKEN_LENGTH      ( 5)   // minimum length of a colour token
-#define MAXIMUM_TOKEN_LENGTH      (10)   // maximum length of a colour token
-#define PRINT_BUFFER              (2*1024)
 #define TRANSFER_LENGTH           (2048)
 
+/* Terminal colour escape codes, concatenated with the format strings at compile time */
+#define CONSOLE_BLACK             "\x1B[30m"
+#define CONSOLE_RED               "\x1B[91m"
+#define CONSOLE_GREEN             "\x1B[92m"
+#define CONSOLE_YELLOW            "\x1B[93m"
+#define CONSOLE_BLUE              "\x1B[94m"
+#define CONSOLE_MAGENTA           "\x1B[95m"
+#define CONSOLE_CYAN              "\x1B[96m"
+#define CONSOLE_WHITE             "\x1B[97m"
+#define CONSOLE_ORANGE            "\x1B[38;5;208m"
+#define CONSOLE_PINK              "\x1B[38;5;212m"
+#define CONSOLE_BROWN             "\x1B[38;5;94m"
+#define CONSOLE_PURPLE            "\x1B[35m"
+
 
 
 
@@ -48,7 +60,8 @@
 #define LOG_TERMINAL      (UART_TERMINAL)     /* error conditions   */
 #endif
 
-#define LOG_LVL      (LOG_INFO)       /* error conditions   */
+/* Most verbose level built in, the level of each module is then set at run time, see ConsoleLogLevels */
+#define LOG_LVL      (LOG_DEBUG)
 
 
 #define RESET_VALUE             (0x00)
@@ -59,57 +72,83 @@
 #define SEGGER_INDEX            (0)
 
 
+/* fn_ has to be a string literal, the prefix and colour of each level are joined to it at compile time. The level of
+ * the module of the calling file is checked before the arguments are evaluated, see CONSOLE_LOG_MODULE */
+#if (CONSOLE_LOG_BINARY == 1)
+/* Binary frames formatted on the host by script/console_log_decode.py, see CONSOLE_LOG_FRAME */
+#define APP_PRINT(fn_, ...)         ({CONSOLE_LOG_FRAME(CONSOLE_WHITE fn_, ##__VA_ARGS__);})
+
+#define APP_ERR_PRINT(fn_, ...)     ({if(CONSOLE_LOG_ENABLED(LOG_ERROR)){\
+                                        CONSOLE_LOG_FRAME(CONSOLE_RED "[ERR] In Function: %s(), " fn_,\
+                                                          __FUNCTION__, ##__VA_ARGS__);\
+                                     }})
+
+#define APP_WARN_PRINT(fn_, ...) ({if(CONSOLE_LOG_ENABLED(LOG_WARN)){\
+                                     CONSOLE_LOG_FRAME(CONSOLE_YELLOW "[WARN] In Function: %s(), " fn_,\
+                                                       __FUNCTION__, ##__VA_ARGS__);\
+                                 }})
+
+#define APP_INFO_PRINT(fn_, ...) ({if(CONSOLE_LOG_ENABLED(LOG_INFO)){\
+                                     CONSOLE_LOG_FRAME(CONSOLE_WHITE "[INFO] In Function: %s(), " fn_,\
+                                                       __FUNCTION__, ##__VA_ARGS__);\
+                                 }})
+
+#define APP_DBG_PRINT(fn_, ...)  ({if(CONSOLE_LOG_ENABLED(LOG_DEBUG)){\
+                                     CONSOLE_LOG_FRAME(CONSOLE_BLUE "[DBG] In Function: %s(), " fn_,\
+                                                       __FUNCTION__, ##__VA_ARGS__);\
+                                 }})
+#else
 #define APP_PRINT(fn_, ...)         ({if(LOG_TERMINAL == RTT_TERMINAL){\
-                                       SEGGER_RTT_printf (SEGGER_INDEX,(fn_), ##__VA_ARGS__);\
+                                       SEGGER_RTT_printf (SEGGER_INDEX, fn_, ##__VA_ARGS__);\
                                     }\
                                     else {                             \
-                                       Console_ColorPrintf("[WHITE]"); \
-                                        Console_ColorPrintf(fn_ , ##__VA_ARGS__);\
+                                        Console_ColorPrintf(CONSOLE_WHITE fn_, ##__VA_ARGS__);\
                                     }})
 
-#define APP_ERR_PRINT(fn_, ...)     ({if(LOG_LVL >= LOG_ERROR){\
+#define APP_ERR_PRINT(fn_, ...)     ({if(CONSOLE_LOG_ENABLED(LOG_ERROR)){\
                                         if(LOG_TERMINAL == RTT_TERMINAL){\
-                                            SEGGER_RTT_printf (SEGGER_INDEX, "[ERR] In Function: %s(), ", __FUNCTION__);\
-      									    SEGGER_RTT_printf (SEGGER_INDEX, (fn_), ##__VA_ARGS__);\
-                                     	}\
+                                            SEGGER_RTT_printf (SEGGER_INDEX, "[ERR] In Function: %s(), " fn_,\
+                                                               __FUNCTION__, ##__VA_ARGS__);\
+                                        }\
                                         else {\
-                                            Console_ColorPrintf("[RED][ERR] In Function: %s(), ",__FUNCTION__);\
-                                            Console_ColorPrintf(fn_, ##__VA_ARGS__);\
+                                            Console_ColorPrintf(CONSOLE_RED "[ERR] In Function: %s(), " fn_,\
+                                                                __FUNCTION__, ##__VA_ARGS__);\
                                         }\
-								     }})
+                                     }})
 
-#define APP_WARN_PRINT(fn_, ...) ({if(LOG_LVL >= LOG_WARN){\
+#define APP_WARN_PRINT(fn_, ...) ({if(CONSOLE_LOG_ENABLED(LOG_WARN)){\
                                      if(LOG_TERMINAL == RTT_TERMINAL){\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, "[WARN] In Function: %s(), ", __FUNCTION__);\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, (fn_), ##__VA_ARGS__);\
-                                     	}\
+                                         SEGGER_RTT_printf (SEGGER_INDEX, "[WARN] In Function: %s(), " fn_,\
+                                                            __FUNCTION__, ##__VA_ARGS__);\
+                                     }\
                                      else {\
-                                         Console_ColorPrintf("[YELLOW][WARN] In Function: %s(), ",__FUNCTION__); \
-                                         Console_ColorPrintf(fn_, ##__VA_ARGS__);\
+                                         Console_ColorPrintf(CONSOLE_YELLOW "[WARN] In Function: %s(), " fn_,\
+                                                             __FUNCTION__, ##__VA_ARGS__);\
                                      }\
-								 }})
+                                 }})
 
-#define APP_INFO_PRINT(fn_, ...) ({if(LOG_LVL >= LOG_INFO){\
+#define APP_INFO_PRINT(fn_, ...) ({if(CONSOLE_LOG_ENABLED(LOG_INFO)){\
                                      if(LOG_TERMINAL == RTT_TERMINAL){\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, "[INFO] In Function: %s(), ", __FUNCTION__);\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, (fn_), ##__VA_ARGS__);\
-                                     	}\
+                                         SEGGER_RTT_printf (SEGGER_INDEX, "[INFO] In Function: %s(), " fn_,\
+                                                            __FUNCTION__, ##__VA_ARGS__);\
+                                     }\
                                      else {\
-                                         Console_ColorPrintf("[WHITE][INFO] In Function: %s(), ",__FUNCTION__);\
-                                         Console_ColorPrintf(fn_, ##__VA_ARGS__);\
-                                    }\
+                                         Console_ColorPrintf(CONSOLE_WHITE "[INFO] In Function: %s(), " fn_,\
+                                                             __FUNCTION__, ##__VA_ARGS__);\
+                                     }\
                                  }})
 
-#define APP_DBG_PRINT(fn_, ...)  ({if(LOG_LVL >= LOG_DEBUG){\
+#define APP_DBG_PRINT(fn_, ...)  ({if(CONSOLE_LOG_ENABLED(LOG_DEBUG)){\
                                      if(LOG_TERMINAL == RTT_TERMINAL){\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, "[DBG] In Function: %s(), ", __FUNCTION__);\
-                                         SEGGER_RTT_printf (SEGGER_INDEX, (fn_), ##__VA_ARGS__);\
-                                     	}\
+                                         SEGGER_RTT_printf (SEGGER_INDEX, "[DBG] In Function: %s(), " fn_,\
+                                                            __FUNCTION__, ##__VA_ARGS__);\
+                                     }\
                                      else {\
-                                         Console_ColorPrintf("[BLUE][DBG] In Function: %s(), ",__FUNCTION__); \
-                                         Console_ColorPrintf(fn_, ##__VA_ARGS__);\
+                                         Console_ColorPrintf(CONSOLE_BLUE "[DBG] In Function: %s(), " fn_,\
+                                                             __FUNCTION__, ##__VA_ARGS__);\
                                      }\
                                  }})
+#endif
 
 #define APP_ERR_TRAP(err)        ({if(err){\
                                      if(LOG_LVL >= RTT_TERMINAL){\
@@ -117,7 +156,7 @@
                                          __BKPT(0);\
                                      }\
                                      else {\
-                                         Console_ColorPrintf("[ORANGE]\r\nReturned Error Code: 0x%x	\r\n", (unsigned int)err);\
+                                         Console_ColorPrintf(CONSOLE_ORANGE "\r\nReturned Error Code: 0x%x	\r\n", (unsigned int)err);\
                                          __BKPT(0);\
                                      }\
                                  }})
@@ -127,6 +166,7 @@
 #define APP_CHECK_DATA          (SEGGER_RTT_HasKey())
 
 void Console_ColorPrintf(const char *format, ...);
+void Console_PrintText(const char *text, size_t length);
 void Console_Init(void);
 void Console_DisplayMenu(void);
 
@@ -31,6 +31,12 @@ bool ConsoleClaimCertificateStored = false;
 bool ConsoleClaimPrivateKeyStored = false;
 
 static ConsoleCredentialMem_t ConsoleDataFlashInfo[5];
+static ConsoleCredentialMem_t ConsoleLogLevelsMem =
+{
+    .num_bytes = BLOCK_SIZE_LOG_LEVELS,
+    .addr = FLASH_HP_DF_LOG_LEVELS,
+    .num_block = BLOCK_NUM_LOG_LEVELS,
+};
 static bool ConsoleFashEventNotBlank = false;
 static bool ConsoleFlashEventBlank = false;
 static bool ConsoleFlashEventEraseComplete = false;
@@ -179,6 +185,7 @@ void Console_LoadCredentialsFromFlash(void)
          * trying to provision the device in fleet provisioning workflow */
         CloudProv_ImportClaimCertificate((uint8_t *) ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].addr,
                                          ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].length,
+                                         BLOCK_SIZE_CERT,
                                          false);
     }
     else
@@ -194,6 +201,7 @@ void Console_LoadCredentialsFromFlash(void)
          * trying to provision the device in fleet provisioning workflow */
         CloudProv_ImportClaimPrivateKey((uint8_t *) ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].addr,
                                         ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].length,
+                                        BLOCK_SIZE_KEY,
                                         false);
     }
     else
@@ -264,11 +272,11 @@ void Console_ResetClaimCredentials(void)
 
     if (err == FSP_SUCCESS)
     {
-        Console_ColorPrintf("\r\n[GREEN]Data flash info successfully writen to flash.[WHITE]\r\n");
+        Console_ColorPrintf("\r\n" CONSOLE_GREEN "Data flash info successfully writen to flash." CONSOLE_WHITE "\r\n");
     }
     else
     {
-        Console_ColorPrintf("\r\n[RED]Data flash info write to flash failed.[WHITE]\r\n");
+        Console_ColorPrintf("\r\n" CONSOLE_RED "Data flash info write to flash failed." CONSOLE_WHITE "\r\n");
     }
 }
 
@@ -285,19 +293,21 @@ void Console_CheckStoredCredentials(void)
         if ((NULL != strstr (read_buffer, "-----END CERTIFICATE-----"))
                 && (strlen (read_buffer) == ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].length))
         {
-            Console_ColorPrintf("\r\n [GREEN]Claim Certificate saved in data flash is correctly formatted[WHITE]\r\n");
+            Console_ColorPrintf("\r\n " CONSOLE_GREEN "Claim Certificate saved in data flash is correctly formatted"
+                                CONSOLE_WHITE "\r\n");
             memset (read_buffer, 0, strlen (read_buffer));
         }
         else
         {
-            Console_ColorPrintf("\r\n [RED]Claim Certificate saved in data flash is invalid[WHITE]\r\n");
+            Console_ColorPrintf("\r\n " CONSOLE_RED "Claim Certificate saved in data flash is invalid"
+                                CONSOLE_WHITE "\r\n");
             memset (ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].stored_in_flash, 0, CONSOLE_FLASH_LENGTH_SAVE);
         }
     }
     else
     {
-        Console_ColorPrintf("\r\n [RED]No Claim Certificate is saved in data flash\r\n"
-                            "Cloud Application will try to use default value[WHITE]\r\n");
+        Console_ColorPrintf("\r\n " CONSOLE_RED "No Claim Certificate is saved in data flash\r\n"
+                            "Cloud Application will try to use default value" CONSOLE_WHITE "\r\n");
     }
 
     /* Check if credential is stored in flash */
@@ -309,19 +319,21 @@ void Console_CheckStoredCredentials(void)
         if ((NULL != strstr (read_buffer, "-----END RSA PRIVATE KEY-----"))
                 && (strlen (read_buffer) == ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].length))
         {
-            Console_ColorPrintf("\r\n [GREEN]Claim Private key saved in data flash is correctly formatted[WHITE]\r\n");
+            Console_ColorPrintf("\r\n " CONSOLE_GREEN "Claim Private key saved in data flash is correctly formatted"
+                                CONSOLE_WHITE "\r\n");
             memset (read_buffer, 0, strlen (read_buffer));
         }
         else
         {
-            Console_ColorPrintf("\r\n [RED]Claim Private key saved in data flash is invalid[WHITE]\r\n");
+            Console_ColorPrintf("\r\n " CONSOLE_RED "Claim Private key saved in data flash is invalid"
+                                CONSOLE_WHITE "\r\n");
             memset (ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].stored_in_flash, 0, CONSOLE_FLASH_LENGTH_SAVE);
         }
     }
     else
     {
-        Console_ColorPrintf("\r\n [RED]No Claim Private key is saved in data flash\r\n"
-                            "Cloud Application will try to use default value[WHITE]\r\n");
+        Console_ColorPrintf("\r\n " CONSOLE_RED "No Claim Private key is saved in data flash\r\n"
+                            "Cloud Application will try to use default value" CONSOLE_WHITE "\r\n");
     }
 
     /* Check if credential is stored in flash */
@@ -335,20 +347,22 @@ void Console_CheckStoredCredentials(void)
          * was removed from count for easier string manipulations */
         if (strlen (read_buffer) == (ConsoleDataFlashInfo[CONSOLE_MQTT_ENDPOINT].length +1u))
         {
-            Console_ColorPrintf("\r\n [GREEN]MQTT end point saved in data flash has valid length[WHITE]\r\n");
-            Console_ColorPrintf("\r\n     >[ORANGE]%s[WHITE]\r\n", read_buffer);
+            Console_ColorPrintf("\r\n " CONSOLE_GREEN "MQTT end point saved in data flash has valid length"
+                                CONSOLE_WHITE "\r\n");
+            Console_ColorPrintf("\r\n     >" CONSOLE_ORANGE "%s" CONSOLE_WHITE "\r\n", read_buffer);
             memset (read_buffer, 0, strlen (read_buffer));
         }
         else
         {
-            Console_ColorPrintf("\r\n [RED]MQTT endpoint from flash memory has invalid lenth.[WHITE]\r\n");
+            Console_ColorPrintf("\r\n " CONSOLE_RED "MQTT endpoint from flash memory has invalid lenth."
+                                CONSOLE_WHITE "\r\n");
             memset (ConsoleDataFlashInfo[CONSOLE_MQTT_ENDPOINT].stored_in_flash, 0, CONSOLE_FLASH_LENGTH_SAVE);
         }
     }
     else
     {
-        Console_ColorPrintf("\r\n [RED]No MQTT end point is not saved in data flash.\r\n"
-                            "Cloud Application will try to use default value[WHITE]\r\n");
+        Console_ColorPrintf("\r\n " CONSOLE_RED "No MQTT end point is not saved in data flash.\r\n"
+                            "Cloud Application will try to use default value" CONSOLE_WHITE "\r\n");
     }
 
     /* Check if credential is stored in flash */
@@ -362,25 +376,71 @@ void Console_CheckStoredCredentials(void)
         * was removed from count for easier string manipulations */
         if (strlen (read_buffer) == ConsoleDataFlashInfo[CONSOLE_IOT_THING_NAME].length +1u)
         {
-            Console_ColorPrintf("\r\n [GREEN]IOT thing name saved in data flash has valid length[WHITE]\r\n\r\n");
-            Console_ColorPrintf("\r\n     >[ORANGE]%s[WHITE]\r\n", read_buffer);
+            Console_ColorPrintf("\r\n " CONSOLE_GREEN "IOT thing name saved in data flash has valid length"
+                                CONSOLE_WHITE "\r\n\r\n");
+            Console_ColorPrintf("\r\n     >" CONSOLE_ORANGE "%s" CONSOLE_WHITE "\r\n", read_buffer);
 
             memset (read_buffer, 0, strlen (read_buffer));
         }
         else
         {
             Console_ColorPrintf(
-                    "\r\n [RED]IOT thing name saved in data flash has invalid length[WHITE]\r\n");
+                    "\r\n " CONSOLE_RED "IOT thing name saved in data flash has invalid length" CONSOLE_WHITE "\r\n");
             memset (ConsoleDataFlashInfo[CONSOLE_IOT_THING_NAME].stored_in_flash, 0, CONSOLE_FLASH_LENGTH_SAVE);
         }
     }
     else
     {
-        Console_ColorPrintf("\r\n [RED]No IOT thing name is saved in data flash.\r\n"
-                            "Cloud Application will try to use default value[WHITE]\r\n");
+        Console_ColorPrintf("\r\n " CONSOLE_RED "No IOT thing name is saved in data flash.\r\n"
+                            "Cloud Application will try to use default value" CONSOLE_WHITE "\r\n");
+    }
+}
+
+/*******************************************************************************************************************//**
+ * @brief Set the log level of each module to the one saved in data flash. Default levels are kept if none were saved.
+ **********************************************************************************************************************/
+void Console_LoadLogLevelsFromFlash(void)
+{
+    const uint8_t *storedLevels = (const uint8_t *) FLASH_HP_DF_LOG_LEVELS + CONSOLE_FLASH_LENGTH_SAVE;
+
+    if (0 == strncmp ((char *)FLASH_HP_DF_LOG_LEVELS, (char *)CONSOLE_FLASH_SAVE, CONSOLE_FLASH_LENGTH_SAVE))
+    {
+        for(uint8_t module = 0u; module < CONSOLE_LOG_MODULE_COUNT; module++)
+        {
+            if (storedLevels[module] <= LOG_DEBUG)
+            {
+                ConsoleLogLevels[module] = storedLevels[module];
+            }
+        }
     }
 }
 
+/*******************************************************************************************************************//**
+ * @brief Save the current log level of each module in data flash, loaded at the next start up.
+ * @retval      FSP_SUCCESS             Upon successful write
+ * @retval      Any Other Error code    Upon unsuccessful write
+ **********************************************************************************************************************/
+fsp_err_t Console_StoreLogLevels(void)
+{
+    fsp_err_t err = FSP_SUCCESS;
+    uint8_t logLevelsBlock[BLOCK_SIZE_LOG_LEVELS] = {0u};
+
+    memcpy (logLevelsBlock, CONSOLE_FLASH_SAVE, CONSOLE_FLASH_LENGTH_SAVE);
+    memcpy (&logLevelsBlock[CONSOLE_FLASH_LENGTH_SAVE], ConsoleLogLevels, CONSOLE_LOG_MODULE_COUNT);
+    err = Console_WriteToFlash(&ConsoleLogLevelsMem, logLevelsBlock);
+
+    if (err == FSP_SUCCESS)
+    {
+        Console_ColorPrintf("\r\n" CONSOLE_GREEN "Log levels successfully writen to flash." CONSOLE_WHITE "\r\n");
+    }
+    else
+    {
+        Console_ColorPrintf("\r\n" CONSOLE_RED "Log levels write to flash failed." CONSOLE_WHITE "\r\n");
+    }
+
+    return err;
+}
+
 void Console_FlashDeinit(void)
 {
     fsp_err_t err = FSP_SUCCESS;
@@ -433,8 +493,11 @@ fsp_err_t Console_StoreAwsCredential(ConsoleCredential_t credentialType, const c
 
     if (err == FSP_SUCCESS)
     {
-        Console_ColorPrintf("\r\n[GREEN]Credential successfully writen to flash.\r\n"
-                                   "    >[WHITE]%s\r\n", credentialBuffer);
+        /* Certificates and keys are longer than a console log, the credential is printed on its own */
+        Console_ColorPrintf("\r\n" CONSOLE_GREEN "Credential successfully writen to flash.\r\n"
+                                   "    >" CONSOLE_WHITE);
+        Console_PrintText(credentialBuffer, credentialLength);
+        Console_ColorPrintf("\r\n");
         /* Store flash data info in flash memory. This basically serves the purpose of knowing at application
          * startup if data was saved previously in flash or not, with standard string labels */
         strcpy((char *)ConsoleDataFlashInfo[credentialType].stored_in_flash, (char *)CONSOLE_FLASH_SAVE);
@@ -444,11 +507,12 @@ fsp_err_t Console_StoreAwsCredential(ConsoleCredential_t credentialType, const c
 
         if (err == FSP_SUCCESS)
         {
-            Console_ColorPrintf("\r\n[GREEN]Data flash info successfully writen to flash.[WHITE]\r\n");
+            Console_ColorPrintf("\r\n" CONSOLE_GREEN "Data flash info successfully writen to flash."
+                                CONSOLE_WHITE "\r\n");
         }
         else
         {
-            Console_ColorPrintf("\r\n[RED]Data flash info write to flash failed.[WHITE]\r\n");
+            Console_ColorPrintf("\r\n" CONSOLE_RED "Data flash info write to flash failed." CONSOLE_WHITE "\r\n");
         }
 
         if(credentialType == CONSOLE_MQTT_ENDPOINT)
@@ -465,24 +529,26 @@ fsp_err_t Console_StoreAwsCredential(ConsoleCredential_t credentialType, const c
         {
             CloudProv_ImportClaimCertificate((uint8_t *) ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].addr,
                                              ConsoleDataFlashInfo[CONSOLE_CERTIFICATE].length,
+                                             BLOCK_SIZE_CERT,
                                              true);
-            Console_ColorPrintf("\r\n[YELLOW][IMPORTANT]To force Device Provisioning with this new "
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "[IMPORTANT]To force Device Provisioning with this new "
                                 "Claim Certificate, DO NOT reset the Cloud Kit. Instead, leave this menu, "
-                                "enter other credentials if needed and start application [WHITE]\r\n");
+                                "enter other credentials if needed and start application " CONSOLE_WHITE "\r\n");
         }
         else if(credentialType == CONSOLE_RSA_PRIVATE_KEY)
         {
             CloudProv_ImportClaimPrivateKey((uint8_t *) ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].addr,
                                             ConsoleDataFlashInfo[CONSOLE_RSA_PRIVATE_KEY].length,
+                                            BLOCK_SIZE_KEY,
                                             true);
-            Console_ColorPrintf("\r\n[YELLOW][IMPORTANT] To force Device Provisioning with this new "
+            Console_ColorPrintf("\r\n" CONSOLE_YELLOW "[IMPORTANT] To force Device Provisioning with this new "
                                 "RSA Claim Private Key, DO NOT reset the Cloud Kit. Instead, leave this menu, "
-                                "enter other credentials if needed and start application [WHITE]\r\n");
+                                "enter other credentials if needed and start application " CONSOLE_WHITE "\r\n");
         }
     }
     else
     {
-        Console_ColorPrintf("\r\n[RED]Credential write to flash failed.[WHITE]\r\n");
+        Console_ColorPrintf("\r\n" CONSOLE_RED "Credential write to flash failed." CONSOLE_WHITE "\r\n");
     }
 
     return err;
@@ -56,29 +56,35 @@ typedef enum
 /* Data Flash */
 #define FLASH_HP_DF_BLOCK_0               (0x08001000U) /*   64 B:    0x80001000 - 0x8000103F */
 #define FLASH_HP_DF_BLOCK_CERTIFICATE     (0x08001040U) /*   1536 B:  0x08001040 - 0x0800163F */
-#define FLASH_HP_DF_BLOCK_KEY             (0x08001640U) /*   2048 B:  0x08001640 - 0x08001E3F */
-#define FLASH_HP_DF_MQTT_END_POINT        (0x08001E40U) /*   128 B:   0x08001E40 - 0x08001EBF */
+#define FLASH_HP_DF_BLOCK_KEY             (0x08001640U) /*   1920 B:  0x08001640 - 0x08001DBF */
+#define FLASH_HP_DF_MQTT_END_POINT        (0x08001DC0U) /*   256 B:   0x08001DC0 - 0x08001EBF */
 #define FLASH_HP_DF_IOT_THING_NAME        (0x08001EC0U) /*   128 B:   0x08001EC0 - 0x08001F3F */
 #define FLASH_HP_DF_DATA_INFO             (0x08001F40U) /*   128 B:   0x08001F40 - 0x08001FBF */
+#define FLASH_HP_DF_LOG_LEVELS            (0x08001FC0U) /*   64 B:    0x08001FC0 - 0x08001FFF */
 
 
-#define TOTAL_BLOCK_SIZE                  (3968)
-#define TOTAL_BLOCK_NUM					  (62)
+#define TOTAL_BLOCK_SIZE                  (4032)
+#define TOTAL_BLOCK_NUM					  (63)
 
 #define BLOCK_SIZE_CERT                   (1536)
 #define BLOCK_NUM_CERT			          (24)
 
-#define BLOCK_SIZE_KEY                    (2048)
-#define BLOCK_NUM_KEY			          (32)
+#define BLOCK_SIZE_KEY                    (1920)
+#define BLOCK_NUM_KEY			          (30)
 
-#define BLOCK_SIZE_MQTT_ENDPOINT          (128)
-#define BLOCK_NUM_MQTT_ENDPOINT	          (2)
+/* Holds the whole endpoint list, see CLOUD_PROV_ENDPOINT_LIST_BUFFER_SIZE */
+#define BLOCK_SIZE_MQTT_ENDPOINT          (256)
+#define BLOCK_NUM_MQTT_ENDPOINT	          (4)
 
 #define BLOCK_SIZE_IOT_THING              (128)
 #define BLOCK_NUM_IOT_THING		          (2)
 
 #define BLOCK_SIZE_DATA_INFO              (128)
 #define BLOCK_NUM_DATA_INFO		          (2)
+
+/* Saved status string followed by the level of each module, see ConsoleLogLevels */
+#define BLOCK_SIZE_LOG_LEVELS             (64)
+#define BLOCK_NUM_LOG_LEVELS              (1)
 //
 #define BUFFER_SIZE                       (2048)
 
@@ -94,5 +100,7 @@ void Console_FlashSizesInfo(uint32_t *physicalSize, uint32_t *allocatedSize, uin
 void Console_ResetClaimCredentials(void);
 void Console_LoadCredentialsFromFlash (void);
 void Console_CheckStoredCredentials (void);
+void Console_LoadLogLevelsFromFlash(void);
+fsp_err_t Console_StoreLogLevels(void);
 
 #endif /* CONSOLE_FLASH_H */
@@ -0,0 +1,350 @@
+/***********************************************************************************************************************
+ * File Name    : console_log.c
+ * Description  : Lock-free ring of formatted console logs, drained to the console UART from its interrupts
+ **********************************************************************************************************************/
+/*
+ * The ring is split in CONSOLE_LOG_SLOT_COUNT slots, each holding a sequence number (Vyukov bounded queue):
+ * - a slot is free for the log reserved at ring position p when its sequence is p,
+ * - the first slot of a log is committed when its sequence is p + 1, its other slots keep the free sequence,
+ * - the sender frees the slots of a log once it is copied to the transmit buffer, sequence p + CONSOLE_LOG_SLOT_COUNT.
+ * Tasks reserve CONSOLE_LOG_RECORD_SLOTS contiguous slots with a compare and swap of ConsoleLogEnqueue, so the text
+ * of a log never wraps and is formatted in place. A reservation that would wrap takes the slots up to the end of the
+ * ring as a padding log, which is committed empty and skipped by the sender.
+ * The sender owns ConsoleLogBusy from the start of a write until its transmit complete interrupt, which chains the
+ * next committed log, so a log costs its caller the formatting only. Copying the log out of the ring before the write
+ * keeps the ring free of the log on the wire: the oldest log in the ring is then the one blocking a reservation, which
+ * the drop-oldest policy can take out.
+ */
+#include <string.h>
+#include <console.h>
+#include <console_log.h>
+
+#define CONSOLE_LOG_SLOT_MASK       (CONSOLE_LOG_SLOT_COUNT - 1u)
+
+#if ((CONSOLE_LOG_SLOT_COUNT & CONSOLE_LOG_SLOT_MASK) != 0u)
+#error "CONSOLE_LOG_SLOT_COUNT must be a power of two"
+#endif
+#if ((2u * CONSOLE_LOG_RECORD_SLOTS) > CONSOLE_LOG_SLOT_COUNT)
+#error "CONSOLE_LOG_SLOT_COUNT must hold a log and its padding to the end of the ring"
+#endif
+
+typedef struct
+{
+    /** Ring position the slot is free or committed for, less the slot index so that zeroed slots are free */
+    uint32_t sequence;
+    /** Length of the text of the log starting at this slot, 0 for padding */
+    uint16_t length;
+    /** Number of slots of the log starting at this slot */
+    uint8_t count;
+}ConsoleLogSlot_t;
+
+static char ConsoleLogText[CONSOLE_LOG_SLOT_COUNT * CONSOLE_LOG_SLOT_SIZE];
+static ConsoleLogSlot_t ConsoleLogSlots[CONSOLE_LOG_SLOT_COUNT];
+/** @brief Ring position of the next reservation */
+static uint32_t ConsoleLogEnqueue = 0u;
+/** @brief Ring position of the oldest log not sent */
+static uint32_t ConsoleLogDequeue = 0u;
+/** @brief Log the UART is sending */
+static char ConsoleLogTransmit[CONSOLE_LOG_RECORD_SIZE];
+/** @brief Set from the start of a write to its transmit complete interrupt */
+static bool ConsoleLogBusy = false;
+/** @brief Set once the UART is open */
+static bool ConsoleLogStarted = false;
+static uint32_t ConsoleLogDroppedCount = 0u;
+
+uint8_t ConsoleLogLevels[CONSOLE_LOG_MODULE_COUNT] =
+{
+    CONSOLE_LOG_LEVEL_DEFAULT, CONSOLE_LOG_LEVEL_DEFAULT, CONSOLE_LOG_LEVEL_DEFAULT,
+    CONSOLE_LOG_LEVEL_DEFAULT, CONSOLE_LOG_LEVEL_DEFAULT, CONSOLE_LOG_LEVEL_DEFAULT
+};
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTION PROTOTYPES
+**********************************************************************************************************************/
+/**
+ * @brief Read the sequence of the slot at a ring position.
+ */
+static uint32_t Console_LogSequence(uint32_t position);
+
+/**
+ * @brief Publish the sequence of the slot at a ring position.
+ */
+static void Console_LogSetSequence(uint32_t position, uint32_t sequence);
+
+/**
+ * @brief Give the slots of a log back to the ring, for the lap after.
+ */
+static void Console_LogFree(uint32_t position, uint8_t count);
+
+#if (CONSOLE_LOG_OVERFLOW_POLICY == CONSOLE_LOG_DROP_OLDEST)
+/**
+ * @brief Take the oldest log out of the ring if it holds the slot a reservation waits for and is committed.
+ * @param[in] blocked Ring position, for the previous lap, of the first slot that is not free.
+ * @return true if the oldest log was taken out.
+ */
+static bool Console_LogDropOldest(uint32_t blocked);
+#endif
+
+/**
+ * @brief Send the oldest committed log, skipping padding. Called with ConsoleLogBusy taken, releases it when the
+ *        ring has nothing committed left.
+ */
+static void Console_LogSendNext(void);
+
+/**
+ * @brief Take ConsoleLogBusy and send the oldest committed log if the UART is idle.
+ */
+static void Console_LogKick(void);
+
+/**********************************************************************************************************************
+                                    LOCAL FUNCTIONS
+**********************************************************************************************************************/
+static uint32_t Console_LogSequence(uint32_t position)
+{
+    return __atomic_load_n(&ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK].sequence, __ATOMIC_ACQUIRE)
+           + (position & CONSOLE_LOG_SLOT_MASK);
+}
+
+static void Console_LogSetSequence(uint32_t position, uint32_t sequence)
+{
+    __atomic_store_n(&ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK].sequence,
+                     sequence - (position & CONSOLE_LOG_SLOT_MASK), __ATOMIC_RELEASE);
+}
+
+static void Console_LogFree(uint32_t position, uint8_t count)
+{
+    for(uint32_t index = 0u; index < count; index++)
+    {
+        Console_LogSetSequence(position + index, position + index + CONSOLE_LOG_SLOT_COUNT);
+    }
+}
+
+#if (CONSOLE_LOG_OVERFLOW_POLICY == CONSOLE_LOG_DROP_OLDEST)
+static bool Console_LogDropOldest(uint32_t blocked)
+{
+    uint32_t position = __atomic_load_n(&ConsoleLogDequeue, __ATOMIC_ACQUIRE);
+    ConsoleLogSlot_t *slot = &ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK];
+    uint8_t count;
+    bool dropped = false;
+
+    /* A blocked slot before the oldest log belongs to the log the sender is copying out */
+    if(((int32_t)(blocked - position) >= 0) && (Console_LogSequence(position) == (position + 1u)))
+    {
+        count = slot->count;
+        /* The sender or another task may take the same log first, count is only used if the swap succeeds */
+        if(__atomic_compare_exchange_n(&ConsoleLogDequeue, &position, position + count, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == true)
+        {
+            if(slot->length != 0u)
+            {
+                (void)__atomic_fetch_add(&ConsoleLogDroppedCount, 1u, __ATOMIC_RELAXED);
+            }
+            Console_LogFree(position, count);
+        }
+        dropped = true;
+    }
+
+    return dropped;
+}
+#endif
+
+static void Console_LogSendNext(void)
+{
+    uint32_t position;
+    ConsoleLogSlot_t *slot;
+    uint8_t count;
+    uint16_t length;
+    bool sending = false;
+
+    while(sending == false)
+    {
+        position = __atomic_load_n(&ConsoleLogDequeue, __ATOMIC_ACQUIRE);
+        slot = &ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK];
+        if(Console_LogSequence(position) != (position + 1u))
+        {
+            /* Nothing committed. A log committed after the check but before the release would find the ring busy
+             * and not kick it, so check again once released */
+            __atomic_store_n(&ConsoleLogBusy, false, __ATOMIC_RELEASE);
+            if((Console_LogSequence(position) != (position + 1u))
+               || (__atomic_exchange_n(&ConsoleLogBusy, true, __ATOMIC_ACQUIRE) == true))
+            {
+                break;
+            }
+            continue;
+        }
+
+        count = slot->count;
+        if(__atomic_compare_exchange_n(&ConsoleLogDequeue, &position, position + count, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == false)
+        {
+            /* Dropped by the overflow policy meanwhile */
+            continue;
+        }
+
+        /* Padding is freed without being sent */
+        length = slot->length;
+        memcpy(ConsoleLogTransmit, &ConsoleLogText[(position & CONSOLE_LOG_SLOT_MASK) * CONSOLE_LOG_SLOT_SIZE], length);
+        Console_LogFree(position, count);
+        if(length != 0u)
+        {
+            if(R_SCI_UART_Write(&g_console_uart_ctrl, (uint8_t *)ConsoleLogTransmit, length) == FSP_SUCCESS)
+            {
+                sending = true;
+            }
+            else
+            {
+                (void)__atomic_fetch_add(&ConsoleLogDroppedCount, 1u, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+static void Console_LogKick(void)
+{
+    if((__atomic_load_n(&ConsoleLogStarted, __ATOMIC_ACQUIRE) == true)
+       && (__atomic_exchange_n(&ConsoleLogBusy, true, __ATOMIC_ACQUIRE) == false))
+    {
+        Console_LogSendNext();
+    }
+}
+
+/**********************************************************************************************************************
+                                    GLOBAL FUNCTIONS
+**********************************************************************************************************************/
+bool Console_LogReserve(ConsoleLogRecord_t *record)
+{
+    uint32_t position;
+    uint32_t padding;
+    uint32_t index;
+    int32_t lag = 0;
+    bool reserved = false;
+
+    position = __atomic_load_n(&ConsoleLogEnqueue, __ATOMIC_RELAXED);
+    while(reserved == false)
+    {
+        padding = 0u;
+        if(((position & CONSOLE_LOG_SLOT_MASK) + CONSOLE_LOG_RECORD_SLOTS) > CONSOLE_LOG_SLOT_COUNT)
+        {
+            padding = CONSOLE_LOG_SLOT_COUNT - (position & CONSOLE_LOG_SLOT_MASK);
+        }
+
+        /* Every slot has to be free for this lap: behind means the ring is full, ahead means another task took
+         * position first */
+        for(index = 0u; index < (padding + CONSOLE_LOG_RECORD_SLOTS); index++)
+        {
+            lag = (int32_t)(Console_LogSequence(position + index) - (position + index));
+            if(lag != 0)
+            {
+                break;
+            }
+        }
+
+        if(lag > 0)
+        {
+            position = __atomic_load_n(&ConsoleLogEnqueue, __ATOMIC_RELAXED);
+        }
+        else if(lag < 0)
+        {
+#if (CONSOLE_LOG_OVERFLOW_POLICY == CONSOLE_LOG_DROP_OLDEST)
+            if(Console_LogDropOldest(position + index - CONSOLE_LOG_SLOT_COUNT) == true)
+            {
+                position = __atomic_load_n(&ConsoleLogEnqueue, __ATOMIC_RELAXED);
+                continue;
+            }
+#endif
+            (void)__atomic_fetch_add(&ConsoleLogDroppedCount, 1u, __ATOMIC_RELAXED);
+            break;
+        }
+        else if(__atomic_compare_exchange_n(&ConsoleLogEnqueue, &position,
+                                            position + padding + CONSOLE_LOG_RECORD_SLOTS, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == true)
+        {
+            if(padding != 0u)
+            {
+                ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK].length = 0u;
+                ConsoleLogSlots[position & CONSOLE_LOG_SLOT_MASK].count = (uint8_t)padding;
+                Console_LogSetSequence(position, position + 1u);
+            }
+            record->position = position + padding;
+            record->end = position + padding + CONSOLE_LOG_RECORD_SLOTS;
+            record->text = &ConsoleLogText[(record->position & CONSOLE_LOG_SLOT_MASK) * CONSOLE_LOG_SLOT_SIZE];
+            reserved = true;
+        }
+        else
+        {
+            /* position was reloaded by the failed swap */
+        }
+    }
+
+    return reserved;
+}
+
+void Console_LogCommit(ConsoleLogRecord_t *record, size_t length)
+{
+    ConsoleLogSlot_t *slot = &ConsoleLogSlots[record->position & CONSOLE_LOG_SLOT_MASK];
+    uint32_t used = (uint32_t)((length + CONSOLE_LOG_SLOT_SIZE - 1u) / CONSOLE_LOG_SLOT_SIZE);
+    uint32_t end = record->end;
+
+    if(used == 0u)
+    {
+        used = 1u;
+    }
+    /* Slots after the text go back to the ring if nothing was reserved after them, they are still free for this
+     * lap. Otherwise they are sent out with the log */
+    if(__atomic_compare_exchange_n(&ConsoleLogEnqueue, &end, record->position + used, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == false)
+    {
+        used = record->end - record->position;
+    }
+
+    slot->length = (uint16_t)length;
+    slot->count = (uint8_t)used;
+    Console_LogSetSequence(record->position, record->position + 1u);
+
+    Console_LogKick();
+}
+
+void Console_LogStart(void)
+{
+    __atomic_store_n(&ConsoleLogStarted, true, __ATOMIC_RELEASE);
+    Console_LogKick();
+}
+
+void Console_LogTransmitDone(void)
+{
+    /* ConsoleLogBusy is still taken by the write that just completed */
+    Console_LogSendNext();
+}
+
+uint32_t Console_LogDropped(void)
+{
+    return __atomic_load_n(&ConsoleLogDroppedCount, __ATOMIC_RELAXED);
+}
+
+bool Console_LogIdle(void)
+{
+    return (__atomic_load_n(&ConsoleLogDequeue, __ATOMIC_ACQUIRE)
+            == __atomic_load_n(&ConsoleLogEnqueue, __ATOMIC_ACQUIRE));
+}
+
+void Console_LogFrame(uint8_t *frame, uint32_t site, const uint8_t *end)
+{
+    size_t length = (size_t)(end - frame);
+#if (LOG_TERMINAL != RTT_TERMINAL)
+    ConsoleLogRecord_t record;
+#endif
+
+    frame[0] = CONSOLE_LOG_FRAME_SYNC;
+    frame[1] = (uint8_t)length;
+    memcpy(&frame[2], &site, sizeof(site));
+
+#if (LOG_TERMINAL == RTT_TERMINAL)
+    (void)SEGGER_RTT_Write(SEGGER_INDEX, frame, length);
+#else
+    if(Console_LogReserve(&record) == true)
+    {
+        memcpy(record.text, frame, length);
+        Console_LogCommit(&record, length);
+    }
+#endif
+}
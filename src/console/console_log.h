@@ -0,0 +1,217 @@
+/***********************************************************************************************************************
+ * File Name    : console_log.h
+ * Description  : Lock-free ring of formatted console logs, drained to the console UART from its interrupts
+ **********************************************************************************************************************/
+#ifndef CONSOLE_LOG_H
+#define CONSOLE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <logging_levels.h>
+
+/** @brief Size of a ring slot. A log takes as many consecutive slots as its text needs */
+#define CONSOLE_LOG_SLOT_SIZE           (64u)
+
+/** @brief Number of slots, a power of two. The ring holds CONSOLE_LOG_SLOT_COUNT * CONSOLE_LOG_SLOT_SIZE bytes */
+#define CONSOLE_LOG_SLOT_COUNT          (64u)
+
+/** @brief Slots reserved to format a log in, longer logs are truncated */
+#define CONSOLE_LOG_RECORD_SLOTS        (16u)
+
+/** @brief Room a log is formatted in */
+#define CONSOLE_LOG_RECORD_SIZE         (CONSOLE_LOG_RECORD_SLOTS * CONSOLE_LOG_SLOT_SIZE)
+
+/** @brief Overflow policies: a full ring drops the log being written, or the oldest logs not sent yet */
+#define CONSOLE_LOG_DROP_NEW            (0)
+#define CONSOLE_LOG_DROP_OLDEST         (1)
+
+/** @brief Policy used when the ring is full, set by the CONSOLE_LOG_DROP_OLDEST CMake option */
+#ifndef CONSOLE_LOG_OVERFLOW_POLICY
+#define CONSOLE_LOG_OVERFLOW_POLICY     CONSOLE_LOG_DROP_NEW
+#endif
+
+/**
+ * @brief Modules with their own log level. A source file picks its module by defining CONSOLE_LOG_MODULE before its
+ *        includes, files that do not are logged as CONSOLE_LOG_MODULE_CONSOLE
+ */
+typedef enum
+{
+    CONSOLE_LOG_MODULE_CLOUD_APP =      0u,
+    CONSOLE_LOG_MODULE_CLOUD_PROV =     1u,
+    CONSOLE_LOG_MODULE_SENSOR =         2u,
+    CONSOLE_LOG_MODULE_OB1203 =         3u,
+    CONSOLE_LOG_MODULE_CONSOLE =        4u,
+    CONSOLE_LOG_MODULE_LED =            5u,
+}ConsoleLogModule_t;
+
+#define CONSOLE_LOG_MODULE_COUNT        (6u)
+
+#ifndef CONSOLE_LOG_MODULE
+#define CONSOLE_LOG_MODULE              (CONSOLE_LOG_MODULE_CONSOLE)
+#endif
+
+/** @brief Level of every module until the levels stored in data flash are loaded, or if none were stored */
+#define CONSOLE_LOG_LEVEL_DEFAULT       (LOG_INFO)
+
+/**
+ * @brief Log level of each module, LOG_NONE to LOG_DEBUG, changed from the console menu. APP_*_PRINT checks it
+ *        before its arguments are evaluated, a disabled level costs a load and a compare.
+ */
+extern uint8_t ConsoleLogLevels[CONSOLE_LOG_MODULE_COUNT];
+
+/** @brief True if the module of the calling file logs at level_, LOG_LVL being the most verbose level built in */
+#define CONSOLE_LOG_ENABLED(level_)     ((LOG_LVL >= (level_)) && (ConsoleLogLevels[CONSOLE_LOG_MODULE] >= (level_)))
+
+/**
+ * @brief Send APP_*_PRINT logs as binary frames that script/console_log_decode.py turns back into text, set by the
+ *        CONSOLE_LOG_BINARY CMake option
+ */
+#ifndef CONSOLE_LOG_BINARY
+#define CONSOLE_LOG_BINARY              (0)
+#endif
+
+/** @brief First byte of a binary frame, console text is ASCII so never holds it */
+#define CONSOLE_LOG_FRAME_SYNC          (0xC5u)
+
+/** @brief Sync byte, frame length and 32-bit ID of the log site */
+#define CONSOLE_LOG_FRAME_HEADER_SIZE   (6u)
+
+/** @brief Arguments a binary log can take, APP_*_PRINT function name included */
+#define CONSOLE_LOG_FRAME_ARGS_MAX      (8u)
+
+/** @brief Largest binary frame, every argument being 8 bytes long */
+#define CONSOLE_LOG_FRAME_SIZE_MAX      (CONSOLE_LOG_FRAME_HEADER_SIZE + (CONSOLE_LOG_FRAME_ARGS_MAX * 8u))
+
+/**
+ * @brief Write a log as a binary frame, formatted on the host.
+ * @details The format is stored in the .console_log_fmt section, which the linker script keeps out of flash. Its
+ *          offset in that section is the ID of the log site. Arguments are copied raw: integers as 32 bits, long
+ *          long as 64 bits, float and double as float and pointers as 32-bit addresses. The decoder reads strings
+ *          found in flash out of the ELF file, strings in RAM are shown by address.
+ * @param[in] fn_ Format, a string literal.
+ */
+#define CONSOLE_LOG_FRAME(fn_, ...)     ({\
+            static const char ConsoleLogSite[] __attribute__((section(".console_log_fmt"), used)) = fn_;\
+            uint8_t consoleLogFrame[CONSOLE_LOG_FRAME_SIZE_MAX];\
+            uint8_t *consoleLogArg = &consoleLogFrame[CONSOLE_LOG_FRAME_HEADER_SIZE];\
+            CONSOLE_LOG_PUT_ARGS(__VA_ARGS__)\
+            Console_LogFrame(consoleLogFrame, (uint32_t)(uintptr_t)ConsoleLogSite, consoleLogArg);\
+        })
+
+/* Argument count, from 0 to CONSOLE_LOG_FRAME_ARGS_MAX, and one put per argument */
+#define CONSOLE_LOG_PUT_ARGS(...)       CONSOLE_LOG_PUT_N(CONSOLE_LOG_COUNT(_, ##__VA_ARGS__), ##__VA_ARGS__)
+#define CONSOLE_LOG_COUNT(...)          CONSOLE_LOG_COUNT_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define CONSOLE_LOG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, count, ...) count
+#define CONSOLE_LOG_PUT_N(count, ...)   CONSOLE_LOG_PUT_N_(count, ##__VA_ARGS__)
+#define CONSOLE_LOG_PUT_N_(count, ...)  CONSOLE_LOG_PUT_##count(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_0()
+#define CONSOLE_LOG_PUT_1(arg)          CONSOLE_LOG_PUT(arg)
+#define CONSOLE_LOG_PUT_2(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_1(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_3(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_2(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_4(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_3(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_5(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_4(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_6(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_5(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_7(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_6(__VA_ARGS__)
+#define CONSOLE_LOG_PUT_8(arg, ...)     CONSOLE_LOG_PUT(arg) CONSOLE_LOG_PUT_7(__VA_ARGS__)
+#define CONSOLE_LOG_PUT(arg)            consoleLogArg = _Generic((arg),\
+                                            float: Console_LogPutFloat,\
+                                            double: Console_LogPutDouble,\
+                                            long long: Console_LogPutLong,\
+                                            unsigned long long: Console_LogPutLong,\
+                                            char *: Console_LogPutPointer,\
+                                            const char *: Console_LogPutPointer,\
+                                            unsigned char *: Console_LogPutPointer,\
+                                            const unsigned char *: Console_LogPutPointer,\
+                                            void *: Console_LogPutPointer,\
+                                            const void *: Console_LogPutPointer,\
+                                            default: Console_LogPutWord)(consoleLogArg, (arg));
+
+static inline uint8_t *Console_LogPutWord(uint8_t *out, uint32_t value)
+{
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+}
+
+static inline uint8_t *Console_LogPutLong(uint8_t *out, uint64_t value)
+{
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+}
+
+static inline uint8_t *Console_LogPutFloat(uint8_t *out, float value)
+{
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+}
+
+static inline uint8_t *Console_LogPutDouble(uint8_t *out, double value)
+{
+    return Console_LogPutFloat(out, (float)value);
+}
+
+static inline uint8_t *Console_LogPutPointer(uint8_t *out, const void *value)
+{
+    return Console_LogPutWord(out, (uint32_t)(uintptr_t)value);
+}
+
+/**
+ * @brief Log being written, from Console_LogReserve to Console_LogCommit
+ */
+typedef struct
+{
+    /** Text buffer, CONSOLE_LOG_RECORD_SIZE bytes long */
+    char *text;
+    /** Ring position of the first slot of the log */
+    uint32_t position;
+    /** Ring position after the last slot reserved, padding to the end of the ring included */
+    uint32_t end;
+}ConsoleLogRecord_t;
+
+/**
+ * @brief Reserve room for a log in the ring, without lock. Can be called from any task.
+ * @param[out] record Log to format in record->text, then to give to Console_LogCommit.
+ * @return false if the ring is full and the overflow policy dropped this log.
+ */
+bool Console_LogReserve(ConsoleLogRecord_t *record);
+
+/**
+ * @brief Hand a formatted log over to the UART. Slots the text does not use go back to the ring when no other log
+ *        was reserved after this one.
+ * @param[in] record Log filled by Console_LogReserve.
+ * @param[in] length Length of the text, at most CONSOLE_LOG_RECORD_SIZE.
+ */
+void Console_LogCommit(ConsoleLogRecord_t *record, size_t length);
+
+/**
+ * @brief Start sending the oldest log if the UART is idle. Console_Init calls it once the UART is open, logs
+ *        committed before wait in the ring until then.
+ */
+void Console_LogStart(void);
+
+/**
+ * @brief Chain the next log once the UART finished sending one. Called from the UART transmit complete interrupt.
+ */
+void Console_LogTransmitDone(void);
+
+/**
+ * @brief Number of logs the overflow policy dropped since reset.
+ */
+uint32_t Console_LogDropped(void);
+
+/**
+ * @brief True once every log reserved is committed and copied out of the ring, the last one may still be on the wire.
+ */
+bool Console_LogIdle(void);
+
+/**
+ * @brief Complete the header of a binary frame built by CONSOLE_LOG_FRAME and send it, to RTT if it is the log
+ *        terminal, else through the log ring.
+ * @param[in] frame Frame, CONSOLE_LOG_FRAME_SIZE_MAX bytes long.
+ * @param[in] site ID of the log site.
+ * @param[in] end Position after the last argument.
+ */
+void Console_LogFrame(uint8_t *frame, uint32_t site, const uint8_t *end);
+
+#endif //CONSOLE_LOG_H
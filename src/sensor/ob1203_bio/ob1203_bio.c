@@ -21,6 +21,8 @@
  * Copyright (C) 2023 Renesas Electronics Corporation. All rights reserved.
  ***********************************************************************************************************************/
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_OB1203)
+
 #include "ob1203_bio.h"
 #include "hal_data.h"
 #include "oximeter_thread.h"
@@ -19,6 +19,8 @@
  * included in this file may be subject to different terms.
  **********************************************************************************************************************/
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_SENSOR)
+
 #include <console.h>
 #include "sensor_icm20948.h"
 #include <sensor_thread.h>
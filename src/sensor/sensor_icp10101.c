@@ -18,6 +18,8 @@
  * CONTRACT OR TORT, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THE CONTENTS. Third-party contents
  * included in this file may be subject to different terms.
  **********************************************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_SENSOR)
+
 #include <console.h>
 #include <sensor_icp10101.h>
 #include <sensor_thread.h>
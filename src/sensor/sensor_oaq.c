@@ -3,6 +3,8 @@
  * Description  : Contains data structures and function definitions for ZMOD4510 sensor data read
  ***********************************************************************************************************************/
 
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_SENSOR)
+
 #include <sensor_oaq.h>
 #include <sensor_thread.h>
 #include "console.h"
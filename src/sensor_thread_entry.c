@@ -20,6 +20,8 @@
  *
  * Copyright (C) 2023 Renesas Electronics Corporation. All rights reserved.
  ***********************************************************************************************************************/
+#define CONSOLE_LOG_MODULE      (CONSOLE_LOG_MODULE_SENSOR)
+
 #include "sensor_thread.h"
 #include <console.h>
 #include <sensor_config.h>